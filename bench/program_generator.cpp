@@ -0,0 +1,262 @@
+#include "program_generator.h"
+
+#include <vector>
+
+
+namespace {
+
+// splitmix64: воспроизводим везде, в отличие от распределений <random>
+class Random {
+public:
+    explicit Random (uint64_t seed) : state(seed) {}
+
+    uint64_t
+    next ()
+    {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // [0, n)
+    int below (int n) { return n > 0 ? (int) (next() % (uint64_t) n) : 0; }
+
+    bool chance (double p) { return (double) (next() >> 11) * (1.0 / 9007199254740992.0) < p; }
+
+private:
+    uint64_t state;
+};
+
+class Generator {
+public:
+    Generator (const GeneratorOptions& options)
+        : options(options), random(options.seed) {}
+
+    std::string
+    program ()
+    {
+        for (int k = 0; k < options.functions; ++k) function(k);
+
+        // main вызывает часть функций, чтобы программу можно было запустить
+        out += "int main() {\n    int r = 0;\n";
+        for (int k = 0; k < options.functions; k += 7) {
+            out += "    r = (r + f" + std::to_string(k) + "(" + std::to_string(random.below(10)) + ", " +
+                   std::to_string(random.below(10)) + ")) % 256;\n";
+        }
+        out += "    return r;\n}\n";
+        return std::move(out);
+    }
+
+private:
+    const GeneratorOptions& options;
+    Random random;
+    std::string out;
+
+    int currentFunction = 0;
+    int nextName = 0;                   // Имена локальных переменных в функции
+    std::vector<std::string> readable;  // Видимые переменные
+    std::vector<std::string> writable;  // Видимые, которым можно присваивать
+    int loopDepth = 0;
+
+    static const int callLevels = 4;    // Глубина графа вызовов
+
+    void
+    indent (int level)
+    {
+        out.append((size_t) level * 4, ' ');
+    }
+
+    std::string
+    fresh (const char* prefix)
+    {
+        return prefix + std::to_string(nextName++);
+    }
+
+    void
+    function (int k)
+    {
+        currentFunction = k;
+        nextName = 0;
+        readable = { "a", "b" };
+        writable.clear();
+        loopDepth = 0;
+
+        out += "int f" + std::to_string(k) + "(int a, int b) {\n";
+        size_t readableMark = readable.size(), writableMark = writable.size();
+        std::string acc = fresh("v");
+        indent(1);
+        out += "int " + acc + " = " + intExpr(options.expressionSize) + ";\n";
+        readable.push_back(acc);
+        writable.push_back(acc);
+        statements(1);
+        indent(1);
+        out += "return " + acc + " % 65536;\n";
+        readable.resize(readableMark);
+        writable.resize(writableMark);
+        out += "}\n\n";
+    }
+
+    // Операторы блока на уровне level (1 - тело функции)
+    void
+    statements (int level)
+    {
+        size_t readableMark = readable.size(), writableMark = writable.size();
+        int count = 2 + random.below(3);
+        for (int i = 0; i < count; ++i) {
+            // Ветвление ~1.2 составных оператора на блок: глубина растит объём умеренно
+            if (level <= options.depth && random.chance(0.4)) {
+                compound(level);
+            }
+            else {
+                simple(level);
+            }
+        }
+        readable.resize(readableMark);
+        writable.resize(writableMark);
+    }
+
+    void
+    block (int level)
+    {
+        out += "{\n";
+        statements(level + 1);
+        indent(level);
+        out += "}";
+    }
+
+    void
+    simple (int level)
+    {
+        indent(level);
+        int kind = random.below(10);
+        if (kind < 4 || writable.empty()) {
+            std::string name = fresh("v");
+            out += "int " + name + " = " + intExpr(options.expressionSize) + ";\n";
+            readable.push_back(name);
+            writable.push_back(name);
+        }
+        else if (kind < 8) {
+            static const char* const ops[] = { "=", "+=", "-=", "*=" };
+            const std::string& target = writable[(size_t) random.below((int) writable.size())];
+            out += target + " " + ops[random.below(4)] + " " + intExpr(options.expressionSize) + ";\n";
+        }
+        else if (loopDepth > 0 && kind == 8) {
+            out += std::string("if (") + boolExpr(options.expressionSize) + ") " +
+                   (random.chance(0.5) ? "break;\n" : "continue;\n");
+        }
+        else {
+            // Значение в диапазоне, чтобы умножения не росли без предела
+            const std::string& target = writable[(size_t) random.below((int) writable.size())];
+            out += target + " = " + target + " % 1000;\n";
+        }
+    }
+
+    void
+    compound (int level)
+    {
+        indent(level);
+        if (!random.chance(options.loopDensity)) {
+            out += "if (" + boolExpr(options.expressionSize) + ") ";
+            block(level);
+            if (random.chance(0.5)) {
+                out += " else ";
+                block(level);
+            }
+            out += "\n";
+            return;
+        }
+
+        ++loopDepth;
+        std::string counter = fresh("i");
+        std::string bound = std::to_string(2 + random.below(8));
+        readable.push_back(counter);
+        switch (random.below(3)) {
+            case 0:
+                out += "for (int " + counter + " = 0; " + counter + " < " + bound + "; " + counter + "++) ";
+                block(level);
+                out += "\n";
+                readable.pop_back();        // Счётчик for виден только в цикле
+                break;
+            case 1:
+                // Счётчик увеличивается до тела: continue не зацикливает
+                out += "int " + counter + " = 0;\n";
+                indent(level);
+                out += "while (" + counter + " < " + bound + ") {\n";
+                indent(level + 1);
+                out += counter + "++;\n";
+                statements(level + 1);
+                indent(level);
+                out += "}\n";
+                break;
+            default:
+                out += "int " + counter + " = 0;\n";
+                indent(level);
+                out += "do {\n";
+                indent(level + 1);
+                out += counter + "++;\n";
+                statements(level + 1);
+                indent(level);
+                out += "} while (" + counter + " < " + bound + ");\n";
+                break;
+        }
+        // Счётчик while/do-while объявлен в блоке снаружи и виден дальше
+        --loopDepth;
+    }
+
+    std::string
+    leaf ()
+    {
+        if (random.chance(0.3)) return std::to_string(random.below(100));
+        return readable[(size_t) random.below((int) readable.size())];
+    }
+
+    // Целое выражение примерно из size операндов
+    std::string
+    intExpr (int size)
+    {
+        if (size <= 1) return leaf();
+
+        int left = 1 + random.below(size - 1);
+        int right = size - left;
+        int kind = random.below(12);
+        // Вызовы - вне циклов и только функций уровня ниже: время работы
+        // программы ограничено, а не растёт экспоненциально с числом функций
+        int level = currentFunction % callLevels;
+        if (kind == 0 && loopDepth == 0 && level > 0 && currentFunction >= callLevels) {
+            int callee = random.below(currentFunction / callLevels) * callLevels + random.below(level);
+            return "f" + std::to_string(callee) + "(" + intExpr(left) + ", " + intExpr(right) + ")";
+        }
+        if (kind == 1) return "-(" + intExpr(size - 1) + ")";
+        if (kind == 2 || kind == 3) {
+            // Делитель от 2 до 14: остаток от 7 лежит в [-6, 6]
+            return "(" + intExpr(left) + (kind == 2 ? " / " : " % ") + "(" + intExpr(right) + " % 7 + 8))";
+        }
+        static const char* const ops[] = { " + ", " - ", " * " };
+        return "(" + intExpr(left) + ops[random.below(3)] + intExpr(right) + ")";
+    }
+
+    // Условие примерно из size операндов
+    std::string
+    boolExpr (int size)
+    {
+        if (size >= 4 && random.chance(0.3)) {
+            int left = size / 2;
+            std::string op = random.chance(0.5) ? " && " : " || ";
+            return "(" + boolExpr(left) + op + boolExpr(size - left) + ")";
+        }
+        if (size >= 2 && random.chance(0.1)) return "!(" + boolExpr(size) + ")";
+
+        static const char* const ops[] = { " < ", " > ", " <= ", " >= ", " == ", " != " };
+        int left = size > 1 ? 1 + random.below(size - 1) : 1;
+        return intExpr(left) + ops[random.below(6)] + intExpr(size > left ? size - left : 1);
+    }
+};
+
+} // namespace
+
+std::string
+generateProgram (const GeneratorOptions& options)
+{
+    return Generator(options).program();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Генератор случайных программ на поддерживаемом подмножестве C для
+ * бенчмарков.
+ *
+ * Программа проходит семантический анализ без ошибок: функции int от двух
+ * int, переменные объявлены с инициализатором до использования, условия -
+ * сравнения и логические операции, делители не бывают нулём, функции
+ * вызывают только объявленные раньше и не из циклов (без рекурсии, граф
+ * вызовов неглубокий), циклы ограничены счётчиками - программа быстро
+ * завершается и после трансляции. Один и тот же seed даёт один и тот же текст на любой
+ * платформе: генератор случайных чисел свой, а не из <random>.
+ */
+
+struct GeneratorOptions {
+    int functions = 100;            // Функций кроме main
+    int depth = 3;                  // Наибольшая вложенность блоков в функции
+    int expressionSize = 6;         // Примерное число операндов в выражении
+    double loopDensity = 0.3;       // Доля циклов среди составных операторов
+    uint64_t seed = 1;
+};
+
+std::string generateProgram(const GeneratorOptions& options);
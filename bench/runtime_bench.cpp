@@ -0,0 +1,246 @@
+/**
+ * Бенчмарк времени выполнения сгенерированного Python кода.
+ *
+ * Каждое ядро транслируется в нескольких вариантах - без оптимизаций, отдельно
+ * с выносом инвариантов из циклов, с подстановкой функций, с заменой хвостовой
+ * рекурсии циклом, с локальными псевдонимами функций и range в циклах,
+ * с кешированием чистых рекурсивных функций, и со всеми сразу.
+ * Варианты запускаются интерпретатором (по умолчанию python3, см. аргумент
+ * или переменную PYTHON). Печатается лучшее время из нескольких запусков и
+ * ускорение полного варианта; коды завершения вариантов должны совпадать.
+ *
+ *     make bench
+ *     bench/runtime_bench [python] [повторы]
+ */
+
+#include "lexer.h"
+#include "parser.h"
+#include "semantic.h"
+#include "symbol_table.h"
+#include "optimizer.h"
+#include "inliner.h"
+#include "code_generator.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+struct Kernel {
+    const char* name;
+    const char* source;
+};
+
+const Kernel kernels[] = {
+    { "condition", R"(
+int main() {
+    int n = 1000; int m = 1500; int i = 0; int s = 0;
+    while (i < n * m - n / 2) {
+        s = s + i % 8;
+        i = i + 1;
+    }
+    return s % 256;
+})" },
+    { "body", R"(
+int main() {
+    int x = 12; int y = 34; int z = 5; int s = 0; int i = 0;
+    while (i < 1000000) {
+        s = (s + x * y - z * x + i) % 65536;
+        i = i + 1;
+    }
+    return s % 256;
+})" },
+    { "nested", R"(
+int main() {
+    int n = 700; int k = 3; int s = 0;
+    for (int i = 0; i < n; i++) {
+        int j = 0;
+        while (j < n + k * 2) {
+            s = (s + n * k + i * 3 + j) % 65536;
+            j = j + 1;
+        }
+    }
+    return s % 256;
+})" },
+    { "pure-call", R"(
+int limit(int a, int b) { return a * b + 1; }
+int main() {
+    int a = 1000; int b = 1000; int s = 0; int i = 0;
+    while (i < limit(a, b)) {
+        s = s + 1;
+        i = i + 1;
+    }
+    return s % 256;
+})" },
+    { "helpers", R"(
+int square(int v) { return v * v; }
+int dist(int a, int b) { int d = a - b; return d * d; }
+int main() {
+    int s = 0;
+    for (int i = 0; i < 400000; i++) {
+        s = (s + square(i % 100) + dist(i % 37, 18)) % 65536;
+    }
+    return s % 256;
+})" },
+    { "tailcall", R"(
+int accumulate(int n, int acc) {
+    if (n == 0) return acc;
+    return accumulate(n - 1, (acc + n * n) % 65536);
+}
+int main() {
+    int s = 0;
+    for (int i = 0; i < 1500; i++) {
+        s = (s + accumulate(300, i)) % 65536;
+    }
+    return s % 256;
+})" },
+    { "globals", R"(
+int is_prime(int n) {
+    if (n < 2) return 0;
+    int d = 2;
+    while (d * d <= n) {
+        if (n % d == 0) return 0;
+        d++;
+    }
+    return 1;
+}
+int count_primes(int limit) {
+    int c = 0;
+    for (int i = 0; i < limit; i++) {
+        c = c + is_prime(i);
+    }
+    return c;
+}
+int grid(int n) {
+    int s = 0;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < 4; j++) {
+            s = (s + i * j) % 1000;
+        }
+    }
+    return s;
+}
+int main() {
+    return (count_primes(60000) + grid(100000)) % 256;
+})" },
+    { "memoize", R"(
+int fib(int n) {
+    if (n < 2) return n;
+    return (fib(n - 1) + fib(n - 2)) % 65536;
+}
+int main() {
+    return fib(27) % 256;
+})" },
+};
+
+// Набор включённых оптимизаций; all - настройки по умолчанию
+struct Variant {
+    const char* name;
+    bool hoist;
+    bool inlineCalls;
+    bool tailCalls;
+    bool bindGlobals;
+    bool memoize;
+};
+
+const Variant variants[] = {
+    { "baseline", false, false, false, false, false },
+    { "hoist", true, false, false, false, false },
+    { "inline", false, true, false, false, false },
+    { "tailcall", false, false, true, false, false },
+    { "bind", false, false, false, true, false },
+    { "memoize", false, false, false, false, true },
+    { "all", true, true, true, false, false },
+};
+const size_t variantCount = sizeof(variants) / sizeof(variants[0]);
+
+std::string
+translate (const std::string& code, const Variant& variant)
+{
+    Lexer lexer(code);
+    Parser parser(lexer.tokenize());
+    auto program = parser.parseProgram();
+
+    SymbolTable symbolTable;
+    SemanticAnalyzer semanticAnalyzer(symbolTable);
+    if (!semanticAnalyzer.analyze(program)) {
+        throw std::runtime_error(semanticAnalyzer.getErrors().front());
+    }
+
+    InlinerOptions inlinerOptions;
+    inlinerOptions.enabled = variant.inlineCalls;
+    Inliner inliner(semanticAnalyzer, inlinerOptions);
+    if (inliner.inlineCalls(program.get()).changed()) {
+        semanticAnalyzer.analyze(program);
+    }
+
+    Optimizer optimizer(semanticAnalyzer);
+    if (optimizer.optimize(program.get()).changed()) {
+        semanticAnalyzer.analyze(program);
+    }
+
+    CodeGenOptions options;
+    options.hoistLoopInvariants = variant.hoist;
+    options.convertTailCalls = variant.tailCalls;
+    options.bindLoopGlobals = variant.bindGlobals;
+    options.memoizePureRecursive = variant.memoize;
+    CodeGenerator codeGen(&semanticAnalyzer, options);
+    return codeGen.generate(program.get());
+}
+
+// Лучшее время из repeat запусков, мс; status - результат std::system
+double
+run (const std::string& python, const std::string& script, int repeat, int& status)
+{
+    std::string command = python + " " + script;
+    double best = 0;
+    for (int i = 0; i < repeat; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        status = std::system(command.c_str());
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (i == 0 || elapsed.count() < best) best = elapsed.count();
+    }
+    return best;
+}
+
+} // namespace
+
+int
+main (int argc, char** argv)
+{
+    const char* env = std::getenv("PYTHON");
+    std::string python = (argc > 1) ? argv[1] : (env ? env : "python3");
+    int repeat = (argc > 2) ? std::atoi(argv[2]) : 3;
+    if (repeat < 1) repeat = 1;
+
+    std::printf("%-12s", "kernel");
+    for (const Variant& variant : variants) std::printf(" %10s ms", variant.name);
+    std::printf(" %9s\n", "speedup");
+
+    int failures = 0;
+    for (const Kernel& kernel : kernels) {
+        double times[variantCount];
+        int status[variantCount];
+        bool same = true;
+
+        std::printf("%-12s", kernel.name);
+        for (size_t v = 0; v < variantCount; ++v) {
+            std::string script = std::string("bench/_runtime_") + kernel.name + "_" + variants[v].name + ".py";
+            std::ofstream(script) << translate(kernel.source, variants[v]);
+            times[v] = run(python, script, repeat, status[v]);
+            std::remove(script.c_str());
+
+            same = same && status[v] == status[0];
+            std::printf(" %13.1f", times[v]);
+            std::fflush(stdout);
+        }
+
+        std::printf(" %8.2fx%s\n", times[0] / times[variantCount - 1], same ? "" : "  (result differs!)");
+        if (!same) ++failures;
+    }
+    return failures ? 1 : 0;
+}
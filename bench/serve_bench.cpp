@@ -0,0 +1,182 @@
+/**
+ * Бенчмарк задержки запроса: однократный c2py-cli против сервера.
+ *
+ * Один и тот же небольшой файл транслируется повторно:
+ * - cli     - запуск build/c2py-cli -o - на каждый файл (процесс, таблицы,
+ *             холодные кеши - каждый раз)
+ * - client  - запуск build/c2py-client -o - к серверу c2py-cli --serve
+ * - socket  - запрос по уже открытому соединению (так сервер видит
+ *             редактор или сборщик, связанный с protocol.h)
+ * Сервер запускается без кеша результатов: все три варианта транслируют
+ * файл заново. Печатаются медиана и 90-й процентиль.
+ *
+ *     make bench_serve
+ *     bench/serve_bench [запросов] [функций]
+ */
+
+#include "protocol.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace {
+
+const char* workDir = "bench/_serve";
+
+std::string
+makeProgram (int functions)
+{
+    std::string code;
+    for (int k = 0; k < functions; ++k) {
+        std::string n = std::to_string(k);
+        code += "int f" + n + "(int n) {\n"
+                "    int s = " + n + ";\n"
+                "    for (int i = 0; i < n; i++) {\n"
+                "        if (i % 3 == 0) { s = (s + i * " + n + ") % 65536; } else { s = s - 1; }\n"
+                "    }\n"
+                "    return s;\n"
+                "}\n";
+    }
+    code += "int main() {\n    return f0(10) % 256;\n}\n";
+    return code;
+}
+
+// Запуск с выводом в /dev/null; pid процесса
+pid_t
+spawn (const std::vector<std::string>& args)
+{
+    std::vector<char*> argv;
+    for (const std::string& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+    pid_t pid = 0;
+    if (posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ) != 0) {
+        throw std::runtime_error("cannot start " + args[0]);
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    return pid;
+}
+
+int
+waitFor (pid_t pid)
+{
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+double
+percentile (std::vector<double> ms, double p)
+{
+    std::sort(ms.begin(), ms.end());
+    return ms[std::min(ms.size() - 1, (size_t) (p * (double) ms.size()))];
+}
+
+template <typename Request>
+std::vector<double>
+measure (int requests, Request request)
+{
+    std::vector<double> ms;
+    for (int i = 0; i < requests; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        request();
+        ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return ms;
+}
+
+void
+print (const char* name, const std::vector<double>& ms, double baseline)
+{
+    double median = percentile(ms, 0.5);
+    std::printf("%-8s median %7.3f ms   p90 %7.3f ms   %5.1fx\n", name, median, percentile(ms, 0.9),
+                baseline / median);
+}
+
+} // namespace
+
+int
+main (int argc, char** argv)
+{
+    int requests = argc > 1 ? std::atoi(argv[1]) : 200;
+    int functions = argc > 2 ? std::atoi(argv[2]) : 10;
+
+    std::filesystem::create_directories(workDir);
+    std::string source = std::string(workDir) + "/prog.c";
+    std::ofstream(source) << makeProgram(functions);
+    std::string socketPath = std::string(workDir) + "/c2py.sock";
+    // Сервер принимает только закрытый каталог сокета
+    std::filesystem::permissions(workDir, std::filesystem::perms::owner_all);
+
+    pid_t server = spawn({ "build/c2py-cli", "--serve", "-q", "-j", "1", "--socket", socketPath });
+    int fd = -1;
+    for (int attempt = 0; attempt < 100 && fd < 0; ++attempt) {
+        usleep(20000);
+        fd = connectSocket(socketPath);
+    }
+    if (fd < 0) {
+        std::fprintf(stderr, "server did not start on %s\n", socketPath.c_str());
+        kill(server, SIGTERM);
+        return 1;
+    }
+
+    std::ifstream in(source);
+    TranslateRequest request;
+    request.options.fileName = source;
+    request.code.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    std::printf("%d requests, %d functions (%zu bytes)\n", requests, functions, request.code.size());
+    int failures = 0;
+    std::vector<double> cli = measure(requests, [&] {
+        failures += waitFor(spawn({ "build/c2py-cli", "-q", "-j", "1", "-o", "-", source })) != 0;
+    });
+    std::vector<double> client = measure(requests, [&] {
+        failures += waitFor(spawn({ "build/c2py-client", "-q", "--socket", socketPath, "-o", "-", source })) != 0;
+    });
+    std::vector<double> socket = measure(requests, [&] {
+        std::string frame;
+        size_t pos = 0;
+        TranslateResult result;
+        if (!writeFrame(fd, encodeRequest(request)) || !readFrame(fd, frame) ||
+            !decodeResult(frame, pos, result) || !result.ok) {
+            ++failures;
+        }
+    });
+
+    double baseline = percentile(cli, 0.5);
+    print("cli", cli, baseline);
+    print("client", client, baseline);
+    print("socket", socket, baseline);
+
+    TranslateRequest shutdown;
+    shutdown.kind = RequestKind::Shutdown;
+    std::string frame;
+    writeFrame(fd, encodeRequest(shutdown));
+    readFrame(fd, frame);
+    close(fd);
+    waitFor(server);
+    std::filesystem::remove_all(workDir);
+
+    if (failures) {
+        std::fprintf(stderr, "%d requests failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
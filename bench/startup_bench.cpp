@@ -0,0 +1,194 @@
+/**
+ * Бенчмарк времени запуска: импорт сгенерированного модуля из .py и из .pyc.
+ *
+ * Программа из множества функций транслируется обоими генераторами -
+ * CodeGenerator (текст) и PycGenerator (байт-код CPython 3.11). Измеряется
+ * импорт модуля без вызова main():
+ * - py      - python -B: текст разбирается и компилируется при каждом запуске
+ *             (так запускается python prog.py - скрипт не кешируется)
+ * - py+pyc  - повторный импорт .py с готовым __pycache__
+ * - pyc     - .pyc от PycGenerator без исходника рядом
+ * Из времени вычитается запуск интерпретатора без импорта. Коды завершения
+ * программ из .py и .pyc сравниваются.
+ *
+ *     make bench_startup
+ *     bench/startup_bench [python] [функций] [повторы]
+ */
+
+#include "lexer.h"
+#include "parser.h"
+#include "semantic.h"
+#include "symbol_table.h"
+#include "optimizer.h"
+#include "inliner.h"
+#include "code_generator.h"
+#include "pyc_generator.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+const char* workDir = "bench/_startup";
+
+// Независимые функции с циклами и ветвлениями; main вызывает каждую десятую
+std::string
+makeProgram (int functions)
+{
+    std::string code;
+    for (int k = 0; k < functions; ++k) {
+        std::string n = std::to_string(k);
+        code += "int f" + n + "(int n) {\n"
+                "    int s = " + n + ";\n"
+                "    for (int i = 0; i < n; i++) {\n"
+                "        if (i % 3 == 0) { s = (s + i * " + n + ") % 65536; } else { s = s - 1; }\n"
+                "    }\n"
+                "    while (s > 1000) { s = s / 2; }\n"
+                "    return s;\n"
+                "}\n";
+    }
+    code += "int main() {\n    int r = 0;\n";
+    for (int k = 0; k < functions; k += 10) {
+        code += "    r = (r + f" + std::to_string(k) + "(20)) % 256;\n";
+    }
+    code += "    return r;\n}\n";
+    return code;
+}
+
+struct Translation {
+    std::string text;
+    std::string pyc;
+    double textMs = 0;
+    double pycMs = 0;
+};
+
+Translation
+translate (const std::string& code)
+{
+    Lexer lexer(code);
+    Parser parser(lexer.tokenize());
+    auto program = parser.parseProgram();
+
+    SymbolTable symbolTable;
+    SemanticAnalyzer semanticAnalyzer(symbolTable);
+    if (!semanticAnalyzer.analyze(program)) {
+        throw std::runtime_error(semanticAnalyzer.getErrors().front());
+    }
+
+    // Без подстановки: функций в модуле столько же, сколько в программе
+    InlinerOptions inlinerOptions;
+    inlinerOptions.enabled = false;
+    Inliner inliner(semanticAnalyzer, inlinerOptions);
+    inliner.inlineCalls(program.get());
+
+    Optimizer optimizer(semanticAnalyzer);
+    if (optimizer.optimize(program.get()).changed()) {
+        semanticAnalyzer.analyze(program);
+    }
+
+    Translation result;
+    auto start = std::chrono::steady_clock::now();
+    result.text = CodeGenerator(&semanticAnalyzer).generate(program.get());
+    auto middle = std::chrono::steady_clock::now();
+    result.pyc = PycGenerator(&semanticAnalyzer).generate(program.get(), "startup.c");
+    auto end = std::chrono::steady_clock::now();
+
+    result.textMs = std::chrono::duration<double, std::milli>(middle - start).count();
+    result.pycMs = std::chrono::duration<double, std::milli>(end - middle).count();
+    return result;
+}
+
+// Лучшее время из repeat запусков, мс; status - результат std::system
+double
+run (const std::string& command, int repeat, int& status)
+{
+    double best = 0;
+    for (int i = 0; i < repeat; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        status = std::system(command.c_str());
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (i == 0 || elapsed.count() < best) best = elapsed.count();
+    }
+    return best;
+}
+
+// Импорт модуля mod из каталога dir
+std::string
+importCommand (const std::string& python, const std::string& flags, const std::string& dir)
+{
+    return python + " " + flags + " -c \"import sys; sys.path.insert(0, '" + dir + "'); import mod\"";
+}
+
+} // namespace
+
+int
+main (int argc, char** argv)
+{
+    const char* env = std::getenv("PYTHON");
+    std::string python = (argc > 1) ? argv[1] : (env ? env : "python3");
+    int functions = (argc > 2) ? std::atoi(argv[2]) : 2000;
+    int repeat = (argc > 3) ? std::atoi(argv[3]) : 5;
+    if (functions < 1) functions = 1;
+    if (repeat < 1) repeat = 1;
+
+    Translation translation = translate(makeProgram(functions));
+
+    namespace fs = std::filesystem;
+    std::string pyDir = std::string(workDir) + "/py";
+    std::string cachedDir = std::string(workDir) + "/cached";
+    std::string pycDir = std::string(workDir) + "/pyc";
+    fs::remove_all(workDir);
+    for (const std::string& dir : { pyDir, cachedDir, pycDir }) {
+        fs::create_directories(dir);
+    }
+    std::ofstream(pyDir + "/mod.py") << translation.text;
+    std::ofstream(cachedDir + "/mod.py") << translation.text;
+    std::ofstream(pycDir + "/mod.pyc", std::ios::binary) << translation.pyc;
+
+    std::printf("%d functions: .py %zu bytes (generated in %.1f ms), .pyc %zu bytes (%.1f ms)\n",
+                functions, translation.text.size(), translation.textMs,
+                translation.pyc.size(), translation.pycMs);
+
+    int status = 0;
+    int failures = 0;
+    double base = run(python + " -B -c \"import sys\"", repeat, status);
+
+    // __pycache__ как после первого импорта (import не пишет его при PYTHONDONTWRITEBYTECODE)
+    std::string cacheCommand = python + " -c \"import py_compile; py_compile.compile('" + cachedDir + "/mod.py')\"";
+    if (std::system(cacheCommand.c_str()) != 0) ++failures;
+
+    struct Case { const char* name; std::string command; };
+    const Case cases[] = {
+        { "py", importCommand(python, "-B", pyDir) },
+        { "py+pyc", importCommand(python, "", cachedDir) },
+        { "pyc", importCommand(python, "-B", pycDir) },
+    };
+
+    double times[3];
+    std::printf("%-8s %10s %10s\n", "import", "total ms", "import ms");
+    for (size_t i = 0; i < 3; ++i) {
+        times[i] = run(cases[i].command, repeat, status);
+        if (status != 0) ++failures;
+        std::printf("%-8s %10.1f %10.1f%s\n", cases[i].name, times[i], times[i] - base,
+                    status != 0 ? "  (import failed!)" : "");
+    }
+    std::printf("startup without compile: %.2fx faster than py\n",
+                (times[0] - base) / (times[2] - base > 0.01 ? times[2] - base : 0.01));
+
+    // Программа целиком: одинаковый код завершения
+    int textStatus = 0, pycStatus = 0;
+    run(python + " -B " + pyDir + "/mod.py", 1, textStatus);
+    run(python + " " + pycDir + "/mod.pyc", 1, pycStatus);
+    if (textStatus != pycStatus) {
+        std::printf("exit status differs: py %d, pyc %d\n", textStatus, pycStatus);
+        ++failures;
+    }
+
+    fs::remove_all(workDir);
+    return failures ? 1 : 0;
+}
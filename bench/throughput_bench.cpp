@@ -0,0 +1,410 @@
+/**
+ * Бенчмарк пропускной способности конвейера на сгенерированных программах.
+ *
+ * program_generator строит программу по seed и параметрам формы: число
+ * функций, вложенность, размер выражений, доля циклов. Каждая стадия
+ * замеряется отдельно (лучшее из повторов), затем весь translateSource:
+ * - lex       - Lexer::tokenize
+ * - parse     - Parser::parseProgram по готовым токенам
+ * - semantic  - SemanticAnalyzer::analyze; строкой ниже - построение графа
+ *               вызовов внутри него (CallGraphStats::buildMicros)
+ * - optimize  - подстановка, оптимизатор и повторный анализ, как в конвейере
+ * - codegen   - CodeGenerator в один поток
+ * - pyc       - PycGenerator
+ * - total     - translateSource
+ * Скорость считается от входа: МБ исходника, токенов и узлов AST в секунду.
+ *
+ * Базовая линия - файл с МБ/с по наборам и стадиям. --save записывает её,
+ * --baseline сравнивает с ней; с --check падение любой стадии больше
+ * допуска завершает бенчмарк с кодом 1. МБ/с абсолютны и зависят от машины:
+ * проверять имеет смысл только с линией, сохранённой на той же машине.
+ *
+ *     make bench_throughput            (отчёт: сравнение с bench/throughput_baseline.txt,
+ *                                       замеренной на другой машине, без проверки)
+ *     make bench_baseline              (линия этой машины: bench/throughput_baseline.local)
+ *     make bench_check                 (--check с линией этой машины)
+ *     bench/throughput_bench [--preset NAME] [--functions N] [--depth N]
+ *         [--expr N] [--loops P] [--seed N] [--repeat N] [--emit]
+ *         [--save FILE] [--baseline FILE] [--check] [--tolerance P]
+ */
+
+#include "program_generator.h"
+
+#include "lexer.h"
+#include "parser.h"
+#include "semantic.h"
+#include "symbol_table.h"
+#include "optimizer.h"
+#include "inliner.h"
+#include "code_generator.h"
+#include "pyc_generator.h"
+#include "pipeline.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Preset {
+    std::string name;
+    GeneratorOptions options;
+};
+
+// Наборы по умолчанию: разные формы нагружают разные стадии
+std::vector<Preset>
+defaultPresets ()
+{
+    auto make = [](const char* name, int functions, int depth, int expr, double loops) {
+        Preset preset { name, {} };
+        preset.options.functions = functions;
+        preset.options.depth = depth;
+        preset.options.expressionSize = expr;
+        preset.options.loopDensity = loops;
+        return preset;
+    };
+    return {
+        make("balanced", 100, 3, 6, 0.3),
+        make("wide", 1000, 1, 4, 0.2),       // Много мелких функций
+        make("deep", 50, 7, 4, 0.5),         // Глубокие вложенные блоки и области видимости
+        make("expr", 100, 2, 40, 0.2),       // Длинные выражения
+        make("loops", 100, 4, 6, 0.9),       // Почти одни циклы: анализ циклов, инварианты
+    };
+}
+
+const char* const stages[] = { "lex", "parse", "semantic", "optimize", "codegen", "pyc", "total" };
+
+double
+elapsedMs (std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+size_t
+countNodes (const Expression* expr)
+{
+    if (!expr) return 0;
+    size_t count = 1;
+    if (auto* unary = dynamic_cast<const UnaryExpr*>(expr)) {
+        count += countNodes(unary->expr.get());
+    }
+    else if (auto* binary = dynamic_cast<const BinaryExpr*>(expr)) {
+        count += countNodes(binary->lhs.get()) + countNodes(binary->rhs.get());
+    }
+    else if (auto* call = dynamic_cast<const CallExpr*>(expr)) {
+        for (const auto& arg : call->args) count += countNodes(arg.get());
+    }
+    return count;
+}
+
+size_t
+countNodes (const Statement* stmt)
+{
+    if (!stmt) return 0;
+    size_t count = 1;
+    if (auto* expression = dynamic_cast<const ExpressionStmt*>(stmt)) {
+        count += countNodes(expression->expr.get());
+    }
+    else if (auto* decl = dynamic_cast<const VarDecl*>(stmt)) {
+        count += countNodes(decl->init.get());
+    }
+    else if (auto* block = dynamic_cast<const BlockStmt*>(stmt)) {
+        for (const auto& inner : block->statements) count += countNodes(inner.get());
+    }
+    else if (auto* ifStmt = dynamic_cast<const IfStmt*>(stmt)) {
+        count += countNodes(ifStmt->condition.get()) + countNodes(ifStmt->thenBranch.get()) +
+                 countNodes(ifStmt->elseBranch.get());
+    }
+    else if (auto* whileStmt = dynamic_cast<const WhileStmt*>(stmt)) {
+        count += countNodes(whileStmt->condition.get()) + countNodes(whileStmt->body.get());
+    }
+    else if (auto* doWhile = dynamic_cast<const DoWhileStmt*>(stmt)) {
+        count += countNodes(doWhile->body.get()) + countNodes(doWhile->condition.get());
+    }
+    else if (auto* forStmt = dynamic_cast<const ForStmt*>(stmt)) {
+        count += countNodes(forStmt->init.get()) + countNodes(forStmt->condition.get()) +
+                 countNodes(forStmt->update.get()) + countNodes(forStmt->body.get());
+    }
+    else if (auto* returnStmt = dynamic_cast<const ReturnStmt*>(stmt)) {
+        count += countNodes(returnStmt->value.get());
+    }
+    return count;
+}
+
+size_t
+countNodes (const Program* program)
+{
+    size_t count = 1;
+    for (const auto& function : program->functions) count += 1 + countNodes(function->body.get());
+    return count;
+}
+
+// Разобранная и проанализированная программа; анализатор ссылается на таблицу
+struct Analyzed {
+    SymbolTable symbolTable;
+    SemanticAnalyzer analyzer { symbolTable };
+    ProgramPtr program;
+};
+
+std::unique_ptr<Analyzed>
+analyze (const std::vector<Token>& tokens)
+{
+    auto analyzed = std::make_unique<Analyzed>();
+    analyzed->program = Parser(tokens).parseProgram();
+    if (!analyzed->analyzer.analyze(analyzed->program)) {
+        throw std::runtime_error("generated program: " + analyzed->analyzer.getErrors().front());
+    }
+    return analyzed;
+}
+
+// Подстановка и оптимизация - как в translateSource
+void
+optimize (Analyzed& analyzed)
+{
+    Inliner inliner(analyzed.analyzer);
+    if (inliner.inlineCalls(analyzed.program.get()).changed()) {
+        analyzed.analyzer.analyze(analyzed.program);
+    }
+    Optimizer optimizer(analyzed.analyzer);
+    if (optimizer.optimize(analyzed.program.get()).changed()) {
+        analyzed.analyzer.analyze(analyzed.program);
+    }
+}
+
+// Лучшее время стадии из repeat повторов; prepare - вне замера
+double
+best (int repeat, const std::function<void()>& prepare, const std::function<void()>& stage)
+{
+    double bestMs = 0;
+    for (int i = 0; i < repeat; ++i) {
+        prepare();
+        auto start = std::chrono::steady_clock::now();
+        stage();
+        double ms = elapsedMs(start);
+        if (i == 0 || ms < bestMs) bestMs = ms;
+    }
+    return bestMs;
+}
+
+// МБ/с по стадиям одного набора
+std::map<std::string, double>
+measure (const std::string& code, int repeat)
+{
+    std::vector<Token> tokens = Lexer(code).tokenize();
+    size_t nodes = countNodes(analyze(tokens)->program.get());
+    std::map<std::string, double> ms;
+
+    ms["lex"] = best(repeat, [] {}, [&] { Lexer(code).tokenize(); });
+
+    std::vector<Token> copy;
+    ms["parse"] = best(repeat, [&] { copy = tokens; }, [&] { Parser(std::move(copy)).parseProgram(); });
+
+    // Стадии после разбора получают свежую программу: оптимизатор меняет AST
+    std::unique_ptr<Analyzed> analyzed;
+    ProgramPtr program;
+    double callGraphMs = -1;        // Лучшее из повторов, как у стадий
+    size_t callSites = 0;
+    ms["semantic"] = best(repeat,
+        [&] { program = Parser(tokens).parseProgram(); },
+        [&] {
+            SymbolTable symbolTable;
+            SemanticAnalyzer analyzer(symbolTable);
+            analyzer.analyze(program);
+            const CallGraphStats& graph = analyzer.getCallGraph().stats();
+            if (callGraphMs < 0 || graph.buildMicros / 1e3 < callGraphMs) callGraphMs = graph.buildMicros / 1e3;
+            callSites = graph.callSites;
+        });
+    ms["optimize"] = best(repeat, [&] { analyzed = analyze(tokens); }, [&] { optimize(*analyzed); });
+
+    auto prepareOptimized = [&] {
+        analyzed = analyze(tokens);
+        optimize(*analyzed);
+    };
+    std::string output;
+    ms["codegen"] = best(repeat, prepareOptimized, [&] {
+        output = CodeGenerator(&analyzed->analyzer).generate(analyzed->program.get());
+    });
+    ms["pyc"] = best(repeat, prepareOptimized, [&] {
+        output = PycGenerator(&analyzed->analyzer).generate(analyzed->program.get(), "bench.c");
+    });
+    ms["total"] = best(repeat, [] {}, [&] {
+        if (!translateSource(code).ok) throw std::runtime_error("generated program does not translate");
+    });
+
+    double megabytes = code.size() / 1e6;
+    std::printf("  %-9s %10s %10s %12s %12s\n", "stage", "ms", "MB/s", "Mtokens/s", "Mnodes/s");
+    std::map<std::string, double> rates;
+    for (const char* stage : stages) {
+        double seconds = ms[stage] / 1e3;
+        rates[stage] = megabytes / seconds;
+        std::printf("  %-9s %10.3f %10.2f %12.2f %12.2f\n", stage, ms[stage], rates[stage],
+                    tokens.size() / 1e6 / seconds, nodes / 1e6 / seconds);
+        if (std::string(stage) == "semantic") {
+            std::printf("    callgraph %8.3f   (%.1f%% of semantic, %zu call sites)\n", callGraphMs,
+                        ms[stage] > 0 ? callGraphMs / ms[stage] * 100 : 0.0, callSites);
+        }
+    }
+    return rates;
+}
+
+// Базовая линия: строки "набор стадия МБ/с"
+using Baseline = std::map<std::string, double>;
+
+Baseline
+loadBaseline (const std::string& path)
+{
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot read baseline " + path);
+    Baseline baseline;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string preset, stage;
+        double rate;
+        if (fields >> preset >> stage >> rate) baseline[preset + " " + stage] = rate;
+    }
+    return baseline;
+}
+
+void
+saveBaseline (const std::string& path, const Baseline& baseline)
+{
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("cannot write baseline " + path);
+    out << "# bench/throughput_bench: preset stage MB/s (make bench_baseline)\n";
+    for (const auto& entry : baseline) {
+        char rate[32];
+        std::snprintf(rate, sizeof(rate), "%.3f", entry.second);
+        out << entry.first << " " << rate << "\n";
+    }
+}
+
+void
+usage ()
+{
+    std::fprintf(stderr,
+        "usage: throughput_bench [--preset NAME] [--functions N] [--depth N] [--expr N]\n"
+        "                        [--loops P] [--seed N] [--repeat N] [--emit]\n"
+        "                        [--save FILE] [--baseline FILE] [--check] [--tolerance P]\n");
+}
+
+} // namespace
+
+int
+main (int argc, char** argv)
+{
+    std::vector<Preset> presets = defaultPresets();
+    std::string only;
+    GeneratorOptions custom;
+    bool isCustom = false;
+    uint64_t seed = 1;
+    int repeat = 5;
+    bool emit = false;
+    bool check = false;
+    double tolerance = 0.2;
+    std::string savePath, baselinePath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                usage();
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--preset") only = value();
+        else if (arg == "--functions") { custom.functions = std::atoi(value()); isCustom = true; }
+        else if (arg == "--depth") { custom.depth = std::atoi(value()); isCustom = true; }
+        else if (arg == "--expr") { custom.expressionSize = std::atoi(value()); isCustom = true; }
+        else if (arg == "--loops") { custom.loopDensity = std::atof(value()); isCustom = true; }
+        else if (arg == "--seed") seed = std::strtoull(value(), nullptr, 10);
+        else if (arg == "--repeat") repeat = std::atoi(value());
+        else if (arg == "--emit") emit = true;
+        else if (arg == "--save") savePath = value();
+        else if (arg == "--baseline") baselinePath = value();
+        else if (arg == "--check") check = true;
+        else if (arg == "--tolerance") tolerance = std::atof(value());
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (repeat < 1) repeat = 1;
+
+    if (isCustom) {
+        presets = { { "custom", custom } };
+    }
+    else if (!only.empty()) {
+        std::vector<Preset> selected;
+        for (const Preset& preset : presets) {
+            if (preset.name == only) selected.push_back(preset);
+        }
+        if (selected.empty()) {
+            std::fprintf(stderr, "unknown preset %s\n", only.c_str());
+            return 2;
+        }
+        presets = selected;
+    }
+    for (Preset& preset : presets) preset.options.seed = seed;
+
+    if (emit) {
+        for (const Preset& preset : presets) std::fputs(generateProgram(preset.options).c_str(), stdout);
+        return 0;
+    }
+
+    try {
+        Baseline baseline;
+        if (!baselinePath.empty()) baseline = loadBaseline(baselinePath);
+
+        Baseline current;
+        int regressions = 0;
+        for (const Preset& preset : presets) {
+            const GeneratorOptions& options = preset.options;
+            std::string code = generateProgram(options);
+            std::printf("%s: %d functions, depth %d, expr %d, loops %.2f, seed %llu - %.1f KB\n",
+                        preset.name.c_str(), options.functions, options.depth, options.expressionSize,
+                        options.loopDensity, (unsigned long long) options.seed, code.size() / 1024.0);
+
+            std::map<std::string, double> rates = measure(code, repeat);
+            for (const char* stage : stages) {
+                std::string key = preset.name + " " + stage;
+                current[key] = rates[stage];
+
+                auto found = baseline.find(key);
+                if (found == baseline.end()) continue;
+                double change = rates[stage] / found->second - 1;
+                bool regressed = change < -tolerance;
+                if (regressed) ++regressions;
+                std::printf("  %-9s %+7.1f%% vs baseline%s\n", stage, change * 100,
+                            !regressed ? "" : check ? "  REGRESSION" : "  slower");
+            }
+            std::printf("\n");
+        }
+
+        if (!savePath.empty()) {
+            // Наборы, не замеренные сейчас, остаются из прежнего файла
+            Baseline merged;
+            if (std::ifstream(savePath)) merged = loadBaseline(savePath);
+            for (const auto& entry : current) merged[entry.first] = entry.second;
+            saveBaseline(savePath, merged);
+            std::printf("baseline saved to %s\n", savePath.c_str());
+        }
+        if (!baseline.empty()) {
+            std::printf("%d stage(s) slower than baseline by more than %.0f%%\n", regressions, tolerance * 100);
+        }
+        return check && regressions ? 1 : 0;
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "error: %s\n", e.what());
+        return 1;
+    }
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -6,8 +7,13 @@
 #include <ostream>
 #include <iostream>
 
+#include "instrument.h"
+
 // Базовые узлы AST
 struct ASTNode {
+#ifdef C2PY_INSTRUMENT
+    ASTNode() { C2PY_COUNT(Nodes, 1); }
+#endif
     virtual ~ASTNode() = default;
     int line = 0;
     int column = 0;
@@ -106,6 +112,9 @@ struct FunctionDecl : ASTNode {
     std::string name;
     std::vector<std::pair<std::string,std::string>> params; // pair<type,name>
     std::unique_ptr<BlockStmt> body;
+    // Хеш токенов функции (позиции - относительно её начала);
+    // 0 - тело не соответствует исходному тексту (изменено после разбора)
+    uint64_t tokenHash = 0;
 };
 
 struct Program : ASTNode {
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Байт-код и формат marshal CPython 3.11 - основа для вывода .pyc.
+ *
+ * Версия зафиксирована: номера опкодов, кеш-слоты после инструкций, формат
+ * таблицы строк и поля объекта кода меняются в каждой версии CPython. Файл
+ * загружается только интерпретатором 3.11 (магическое число pycMagic).
+ *
+ * BytecodeAssembler принимает инструкции с метками переходов и собирает
+ * объект кода: подбирает направление и длину переходов (EXTENDED_ARG),
+ * вставляет кеш-слоты, вычисляет глубину стека и таблицу строк.
+ * MarshalWriter сериализует объект кода так же, как marshal.dumps().
+ */
+
+// Опкоды CPython 3.11, используемые генератором
+enum class PyOp : uint8_t {
+    CACHE = 0,
+    POP_TOP = 1,
+    PUSH_NULL = 2,
+    NOP = 9,
+    UNARY_POSITIVE = 10,
+    UNARY_NEGATIVE = 11,
+    UNARY_NOT = 12,
+    UNARY_INVERT = 15,
+    GET_ITER = 68,
+    RETURN_VALUE = 83,
+    STORE_NAME = 90,
+    FOR_ITER = 93,
+    SWAP = 99,
+    LOAD_CONST = 100,
+    LOAD_NAME = 101,
+    LOAD_ATTR = 106,
+    COMPARE_OP = 107,
+    IMPORT_NAME = 108,
+    JUMP_FORWARD = 110,
+    JUMP_IF_FALSE_OR_POP = 111,
+    JUMP_IF_TRUE_OR_POP = 112,
+    POP_JUMP_FORWARD_IF_FALSE = 114,
+    POP_JUMP_FORWARD_IF_TRUE = 115,
+    LOAD_GLOBAL = 116,
+    COPY = 120,
+    BINARY_OP = 122,
+    LOAD_FAST = 124,
+    STORE_FAST = 125,
+    MAKE_FUNCTION = 132,
+    JUMP_BACKWARD = 140,
+    EXTENDED_ARG = 144,
+    RESUME = 151,
+    PRECALL = 166,
+    CALL = 171,
+    POP_JUMP_BACKWARD_IF_FALSE = 175,
+    POP_JUMP_BACKWARD_IF_TRUE = 176,
+};
+
+// Аргумент BINARY_OP (NB_*); составные присваивания - со смещением NB_INPLACE
+enum PyBinaryOp {
+    NB_ADD = 0,
+    NB_AND = 1,
+    NB_FLOOR_DIVIDE = 2,
+    NB_LSHIFT = 3,
+    NB_MULTIPLY = 5,
+    NB_REMAINDER = 6,
+    NB_OR = 7,
+    NB_RSHIFT = 9,
+    NB_SUBTRACT = 10,
+    NB_XOR = 12,
+    NB_INPLACE = 13
+};
+
+// Аргумент COMPARE_OP - индекс в dis.cmp_op
+enum PyCompareOp { CMP_LT = 0, CMP_LE, CMP_EQ, CMP_NE, CMP_GT, CMP_GE };
+
+// Флаги объекта кода функции
+const int CO_OPTIMIZED = 0x1;
+const int CO_NEWLOCALS = 0x2;
+
+// Первые 4 байта .pyc для CPython 3.11 (importlib.util.MAGIC_NUMBER)
+extern const char pycMagic[4];
+
+struct PyCode;
+
+// Константа объекта кода
+struct PyConst {
+    enum Kind { None, False, True, Int, Float, String, Code };
+
+    Kind kind = None;
+    long long intValue = 0;
+    double floatValue = 0;
+    std::string text;
+    std::shared_ptr<const PyCode> code;
+
+    static PyConst makeInt(long long value);
+    static PyConst makeFloat(double value);
+    static PyConst makeString(const std::string& text);
+    static PyConst makeBool(bool value);
+    static PyConst makeCode(std::shared_ptr<const PyCode> code);
+
+    // Совпадение для co_consts: 1, 1.0 и True - разные константы
+    bool sameAs(const PyConst& other) const;
+};
+
+// Объект кода (поля в порядке marshal)
+struct PyCode {
+    int argCount = 0;
+    int stackSize = 0;
+    int flags = 0;
+    std::string code;                   // Инструкции вместе с кеш-слотами
+    std::vector<PyConst> consts;
+    std::vector<std::string> names;     // co_names: глобальные имена и атрибуты
+    std::vector<std::string> varNames;  // Параметры, затем остальные локальные
+    std::string fileName;
+    std::string name;
+    std::string qualName;
+    int firstLine = 1;
+    std::string lineTable;
+};
+
+class BytecodeAssembler {
+public:
+    using Label = size_t;
+
+    // Переходы; направление (FORWARD/BACKWARD) выбирается при сборке
+    enum Jump { Always, IfFalse, IfTrue, IfFalseOrPop, IfTrueOrPop, ForIter };
+
+    BytecodeAssembler(const std::string& name, const std::string& fileName, int firstLine);
+
+    Label newLabel();
+    void bind(Label label);
+
+    void emit(PyOp op, int arg = 0);
+    void emitJump(Jump kind, Label target);
+
+    // Строка исходника для следующих инструкций; 0 - без строки
+    void setLine(int line) { currentLine = line; }
+    int line() const { return currentLine; }
+
+    int addConst(const PyConst& value);
+    int addName(const std::string& name);
+    int addLocal(const std::string& name);     // Индекс для LOAD_FAST/STORE_FAST
+    int findLocal(const std::string& name) const;   // -1, если не локальная
+
+    // Последняя инструкция не передаёт управление дальше (return, переход)
+    bool endsBlock() const;
+
+    // Собрать объект кода; argCount первых локальных - параметры
+    PyCode assemble(int argCount, int flags);
+
+private:
+    struct Instr {
+        PyOp op;
+        int arg;
+        int line;
+        bool isJump;
+        Jump jump;
+        Label target;
+    };
+
+    std::vector<Instr> instrs;
+    std::vector<size_t> labels;         // Метка -> индекс инструкции
+    std::unordered_map<std::string, int> nameIndex;
+    std::unordered_map<std::string, int> localIndex;
+    PyCode result;
+    int currentLine = 0;
+
+    static constexpr size_t unbound = static_cast<size_t>(-1);
+
+    void resolveJumps(std::vector<size_t>& offsets);
+    int computeStackSize() const;
+    void encodeLineTable(const std::vector<size_t>& offsets);
+};
+
+// Сериализация в формате marshal 3.11 (версия 4)
+class MarshalWriter {
+public:
+    void writeCode(const PyCode& code);
+    void writeConst(const PyConst& value);
+
+    const std::string& data() const { return buffer; }
+    std::string take() { return std::move(buffer); }
+
+private:
+    std::string buffer;
+
+    void writeByte(uint8_t value) { buffer.push_back(static_cast<char>(value)); }
+    void writeInt32(int32_t value);
+    void writeLong(long long value);
+    void writeFloat(double value);
+    void writeString(const std::string& text, bool interned);
+    void writeBytes(const std::string& bytes);
+    void writeNames(const std::vector<std::string>& names);
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "ast.h"
+#include "dataflow.h"
+
+#include <vector>
+#include <unordered_map>
+
+/**
+ * CallGraph - граф вызовов программы.
+ *
+ * Рёбра записываются SemanticAnalyzer при разрешении вызовов (analyzeCall),
+ * после анализа всех функций граф завершается методом finalize():
+ * - компоненты сильной связности (алгоритм Тарьяна) дают рекурсию,
+ *   в том числе взаимную;
+ * - сводки функций распространяются от вызываемых к вызывающим.
+ *
+ * Функция чистая, если она не пишет в нелокальные переменные и не вызывает
+ * неизвестных (внешних) или нечистых функций: результат зависит только от аргументов.
+ * Вызов можно удалить или переставить, только если функция ещё и гарантированно
+ * завершается (нет циклов и рекурсии ни в ней, ни в вызываемых).
+ */
+
+struct FunctionSummary {
+    bool writesNonLocals = false;   // Запись в переменную, объявленную вне функции
+    bool callsUnknown = false;      // Вызов функции, не определённой в программе
+    bool hasLoops = false;
+    bool recursive = false;         // Входит в цикл графа вызовов
+    bool pure = false;
+    bool terminates = false;
+    int scc = -1;                   // Номер компоненты (в порядке: вызываемые раньше)
+};
+
+struct CallGraphStats {
+    size_t functions = 0;
+    size_t edges = 0;               // Различные пары (caller, callee)
+    size_t callSites = 0;
+    size_t sccs = 0;
+    double buildMicros = 0;         // Время записи рёбер и сводок и finalize()
+};
+
+class CallGraph {
+public:
+    void clear();
+
+    // Заполнение (вызывается из SemanticAnalyzer)
+    void addFunction(const FunctionDecl* func);
+    void addCall(const FunctionDecl* caller, const CallExpr* site, const FunctionDecl* callee);
+    void addUnknownCall(const FunctionDecl* caller, const CallExpr* site);
+    void setLocalEffects(const FunctionDecl* func, const FunctionDataflow& df);
+
+    // SCC и сводки; вызывать после анализа всех функций
+    void finalize();
+
+    // Запросы
+    const std::vector<const FunctionDecl*>& callees(const FunctionDecl* func) const;
+    const std::vector<const FunctionDecl*>& callers(const FunctionDecl* func) const;
+    const FunctionDecl* calleeOf(const CallExpr* site) const;
+    const FunctionSummary* summary(const FunctionDecl* func) const;
+
+    bool isRecursive(const FunctionDecl* func) const;
+    bool isPure(const FunctionDecl* func) const;
+
+    // Компоненты в обратном топологическом порядке: вызываемые раньше вызывающих
+    const std::vector<std::vector<const FunctionDecl*>>& sccs() const { return components; }
+
+    const CallGraphStats& stats() const { return buildStats; }
+
+    // Отладочный вывод
+    void print(std::ostream& os = std::cout) const;
+
+private:
+    struct Node {
+        std::vector<const FunctionDecl*> callees;
+        std::vector<const FunctionDecl*> callers;
+        FunctionSummary summary;
+    };
+
+    std::vector<const FunctionDecl*> order;     // Порядок объявления
+    std::unordered_map<const FunctionDecl*, Node> nodes;
+    std::unordered_map<const CallExpr*, const FunctionDecl*> sites;
+    std::vector<std::vector<const FunctionDecl*>> components;
+    CallGraphStats buildStats;
+
+    void findComponents();
+};
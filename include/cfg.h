@@ -0,0 +1,58 @@
+#pragma once
+
+#include "ast.h"
+
+#include <vector>
+#include <unordered_map>
+
+/**
+ * ControlFlowGraph - граф потока управления одной функции.
+ *
+ * Базовый блок хранит элементы в порядке выполнения: простые операторы
+ * (VarDecl, ExpressionStmt, ReturnStmt) и выражения, вычисляемые управляющими
+ * конструкциями (условия if/циклов, update цикла for).
+ * break/continue порождают рёбра к выходу/продолжению ближайшего цикла,
+ * return - к блоку exit.
+ */
+
+struct CFGBlock {
+    int id = 0;
+    std::vector<ASTNode*> items;
+    std::vector<int> succs;
+    std::vector<int> preds;
+};
+
+// Блоки, относящиеся к циклу
+struct CFGLoop {
+    int header = -1;            // Блок проверки условия
+    int exit = -1;              // Блок сразу после цикла
+    std::vector<int> blocks;    // Все блоки цикла (условие, тело, update)
+};
+
+class ControlFlowGraph {
+public:
+    std::vector<CFGBlock> blocks;
+    int entry = 0;
+    int exit = 1;
+
+    // Построить граф для тела функции
+    static ControlFlowGraph build(FunctionDecl* func);
+
+    // Блок, содержащий элемент (оператор или выражение-условие); -1, если нет
+    int blockOf(const ASTNode* item) const;
+
+    // Информация о цикле (WhileStmt/DoWhileStmt/ForStmt); nullptr, если нет
+    const CFGLoop* loopOf(const Statement* loop) const;
+
+    // В функции есть хотя бы один цикл
+    bool hasLoops() const { return !loops.empty(); }
+
+    // Отладочный вывод
+    void print(std::ostream& os = std::cout) const;
+
+private:
+    std::unordered_map<const ASTNode*, int> itemBlocks;
+    std::unordered_map<const Statement*, CFGLoop> loops;
+
+    friend class CFGBuilder;
+};
@@ -2,29 +2,67 @@
 
 #include "ast.h"
 #include "semantic.h"
+#include "code_sink.h"
+#include "source_map.h"
 
 #include <string>
-#include <sstream>
 #include <memory>
 #include <vector>
+#include <unordered_map>
 #include <unordered_set>
+#include <set>
 
 /**
  * CodeGenerator - генератор Python кода из аннотированного AST.
  * 
  * Трансляция C конструкций в Python:
  * - Управляющие конструкции: if, for, while, do-while -> Python эквиваленты
- * - Функции: main() -> if __name__ == "__main__"
+ * - Функции: main() -> def main() и sys.exit(main()) под if __name__ == "__main__"
  * - Типы данных: C типы игнорируются (Python динамическая типизация)
+ * - Функции не зависят друг от друга (временные _c2py_invN нумеруются в каждой
+ *   заново); с options.threads > 1 они генерируются в пуле потоков в свои
+ *   буферы и склеиваются в исходном порядке - результат тот же, что и в одном потоке
+ * - Строка собирается в переиспользуемом буфере (отступ - срез общей строки
+ *   пробелов) и передаётся в приёмник (CodeSink) одним вызовом; импорты
+ *   вставляются в заголовок в конце
+ * - По запросу строится карта исходника (SourceMap): для каждой строки вывода -
+ *   позиция оператора C, из которого она получена
  * - Операции: унарные, бинарные, составные
+ * - Переполнение int: маска только для операций, которые по анализу диапазонов
+ *   могут выйти за 32 бита
+ * - Инварианты циклов вычисляются один раз во временные _c2py_invN перед циклом
+ * - Хвостовые вызовы функции самой себя -> цикл while True с перепривязкой параметров
+ * - По запросу функции программы и range, вызываемые внутри циклов функции,
+ *   связываются с локальными именами _c2py_<имя> при входе: LOAD_FAST вместо
+ *   поиска в globals и builtins на каждой итерации. Выигрыш есть в CPython до
+ *   3.10; с 3.11 LOAD_GLOBAL кешируется и работает так же быстро
+ * - По запросу чистые рекурсивные функции с числовыми параметрами оборачиваются
+ *   в functools.lru_cache (fib, рекурсивное динамическое программирование);
+ *   обёртка добавляет кадр стека, и глубокая рекурсия раньше упирается в
+ *   sys.getrecursionlimit() - поэтому выключено по умолчанию
  */
 
+// Параметры генерации
+struct CodeGenOptions {
+    bool wrapIntegerOverflow = true;    // Эмулировать переполнение int, где оно возможно
+    bool hoistLoopInvariants = true;    // Выносить инвариантные выражения из циклов
+    bool convertTailCalls = true;       // Хвостовую рекурсию - в цикл
+    bool bindLoopGlobals = false;       // Функции и range, вызываемые в циклах, - в локальные имена
+    bool memoizePureRecursive = false;  // Кешировать результаты чистых рекурсивных функций
+    std::unordered_set<std::string> noMemoize;  // Функции, которые кешировать нельзя
+    size_t threads = 1;                 // Потоков генерации функций; 0 - по числу ядер
+};
+
 class CodeGenerator {
 private:
     const SemanticAnalyzer* semanticAnalyzer;  // Для доступа к аннотациям
-    std::ostringstream output;
+    CodeGenOptions options;
+    CodeSink* out = nullptr;            // Приёмник текущей генерации
+    SourceMap* sourceMap = nullptr;     // Карта текущей генерации, если запрошена
+    SourcePosition position;            // Оператор C, для которого пишутся строки
+    std::string line;                   // Собираемая строка, вместе с отступом
     int indentLevel;
-    const std::string indentStr = "    ";  // 4 пробела
+    static const size_t indentWidth = 4;
     
     // Флаги состояния
     bool inLoop = false;
@@ -32,42 +70,89 @@ private:
     bool hasReturn = false;
     std::string currentFunctionName = "";
     
+    // "return f(...)" текущей функции f вне циклов: тело обёрнуто в while True,
+    // вызов заменяется присваиванием параметров и continue
+    const FunctionDecl* currentFunction = nullptr;
+    std::unordered_set<const ReturnStmt*> tailCalls;
+    
+    // Вложенные циклы: что выполнить перед continue
+    struct LoopContext {
+        Expression* update;             // update цикла for, транслированного в while
+        Expression* doWhileCondition;   // Условие do-while
+    };
+    std::vector<LoopContext> loopStack;
+    
+    // Вынесенные из циклов выражения -> имена временных переменных
+    std::unordered_map<const Expression*, std::string> hoisted;
+    int hoistedCount = 0;
+    
     // Импорты, необходимые для программы
-    std::unordered_set<std::string> requiredImports;
+    std::set<std::string> requiredImports;
     
     // Вспомогательные методы
-    std::string getIndent() const;
     void increaseIndent();
     void decreaseIndent();
-    void emitLine(const std::string& line);
+    void emitLine(const std::string& text);
+    
+    // Вывод по частям в буфер строки: beginLine() - отступ,
+    // endLine() - перевод строки и передача строки в приёмник
+    void write(const std::string& text);
+    void write(const char* text);
+    void write(char c);
+    void beginLine();
+    void endLine();
+    void setPosition(const ASTNode* node);  // Узел без позиции её не меняет
     
-    // Генерация выражений
-    std::string generateExpression(Expression* expr);
-    std::string generateNumber(NumberExpr* expr);
-    std::string generateIdentifier(IdentifierExpr* expr);
-    std::string generateUnary(UnaryExpr* expr);
-    std::string generateBinary(BinaryExpr* expr);
-    std::string generateCall(CallExpr* expr);
+    // Генерация выражений (пишут в текущую строку)
+    void generateExpression(Expression* expr);
+    void generateNumber(NumberExpr* expr);
+    void generateIdentifier(IdentifierExpr* expr);
+    void generateUnary(UnaryExpr* expr);
+    void generateBinary(BinaryExpr* expr);
+    void generateCall(CallExpr* expr);
+    
+    // Скобки по приоритетам Python и эмуляция переполнения
+    int precedenceOf(Expression* expr) const;
+    void generateOperand(Expression* expr, int minPrecedence);
+    bool needsWrap(const Expression* expr) const;
+    void beginWrap();
+    void endWrap();
     
     // Трансляция операторов
-    std::string translateUnaryOp(const std::string& op);
-    std::string translateBinaryOp(const std::string& op);
+    const char* translateUnaryOp(const std::string& op);
+    const char* translateBinaryOp(const std::string& op);
     
     // Генерация операторов
     void generateStatement(Statement* stmt);
     void generateVarDecl(VarDecl* decl);
     void generateExpressionStmt(ExpressionStmt* stmt);
     void generateBlock(BlockStmt* block);
+    void generateBody(Statement* stmt);  // Тело if/цикла, пустое -> pass
     void generateIf(IfStmt* stmt);
     void generateWhile(WhileStmt* stmt);
     void generateDoWhile(DoWhileStmt* stmt);
+    void generateDoWhileExit(Expression* condition);
     void generateFor(ForStmt* stmt);
+    void generateRangeFor(ForStmt* stmt, const InductionVariable& iv);
+    void generateRangeStop(const InductionVariable& iv);
+    void hoistInvariants(Statement* loop);  // Временные для инвариантов перед циклом
     void generateReturn(ReturnStmt* stmt);
+    void generateTailCall(CallExpr* call);
+    void collectTailCalls(Statement* stmt, const FunctionDecl* func);
+    bool isSelfCall(const Expression* expr, const FunctionDecl* func) const;
+    bool shouldMemoize(const FunctionDecl* func) const;
     void generateBreak(BreakStmt* stmt);
     void generateContinue(ContinueStmt* stmt);
     
+    // Глобальные имена, читаемые в циклах функции, -> локальные псевдонимы
+    std::unordered_map<std::string, std::string> localAliases;
+    void bindLoopGlobals(Statement* body, bool bodyIsLoop);
+    void collectLoopGlobals(Statement* stmt, bool inLoop, std::set<std::string>& names);
+    void collectLoopGlobals(Expression* expr, std::set<std::string>& names);
+    
     // Генерация функций
     void generateFunctionDecl(FunctionDecl* func);
+    void generateParallel(const std::vector<FunctionDecl*>& functions, size_t threads);
     void generateMainFunction();
     
     // Утилиты
@@ -76,19 +161,23 @@ private:
     std::string getPythonType(const std::string& cType);
 
 public:
-    CodeGenerator(const SemanticAnalyzer* analyzer = nullptr);
+    CodeGenerator(const SemanticAnalyzer* analyzer = nullptr,
+                  const CodeGenOptions& options = CodeGenOptions());
     
     /**
      * Главный метод генерации кода.
      * @param program AST программы
+     * @param sourceMap если задана - заполняется позициями C строк результата
      * @return Строка с Python кодом
      */
-    std::string generate(const Program* program);
+    std::string generate(const Program* program, SourceMap* sourceMap = nullptr);
     
     /**
-     * Получить сгенерированный код
+     * Генерация в приёмник: код дописывается по мере обхода AST,
+     * импорты - в заголовок в конце. Строки карты считаются от начала
+     * вывода генератора.
      */
-    std::string getOutput() const { return output.str(); }
+    void generate(const Program* program, CodeSink& sink, SourceMap* sourceMap = nullptr);
     
     /**
      * Очистить состояние генератора
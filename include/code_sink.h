@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+/**
+ * CodeSink - приёмник сгенерированного кода.
+ *
+ * CodeGenerator дописывает в приёмник фрагменты строк по мере обхода AST,
+ * не собирая промежуточных строк для выражений и всего файла.
+ *
+ * Импорты становятся известны только в конце генерации, поэтому перед выводом
+ * кода генератор отмечает место заголовка (reserveHeader), а в конце заполняет
+ * его (fillHeader). Приёмник вставляет заголовок на место сам: строка сдвигает
+ * содержимое в своём буфере.
+ */
+
+class CodeSink {
+public:
+    virtual ~CodeSink() = default;
+
+    virtual void append(const char* data, size_t size) = 0;
+    void append(const std::string& text) { append(text.data(), text.size()); }
+    void append(char c) { append(&c, 1); }
+
+    // Сколько байт дописано (без заголовка)
+    virtual size_t size() const = 0;
+
+    // Место заголовка - текущая позиция; заполняется один раз
+    virtual void reserveHeader() = 0;
+    virtual void fillHeader(const std::string& header) = 0;
+
+    // Отдать накопленный вывод получателю
+    virtual void flush() {}
+};
+
+// Растущий буфер в памяти
+class StringSink : public CodeSink {
+private:
+    std::string buffer;
+    size_t headerPos = 0;
+    size_t headerSize = 0;
+
+public:
+    explicit StringSink(size_t capacity = 0) { buffer.reserve(capacity); }
+
+    // Писать в память готовой строки: содержимое стирается, ёмкость остаётся
+    explicit StringSink(std::string&& storage) : buffer(std::move(storage)) { buffer.clear(); }
+
+    void append(const char* data, size_t size) override { buffer.append(data, size); }
+    using CodeSink::append;
+
+    size_t size() const override { return buffer.size() - headerSize; }
+
+    void reserveHeader() override { headerPos = buffer.size(); }
+    void fillHeader(const std::string& header) override;
+
+    const std::string& str() const { return buffer; }
+
+    // Забрать результат без копирования; приёмник становится пустым
+    std::string take();
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "ast.h"
+#include "cfg.h"
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+/**
+ * Анализ потоков данных над ControlFlowGraph.
+ *
+ * DataflowSolver - обобщённый итеративный решатель (worklist) для задач вида
+ *     OUT = gen ∪ (IN − kill)
+ * на битовых множествах. Направление и операция слияния задаются задачей.
+ * Первые клиенты - достигающие определения и живые переменные.
+ */
+
+// Множества до 128 элементов (переменные и определения почти любой
+// функции) хранятся в самом объекте: блоков много, и у каждого по
+// нескольку множеств на задачу - без выделения памяти на каждое
+class BitVector {
+public:
+    BitVector() = default;
+    explicit BitVector(size_t size, bool value = false);
+
+    size_t size() const { return bits; }
+    bool test(size_t i) const { return (data()[i / 64] >> (i % 64)) & 1u; }
+    void set(size_t i) { data()[i / 64] |= (uint64_t(1) << (i % 64)); }
+    void reset(size_t i) { data()[i / 64] &= ~(uint64_t(1) << (i % 64)); }
+    bool any() const;
+
+    BitVector& operator|=(const BitVector& other);
+    BitVector& operator&=(const BitVector& other);
+    BitVector& subtract(const BitVector& other);   // this = this − other
+
+    bool operator==(const BitVector& other) const;
+    bool operator!=(const BitVector& other) const { return !(*this == other); }
+
+private:
+    static const size_t localWords = 2;
+
+    size_t bits = 0;
+    size_t words = 0;
+    uint64_t local[localWords] = {};
+    std::vector<uint64_t> heap;         // Только для множеств больше local
+
+    uint64_t* data() { return words > localWords ? heap.data() : local; }
+    const uint64_t* data() const { return words > localWords ? heap.data() : local; }
+};
+
+// Задача потока данных в форме gen/kill
+struct DataflowProblem {
+    enum Direction { Forward, Backward };
+    enum Meet { Union, Intersection };
+
+    Direction direction = Forward;
+    Meet meet = Union;
+    size_t width = 0;               // Размер битовых множеств
+    std::vector<BitVector> gen;     // По блокам
+    std::vector<BitVector> kill;    // По блокам
+    BitVector boundary;             // IN[entry] (или OUT[exit] для обратных задач)
+};
+
+struct DataflowResult {
+    std::vector<BitVector> in;
+    std::vector<BitVector> out;
+    int iterations = 0;             // Сколько раз вычислялась передаточная функция
+};
+
+class DataflowSolver {
+public:
+    static DataflowResult solve(const ControlFlowGraph& cfg, const DataflowProblem& problem);
+};
+
+/* ===== Определения и использования переменных ===== */
+
+// Точка определения: VarDecl, параметр, присваивание или ++/--
+struct Definition {
+    const ASTNode* site = nullptr;
+    const ASTNode* var = nullptr;   // Объявление переменной (VarDecl)
+    int block = -1;
+};
+
+/**
+ * FunctionDataflow - результаты анализа одной функции:
+ * граф, достигающие определения, живые переменные и цепочки def-use.
+ */
+class FunctionDataflow {
+public:
+    ControlFlowGraph cfg;
+
+    std::vector<Definition> definitions;
+    std::vector<const ASTNode*> variables;              // Индекс -> объявление
+
+    DataflowResult reaching;    // По индексам definitions
+    DataflowResult liveness;    // По индексам variables
+
+    // Цепочки use-def и def-use (индексы в definitions)
+    std::unordered_map<const IdentifierExpr*, std::vector<int>> useDefs;
+    std::vector<std::vector<const IdentifierExpr*>> defUses;
+
+    // Построить граф и решить задачи для функции.
+    // params - объявления параметров (определены на входе в функцию)
+    static FunctionDataflow analyze(FunctionDecl* func,
+                                    const std::vector<const ASTNode*>& params);
+
+    int variableIndex(const ASTNode* var) const;
+
+    // Определения, достигающие использования переменной
+    const std::vector<int>* reachingDefs(const IdentifierExpr* use) const;
+
+    // Переменная записывается где-либо внутри цикла (условие, тело, update)
+    bool isModifiedInLoop(const ASTNode* var, const Statement* loop) const;
+
+    // Переменная жива сразу после выхода из цикла
+    bool isLiveAfterLoop(const ASTNode* var, const Statement* loop) const;
+
+private:
+    std::unordered_map<const ASTNode*, int> varIndex;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "ast.h"
+
+#include <bitset>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Структурированные диагностики семантического анализа.
+ *
+ * Диагностика хранит код, позицию и аргументы; текст сообщения строится
+ * только при выводе (format). Строковые аргументы копируются в общий пул,
+ * поэтому сообщение не зависит от времени жизни AST, а добавление
+ * диагностики не выделяет память на каждое сообщение.
+ * Подавленные коды отбрасываются до записи аргументов.
+ */
+
+enum class DiagCode : uint8_t {
+    // Ошибки
+    Fatal,
+    UnknownStatement,
+    UndeclaredIdentifier,
+    UndefinedFunction,
+    NotAFunction,
+    IfConditionNotBool,
+    WhileConditionNotBool,
+    ForConditionNotBool,
+    DoWhileConditionNotBool,
+    NotOperandNotBool,
+    NegateOperandNotNumeric,
+    IncDecOperandNotLValue,
+    IncDecOperandNotNumeric,
+    BreakOutsideLoop,
+    ContinueOutsideLoop,
+    AssignToNonLValue,
+    LogicalLhsNotBool,
+    LogicalRhsNotBool,
+    ArithmeticLhsNotNumeric,
+    ArithmeticRhsNotNumeric,
+    ReturnWithoutValue,
+    TypeMismatch,
+    MainWithParameters,
+    // Предупреждения
+    MissingReturn,
+
+    Count
+};
+
+enum class Severity : uint8_t { Error, Warning };
+
+struct Diagnostic {
+    DiagCode code;
+    Severity severity;
+    uint8_t argCount = 0;
+    int line = 0;
+    int column = 0;
+    uint32_t argOffset = 0;     // Начало аргументов в пуле DiagnosticEngine
+};
+
+class DiagnosticEngine {
+public:
+    // Удалить накопленные диагностики (подавления сохраняются)
+    void clear();
+
+    // Добавить диагностику; аргументы подставляются в шаблон сообщения по порядку
+    void report(DiagCode code, const ASTNode* node,
+                std::initializer_list<std::string_view> args = {});
+
+    // Скопировать диагностику из другого набора со сдвигом строки
+    void append(const DiagnosticEngine& from, const Diagnostic& diag, int lineDelta = 0);
+
+    void suppress(DiagCode code, bool suppressed = true) { this->suppressed[(size_t)code] = suppressed; }
+    bool isSuppressed(DiagCode code) const { return suppressed[(size_t)code]; }
+
+    const std::vector<Diagnostic>& all() const { return diagnostics; }
+    size_t errorCount() const { return errors; }
+    size_t warningCount() const { return diagnostics.size() - errors; }
+
+    // i-й строковый аргумент диагностики
+    std::string_view argument(const Diagnostic& diag, size_t i) const;
+
+    // Полный текст: "Semantic error at line L:C - ..." / "Warning at line L:C - ..."
+    std::string format(const Diagnostic& diag) const;
+
+    static Severity severityOf(DiagCode code);
+    static const char* nameOf(DiagCode code);               // Например "undeclared-identifier"
+    static bool codeFromName(std::string_view name, DiagCode& code);
+
+private:
+    std::vector<Diagnostic> diagnostics;
+    std::string pool;           // Аргументы, разделённые '\0'
+    size_t errors = 0;
+    std::bitset<(size_t)DiagCode::Count> suppressed;
+};
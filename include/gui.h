@@ -5,6 +5,7 @@
 #include <FL/Fl_Double_Window.H>
 #include <FL/Fl_Text_Display.H>
 #include <FL/Fl_Button.H>
+#include <FL/Fl_Box.H>
 extern void ui_translate(Fl_Button*, void*);
 extern void ui_import(Fl_Button*, void*);
 extern void ui_export(Fl_Button*, void*);
@@ -14,6 +15,7 @@ public:
   Fl_Double_Window* make_window();
   Fl_Text_Display* input_window;
   Fl_Text_Display* output_window;
+  Fl_Box* status_box;
   // Fl_Text_Editor* input_window;
   // include FL/Fl_Text_Editor
 };
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "ast.h"
+#include "dataflow.h"
+
+#include <unordered_map>
+
+class SemanticAnalyzer;
+
+/**
+ * Анализ индуктивных переменных циклов for.
+ *
+ * Цикл вида
+ *     for (i = X; i < Y; i += k)      (также int i = X, <=, >, >=, ++, --, -=, i = i ± k)
+ * можно транслировать в "for i in range(...)", если:
+ * - i и границы целочисленные, шаг k - ненулевая константа нужного знака;
+ * - i не записывается в теле и условии (только в update);
+ * - Y не имеет побочных эффектов и не меняется внутри цикла.
+ * Если значение i нужно после цикла, допускается только шаг ±1:
+ * генератор восстанавливает итоговое значение i в ветке else.
+ */
+
+struct InductionVariable {
+    const ASTNode* var = nullptr;       // Объявление переменной цикла
+    Expression* start = nullptr;        // X; nullptr, если init отсутствует (старт - текущее i)
+    Expression* bound = nullptr;        // Y
+    long long step = 1;                 // k (со знаком)
+    bool inclusive = false;             // Условие <= или >=
+    bool liveAfterLoop = false;         // Значение i читается после цикла
+};
+
+class InductionAnalysis {
+public:
+    // Найти индуктивные переменные всех циклов for функции
+    static void analyzeFunction(FunctionDecl* func, const FunctionDataflow& df,
+                                const SemanticAnalyzer& sema,
+                                std::unordered_map<const ForStmt*, InductionVariable>& result);
+
+    // Проверить один цикл; false, если цикл не подходит
+    static bool analyzeLoop(ForStmt* loop, const FunctionDataflow& df,
+                            const SemanticAnalyzer& sema, InductionVariable& iv);
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "ast.h"
+#include "semantic.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Inliner - подстановка тел маленьких функций в места вызова.
+ *
+ * Вызов функции в CPython стоит десятки наносекунд, а транслированный C код часто
+ * вызывает в горячих циклах крошечные помощники вроде square(x). Подставляются
+ * функции-листья графа вызовов (не рекурсивные, без вызовов внутри) вида
+ *     T f(params) { T1 l1 = e1; ... return e; }
+ * где инициализаторы и e не имеют побочных эффектов, а размер тела не больше порога.
+ *
+ * Аргумент подставляется в тело напрямую, если это число или переменная, либо
+ * выражение без эффектов, которое тело читает не больше одного раза. Иначе аргумент
+ * и локальные переменные вычисляются во временные _c2py_inlN_<имя>, объявляемые
+ * перед оператором с вызовом, - только если вызов вычисляется безусловно и ровно
+ * один раз при выполнении оператора (не в условии цикла и не справа от && и ||).
+ * Типы аргументов должны совпадать с типами параметров: неявные преобразования
+ * C при подстановке потерялись бы.
+ *
+ * После подстановки программу нужно проанализировать заново; ставшие ненужными
+ * функции удаляет Optimizer.
+ */
+
+struct InlinerOptions {
+    bool enabled = true;        // Выключатель прохода
+    int maxSize = 16;           // Наибольшее число узлов выражений в теле функции
+};
+
+struct InlinerStats {
+    int candidates = 0;         // Функций, пригодных для подстановки
+    int inlinedCalls = 0;
+
+    bool changed() const { return inlinedCalls != 0; }
+};
+
+class Inliner {
+private:
+    const SemanticAnalyzer& semanticAnalyzer;
+    InlinerOptions options;
+    InlinerStats stats;
+    int nextId = 0;             // Номер подстановки для имён временных
+
+    // Пригодная для подстановки функция
+    struct Candidate {
+        const FunctionDecl* func = nullptr;
+        std::vector<const VarDecl*> locals;
+        const Expression* result = nullptr;             // Выражение return
+        std::vector<TypeInfo> paramTypes;
+        std::unordered_map<std::string, int> uses;      // Чтения параметров и локальных
+    };
+    std::unordered_map<const FunctionDecl*, Candidate> candidates;
+
+    void collectCandidates(Program* program);
+    bool isCandidate(const FunctionDecl* func, Candidate& candidate) const;
+
+    // Обход с подстановкой; prelude - объявления, вставляемые перед текущим оператором
+    void inlineInBlock(BlockStmt* block);
+    void inlineInStatement(StmtPtr& slot);
+    void inlineInStatement(Statement* stmt, std::vector<StmtPtr>& prelude);
+    void inlineInExpression(ExprPtr& slot, std::vector<StmtPtr>& prelude, bool statementPosition);
+    bool inlineCall(ExprPtr& slot, const std::vector<TypeInfo>& argTypes,
+                    const std::vector<bool>& argEffects,
+                    std::vector<StmtPtr>& prelude, bool statementPosition);
+
+public:
+    explicit Inliner(const SemanticAnalyzer& analyzer, const InlinerOptions& options = InlinerOptions());
+
+    /**
+     * Подставить вызовы во всей программе (после успешного семантического анализа).
+     * @return Статистика изменений
+     */
+    InlinerStats inlineCalls(Program* program);
+};
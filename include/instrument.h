@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * Замеры фаз трансляции: время, выделения памяти и счётчики.
+ *
+ * Точки замера в коде - макросы:
+ *
+ *     C2PY_PHASE("lex");                  // до конца блока
+ *     C2PY_COUNT(Tokens, tokens.size());
+ *
+ * Без C2PY_INSTRUMENT (make -f Makefile_cli INSTRUMENT=1) макросы пусты:
+ * ни вызовов, ни вычисления аргументов C2PY_COUNT. С ним каждая фаза
+ * записывается событием в буфер своего потока (без блокировок), а замена
+ * operator new считает выделения потока: событие хранит их число и объём
+ * за время фазы, включая вложенные фазы.
+ *
+ * Результаты - после завершения трансляции, когда потоки больше не пишут:
+ * summary() - таблица по фазам и счётчики, chromeTrace() - JSON для
+ * chrome://tracing и Perfetto (события "X" по потокам, счётчики - "C").
+ */
+
+namespace instrument {
+
+enum class Counter {
+    Tokens,             // Токенов лексера
+    Nodes,              // Узлов AST, созданных парсером
+    ScopesPushed,       // Областей видимости в таблицах символов
+    LinesEmitted,       // Строк Python текста
+    BytesEmitted,
+    CallSites,          // Вызовов, записанных в граф вызовов
+    CallGraphMicros,    // Время построения графа вызовов, мкс
+    Count
+};
+
+const char* counterName(Counter counter);
+
+// Замер включён при сборке (C2PY_INSTRUMENT)
+bool enabled();
+
+// Фаза от конструктора до деструктора
+class Phase {
+public:
+    explicit Phase(const char* name);
+    ~Phase();
+
+    Phase(const Phase&) = delete;
+    Phase& operator=(const Phase&) = delete;
+
+private:
+    const char* name;
+    std::chrono::steady_clock::time_point start;
+    uint64_t allocations;
+    uint64_t allocatedBytes;
+};
+
+void count(Counter counter, uint64_t value);
+uint64_t counter(Counter counter);
+
+// Выделения памяти текущим потоком с его начала (0 без C2PY_INSTRUMENT)
+uint64_t threadAllocations();
+uint64_t threadAllocatedBytes();
+
+std::string summary();
+std::string chromeTrace();
+
+// Забыть события и счётчики
+void reset();
+
+} // namespace instrument
+
+#ifdef C2PY_INSTRUMENT
+#define C2PY_PHASE_NAME2(line) c2pyPhase##line
+#define C2PY_PHASE_NAME(line) C2PY_PHASE_NAME2(line)
+#define C2PY_PHASE(name) ::instrument::Phase C2PY_PHASE_NAME(__LINE__)(name)
+#define C2PY_COUNT(counter, value) ::instrument::count(::instrument::Counter::counter, (uint64_t) (value))
+#else
+#define C2PY_PHASE(name) ((void) 0)
+#define C2PY_COUNT(counter, value) ((void) 0)
+#endif
@@ -46,6 +46,13 @@ public:
      * \returns These tokens
     */
     std::vector<Token> tokenize();
+
+    /**
+     * \brief Same, into a caller's vector: its contents are replaced,
+     * its capacity is kept (Translator reuses one vector for many inputs)
+     * \param tokens Receives the tokens
+    */
+    void tokenize(std::vector<Token>& tokens);
 private:
     /**
      * \brief Takes a look at the current char in the source code
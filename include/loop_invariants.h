@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ast.h"
+#include "dataflow.h"
+
+#include <unordered_map>
+#include <vector>
+
+class SemanticAnalyzer;
+
+/**
+ * Вынос инвариантов из циклов (loop-invariant code motion).
+ *
+ * CPython не выносит вычисления из циклов, поэтому "while (i < n * m)" после
+ * трансляции пересчитывает n * m на каждой итерации. Анализ находит в условиях,
+ * телах и update циклов while, do-while и for максимальные подвыражения, которые:
+ * - не имеют побочных эффектов (с учётом сводок вызываемых функций);
+ * - читают только переменные, не записываемые внутри цикла (по def-use).
+ * Каждое выражение назначается самому внешнему циклу, относительно которого оно
+ * инвариантно; генератор вычисляет его во временную переменную перед этим циклом.
+ *
+ * Перед циклом выражение вычисляется, даже если в цикле до него не дойдёт,
+ * поэтому операции, способные завершиться исключением в Python (деление на
+ * неконстанту, вызовы), выносятся только из условия своего цикла while/for
+ * и только с безусловно вычисляемых позиций (не из правой части && и ||).
+ * Выражения без переменных не выносятся: константы сворачивает сам CPython.
+ */
+
+class LoopInvariantAnalysis {
+public:
+    /**
+     * Проанализировать функцию.
+     * @param result Цикл -> выражения, вычисляемые перед ним (в порядке обхода)
+     */
+    static void analyzeFunction(FunctionDecl* func, const FunctionDataflow& df,
+                                const SemanticAnalyzer& sema,
+                                std::unordered_map<const Statement*, std::vector<Expression*>>& result);
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "ast.h"
+#include "semantic.h"
+
+#include <string>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
+/**
+ * Optimizer - оптимизирующий проход по аннотированному AST перед генерацией кода.
+ *
+ * Удаляет:
+ * - неиспользуемые локальные переменные, все записи в которые не имеют побочных эффектов;
+ * - код после return/break/continue внутри блока;
+ * - ветки if с константным условием;
+ * - функции, недостижимые из main().
+ *
+ * Работает по результатам SemanticAnalyzer (hasSideEffects, связи IdentifierExpr::declaration),
+ * поэтому запускается после успешного семантического анализа.
+ */
+
+// Статистика выполненных преобразований
+struct OptimizerStats {
+    int removedVariables = 0;
+    int removedStatements = 0;
+    int foldedBranches = 0;
+    int removedFunctions = 0;
+
+    bool changed() const {
+        return removedVariables || removedStatements || foldedBranches || removedFunctions;
+    }
+};
+
+class Optimizer {
+private:
+    const SemanticAnalyzer& semanticAnalyzer;
+    OptimizerStats stats;
+
+    // Использование локальной переменной внутри функции
+    struct VarUsage {
+        int reads = 0;         // Чтения значения
+        int pureStores = 0;    // "x = <без побочных эффектов>;" отдельным оператором
+        int otherWrites = 0;   // Любые другие записи (вложенные, составные, с эффектами)
+    };
+    std::unordered_map<const ASTNode*, VarUsage> usage;
+    std::unordered_set<const VarDecl*> locals;
+    const ASTNode* currentStore = nullptr;  // Цель разбираемого "x = e;"
+
+    // Удаление неиспользуемых переменных
+    void removeUnusedVariables(FunctionDecl* func);
+    void collectUsage(Statement* stmt);
+    void collectUsage(Expression* expr, bool isStoreTarget = false);
+    bool removeDeadStores(Statement* stmt, const std::unordered_set<const ASTNode*>& dead);
+    bool isDeadStore(Statement* stmt, const std::unordered_set<const ASTNode*>& dead) const;
+
+    // Недостижимый код и константные условия
+    void simplifyStatement(StmtPtr& slot);
+    void simplifyBlock(BlockStmt* block);
+    bool terminates(const Statement* stmt) const;
+
+    // Недостижимые функции
+    void removeUnreachableFunctions(Program* program);
+    void collectCalls(const Statement* stmt, std::unordered_set<std::string>& callees) const;
+    void collectCalls(const Expression* expr, std::unordered_set<std::string>& callees) const;
+
+    bool hasSideEffects(Expression* expr) const;
+    static const ASTNode* storeTarget(const Expression* expr);
+
+public:
+    explicit Optimizer(const SemanticAnalyzer& analyzer);
+
+    /**
+     * Выполнить все преобразования над программой.
+     * @return Статистика изменений
+     */
+    OptimizerStats optimize(Program* program);
+
+    /**
+     * Вычислить константное значение выражения, если оно известно на этапе трансляции.
+     * Арифметика - int по модулю 2^32 (как с эмуляцией переполнения);
+     * / и % - только с неотрицательными операндами, где C и Python совпадают.
+     */
+    static std::optional<long long> evaluateConstant(const Expression* expr);
+};
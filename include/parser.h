@@ -16,10 +16,13 @@ public:
     // Разобрать программу; бросает std::runtime_error при синтаксической ошибке.
     ProgramPtr parseProgram();
 
+    // Забрать токены после разбора (вектор переиспользуется для следующего входа)
+    std::vector<Token> releaseTokens();
+
     friend class ParserTester;
     
 private:
-    const std::vector<Token> tokens;
+    std::vector<Token> tokens;
     size_t pos;
     SymbolTable symbols;
 
@@ -60,4 +63,5 @@ private:
 
     // Утилиты
     std::string tokenLocation() const;
+    uint64_t hashTokens(size_t begin, size_t end) const;
 };
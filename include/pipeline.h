@@ -0,0 +1,117 @@
+#pragma once
+
+#include "code_generator.h"
+#include "inliner.h"
+#include "semantic.h"
+#include "source_map.h"
+#include "symbol_table.h"
+#include "token.h"
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Конвейер трансляции одного исходника - то же, что делает окно по кнопке
+ * Translate: лексер -> парсер -> семантический анализ -> подстановка функций
+ * -> оптимизатор -> генератор (текст или .pyc).
+ *
+ * translateSource() создаёт объекты конвейера на время вызова, общего
+ * изменяемого состояния нет: разные исходники транслируются одновременно
+ * из разных потоков. Translator держит их между вызовами.
+ * Синтаксическая ошибка, ошибки анализа и неподдерживаемые генератором
+ * конструкции не бросаются, а возвращаются в TranslateResult::errors.
+ */
+
+struct TranslateOptions {
+    CodeGenOptions codegen;
+    InlinerOptions inliner;
+    bool optimize = true;               // Удаление мёртвого кода и свёртка ветвлений
+    bool bytecode = false;              // .pyc (PycGenerator) вместо текста
+    bool sourceMap = false;             // Заполнить TranslateResult::sourceMap (только текст)
+    std::string fileName = "<c2py>";    // Имя исходника в .pyc (трассировки)
+};
+
+struct TranslateResult {
+    bool ok = false;
+    std::string output;                 // Python код или содержимое .pyc
+    std::vector<std::string> errors;
+    std::vector<std::string> warnings;
+    SourceMap sourceMap;
+};
+
+// Фазы конвейера в порядке выполнения
+enum class TranslatePhase { Lex, Parse, Semantic, Inline, Optimize, Generate, Count };
+
+const char* phaseName(TranslatePhase phase);
+
+// Вызывается в начале каждой фазы и повторно внутри долгих (анализ -
+// между функциями); false - прервать трансляцию
+using TranslateProgress = std::function<bool(TranslatePhase phase)>;
+
+/**
+ * Translator - конвейер для многих входов подряд, для встраивания в сервисы.
+ *
+ * Состояние между входами не освобождается, а очищается: вектор токенов,
+ * таблица символов (с таблицами закрытых областей), карты аннотаций и
+ * потоков данных анализатора, буфер вывода генератора и сам результат
+ * сохраняют ёмкость, и трансляция похожих по размеру входов после первых
+ * почти не выделяет память на эти структуры. AST строится заново на
+ * каждый вход: его узлы принадлежат программе.
+ *
+ * Последняя проанализированная программа хранится до следующего входа:
+ * анализ - SemanticAnalyzer::reanalyze(), и функции с прежними токенами и
+ * сигнатурами зависимостей переносятся из неё без повторного анализа
+ * (правка одной функции в окне или повторная пакетная трансляция). Функции,
+ * изменённые подстановкой или оптимизатором, не переносятся. Анализ после
+ * подстановки и оптимизации - полный.
+ *
+ * Объект не потокобезопасен: по одному Translator на поток.
+ */
+class Translator {
+public:
+    using Result = TranslateResult;
+
+    explicit Translator(const TranslateOptions& options = TranslateOptions());
+
+    Translator(const Translator&) = delete;
+    Translator& operator=(const Translator&) = delete;
+
+    const TranslateOptions& options() const { return translateOptions; }
+
+    // Имя исходника в .pyc следующих входов; остальные параметры задаются
+    // при создании: от них зависит сохраняемое между входами состояние
+    void setFileName(const std::string& name) { translateOptions.fileName = name; }
+
+    // Результат действителен до следующего translate() или release().
+    // progress может прервать трансляцию (окно отменяет устаревший запрос):
+    // результат - ошибка "translation cancelled"
+    const Result& translate(std::string_view code, const TranslateProgress& progress = nullptr);
+
+    // Входы по очереди на одном состоянии; результаты принадлежат вызывающему
+    std::vector<Result> translate(const std::vector<std::string_view>& codes);
+
+    // Забрать последний результат (его буферы не переиспользуются)
+    Result release();
+
+    // Сколько функций последний translate() взял из прошлого входа без анализа
+    size_t reusedFunctions() const { return reused; }
+
+private:
+    TranslateOptions translateOptions;
+    std::string source;
+    std::vector<Token> tokens;
+    SymbolTable symbolTable;
+    SemanticAnalyzer analyzer;
+    CodeGenerator generator;
+    Result result;
+    ProgramPtr previous;            // Проанализирована последней; пусто - полный анализ
+    size_t reused = 0;
+
+    void cancelled();
+};
+
+// Однократная трансляция: Translator на один вход
+TranslateResult translateSource(const std::string& code,
+                                const TranslateOptions& options = TranslateOptions());
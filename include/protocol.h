@@ -0,0 +1,77 @@
+#pragma once
+
+#include "pipeline.h"
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Двоичное представление запросов и результатов трансляции.
+ *
+ * Результат (encodeResult) - тело записи TranslationCache и ответа сервера
+ * c2py-cli --serve. Запрос - параметры и исходный текст для сервера.
+ * Числа - little-endian u32; строка - длина u32 и байты; список - число
+ * элементов u32 и строки.
+ *
+ * Запрос:  u32 вид (RequestKind), u32 флаги (RequestFlag), имя файла, код,
+ *          с RequestMemoize - список функций, которые кешировать нельзя
+ * Ответ:   u32 ok, ошибки, предупреждения, вывод, u32 строк карты, mappings
+ *
+ * Через сокет запросы и ответы идут кадрами: u32 длина и тело. Соединение
+ * держит сколько угодно запросов подряд; ответ на каждый приходит до
+ * следующего запроса.
+ */
+
+enum class RequestKind : uint32_t {
+    Translate = 1,
+    Shutdown = 2,           // Остановить сервер; ответ - пустой ok
+};
+
+enum RequestFlag : uint32_t {
+    RequestBytecode = 1,
+    RequestSourceMap = 2,
+    RequestNoInline = 4,
+    RequestNoOptimize = 8,
+    RequestMemoize = 16,        // CodeGenOptions::memoizePureRecursive и noMemoize
+    RequestBindLoopGlobals = 32,
+};
+
+struct TranslateRequest {
+    RequestKind kind = RequestKind::Translate;
+    TranslateOptions options;   // Передаются флаги и имя файла, остальное - по умолчанию сервера
+    std::string code;
+};
+
+// Наибольший кадр; длиннее - ошибка протокола, а не попытка выделить 4 ГБ
+const uint32_t maxFrameSize = 256u << 20;
+
+void encodeResult(std::string& out, const TranslateResult& result);
+// Разбор с позиции pos; false - данные обрезаны или испорчены
+bool decodeResult(const std::string& data, size_t& pos, TranslateResult& result);
+
+std::string encodeRequest(const TranslateRequest& request);
+// Флаги накладываются на options, в которых request уже лежит
+bool decodeRequest(const std::string& data, TranslateRequest& request);
+
+#ifndef _WIN32
+
+// Кадр целиком; false - конец потока, ошибка или кадр длиннее maxFrameSize
+bool readFrame(int fd, std::string& payload);
+bool writeFrame(int fd, const std::string& payload);
+
+// Сокет сервера по умолчанию: $C2PY_SOCKET, $XDG_RUNTIME_DIR/c2py.sock
+// или /tmp/c2py-<uid>/c2py.sock
+std::string defaultSocketPath();
+
+// Каталог сокета принадлежит текущему пользователю и закрыт для остальных
+// (0700); create - создать недостающий. false - errno
+bool checkSocketDirectory(const std::string& socketPath, bool create);
+
+// Процесс на другом конце соединения - того же пользователя
+bool peerIsSameUser(int fd);
+
+// Соединение с сервером того же пользователя; -1 - нет сервера
+// или он чужой (errno EACCES)
+int connectSocket(const std::string& path);
+
+#endif
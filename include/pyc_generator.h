@@ -0,0 +1,115 @@
+#pragma once
+
+#include "ast.h"
+#include "semantic.h"
+#include "code_generator.h"
+#include "code_sink.h"
+#include "bytecode.h"
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * PycGenerator - генератор .pyc (байт-код CPython 3.11) из аннотированного AST.
+ *
+ * Альтернатива CodeGenerator для больших модулей: при импорте .pyc интерпретатор
+ * не разбирает и не компилирует Python текст. Программа ведёт себя так же, как
+ * текст CodeGenerator с теми же CodeGenOptions:
+ * - / -> //, && || ! -> and or not, маска переполнения int там же, где в тексте
+ * - for с индуктивной переменной -> range(), инварианты циклов - в _c2py_invN
+ * - хвостовой вызов функции самой себя -> присваивание параметров и переход
+ *   в начало функции
+ * - main() вызывается через sys.exit(main()) под if __name__ == "__main__"
+ * - memoizePureRecursive, bindLoopGlobals и threads не поддерживаются
+ *
+ * Условия if и циклов переводятся в переходы без вычисления значения (как это
+ * делает компилятор CPython), условие цикла проверяется в конце итерации.
+ * Номера строк в таблице строк - строки операторов C: трассировки и профили
+ * указывают в исходник без карты (SourceMap).
+ *
+ * Заголовок .pyc без проверки исходника (время и размер - 0): файл запускается
+ * как python3 prog.pyc или импортируется, если рядом нет prog.py.
+ * Неподдерживаемая конструкция - std::runtime_error.
+ */
+
+class PycGenerator {
+private:
+    const SemanticAnalyzer* semanticAnalyzer;
+    CodeGenOptions options;
+    std::string fileName;               // co_filename
+
+    BytecodeAssembler* as = nullptr;    // Код текущей функции
+    const FunctionDecl* currentFunction = nullptr;
+    BytecodeAssembler::Label functionStart = 0;     // Цель хвостовых вызовов
+    std::unordered_set<const ReturnStmt*> tailCalls;
+
+    // Вложенные циклы: куда переходят break и continue
+    struct LoopContext {
+        BytecodeAssembler::Label continueTarget;
+        BytecodeAssembler::Label breakTarget;
+        bool hasIterator;               // На стеке итератор range(): снять при выходе
+    };
+    std::vector<LoopContext> loopStack;
+
+    // Вынесенные из циклов выражения -> локальные _c2py_invN
+    std::unordered_map<const Expression*, int> hoisted;
+    int hoistedCount = 0;
+
+    // Выражения (оставляют значение на стеке)
+    void generateExpression(Expression* expr);
+    void generateNumber(NumberExpr* expr);
+    void generateUnary(UnaryExpr* expr);
+    void generateBinary(BinaryExpr* expr);
+    void generateCall(CallExpr* expr);
+    void generateAssignment(BinaryExpr* expr, bool keepValue);
+    void generateIncrement(UnaryExpr* expr, bool keepValue);
+    void generateEffect(Expression* expr);      // Выражение-оператор, значение не нужно
+    void generateWrap();
+    bool needsWrap(const Expression* expr) const;
+
+    // Переход на target, если значение условия равно onTrue
+    void generateBranch(Expression* cond, BytecodeAssembler::Label target, bool onTrue);
+
+    // Имена: локальная -> LOAD_FAST, иначе глобальная
+    void loadName(const std::string& name);
+    void storeName(const std::string& name);
+    void loadConst(const PyConst& value);
+    void setLine(const ASTNode* node);  // Строка узла для следующих инструкций
+    void collectLocals(Statement* stmt);
+    void collectLocals(Expression* expr);
+
+    // Операторы
+    void generateStatement(Statement* stmt);
+    void generateVarDecl(VarDecl* decl);
+    void generateIf(IfStmt* stmt);
+    void generateWhile(WhileStmt* stmt);
+    void generateDoWhile(DoWhileStmt* stmt);
+    void generateFor(ForStmt* stmt);
+    void generateRangeFor(ForStmt* stmt, const InductionVariable& iv);
+    void generateRangeStop(const InductionVariable& iv);
+    void hoistInvariants(Statement* loop);
+    void generateReturn(ReturnStmt* stmt);
+    void generateTailCall(CallExpr* call);
+    void collectTailCalls(Statement* stmt, const FunctionDecl* func);
+    bool isSelfCall(const Expression* expr, const FunctionDecl* func) const;
+    void generateBreak();
+    void generateContinue();
+
+    // Функции и модуль
+    PyCode generateFunction(FunctionDecl* func);
+    PyCode generateModule(const Program* program);
+
+public:
+    PycGenerator(const SemanticAnalyzer* analyzer = nullptr,
+                 const CodeGenOptions& options = CodeGenOptions());
+
+    /**
+     * Содержимое .pyc: заголовок и объект кода модуля в формате marshal.
+     * @param fileName имя исходника для трассировок (co_filename)
+     */
+    std::string generate(const Program* program, const std::string& fileName = "<c2py>");
+
+    void generate(const Program* program, CodeSink& sink, const std::string& fileName = "<c2py>");
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ast.h"
+#include "dataflow.h"
+
+#include <climits>
+#include <unordered_map>
+#include <unordered_set>
+
+class SemanticAnalyzer;
+
+/**
+ * Анализ диапазонов значений целочисленных переменных.
+ *
+ * В C арифметика int переполняется по модулю 2^32, в Python целые не ограничены,
+ * поэтому точная трансляция требует маскирования результата. Анализ находит
+ * операции (+, -, *, /, унарный -, ++/--, составные присваивания), которые при
+ * известных диапазонах операндов не выходят за границы int - для них маска не нужна.
+ *
+ * Анализ нечувствителен к потоку управления: диапазон переменной - объединение
+ * значений всех её определений, вычисляется итерациями до неподвижной точки
+ * с расширением до полного диапазона int. Параметры и результаты вызовов
+ * считаются произвольными int. В теле и update цикла for с индуктивной
+ * переменной учитывается условие цикла: тело и i++ выполняются только при
+ * i < Y, а в теле ни i, ни Y не меняются.
+ */
+
+struct ValueRange {
+    long long lo = 1;
+    long long hi = 0;           // lo > hi - пустой диапазон (значение ещё не известно)
+
+    ValueRange() = default;
+    ValueRange(long long l, long long h) : lo(l), hi(h) {}
+
+    static ValueRange full() { return ValueRange(INT_MIN, INT_MAX); }
+
+    bool empty() const { return lo > hi; }
+    bool fitsInt() const { return empty() || (lo >= INT_MIN && hi <= INT_MAX); }
+    bool contains(long long v) const { return lo <= v && v <= hi; }
+
+    ValueRange join(const ValueRange& other) const;
+
+    bool operator==(const ValueRange& other) const {
+        return (empty() && other.empty()) || (lo == other.lo && hi == other.hi);
+    }
+    bool operator!=(const ValueRange& other) const { return !(*this == other); }
+};
+
+class RangeAnalysis {
+public:
+    /**
+     * Проанализировать функцию.
+     * @param params Объявления параметров
+     * @param ranges Диапазоны целочисленных переменных (результат)
+     * @param overflowSites Операции, которые могут переполнить int (результат)
+     */
+    static void analyzeFunction(FunctionDecl* func, const FunctionDataflow& df,
+                                const std::vector<const ASTNode*>& params,
+                                const SemanticAnalyzer& sema,
+                                std::unordered_map<const ASTNode*, ValueRange>& ranges,
+                                std::unordered_set<const Expression*>& overflowSites);
+};
@@ -4,10 +4,18 @@
 
 #include "ast.h"
 #include "symbol_table.h"
+#include "dataflow.h"
+#include "induction.h"
+#include "call_graph.h"
+#include "range_analysis.h"
+#include "loop_invariants.h"
+#include "diagnostics.h"
 
+#include <functional>
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include <stdexcept>
 #include <iostream>
@@ -29,7 +37,7 @@ struct TypeInfo {
     TypeInfo() = default;
     TypeInfo(Kind k) : kind(k) {}
     
-    std::string toString() const {
+    const char* name() const {
         static const char* names[] = {
             "void", "int", "float", "double", "char", "bool",
             "unknown", "error", "string", "pointer", "array"
@@ -37,6 +45,8 @@ struct TypeInfo {
         return names[kind];
     }
     
+    std::string toString() const { return name(); }
+    
     bool isNumeric() const {
         return kind == Int || kind == Float || kind == Double || kind == Char;
     }
@@ -70,28 +80,75 @@ struct SemanticAnnotation {
     ASTNode* resolvedDecl = nullptr;
 };
 
+// Анализ прерван по запросу (SemanticAnalyzer::setInterrupt)
+struct AnalysisInterrupted {};
+
 // Главный класс семантического анализатора
 class SemanticAnalyzer {
 private:
     SymbolTable& symbolTable;  // Используем вашу существующую таблицу символов
-    std::vector<std::string> errors;
-    std::vector<std::string> warnings;
+    DiagnosticEngine diagnostics;
+    
+    // Текст диагностик строится только по запросу getErrors()/getWarnings()
+    mutable std::vector<std::string> errors;
+    mutable std::vector<std::string> warnings;
+    mutable bool diagnosticsFormatted = false;
+    void formatDiagnostics() const;
     
     // Контекст анализа
     TypeInfo currentReturnType;
     bool inLoop = false;
     bool inFunction = false;
+    bool inAssignmentTarget = false;  // Анализируем левую часть '='
     std::string currentFunctionName;
+    FunctionDecl* currentFunction = nullptr;
+    
+    // Результаты анализа одной функции, достаточные для её повторного
+    // использования в reanalyze() без обхода тела
+    struct FunctionRecord {
+        uint64_t tokenHash = 0;
+        std::vector<ASTNode*> nodes;                    // Узлы, аннотированные при анализе тела
+        std::vector<std::unique_ptr<VarDecl>> params;   // Объявления параметров
+        std::vector<const CallExpr*> calls;             // Для восстановления графа вызовов
+        std::vector<bool> callEffects;                  // Эффекты вызываемых функций при последнем уточнении
+        // Имена вне функции -> сигнатура функции, к которой они разрешились ("" - не найдено)
+        std::unordered_map<std::string, std::string> dependencies;
+        size_t diagBegin = 0, diagEnd = 0;              // Диагностики функции в DiagnosticEngine
+        int lineDelta = 0;                              // Сдвиг строк при переносе в новую программу
+    };
+    std::unordered_map<const FunctionDecl*, FunctionRecord> records;
+    FunctionRecord* currentRecord = nullptr;
+    
+    // Состояние повторного анализа
+    const Program* analyzedProgram = nullptr;
+    std::unordered_set<const FunctionDecl*> reusedFunctions;
+    DiagnosticEngine previousDiagnostics;
     
     // Карта аннотаций: ASTNode* -> SemanticAnnotation
     std::unordered_map<ASTNode*, SemanticAnnotation> annotations;
     
-    // Хранилище для временных VarDecl объектов параметров
-    std::vector<std::unique_ptr<VarDecl>> parameterDecls;
+    // Граф потока управления и потоки данных по функциям
+    std::unordered_map<const FunctionDecl*, FunctionDataflow> dataflow;
+    
+    // Индуктивные переменные циклов for, пригодных для range()
+    std::unordered_map<const ForStmt*, InductionVariable> inductionVars;
+    
+    // Цикл -> инвариантные выражения, вычисляемые перед ним
+    std::unordered_map<const Statement*, std::vector<Expression*>> loopInvariants;
+    
+    // Граф вызовов и сводки чистоты функций
+    CallGraph callGraph;
+    
+    // Диапазоны целочисленных переменных и операции, способные переполнить int
+    std::unordered_map<const ASTNode*, ValueRange> valueRanges;
+    std::unordered_set<const Expression*> overflowSites;
+    
+    // Опрос отмены между функциями
+    std::function<bool()> interrupt;
+    void checkInterrupt() const { if (interrupt && interrupt()) throw AnalysisInterrupted(); }
     
     // Вспомогательные методы
-    void error(const std::string& msg, ASTNode* node);
-    void warning(const std::string& msg, ASTNode* node);
+    void report(DiagCode code, ASTNode* node, std::initializer_list<std::string_view> args = {});
     
     // Преобразование строки типа в TypeInfo
     TypeInfo typeFromString(const std::string& typeStr);
@@ -103,6 +160,11 @@ private:
     // Основные методы обхода AST
     void analyzeProgram(Program* program);
     void analyzeFunction(FunctionDecl* func);
+    void restoreFunction(FunctionDecl* func);
+    void discardFunction(const FunctionDecl* func, FunctionRecord& record);
+    void noteDependency(const std::string& name, ASTNode* decl);
+    std::vector<bool> calleeEffects(const FunctionRecord& record) const;
+    static std::string signatureOf(const FunctionDecl* func);
     TypeInfo analyzeExpression(Expression* expr);
     void analyzeStatement(Statement* stmt);
     
@@ -124,9 +186,13 @@ private:
     TypeInfo analyzeNumber(NumberExpr* expr);
     TypeInfo analyzeCall(CallExpr* expr);
     
+    // Уточнение побочных эффектов вызовов по сводкам графа вызовов
+    void refineCallEffects(Statement* stmt);
+    bool refineCallEffects(Expression* expr);
+    
     // Проверки типов
     bool checkTypeCompatibility(const TypeInfo& expected, const TypeInfo& actual, 
-                               ASTNode* node, const std::string& context);
+                               ASTNode* node, const char* context);
     TypeInfo getCommonType(const TypeInfo& t1, const TypeInfo& t2);
     
 public:
@@ -135,14 +201,56 @@ public:
     // Основной публичный метод
     bool analyze(ProgramPtr& program);
     
-    // Доступ к результатам
-    const std::vector<std::string>& getErrors() const { return errors; }
-    const std::vector<std::string>& getWarnings() const { return warnings; }
-    bool hasErrors() const { return !errors.empty(); }
+    /**
+     * Повторный анализ после изменения исходного текста.
+     * previous - программа, проанализированная последней; program - новый разбор.
+     * Функции с тем же хешем токенов, чьи внешние зависимости (сигнатуры вызываемых
+     * функций) не изменились, не анализируются заново: их уже проанализированные
+     * поддеревья переносятся из previous в program вместе с результатами.
+     * После вызова previous содержит только устаревшие узлы и может быть удалён.
+     */
+    bool reanalyze(ProgramPtr& previous, ProgramPtr& program);
+    
+    // Опрашивается между функциями; true - прервать анализ исключением
+    // AnalysisInterrupted. Результаты прерванного анализа недействительны
+    void setInterrupt(std::function<bool()> poll) { interrupt = std::move(poll); }
+    
+    // Сколько функций переиспользовал последний reanalyze()
+    size_t getReusedFunctionCount() const { return reusedFunctions.size(); }
+    
+    // Доступ к результатам (форматированный текст)
+    const std::vector<std::string>& getErrors() const;
+    const std::vector<std::string>& getWarnings() const;
+    bool hasErrors() const { return diagnostics.errorCount() != 0; }
+    
+    // Структурированные диагностики и подавление по коду
+    const DiagnosticEngine& getDiagnostics() const { return diagnostics; }
+    void suppress(DiagCode code, bool suppressed = true) { diagnostics.suppress(code, suppressed); }
     
     // Получение аннотации для узла (для генератора кода)
     const SemanticAnnotation* getAnnotationForNode(ASTNode* node) const;
     
+    // Потоки данных функции (достигающие определения, живые переменные, def-use)
+    const FunctionDataflow* getDataflow(const FunctionDecl* func) const;
+    
+    // Индуктивная переменная цикла; nullptr, если цикл нельзя выразить через range()
+    const InductionVariable* getInductionVariable(const ForStmt* loop) const;
+    
+    // Выражения, которые можно вычислить один раз перед циклом; nullptr, если таких нет
+    const std::vector<Expression*>* getLoopInvariants(const Statement* loop) const;
+    
+    // Диапазон значений целочисленной переменной; nullptr, если не отслеживается
+    const ValueRange* getValueRange(const ASTNode* var) const;
+    
+    // Целочисленная операция может выйти за границы int (нужна эмуляция переполнения)
+    bool mayOverflow(const Expression* expr) const { return overflowSites.count(expr) != 0; }
+    
+    // Граф вызовов (SCC, рекурсия, чистота функций)
+    const CallGraph& getCallGraph() const { return callGraph; }
+    
+    // Оператор присваивания (простой или составной)
+    static bool isAssignmentOp(const std::string& op);
+    
     // Отладочный вывод
     void printAnnotations(std::ostream& os = std::cout) const;
 };
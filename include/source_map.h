@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * SourceMap - соответствие строк сгенерированного Python кода позициям в C.
+ *
+ * Каждой строке вывода CodeGenerator соответствует позиция оператора C, из
+ * которого она получена (строка и столбец первого токена), или ничего -
+ * для импортов, пустых строк и точки входа.
+ *
+ * Формат файла - Source Map v3 (JSON, как у JavaScript): в поле mappings
+ * на каждую строку вывода один сегмент из четырёх чисел base64 VLQ - столбец
+ * в выводе (всегда 0), индекс исходника, строка и столбец в C - разностями
+ * с предыдущим сегментом. Подряд идущие операторы кодируются 4-6 символами
+ * на строку вывода.
+ */
+
+// Позиция в исходнике C, с 1; line == 0 - позиции нет
+struct SourcePosition {
+    int line = 0;
+    int column = 0;
+};
+
+class SourceMap {
+public:
+    // Позиция следующей строки вывода
+    void addLine(SourcePosition position) { lines.push_back(position); }
+
+    // Строки другой карты - после своих
+    void append(const SourceMap& other);
+
+    // count строк без позиции в начало (заголовок с импортами)
+    void prependLines(size_t count);
+
+    void clear() { lines.clear(); }
+    size_t lineCount() const { return lines.size(); }
+
+    // Позиция строки вывода generatedLine (с 1); за пределами карты - без позиции
+    SourcePosition lookup(size_t generatedLine) const;
+
+    // Поле mappings Source Map v3 и обратное преобразование;
+    // некорректная строка - std::runtime_error
+    std::string encodeMappings() const;
+    static SourceMap decodeMappings(const std::string& mappings);
+
+    // Файл карты целиком: имена сгенерированного файла и исходника C
+    std::string toJson(const std::string& generatedFile, const std::string& sourceFile) const;
+    static SourceMap fromJson(const std::string& json, std::string* sourceFile = nullptr,
+                              std::string* generatedFile = nullptr);
+
+private:
+    std::vector<SourcePosition> lines;  // Индекс - номер строки вывода - 1
+};
+
+/**
+ * Ссылки на строки сгенерированного файла в трассировке или профиле -> позиции в C:
+ *   File ".../prog.py", line 12, in f  ->  File "prog.c", line 5, column 9, in f
+ *   .../prog.py:12(f)                  ->  prog.c:5:9(f)       (cProfile, py-spy)
+ * Файл узнаётся по имени generatedFile без каталога и заменяется на sourceFile.
+ * Ссылки на строки без позиции (импорты, точка входа) не меняются.
+ */
+std::string remapLocations(const std::string& text, const SourceMap& map,
+                           const std::string& generatedFile, const std::string& sourceFile);
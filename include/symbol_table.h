@@ -30,12 +30,16 @@ public:
 
     bool isDeclaredInCurrentScope(const std::string& name) const;
 
+    // число открытых областей
+    size_t depth() const { return scopes.size(); }
+
     friend struct SymbolTableTester;
 protected:
     const ScopeContainer& getScopes() const;
 
 private:
     std::vector<std::unordered_map<std::string, ASTNode*>> scopes;
+    ScopeContainer spare;   // Пустые таблицы закрытых областей для повторного использования
 };
 
 
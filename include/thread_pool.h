@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * ThreadPool - фиксированный набор потоков с общей очередью задач.
+ *
+ * Задачи выполняются в порядке постановки, но завершаются в любом порядке;
+ * результаты задача кладёт в свою ячейку заранее подготовленного массива.
+ * wait() дожидается выполнения всех поставленных задач и повторно бросает
+ * первое исключение, вылетевшее из задачи.
+ */
+
+class ThreadPool {
+public:
+    // threads == 0 - по числу ядер
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+    void wait();
+
+    size_t size() const { return workers.size(); }
+
+    // Число потоков по умолчанию: hardware_concurrency(), не меньше 1
+    static size_t defaultThreads();
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable hasTask;
+    std::condition_variable allDone;
+    size_t active = 0;                  // Задач в очереди и в работе
+    bool stopping = false;
+    std::exception_ptr failure;
+
+    void run();
+};
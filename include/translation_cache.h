@@ -0,0 +1,93 @@
+#pragma once
+
+#include "pipeline.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+/**
+ * TranslationCache - каталог результатов трансляции, адресуемых содержимым.
+ *
+ * Ключ - 128-битный хеш (FNV-1a) входного текста, версии транслятора и
+ * параметров, влияющих на результат. Запись - Python код (или .pyc),
+ * ошибки, предупреждения и карта исходника: повторная трансляция того же
+ * файла сводится к чтению записи. Неудачные трансляции тоже кешируются.
+ *
+ * Каталог могут одновременно использовать несколько процессов и потоков:
+ * - запись создаётся во временном файле рядом и переименовывается на место
+ *   (rename атомарен), читатель видит старую запись или новую целиком;
+ * - запись с неверной сигнатурой или контрольной суммой считается промахом
+ *   и удаляется;
+ * - удаление при вытеснении не мешает тем, кто запись уже открыл.
+ *
+ * Вытеснение - LRU по времени изменения файла (попадание обновляет его):
+ * когда размер каталога превышает maxBytes, удаляются самые давние записи,
+ * пока не останется 3/4 предела. Каталог просматривается не на каждую запись,
+ * а после записи каждой четверти предела и в trim().
+ *
+ * Ключ включает номер версии вывода (version()), который увеличивается
+ * с каждым изменением генерируемого кода: записи прежних версий не
+ * используются и вытесняются как давно не читанные.
+ */
+
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t stores = 0;
+    uint64_t evictions = 0;
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+};
+
+class TranslationCache {
+public:
+    // maxBytes == 0 - без ограничения размера
+    explicit TranslationCache(const std::string& directory, uint64_t maxBytes = 0);
+
+    // Ключ записи: 32 шестнадцатеричные цифры
+    static std::string keyFor(const std::string& code, const TranslateOptions& options);
+
+    // Запись по ключу; false - промах (нет записи или она повреждена)
+    bool load(const std::string& key, TranslateResult& result);
+
+    // Сохранить результат; ошибка записи (нет места, нет прав) - не ошибка
+    // трансляции, возвращается false
+    bool store(const std::string& key, const TranslateResult& result);
+
+    // Из кеша или translateSource() с сохранением результата
+    TranslateResult translate(const std::string& code, const TranslateOptions& options);
+
+    // То же на переиспользуемом конвейере; параметры - translator.options()
+    TranslateResult translate(const std::string& code, Translator& translator);
+
+    // Вытеснить давние записи до 3/4 maxBytes; возвращает размер каталога
+    uint64_t trim();
+
+    CacheStats stats() const;
+    const std::string& directory() const { return root; }
+
+    // Формат записей и версия вывода транслятора - часть ключа
+    static const char* version();
+
+    // Параметры, от которых зависит результат (число потоков генерации - нет):
+    // равные строки - одинаковый вывод для одного входа
+    static std::string fingerprint(const TranslateOptions& options);
+
+private:
+    std::string root;
+    uint64_t maxBytes;
+
+    std::atomic<uint64_t> hits { 0 };
+    std::atomic<uint64_t> misses { 0 };
+    std::atomic<uint64_t> stores { 0 };
+    std::atomic<uint64_t> evictions { 0 };
+    std::atomic<uint64_t> bytesRead { 0 };
+    std::atomic<uint64_t> bytesWritten { 0 };
+    std::atomic<uint64_t> pendingBytes { 0 };   // Записано с последнего просмотра каталога
+    std::atomic<uint64_t> tempCounter { 0 };
+    std::mutex trimMutex;
+
+    std::string pathFor(const std::string& key) const;
+};
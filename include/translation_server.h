@@ -0,0 +1,89 @@
+#pragma once
+
+#include "protocol.h"
+#include "translation_cache.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * TranslationServer - долгоживущий транслятор на Unix сокете
+ * (c2py-cli --serve, клиент - c2py-client, протокол - protocol.h).
+ *
+ * Запуск процесса, построение статических таблиц и холодные кеши стоят
+ * больше, чем трансляция небольшого файла. Сервер платит за них один раз:
+ * между запросами живут таблицы, прогретая куча и кеш результатов
+ * (TranslationCache, если задан).
+ *
+ * Каждое соединение обслуживает свой поток до закрытия клиентом: клиент,
+ * держащий соединение открытым, не задерживает остальных. Одновременно
+ * транслируется не больше threads запросов, прочие ждут свободного места.
+ *
+ * Трансляция идёт на Translator, взятом из набора свободных (не больше
+ * threads): запрос получает конвейер с теми же параметрами, что у него,
+ * с выделенными под прошлые входы буферами и прошлой программой для
+ * повторного анализа. Конвейер с другими параметрами не подходит - такой
+ * создаётся заново, а давно не использованные вытесняются из набора.
+ */
+
+struct ServerStats {
+    uint64_t connections = 0;
+    uint64_t requests = 0;
+    uint64_t failed = 0;            // Неудачные трансляции и испорченные запросы
+};
+
+class TranslationServer {
+public:
+    // cache == nullptr - без кеша; threads - одновременных трансляций, 0 - по числу ядер
+    TranslationServer(const std::string& socketPath, TranslationCache* cache = nullptr,
+                      size_t threads = 0);
+    ~TranslationServer();
+
+    TranslationServer(const TranslationServer&) = delete;
+    TranslationServer& operator=(const TranslationServer&) = delete;
+
+    // Создать сокет; false - ошибка (error()). Сокет, оставшийся от
+    // завершившегося сервера, заменяется; занятый живым сервером - ошибка
+    bool listen();
+
+    // Обслуживать запросы до stop() или запроса Shutdown
+    void run();
+
+    // Можно вызывать из обработчика сигнала
+    void stop();
+
+    const std::string& error() const { return lastError; }
+    const std::string& socketPath() const { return path; }
+    ServerStats stats() const;
+
+private:
+    std::string path;
+    TranslationCache* cache;
+    size_t slots;
+    int listenFd = -1;
+    int wakeFds[2] = { -1, -1 };    // stop() пишет байт - run() просыпается
+    std::string lastError;
+
+    std::mutex clientsMutex;
+    std::condition_variable clientsClosed;
+    std::set<int> clients;          // Открытые соединения: при остановке закрываются
+    size_t translating = 0;         // Под clientsMutex
+    std::condition_variable slotFree;
+    // Свободные конвейеры с отпечатком параметров, давние - в начале; под clientsMutex
+    std::vector<std::pair<std::string, std::unique_ptr<Translator>>> idle;
+
+    std::atomic<uint64_t> connections { 0 };
+    std::atomic<uint64_t> requests { 0 };
+    std::atomic<uint64_t> failed { 0 };
+
+    void serve(int fd);
+    TranslateResult translate(const TranslateRequest& request);
+    bool fail(const std::string& what);
+};
@@ -4,7 +4,7 @@ Write-Host ""
 
 # Get path to executable
 $buildDir = ".\build"
-$exeName = "c2py.exe"
+$exeName = "c2py-cli.exe"
 $exePath = Join-Path $buildDir $exeName
 
 # Check if executable exists
@@ -24,11 +24,29 @@ if (-not (Test-Path $exePath)) {
         "src/ast.cpp",
         "src/code_generator.cpp",
         "src/semantic.cpp",
+        "src/optimizer.cpp",
+        "src/cfg.cpp",
+        "src/dataflow.cpp",
+        "src/induction.cpp",
+        "src/call_graph.cpp",
+        "src/range_analysis.cpp",
+        "src/diagnostics.cpp",
+        "src/loop_invariants.cpp",
+        "src/inliner.cpp",
+        "src/code_sink.cpp",
+        "src/thread_pool.cpp",
+        "src/source_map.cpp",
+        "src/instrument.cpp",
+        "src/bytecode.cpp",
+        "src/pyc_generator.cpp",
+        "src/pipeline.cpp",
+        "src/protocol.cpp",
+        "src/translation_cache.cpp",
         "src/symbol_table.cc",
-        "src/main.cpp"
+        "src/cli.cpp"
     )
     
-    $cppflags = @("-iquote", "include", "-g", "-Wall", "-Wextra")
+    $cppflags = @("-iquote", "include", "-g", "-Wall", "-Wextra", "-pthread")
     
     # Compile source files
     $compileCmd = @("c++") + $cppflags + $srcs + @("-o", $exePath)
@@ -91,5 +109,5 @@ Write-Host ""
 Write-Host "Translating file: $selectedFile" -ForegroundColor Yellow
 Write-Host ""
 
-# Run translator
-& $exePath $inputPath
+# Run translator: Python code to the console
+& $exePath -o - $inputPath
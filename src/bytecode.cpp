@@ -0,0 +1,541 @@
+#include "bytecode.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+
+const char pycMagic[4] = { '\xa7', '\x0d', '\x0d', '\x0a' };
+
+namespace {
+
+// Кеш-слоты (по 2 байта), которые интерпретатор 3.11 ожидает после инструкции
+int
+cacheEntries (PyOp op)
+{
+    switch (op) {
+    case PyOp::BINARY_OP:   return 1;
+    case PyOp::PRECALL:     return 1;
+    case PyOp::COMPARE_OP:  return 2;
+    case PyOp::LOAD_ATTR:   return 4;
+    case PyOp::CALL:        return 4;
+    case PyOp::LOAD_GLOBAL: return 5;
+    default:                return 0;
+    }
+}
+
+// Число префиксов EXTENDED_ARG для аргумента
+int
+extendedArgs (int arg)
+{
+    if (arg > 0xffffff) return 3;
+    if (arg > 0xffff) return 2;
+    if (arg > 0xff) return 1;
+    return 0;
+}
+
+void
+writeVarint (std::string& out, unsigned value)
+{
+    while (value >= 64) {
+        out.push_back(static_cast<char>(64 | (value & 63)));
+        value >>= 6;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void
+writeSignedVarint (std::string& out, int value)
+{
+    writeVarint(out, value < 0 ? ((unsigned) -value << 1) | 1 : (unsigned) value << 1);
+}
+
+}
+
+
+PyConst
+PyConst::makeInt (long long value)
+{
+    PyConst c;
+    c.kind = Int;
+    c.intValue = value;
+    return c;
+}
+
+PyConst
+PyConst::makeFloat (double value)
+{
+    PyConst c;
+    c.kind = Float;
+    c.floatValue = value;
+    return c;
+}
+
+PyConst
+PyConst::makeString (const std::string& text)
+{
+    PyConst c;
+    c.kind = String;
+    c.text = text;
+    return c;
+}
+
+PyConst
+PyConst::makeBool (bool value)
+{
+    PyConst c;
+    c.kind = value ? True : False;
+    return c;
+}
+
+PyConst
+PyConst::makeCode (std::shared_ptr<const PyCode> code)
+{
+    PyConst c;
+    c.kind = Code;
+    c.code = std::move(code);
+    return c;
+}
+
+bool
+PyConst::sameAs (const PyConst& other) const
+{
+    if (kind != other.kind) return false;
+    switch (kind) {
+    case Int:    return intValue == other.intValue;
+    case Float:  return std::memcmp(&floatValue, &other.floatValue, sizeof(double)) == 0;
+    case String: return text == other.text;
+    case Code:   return code == other.code;
+    default:     return true;
+    }
+}
+
+
+BytecodeAssembler::BytecodeAssembler (const std::string& name, const std::string& fileName, int firstLine)
+{
+    result.name = name;
+    result.qualName = name;
+    result.fileName = fileName;
+    result.firstLine = firstLine;
+}
+
+BytecodeAssembler::Label
+BytecodeAssembler::newLabel ()
+{
+    labels.push_back(unbound);
+    return labels.size() - 1;
+}
+
+void
+BytecodeAssembler::bind (Label label)
+{
+    labels[label] = instrs.size();
+}
+
+void
+BytecodeAssembler::emit (PyOp op, int arg)
+{
+    instrs.push_back({ op, arg, currentLine, false, Always, 0 });
+}
+
+void
+BytecodeAssembler::emitJump (Jump kind, Label target)
+{
+    instrs.push_back({ PyOp::NOP, 0, currentLine, true, kind, target });
+}
+
+int
+BytecodeAssembler::addConst (const PyConst& value)
+{
+    // Объекты кода не сравниваются: каждая функция - своя константа
+    if (value.kind != PyConst::Code) {
+        for (size_t i = 0; i < result.consts.size(); ++i) {
+            if (result.consts[i].sameAs(value)) return (int) i;
+        }
+    }
+    result.consts.push_back(value);
+    return (int) result.consts.size() - 1;
+}
+
+int
+BytecodeAssembler::addName (const std::string& name)
+{
+    auto it = nameIndex.find(name);
+    if (it != nameIndex.end()) return it->second;
+    result.names.push_back(name);
+    return nameIndex[name] = (int) result.names.size() - 1;
+}
+
+int
+BytecodeAssembler::addLocal (const std::string& name)
+{
+    auto it = localIndex.find(name);
+    if (it != localIndex.end()) return it->second;
+    result.varNames.push_back(name);
+    return localIndex[name] = (int) result.varNames.size() - 1;
+}
+
+int
+BytecodeAssembler::findLocal (const std::string& name) const
+{
+    auto it = localIndex.find(name);
+    return it != localIndex.end() ? it->second : -1;
+}
+
+bool
+BytecodeAssembler::endsBlock () const
+{
+    if (instrs.empty()) return false;
+    const Instr& last = instrs.back();
+    // Метка после последней инструкции - на неё есть переход
+    for (size_t target : labels) {
+        if (target == instrs.size()) return false;
+    }
+    return last.op == PyOp::RETURN_VALUE || (last.isJump && last.jump == Always);
+}
+
+PyCode
+BytecodeAssembler::assemble (int argCount, int flags)
+{
+    for (size_t target : labels) {
+        if (target == unbound || target > instrs.size()) {
+            throw std::logic_error("bytecode: unbound label in " + result.name);
+        }
+    }
+
+    std::vector<size_t> offsets;
+    resolveJumps(offsets);
+
+    // Инструкции: EXTENDED_ARG со старшими байтами, опкод, младший байт, кеш-слоты
+    std::string& code = result.code;
+    code.clear();
+    code.reserve(offsets.back() * 2);
+    for (const Instr& instr : instrs) {
+        int arg = instr.arg;
+        for (int shift = extendedArgs(arg) * 8; shift > 0; shift -= 8) {
+            code.push_back(static_cast<char>(PyOp::EXTENDED_ARG));
+            code.push_back(static_cast<char>((arg >> shift) & 0xff));
+        }
+        code.push_back(static_cast<char>(instr.op));
+        code.push_back(static_cast<char>(arg & 0xff));
+        code.append(cacheEntries(instr.op) * 2, '\0');
+    }
+
+    result.argCount = argCount;
+    result.flags = flags;
+    result.stackSize = computeStackSize();
+    encodeLineTable(offsets);
+    return std::move(result);
+}
+
+void
+BytecodeAssembler::resolveJumps (std::vector<size_t>& offsets)
+{
+    // Длина перехода зависит от расстояния, расстояние - от длин переходов:
+    // длины только растут, поэтому повторяем до неподвижной точки
+    std::vector<int> extended(instrs.size());
+    for (size_t i = 0; i < instrs.size(); ++i) {
+        extended[i] = instrs[i].isJump ? 0 : extendedArgs(instrs[i].arg);
+    }
+
+    offsets.assign(instrs.size() + 1, 0);
+    for (bool changed = true; changed; ) {
+        for (size_t i = 0; i < instrs.size(); ++i) {
+            offsets[i + 1] = offsets[i] + extended[i] + 1 + cacheEntries(instrs[i].op);
+        }
+
+        changed = false;
+        for (size_t i = 0; i < instrs.size(); ++i) {
+            Instr& instr = instrs[i];
+            if (!instr.isJump) continue;
+
+            size_t target = offsets[labels[instr.target]];
+            bool backward = target <= offsets[i];
+            switch (instr.jump) {
+            case Always:
+                instr.op = backward ? PyOp::JUMP_BACKWARD : PyOp::JUMP_FORWARD;
+                break;
+            case IfFalse:
+                instr.op = backward ? PyOp::POP_JUMP_BACKWARD_IF_FALSE : PyOp::POP_JUMP_FORWARD_IF_FALSE;
+                break;
+            case IfTrue:
+                instr.op = backward ? PyOp::POP_JUMP_BACKWARD_IF_TRUE : PyOp::POP_JUMP_FORWARD_IF_TRUE;
+                break;
+            case IfFalseOrPop:
+            case IfTrueOrPop:
+            case ForIter:
+                if (backward) {
+                    throw std::logic_error("bytecode: backward conditional jump in " + result.name);
+                }
+                instr.op = instr.jump == ForIter ? PyOp::FOR_ITER
+                         : instr.jump == IfFalseOrPop ? PyOp::JUMP_IF_FALSE_OR_POP
+                         : PyOp::JUMP_IF_TRUE_OR_POP;
+                break;
+            }
+
+            // Смещение считается от следующей инструкции, в 2-байтовых единицах
+            size_t next = offsets[i + 1];
+            instr.arg = (int) (backward ? next - target : target - next);
+            if (extendedArgs(instr.arg) > extended[i]) {
+                extended[i] = extendedArgs(instr.arg);
+                changed = true;
+            }
+        }
+    }
+}
+
+int
+BytecodeAssembler::computeStackSize () const
+{
+    // Обход всех путей управления: глубина в точке входа инструкции
+    std::vector<int> depthAt(instrs.size() + 1, -1);
+    std::vector<std::pair<size_t, int>> pending = { { 0, 0 } };
+    int maxDepth = 0;
+
+    auto reach = [&](size_t index, int depth) {
+        if (depth < 0) {
+            throw std::logic_error("bytecode: stack underflow in " + result.name);
+        }
+        if (depth > maxDepth) maxDepth = depth;
+        if (depthAt[index] < 0) {
+            depthAt[index] = depth;
+            pending.push_back({ index, depth });
+        }
+    };
+
+    while (!pending.empty()) {
+        auto [index, depth] = pending.back();
+        pending.pop_back();
+        if (index == instrs.size()) continue;
+
+        const Instr& instr = instrs[index];
+        if (instr.isJump) {
+            int taken = 0, fallthrough = 0;
+            switch (instr.jump) {
+            case Always:       taken = 0; break;
+            case IfFalse:
+            case IfTrue:       taken = -1; fallthrough = -1; break;
+            case IfFalseOrPop:
+            case IfTrueOrPop:  taken = 0; fallthrough = -1; break;
+            case ForIter:      taken = -1; fallthrough = 1; break;
+            }
+            reach(labels[instr.target], depth + taken);
+            if (instr.jump != Always) reach(index + 1, depth + fallthrough);
+            continue;
+        }
+
+        int effect = 0;
+        switch (instr.op) {
+        case PyOp::RETURN_VALUE:
+            continue;
+        case PyOp::PUSH_NULL:
+        case PyOp::LOAD_CONST:
+        case PyOp::LOAD_NAME:
+        case PyOp::LOAD_FAST:
+        case PyOp::COPY:
+            effect = 1;
+            break;
+        case PyOp::LOAD_GLOBAL:
+            effect = 1 + (instr.arg & 1);   // Младший бит - NULL перед функцией
+            break;
+        case PyOp::POP_TOP:
+        case PyOp::STORE_NAME:
+        case PyOp::STORE_FAST:
+        case PyOp::COMPARE_OP:
+        case PyOp::IMPORT_NAME:
+        case PyOp::BINARY_OP:
+        case PyOp::CALL:
+            effect = -1;
+            break;
+        case PyOp::PRECALL:
+            effect = -instr.arg;
+            break;
+        default:
+            break;
+        }
+        reach(index + 1, depth + effect);
+    }
+    return maxDepth;
+}
+
+void
+BytecodeAssembler::encodeLineTable (const std::vector<size_t>& offsets)
+{
+    // Формат 3.11: запись на 1-8 единиц кода; код 13 - строка без колонок
+    // (приращение строки - знаковый varint), код 15 - без строки
+    std::string& table = result.lineTable;
+    table.clear();
+    int previousLine = result.firstLine;
+
+    size_t i = 0;
+    while (i < instrs.size()) {
+        int line = instrs[i].line;
+        size_t j = i;
+        while (j < instrs.size() && instrs[j].line == line) ++j;
+
+        size_t units = offsets[j] - offsets[i];
+        bool first = true;
+        while (units > 0) {
+            size_t length = units < 8 ? units : 8;
+            units -= length;
+            if (line <= 0) {
+                table.push_back(static_cast<char>(0x80 | (15 << 3) | (length - 1)));
+                continue;
+            }
+            table.push_back(static_cast<char>(0x80 | (13 << 3) | (length - 1)));
+            writeSignedVarint(table, first ? line - previousLine : 0);
+            first = false;
+        }
+        if (line > 0) previousLine = line;
+        i = j;
+    }
+}
+
+
+void
+MarshalWriter::writeInt32 (int32_t value)
+{
+    uint32_t bits = static_cast<uint32_t>(value);
+    for (int i = 0; i < 4; ++i) {
+        writeByte(static_cast<uint8_t>(bits >> (8 * i)));
+    }
+}
+
+void
+MarshalWriter::writeLong (long long value)
+{
+    // Длинное целое: знаковое число 15-битных цифр, затем цифры по 2 байта
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long) value : (unsigned long long) value;
+    std::vector<uint16_t> digits;
+    while (magnitude) {
+        digits.push_back(static_cast<uint16_t>(magnitude & 0x7fff));
+        magnitude >>= 15;
+    }
+    writeByte('l');
+    writeInt32(value < 0 ? -(int32_t) digits.size() : (int32_t) digits.size());
+    for (uint16_t digit : digits) {
+        writeByte(static_cast<uint8_t>(digit & 0xff));
+        writeByte(static_cast<uint8_t>(digit >> 8));
+    }
+}
+
+void
+MarshalWriter::writeFloat (double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeByte('g');
+    for (int i = 0; i < 8; ++i) {
+        writeByte(static_cast<uint8_t>(bits >> (8 * i)));
+    }
+}
+
+void
+MarshalWriter::writeString (const std::string& text, bool interned)
+{
+    bool ascii = true;
+    for (char c : text) {
+        if (static_cast<unsigned char>(c) >= 0x80) ascii = false;
+    }
+
+    if (!ascii) {
+        writeByte(interned ? 't' : 'u');
+        writeInt32((int32_t) text.size());
+    } else if (text.size() < 256) {
+        writeByte(interned ? 'Z' : 'z');
+        writeByte(static_cast<uint8_t>(text.size()));
+    } else {
+        writeByte(interned ? 'A' : 'a');
+        writeInt32((int32_t) text.size());
+    }
+    buffer.append(text);
+}
+
+void
+MarshalWriter::writeBytes (const std::string& bytes)
+{
+    writeByte('s');
+    writeInt32((int32_t) bytes.size());
+    buffer.append(bytes);
+}
+
+void
+MarshalWriter::writeNames (const std::vector<std::string>& names)
+{
+    if (names.size() < 256) {
+        writeByte(')');
+        writeByte(static_cast<uint8_t>(names.size()));
+    } else {
+        writeByte('(');
+        writeInt32((int32_t) names.size());
+    }
+    for (const std::string& name : names) {
+        writeString(name, true);
+    }
+}
+
+void
+MarshalWriter::writeConst (const PyConst& value)
+{
+    switch (value.kind) {
+    case PyConst::None:
+        writeByte('N');
+        break;
+    case PyConst::False:
+        writeByte('F');
+        break;
+    case PyConst::True:
+        writeByte('T');
+        break;
+    case PyConst::Int:
+        if (value.intValue >= INT32_MIN && value.intValue <= INT32_MAX) {
+            writeByte('i');
+            writeInt32((int32_t) value.intValue);
+        } else {
+            writeLong(value.intValue);
+        }
+        break;
+    case PyConst::Float:
+        writeFloat(value.floatValue);
+        break;
+    case PyConst::String:
+        writeString(value.text, false);
+        break;
+    case PyConst::Code:
+        writeCode(*value.code);
+        break;
+    }
+}
+
+void
+MarshalWriter::writeCode (const PyCode& code)
+{
+    writeByte('c');
+    writeInt32(code.argCount);
+    writeInt32(0);                      // co_posonlyargcount
+    writeInt32(0);                      // co_kwonlyargcount
+    writeInt32(code.stackSize);
+    writeInt32(code.flags);
+    writeBytes(code.code);
+
+    if (code.consts.size() < 256) {
+        writeByte(')');
+        writeByte(static_cast<uint8_t>(code.consts.size()));
+    } else {
+        writeByte('(');
+        writeInt32((int32_t) code.consts.size());
+    }
+    for (const PyConst& value : code.consts) {
+        writeConst(value);
+    }
+
+    writeNames(code.names);
+    writeNames(code.varNames);          // co_localsplusnames
+    writeBytes(std::string(code.varNames.size(), '\x20'));  // CO_FAST_LOCAL
+    writeString(code.fileName, false);
+    writeString(code.name, true);
+    writeString(code.qualName, true);
+    writeInt32(code.firstLine);
+    writeBytes(code.lineTable);
+    writeBytes("");                     // co_exceptiontable: try в программах нет
+}
@@ -0,0 +1,258 @@
+#include "call_graph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
+
+
+namespace {
+
+// Время вызова прибавляется к buildMicros: граф строится вызовами из анализатора
+class BuildTimer {
+public:
+    explicit BuildTimer (double& total)
+        : total(total), started(std::chrono::steady_clock::now()) {}
+
+    ~BuildTimer ()
+    {
+        total += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count();
+    }
+
+private:
+    double& total;
+    std::chrono::steady_clock::time_point started;
+};
+
+} // namespace
+
+void
+CallGraph::clear ()
+{
+    order.clear();
+    nodes.clear();
+    sites.clear();
+    components.clear();
+    buildStats = CallGraphStats();
+}
+
+void
+CallGraph::addFunction (const FunctionDecl* func)
+{
+    BuildTimer timer(buildStats.buildMicros);
+    if (nodes.emplace(func, Node()).second) {
+        order.push_back(func);
+    }
+}
+
+void
+CallGraph::addCall (const FunctionDecl* caller, const CallExpr* site, const FunctionDecl* callee)
+{
+    BuildTimer timer(buildStats.buildMicros);
+    sites[site] = callee;
+    ++buildStats.callSites;
+
+    Node& from = nodes[caller];
+    if (std::find(from.callees.begin(), from.callees.end(), callee) != from.callees.end()) {
+        return;
+    }
+    from.callees.push_back(callee);
+    nodes[callee].callers.push_back(caller);
+    ++buildStats.edges;
+}
+
+void
+CallGraph::addUnknownCall (const FunctionDecl* caller, const CallExpr* site)
+{
+    BuildTimer timer(buildStats.buildMicros);
+    sites[site] = nullptr;
+    ++buildStats.callSites;
+    nodes[caller].summary.callsUnknown = true;
+}
+
+void
+CallGraph::setLocalEffects (const FunctionDecl* func, const FunctionDataflow& df)
+{
+    BuildTimer timer(buildStats.buildMicros);
+    // Локальные переменные - те, что объявлены в функции (VarDecl или параметр)
+    std::unordered_set<const ASTNode*> locals;
+    for (const Definition& d : df.definitions) {
+        if (d.site == d.var) locals.insert(d.var);
+    }
+
+    FunctionSummary& s = nodes[func].summary;
+    s.hasLoops = df.cfg.hasLoops();
+    for (const Definition& d : df.definitions) {
+        if (!locals.count(d.var)) {
+            s.writesNonLocals = true;
+            break;
+        }
+    }
+}
+
+void
+CallGraph::findComponents ()
+{
+    // Итеративный алгоритм Тарьяна: глубина рекурсии не зависит от размера программы
+    std::unordered_map<const FunctionDecl*, int> index, lowlink;
+    std::unordered_set<const FunctionDecl*> onStack;
+    std::vector<const FunctionDecl*> stack;
+    int counter = 0;
+
+    struct Frame {
+        const FunctionDecl* func;
+        size_t next;
+    };
+
+    for (const FunctionDecl* root : order) {
+        if (index.count(root)) continue;
+
+        std::vector<Frame> frames{ { root, 0 } };
+        index[root] = lowlink[root] = counter++;
+        stack.push_back(root);
+        onStack.insert(root);
+
+        while (!frames.empty()) {
+            Frame& frame = frames.back();
+            const std::vector<const FunctionDecl*>& out = nodes[frame.func].callees;
+
+            if (frame.next < out.size()) {
+                const FunctionDecl* callee = out[frame.next++];
+                if (!index.count(callee)) {
+                    index[callee] = lowlink[callee] = counter++;
+                    stack.push_back(callee);
+                    onStack.insert(callee);
+                    frames.push_back({ callee, 0 });
+                } else if (onStack.count(callee)) {
+                    lowlink[frame.func] = std::min(lowlink[frame.func], index[callee]);
+                }
+                continue;
+            }
+
+            // Все вызываемые обработаны - закрываем вершину
+            const FunctionDecl* func = frame.func;
+            frames.pop_back();
+            if (!frames.empty()) {
+                const FunctionDecl* parent = frames.back().func;
+                lowlink[parent] = std::min(lowlink[parent], lowlink[func]);
+            }
+
+            if (lowlink[func] == index[func]) {
+                std::vector<const FunctionDecl*> component;
+                const FunctionDecl* member;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    onStack.erase(member);
+                    component.push_back(member);
+                } while (member != func);
+                components.push_back(std::move(component));
+            }
+        }
+    }
+}
+
+void
+CallGraph::finalize ()
+{
+    BuildTimer timer(buildStats.buildMicros);
+    components.clear();
+    findComponents();
+
+    // Компоненты идут от вызываемых к вызывающим, поэтому сводки
+    // всех внешних вызываемых уже готовы
+    for (size_t c = 0; c < components.size(); ++c) {
+        const std::vector<const FunctionDecl*>& component = components[c];
+
+        bool recursive = component.size() > 1;
+        bool pure = true;
+        bool terminates = true;
+
+        for (const FunctionDecl* func : component) {
+            const Node& node = nodes[func];
+            const FunctionSummary& local = node.summary;
+            if (local.writesNonLocals || local.callsUnknown) pure = false;
+            if (local.hasLoops) terminates = false;
+
+            for (const FunctionDecl* callee : node.callees) {
+                if (callee == func) recursive = true;
+                const FunctionSummary& other = nodes[callee].summary;
+                if (other.scc == -1) continue;   // Та же компонента
+                pure = pure && other.pure;
+                terminates = terminates && other.terminates;
+            }
+        }
+
+        for (const FunctionDecl* func : component) {
+            FunctionSummary& s = nodes[func].summary;
+            s.scc = (int)c;
+            s.recursive = recursive;
+            s.pure = pure;
+            s.terminates = terminates && !recursive;
+        }
+    }
+
+    buildStats.functions = nodes.size();
+    buildStats.sccs = components.size();
+}
+
+const std::vector<const FunctionDecl*>&
+CallGraph::callees (const FunctionDecl* func) const
+{
+    static const std::vector<const FunctionDecl*> empty;
+    auto it = nodes.find(func);
+    return (it != nodes.end()) ? it->second.callees : empty;
+}
+
+const std::vector<const FunctionDecl*>&
+CallGraph::callers (const FunctionDecl* func) const
+{
+    static const std::vector<const FunctionDecl*> empty;
+    auto it = nodes.find(func);
+    return (it != nodes.end()) ? it->second.callers : empty;
+}
+
+const FunctionDecl*
+CallGraph::calleeOf (const CallExpr* site) const
+{
+    auto it = sites.find(site);
+    return (it != sites.end()) ? it->second : nullptr;
+}
+
+const FunctionSummary*
+CallGraph::summary (const FunctionDecl* func) const
+{
+    auto it = nodes.find(func);
+    return (it != nodes.end()) ? &it->second.summary : nullptr;
+}
+
+bool
+CallGraph::isRecursive (const FunctionDecl* func) const
+{
+    const FunctionSummary* s = summary(func);
+    return !s || s->recursive;
+}
+
+bool
+CallGraph::isPure (const FunctionDecl* func) const
+{
+    const FunctionSummary* s = summary(func);
+    return s && s->pure;
+}
+
+void
+CallGraph::print (std::ostream& os) const
+{
+    os << "=== Call graph ===\n";
+    for (const FunctionDecl* func : order) {
+        const Node& node = nodes.at(func);
+        os << func->name << " [scc " << node.summary.scc
+           << (node.summary.recursive ? ", recursive" : "")
+           << (node.summary.pure ? ", pure" : "")
+           << (node.summary.terminates ? ", terminates" : "") << "] ->";
+        for (const FunctionDecl* callee : node.callees) os << " " << callee->name;
+        os << "\n";
+    }
+    os << buildStats.functions << " functions, " << buildStats.edges << " edges, "
+       << buildStats.callSites << " call sites, " << buildStats.sccs << " SCCs, "
+       << buildStats.buildMicros << " us\n";
+}
@@ -0,0 +1,255 @@
+#include "cfg.h"
+
+#include <ostream>
+
+
+// Построитель графа: обходит операторы функции, поддерживая текущий блок
+class CFGBuilder {
+public:
+    explicit CFGBuilder(ControlFlowGraph& g) : cfg(g) {}
+
+    void
+    buildFunction (FunctionDecl* func)
+    {
+        cfg.entry = newBlock();
+        cfg.exit = newBlock();
+        current = cfg.entry;
+
+        if (func->body) {
+            buildStatement(func->body.get());
+        }
+        addEdge(current, cfg.exit);
+    }
+
+private:
+    struct LoopTargets {
+        int breakTarget;
+        int continueTarget;
+    };
+
+    ControlFlowGraph& cfg;
+    int current = 0;
+    std::vector<LoopTargets> loopStack;
+
+    int
+    newBlock ()
+    {
+        CFGBlock block;
+        block.id = (int)cfg.blocks.size();
+        cfg.blocks.push_back(block);
+        return block.id;
+    }
+
+    void
+    addEdge (int from, int to)
+    {
+        cfg.blocks[from].succs.push_back(to);
+        cfg.blocks[to].preds.push_back(from);
+    }
+
+    void
+    append (ASTNode* item)
+    {
+        if (!item) return;
+        cfg.blocks[current].items.push_back(item);
+        cfg.itemBlocks[item] = current;
+    }
+
+    // После безусловного перехода код недостижим - продолжаем в блоке без предков
+    void
+    jump (int target)
+    {
+        addEdge(current, target);
+        current = newBlock();
+    }
+
+    void
+    buildStatement (Statement* stmt)
+    {
+        if (!stmt) return;
+
+        if (auto block = dynamic_cast<BlockStmt*>(stmt)) {
+            for (auto& s : block->statements) buildStatement(s.get());
+        }
+        else if (auto ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+            buildIf(ifStmt);
+        }
+        else if (auto whileStmt = dynamic_cast<WhileStmt*>(stmt)) {
+            buildWhile(whileStmt);
+        }
+        else if (auto doWhileStmt = dynamic_cast<DoWhileStmt*>(stmt)) {
+            buildDoWhile(doWhileStmt);
+        }
+        else if (auto forStmt = dynamic_cast<ForStmt*>(stmt)) {
+            buildFor(forStmt);
+        }
+        else if (auto returnStmt = dynamic_cast<ReturnStmt*>(stmt)) {
+            append(returnStmt);
+            jump(cfg.exit);
+        }
+        else if (dynamic_cast<BreakStmt*>(stmt)) {
+            if (!loopStack.empty()) jump(loopStack.back().breakTarget);
+        }
+        else if (dynamic_cast<ContinueStmt*>(stmt)) {
+            if (!loopStack.empty()) jump(loopStack.back().continueTarget);
+        }
+        else {
+            // VarDecl, ExpressionStmt
+            append(stmt);
+        }
+    }
+
+    void
+    buildIf (IfStmt* stmt)
+    {
+        append(stmt->condition.get());
+        int condBlock = current;
+        int join = -1;
+
+        int thenBlock = newBlock();
+        addEdge(condBlock, thenBlock);
+        current = thenBlock;
+        buildStatement(stmt->thenBranch.get());
+        int thenEnd = current;
+
+        int elseEnd = condBlock;
+        if (stmt->elseBranch) {
+            int elseBlock = newBlock();
+            addEdge(condBlock, elseBlock);
+            current = elseBlock;
+            buildStatement(stmt->elseBranch.get());
+            elseEnd = current;
+        }
+
+        join = newBlock();
+        addEdge(thenEnd, join);
+        addEdge(elseEnd, join);
+        current = join;
+    }
+
+    void
+    buildWhile (WhileStmt* stmt)
+    {
+        int header = newBlock();
+        addEdge(current, header);
+        current = header;
+        append(stmt->condition.get());
+
+        // Блок выхода создаётся заранее, чтобы break мог на него ссылаться
+        int exitBlock = newBlock();
+        int body = newBlock();
+        addEdge(header, body);
+        addEdge(header, exitBlock);
+
+        loopStack.push_back({ exitBlock, header });
+        current = body;
+        buildStatement(stmt->body.get());
+        loopStack.pop_back();
+
+        addEdge(current, header);
+        finishLoop(stmt, header, exitBlock);
+    }
+
+    void
+    buildDoWhile (DoWhileStmt* stmt)
+    {
+        int body = newBlock();
+        addEdge(current, body);
+
+        int exitBlock = newBlock();
+        int condBlock = newBlock();
+
+        loopStack.push_back({ exitBlock, condBlock });
+        current = body;
+        buildStatement(stmt->body.get());
+        loopStack.pop_back();
+
+        addEdge(current, condBlock);
+        current = condBlock;
+        append(stmt->condition.get());
+        addEdge(condBlock, body);
+        addEdge(condBlock, exitBlock);
+
+        finishLoop(stmt, body, exitBlock);
+        cfg.loops[stmt].header = condBlock;
+    }
+
+    void
+    buildFor (ForStmt* stmt)
+    {
+        buildStatement(stmt->init.get());
+
+        int header = newBlock();
+        addEdge(current, header);
+        current = header;
+        append(stmt->condition.get());
+
+        int exitBlock = newBlock();
+        int update = newBlock();
+        int body = newBlock();
+        addEdge(header, body);
+        // Без условия цикл завершается только через break/return
+        if (stmt->condition) addEdge(header, exitBlock);
+
+        loopStack.push_back({ exitBlock, update });
+        current = body;
+        buildStatement(stmt->body.get());
+        loopStack.pop_back();
+
+        addEdge(current, update);
+        current = update;
+        append(stmt->update.get());
+        addEdge(update, header);
+
+        finishLoop(stmt, header, exitBlock);
+    }
+
+    // Все блоки, созданные с начала цикла (кроме блока выхода), принадлежат циклу
+    void
+    finishLoop (Statement* stmt, int first, int exitBlock)
+    {
+        CFGLoop& loop = cfg.loops[stmt];
+        loop.header = first;
+        loop.exit = exitBlock;
+        for (int b = first; b < (int)cfg.blocks.size(); ++b) {
+            if (b != exitBlock) loop.blocks.push_back(b);
+        }
+        current = exitBlock;
+    }
+};
+
+ControlFlowGraph
+ControlFlowGraph::build (FunctionDecl* func)
+{
+    ControlFlowGraph cfg;
+    CFGBuilder builder(cfg);
+    builder.buildFunction(func);
+    return cfg;
+}
+
+int
+ControlFlowGraph::blockOf (const ASTNode* item) const
+{
+    auto it = itemBlocks.find(item);
+    return (it != itemBlocks.end()) ? it->second : -1;
+}
+
+const CFGLoop*
+ControlFlowGraph::loopOf (const Statement* loop) const
+{
+    auto it = loops.find(loop);
+    return (it != loops.end()) ? &it->second : nullptr;
+}
+
+void
+ControlFlowGraph::print (std::ostream& os) const
+{
+    for (const auto& block : blocks) {
+        os << "B" << block.id;
+        if (block.id == entry) os << " (entry)";
+        if (block.id == exit) os << " (exit)";
+        os << ": " << block.items.size() << " items ->";
+        for (int s : block.succs) os << " B" << s;
+        os << "\n";
+    }
+}
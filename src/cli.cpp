@@ -0,0 +1,498 @@
+/**
+ * c2py-cli - консольный транслятор: много файлов за один запуск, без окна
+ * и без FLTK (make -f Makefile_cli).
+ *
+ *     c2py-cli [-j N] [-o DIR | -o -] [--pyc] [--map] [--no-inline]
+ *              [--codegen-threads N] [--memoize [--no-memoize NAME]...] [--bind-globals]
+ *              [--cache DIR] [--cache-size MB] [-q] file.c...
+ *     c2py-cli --serve [--socket PATH] [-j N] [--cache DIR] [--cache-size MB]
+ *     (и [--stats] [--trace FILE] в обоих случаях)
+ *
+ * Каждый файл проходит весь конвейер (translateSource) в пуле потоков;
+ * файлы независимы, поэтому время сборки делится на число потоков. Отчёт о
+ * каждом файле (ok или FAIL с ошибками) печатается в stderr в порядке
+ * аргументов, как только готовы все предыдущие файлы.
+ *
+ *   -j N         потоков; по умолчанию - по числу ядер
+ *   -o DIR       каталог результатов (имя - имя исходника с .py/.pyc);
+ *                по умолчанию - рядом с исходником; "-o -" - в stdout
+ *   --pyc        байт-код CPython 3.11 вместо текста
+ *   --map        карта исходника file.py.map (Source Map v3) рядом с file.py
+ *   --no-inline  без подстановки функций
+ *   --memoize    чистые рекурсивные функции - в functools.lru_cache (только текст;
+ *                глубокая рекурсия раньше упирается в sys.getrecursionlimit())
+ *   --no-memoize NAME  не кешировать функцию NAME (можно повторять)
+ *   --bind-globals  функции и range, вызываемые в циклах, - в локальные имена
+ *                в начале функции (только текст)
+ *   --codegen-threads N  потоков генерации функций внутри одного файла
+ *                (CodeGenOptions::threads); 0 - по числу ядер, по умолчанию 1.
+ *                Вывод тот же, что и в одном потоке; помогает на нескольких
+ *                больших файлах, когда -j не загружает все ядра
+ *   --cache DIR  кеш результатов (TranslationCache): неизменённый файл с теми
+ *                же параметрами не транслируется заново; по умолчанию -
+ *                $C2PY_CACHE, если задана
+ *   --cache-size MB  предел размера кеша; 0 - без предела (по умолчанию 256)
+ *   -q           печатать только ошибки
+ *   --stats      таблица фаз (время, выделения) и счётчики в stderr
+ *   --trace FILE замеры фаз в формате Chrome trace (chrome://tracing, Perfetto);
+ *                --stats и --trace - только в сборке с INSTRUMENT=1
+ *   --serve      не транслировать аргументы, а стать сервером (TranslationServer):
+ *                запросы c2py-client обслуживаются прогретым процессом до
+ *                SIGINT/SIGTERM или c2py-client --stop
+ *   --socket PATH  сокет сервера; по умолчанию $C2PY_SOCKET, $XDG_RUNTIME_DIR/c2py.sock
+ *                или /tmp/c2py-<uid>/c2py.sock. Каталог сокета должен быть
+ *                закрыт для других пользователей (0700), недостающий создаётся
+ *
+ * Код завершения: 0 - все файлы транслированы, 1 - есть ошибки, 2 - неверные
+ * аргументы.
+ */
+
+#include "instrument.h"
+#include "pipeline.h"
+#include "thread_pool.h"
+#include "translation_cache.h"
+#ifndef _WIN32
+#include "protocol.h"
+#include "translation_server.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct CliOptions {
+    size_t threads = 0;
+    std::string outDir;                 // Пусто - рядом с исходником
+    bool toStdout = false;
+    bool writeMap = false;
+    bool quiet = false;
+    bool serve = false;
+    bool printStats = false;
+    std::string traceFile;
+    std::string socketPath;             // Пусто - defaultSocketPath()
+    std::string cacheDir;               // Пусто - без кеша
+    uint64_t cacheMegabytes = 256;
+    TranslateOptions translate;
+    std::vector<std::string> inputs;
+};
+
+// Результат файла, ждущий своей очереди в отчёте
+struct FileJob {
+    std::string input;
+    std::string output;                 // Путь результата; пусто при -o -
+    TranslateResult result;
+    std::string ioError;
+    double ms = 0;
+    bool done = false;
+};
+
+void
+usage (const char* program)
+{
+    std::fprintf(stderr,
+                 "usage: %s [-j N] [-o DIR | -o -] [--pyc] [--map] [--no-inline]\n"
+                 "       [--codegen-threads N] [--memoize [--no-memoize NAME]...] [--bind-globals]\n"
+                 "       [--cache DIR] [--cache-size MB] [-q] file.c...\n"
+                 "       %s --serve [--socket PATH] [-j N] [--cache DIR] [--cache-size MB]\n"
+                 "       (either form also takes --stats and --trace FILE)\n",
+                 program, program);
+}
+
+// Разбор аргументов; false - неверные аргументы (сообщение уже напечатано)
+bool
+parseArguments (int argc, char** argv, CliOptions& options)
+{
+    if (const char* cache = std::getenv("C2PY_CACHE")) {
+        options.cacheDir = cache;
+    }
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j" || arg == "-o" || arg == "--cache" || arg == "--cache-size" ||
+            arg == "--socket" || arg == "--trace" || arg == "--codegen-threads" ||
+            arg == "--no-memoize") {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s: %s needs a value\n", argv[0], arg.c_str());
+                return false;
+            }
+            std::string value = argv[++i];
+            if (arg == "-j") {
+                char* end = nullptr;
+                long threads = std::strtol(value.c_str(), &end, 10);
+                if (*end != '\0' || threads < 1) {
+                    std::fprintf(stderr, "%s: bad thread count '%s'\n", argv[0], value.c_str());
+                    return false;
+                }
+                options.threads = (size_t) threads;
+            }
+            else if (arg == "--codegen-threads") {
+                char* end = nullptr;
+                long threads = std::strtol(value.c_str(), &end, 10);
+                if (*end != '\0' || threads < 0) {
+                    std::fprintf(stderr, "%s: bad thread count '%s'\n", argv[0], value.c_str());
+                    return false;
+                }
+                options.translate.codegen.threads = (size_t) threads;
+            }
+            else if (arg == "--no-memoize") {
+                options.translate.codegen.noMemoize.insert(value);
+            }
+            else if (arg == "--trace") {
+                options.traceFile = value;
+            }
+            else if (arg == "--socket") {
+                options.socketPath = value;
+            }
+            else if (arg == "--cache") {
+                options.cacheDir = value;
+            }
+            else if (arg == "--cache-size") {
+                char* end = nullptr;
+                long long megabytes = std::strtoll(value.c_str(), &end, 10);
+                if (*end != '\0' || megabytes < 0) {
+                    std::fprintf(stderr, "%s: bad cache size '%s'\n", argv[0], value.c_str());
+                    return false;
+                }
+                options.cacheMegabytes = (uint64_t) megabytes;
+            }
+            else if (value == "-") {
+                options.toStdout = true;
+            }
+            else {
+                options.outDir = value;
+            }
+        }
+        else if (arg.compare(0, 2, "-j") == 0 && arg.size() > 2) {
+            options.threads = (size_t) std::max(1, std::atoi(arg.c_str() + 2));
+        }
+        else if (arg == "--pyc") {
+            options.translate.bytecode = true;
+        }
+        else if (arg == "--map") {
+            options.writeMap = true;
+        }
+        else if (arg == "--no-inline") {
+            options.translate.inliner.enabled = false;
+        }
+        else if (arg == "--memoize") {
+            options.translate.codegen.memoizePureRecursive = true;
+        }
+        else if (arg == "--bind-globals") {
+            options.translate.codegen.bindLoopGlobals = true;
+        }
+        else if (arg == "--stats") {
+            options.printStats = true;
+        }
+        else if (arg == "--serve") {
+            options.serve = true;
+        }
+        else if (arg == "-q") {
+            options.quiet = true;
+        }
+        else if (arg == "-h" || arg == "--help") {
+            usage(argv[0]);
+            std::exit(0);
+        }
+        else if (arg.size() > 1 && arg[0] == '-') {
+            std::fprintf(stderr, "%s: unknown option '%s'\n", argv[0], arg.c_str());
+            return false;
+        }
+        else {
+            options.inputs.push_back(arg);
+        }
+    }
+    if (options.inputs.empty() != options.serve) {
+        usage(argv[0]);
+        return false;
+    }
+    if ((options.printStats || !options.traceFile.empty()) && !instrument::enabled()) {
+        std::fprintf(stderr, "%s: --stats and --trace need a build with INSTRUMENT=1 "
+                     "(make -f Makefile_cli clean all INSTRUMENT=1)\n", argv[0]);
+        return false;
+    }
+    if (options.writeMap && options.translate.bytecode) {
+        // В .pyc строки C уже в таблице строк
+        options.writeMap = false;
+    }
+    return true;
+}
+
+bool
+readFile (const std::string& path, std::string& text)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+// Запись через временный файл и rename: прерванная сборка не оставляет
+// обрезанный результат с новым временем изменения
+bool
+writeFile (const std::string& path, const std::string& data)
+{
+    std::string temp = path + ".tmp" + std::to_string(getpid()) + "." +
+                       std::to_string(std::hash<std::string>()(path) & 0xffff);
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(data.data(), (std::streamsize) data.size());
+        if (!out.flush()) {
+            out.close();
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string
+outputPath (const CliOptions& options, const std::string& input)
+{
+    fs::path source(input);
+    fs::path output = options.outDir.empty() ? source : fs::path(options.outDir) / source.filename();
+    output.replace_extension(options.translate.bytecode ? ".pyc" : ".py");
+    return output.string();
+}
+
+void
+translateFile (const CliOptions& options, TranslationCache* cache, FileJob& job)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::string code;
+    if (!readFile(job.input, code)) {
+        job.ioError = "cannot read " + job.input + ": " + std::strerror(errno);
+    }
+    else {
+        TranslateOptions translate = options.translate;
+        translate.fileName = job.input;
+        translate.sourceMap = options.writeMap;
+        job.result = cache ? cache->translate(code, translate) : translateSource(code, translate);
+
+        if (job.result.ok && !options.toStdout) {
+            if (!writeFile(job.output, job.result.output)) {
+                job.ioError = "cannot write " + job.output + ": " + std::strerror(errno);
+            }
+            else if (options.writeMap) {
+                // Исходник в карте - относительно её каталога
+                fs::path mapDir = fs::path(job.output).parent_path();
+                std::string source = fs::path(job.input).lexically_proximate(
+                    mapDir.empty() ? fs::path(".") : mapDir).string();
+                std::string json = job.result.sourceMap.toJson(
+                    fs::path(job.output).filename().string(), source);
+                if (!writeFile(job.output + ".map", json)) {
+                    job.ioError = "cannot write " + job.output + ".map: " + std::strerror(errno);
+                }
+            }
+            // Текст больше не нужен, пока файл ждёт очереди в отчёте
+            job.result.output.clear();
+            job.result.output.shrink_to_fit();
+        }
+    }
+
+    job.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Отчёт о файле; false - файл не транслирован
+bool
+report (const CliOptions& options, const FileJob& job)
+{
+    bool ok = job.result.ok && job.ioError.empty();
+    if (ok && options.toStdout) {
+        std::fwrite(job.result.output.data(), 1, job.result.output.size(), stdout);
+        std::fflush(stdout);
+    }
+    if (!ok) {
+        std::fprintf(stderr, "FAIL %s\n", job.input.c_str());
+        if (!job.ioError.empty()) std::fprintf(stderr, "     %s\n", job.ioError.c_str());
+        for (const auto& error : job.result.errors) {
+            std::fprintf(stderr, "     %s\n", error.c_str());
+        }
+    }
+    else if (!options.quiet) {
+        std::fprintf(stderr, "ok   %s -> %s (%.1f ms)\n", job.input.c_str(),
+                     options.toStdout ? "<stdout>" : job.output.c_str(), job.ms);
+    }
+    if (!options.quiet) {
+        for (const auto& warning : job.result.warnings) {
+            std::fprintf(stderr, "     %s: %s\n", job.input.c_str(), warning.c_str());
+        }
+    }
+    return ok;
+}
+
+// Замеры фаз: таблица в stderr и трасса в файл
+void
+reportInstrumentation (const char* program, const CliOptions& options)
+{
+    if (options.printStats) {
+        std::fprintf(stderr, "%s", instrument::summary().c_str());
+    }
+    if (!options.traceFile.empty() && !writeFile(options.traceFile, instrument::chromeTrace())) {
+        std::fprintf(stderr, "%s: cannot write %s: %s\n", program, options.traceFile.c_str(),
+                     std::strerror(errno));
+    }
+}
+
+#ifndef _WIN32
+
+TranslationServer* activeServer = nullptr;
+
+void
+stopServer (int)
+{
+    if (activeServer) activeServer->stop();
+}
+
+int
+serve (const char* program, const CliOptions& options, TranslationCache* cache)
+{
+    TranslationServer server(options.socketPath.empty() ? defaultSocketPath() : options.socketPath,
+                             cache, options.threads);
+    if (!server.listen()) {
+        std::fprintf(stderr, "%s: %s\n", program, server.error().c_str());
+        return 1;
+    }
+
+    activeServer = &server;
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = stopServer;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    if (!options.quiet) {
+        std::fprintf(stderr, "serving on %s\n", server.socketPath().c_str());
+    }
+    server.run();
+    activeServer = nullptr;
+
+    if (!options.quiet) {
+        ServerStats stats = server.stats();
+        std::fprintf(stderr, "served %llu requests (%llu failed) on %llu connections\n",
+                     (unsigned long long) stats.requests, (unsigned long long) stats.failed,
+                     (unsigned long long) stats.connections);
+    }
+    if (cache) cache->trim();
+    reportInstrumentation(program, options);
+    return 0;
+}
+
+#endif
+
+} // namespace
+
+int
+main (int argc, char** argv)
+{
+    CliOptions options;
+    if (!parseArguments(argc, argv, options)) return 2;
+
+    std::unique_ptr<TranslationCache> cache;
+    if (!options.cacheDir.empty()) {
+        cache.reset(new TranslationCache(options.cacheDir, options.cacheMegabytes << 20));
+    }
+    if (options.serve) {
+#ifndef _WIN32
+        return serve(argv[0], options, cache.get());
+#else
+        std::fprintf(stderr, "%s: --serve needs Unix domain sockets\n", argv[0]);
+        return 2;
+#endif
+    }
+
+    if (!options.outDir.empty()) {
+        std::error_code error;
+        fs::create_directories(options.outDir, error);
+        if (error) {
+            std::fprintf(stderr, "%s: cannot create %s: %s\n", argv[0],
+                         options.outDir.c_str(), error.message().c_str());
+            return 1;
+        }
+    }
+
+    // Два исходника с одним именем в общий каталог - ошибка второго, а не перезапись
+    std::vector<FileJob> jobs(options.inputs.size());
+    std::set<std::string> outputs;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        jobs[i].input = options.inputs[i];
+        if (!options.toStdout) {
+            jobs[i].output = outputPath(options, jobs[i].input);
+            if (!outputs.insert(jobs[i].output).second) {
+                jobs[i].ioError = "output " + jobs[i].output + " is produced by an earlier input";
+                jobs[i].done = true;
+            }
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t threads = options.threads ? options.threads : ThreadPool::defaultThreads();
+    std::mutex reportMutex;
+    size_t nextReport = 0;
+    std::atomic<size_t> failed(0);
+
+    // Отчёт по порядку аргументов: печатаем все готовые файлы подряд от nextReport
+    auto flushReports = [&]() {
+        while (nextReport < jobs.size() && jobs[nextReport].done) {
+            if (!report(options, jobs[nextReport])) ++failed;
+            jobs[nextReport].result = TranslateResult();
+            ++nextReport;
+        }
+    };
+
+    {
+        ThreadPool pool(std::min(threads, jobs.size()));
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            if (jobs[i].done) continue;
+            pool.submit([&, i] {
+                translateFile(options, cache.get(), jobs[i]);
+                std::lock_guard<std::mutex> lock(reportMutex);
+                jobs[i].done = true;
+                flushReports();
+            });
+        }
+        pool.wait();
+    }
+    flushReports();
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (!options.quiet || failed) {
+        std::fprintf(stderr, "%zu files: %zu ok, %zu failed in %.1f ms (%zu threads)\n",
+                     jobs.size(), jobs.size() - failed.load(), failed.load(), ms,
+                     std::min(threads, jobs.size()));
+    }
+    reportInstrumentation(argv[0], options);
+    if (cache) {
+        // Записанное за этот запуск могло вывести каталог за предел
+        cache->trim();
+        if (!options.quiet) {
+            CacheStats stats = cache->stats();
+            std::fprintf(stderr, "cache %s: %llu hits, %llu misses, %llu evicted\n",
+                         cache->directory().c_str(), (unsigned long long) stats.hits,
+                         (unsigned long long) stats.misses, (unsigned long long) stats.evictions);
+        }
+    }
+    return failed ? 1 : 0;
+}
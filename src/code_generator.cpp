@@ -1,17 +1,56 @@
 #include "code_generator.h"
+#include "instrument.h"
+#include "thread_pool.h"
 #include <algorithm>
 #include <cctype>
 #include <cassert>
 
-CodeGenerator::CodeGenerator(const SemanticAnalyzer* analyzer)
-    : semanticAnalyzer(analyzer), indentLevel(0) {}
+CodeGenerator::CodeGenerator(const SemanticAnalyzer* analyzer, const CodeGenOptions& options)
+    : semanticAnalyzer(analyzer), options(options), indentLevel(0) {}
 
-std::string CodeGenerator::getIndent() const {
-    std::string indent;
-    for (int i = 0; i < indentLevel; ++i) {
-        indent += indentStr;
+namespace {
+// Отступ любой глубины - срез одной строки пробелов
+const std::string indentRun(256, ' ');
+}
+
+void CodeGenerator::write(const std::string& text) {
+    line.append(text);
+}
+
+void CodeGenerator::write(const char* text) {
+    line.append(text);
+}
+
+void CodeGenerator::write(char c) {
+    line.push_back(c);
+}
+
+void CodeGenerator::beginLine() {
+    // Буфер строки переиспользуется: после первых строк память не выделяется
+    line.clear();
+    size_t width = indentLevel * indentWidth;
+    while (width > indentRun.size()) {
+        line.append(indentRun);
+        width -= indentRun.size();
+    }
+    line.append(indentRun, 0, width);
+}
+
+void CodeGenerator::endLine() {
+    // Отступ, текст и перевод строки - одним вызовом приёмника
+    line.push_back('\n');
+    C2PY_COUNT(LinesEmitted, 1);
+    C2PY_COUNT(BytesEmitted, line.size());
+    out->append(line);
+    line.clear();
+    if (sourceMap) sourceMap->addLine(position);
+}
+
+void CodeGenerator::setPosition(const ASTNode* node) {
+    // Узлы, созданные оптимизатором без позиции, относятся к внешнему оператору
+    if (node && node->line > 0) {
+        position = { node->line, node->column };
     }
-    return indent;
 }
 
 void CodeGenerator::increaseIndent() {
@@ -22,38 +61,46 @@ void CodeGenerator::decreaseIndent() {
     if (indentLevel > 0) --indentLevel;
 }
 
-void CodeGenerator::emitLine(const std::string& line) {
-    if (!line.empty()) {
-        output << getIndent() << line << "\n";
-    } else {
-        output << "\n";
+void CodeGenerator::emitLine(const std::string& text) {
+    if (!text.empty()) {
+        beginLine();
+        write(text);
     }
+    endLine();
 }
 
 void CodeGenerator::reset() {
-    output.str("");
-    output.clear();
+    out = nullptr;
+    sourceMap = nullptr;
+    position = SourcePosition();
+    line.clear();
     indentLevel = 0;
     inLoop = false;
     inFunction = false;
     hasReturn = false;
     currentFunctionName = "";
+    currentFunction = nullptr;
+    tailCalls.clear();
+    localAliases.clear();
+    loopStack.clear();
+    hoisted.clear();
+    hoistedCount = 0;
     requiredImports.clear();
 }
 
 // ===== Трансляция операторов =====
 
-std::string CodeGenerator::translateUnaryOp(const std::string& op) {
+const char* CodeGenerator::translateUnaryOp(const std::string& op) {
     if (op == "++") return "+= 1";  // Преобразуется в составное присваивание
     if (op == "--") return "-= 1";
     if (op == "!") return "not ";
     if (op == "-") return "-";
     if (op == "+") return "+";
     if (op == "~") return "~";
-    return op;
+    return op.c_str();
 }
 
-std::string CodeGenerator::translateBinaryOp(const std::string& op) {
+const char* CodeGenerator::translateBinaryOp(const std::string& op) {
     if (op == "==") return "==";
     if (op == "!=") return "!=";
     if (op == "<") return "<";
@@ -83,96 +130,212 @@ std::string CodeGenerator::translateBinaryOp(const std::string& op) {
     if (op == "<<=") return "<<=";
     if (op == ">>=") return ">>=";
     if (op == "=") return "=";
-    return op;
+    return op.c_str();
 }
 
 // ===== Генерация выражений =====
 
-std::string CodeGenerator::generateNumber(NumberExpr* expr) {
-    return expr->value;
+void CodeGenerator::generateNumber(NumberExpr* expr) {
+    write(expr->value);
 }
 
-std::string CodeGenerator::generateIdentifier(IdentifierExpr* expr) {
-    return pythonifyVarName(expr->name);
+void CodeGenerator::generateIdentifier(IdentifierExpr* expr) {
+    write(pythonifyVarName(expr->name));
 }
 
-std::string CodeGenerator::generateUnary(UnaryExpr* expr) {
-    std::string operand = generateExpression(expr->expr.get());
-    std::string op = translateUnaryOp(expr->op);
-    
+// Приоритеты операций Python (больше - связывает сильнее)
+namespace {
+enum Precedence {
+    PrecStatement = 0,      // Присваивания, допустимые только как оператор
+    PrecOr = 1,
+    PrecAnd = 2,
+    PrecNot = 3,
+    PrecComparison = 4,
+    PrecAdditive = 6,
+    PrecMultiplicative = 7,
+    PrecUnary = 8,
+    PrecAtom = 10
+};
+
+int binaryPrecedence(const std::string& op) {
+    if (op == "||") return PrecOr;
+    if (op == "&&") return PrecAnd;
+    if (op == "==" || op == "!=" || op == "<" || op == ">" || op == "<=" || op == ">=") {
+        return PrecComparison;
+    }
+    if (op == "+" || op == "-") return PrecAdditive;
+    if (op == "*" || op == "/" || op == "%") return PrecMultiplicative;
+    return PrecStatement;
+}
+}
+
+int CodeGenerator::precedenceOf(Expression* expr) const {
+    if (hoisted.count(expr)) {
+        return PrecAtom;
+    }
+    if (needsWrap(expr)) {
+        // Составное присваивание с маской остаётся оператором
+        auto binary = dynamic_cast<BinaryExpr*>(expr);
+        auto unary = dynamic_cast<UnaryExpr*>(expr);
+        if ((binary && SemanticAnalyzer::isAssignmentOp(binary->op)) ||
+            (unary && (unary->op == "++" || unary->op == "--"))) {
+            return PrecStatement;
+        }
+        return PrecAtom;
+    }
+    if (auto* unary = dynamic_cast<UnaryExpr*>(expr)) {
+        if (unary->op == "!") return PrecNot;
+        if (unary->op == "++" || unary->op == "--") return PrecStatement;
+        return PrecUnary;
+    }
+    if (auto* binary = dynamic_cast<BinaryExpr*>(expr)) {
+        return binaryPrecedence(binary->op);
+    }
+    return PrecAtom;
+}
+
+void CodeGenerator::generateOperand(Expression* expr, int minPrecedence) {
+    bool parens = precedenceOf(expr) < minPrecedence;
+    if (parens) write('(');
+    generateExpression(expr);
+    if (parens) write(')');
+}
+
+bool CodeGenerator::needsWrap(const Expression* expr) const {
+    return options.wrapIntegerOverflow && semanticAnalyzer && semanticAnalyzer->mayOverflow(expr);
+}
+
+// Приведение к 32-битному int со знаком без вызова функции:
+// ((value + 0x80000000 & 0xFFFFFFFF) - 0x80000000)
+void CodeGenerator::beginWrap() {
+    write("((");
+}
+
+void CodeGenerator::endWrap() {
+    write(" + 0x80000000 & 0xFFFFFFFF) - 0x80000000)");
+}
+
+void CodeGenerator::generateUnary(UnaryExpr* expr) {
     // Специальная обработка для инкремента/декремента
     if (expr->op == "++" || expr->op == "--") {
         // Унарный постфикс/префикс инкремент - преобразуется в составное присваивание
         // В контексте выражения это обычно используется как statement
         IdentifierExpr* id = dynamic_cast<IdentifierExpr*>(expr->expr.get());
         if (id) {
-            std::string pyOp = (expr->op == "++") ? "+=" : "-=";
-            return pythonifyVarName(id->name) + " " + pyOp + " 1";
+            std::string name = pythonifyVarName(id->name);
+            write(name);
+            if (needsWrap(expr)) {
+                write(" = ");
+                beginWrap();
+                write(name);
+                write(expr->op == "++" ? " + 1" : " - 1");
+                endWrap();
+                return;
+            }
+            write(expr->op == "++" ? " += 1" : " -= 1");
+            return;
         }
     }
     
     // Логический NOT
     if (expr->op == "!") {
-        return "not " + operand;
+        write("not ");
+        generateOperand(expr->expr.get(), PrecNot);
+        return;
     }
     
     // Унарные + и -
-    return op + operand;
+    bool wrap = needsWrap(expr);
+    if (wrap) beginWrap();
+    write(translateUnaryOp(expr->op));
+    generateOperand(expr->expr.get(), PrecUnary);
+    if (wrap) endWrap();
 }
 
-std::string CodeGenerator::generateBinary(BinaryExpr* expr) {
-    std::string lhs = generateExpression(expr->lhs.get());
-    std::string rhs = generateExpression(expr->rhs.get());
-    std::string op = translateBinaryOp(expr->op);
+void CodeGenerator::generateBinary(BinaryExpr* expr) {
+    if (SemanticAnalyzer::isAssignmentOp(expr->op)) {
+        generateExpression(expr->lhs.get());
+        if (expr->op != "=" && needsWrap(expr)) {
+            // x += e  ->  x = wrap(x + e)
+            std::string arithOp = expr->op.substr(0, 1);
+            write(" = ");
+            beginWrap();
+            generateExpression(expr->lhs.get());
+            write(' ');
+            write(translateBinaryOp(arithOp));
+            write(' ');
+            generateOperand(expr->rhs.get(), binaryPrecedence(arithOp) + 1);
+            endWrap();
+            return;
+        }
+        write(' ');
+        write(translateBinaryOp(expr->op));
+        write(' ');
+        generateExpression(expr->rhs.get());
+        return;
+    }
     
-    return lhs + " " + op + " " + rhs;
+    // Операции левоассоциативны; сравнения в Python образуют цепочки, поэтому
+    // вложенное сравнение всегда берём в скобки
+    int prec = binaryPrecedence(expr->op);
+    int lhsPrec = (prec == PrecComparison) ? prec + 1 : prec;
+    bool wrap = needsWrap(expr);
+    if (wrap) beginWrap();
+    generateOperand(expr->lhs.get(), lhsPrec);
+    write(' ');
+    write(translateBinaryOp(expr->op));
+    write(' ');
+    generateOperand(expr->rhs.get(), prec + 1);
+    if (wrap) endWrap();
 }
 
-std::string CodeGenerator::generateCall(CallExpr* expr) {
+void CodeGenerator::generateCall(CallExpr* expr) {
     std::string funcName = pythonifyVarName(expr->name);
-    std::string args;
+    auto alias = localAliases.find(funcName);
+    write(alias != localAliases.end() ? alias->second : funcName);
     
+    write('(');
     for (size_t i = 0; i < expr->args.size(); ++i) {
-        if (i > 0) args += ", ";
-        args += generateExpression(expr->args[i].get());
+        if (i > 0) write(", ");
+        generateExpression(expr->args[i].get());
     }
-    
-    return funcName + "(" + args + ")";
+    write(')');
 }
 
-std::string CodeGenerator::generateExpression(Expression* expr) {
-    if (!expr) return "";
+void CodeGenerator::generateExpression(Expression* expr) {
+    if (!expr) return;
     
-    if (auto* num = dynamic_cast<NumberExpr*>(expr)) {
-        return generateNumber(num);
-    }
-    if (auto* id = dynamic_cast<IdentifierExpr*>(expr)) {
-        return generateIdentifier(id);
-    }
-    if (auto* unary = dynamic_cast<UnaryExpr*>(expr)) {
-        return generateUnary(unary);
-    }
-    if (auto* binary = dynamic_cast<BinaryExpr*>(expr)) {
-        return generateBinary(binary);
-    }
-    if (auto* call = dynamic_cast<CallExpr*>(expr)) {
-        return generateCall(call);
+    auto inv = hoisted.find(expr);
+    if (inv != hoisted.end()) {
+        write(inv->second);
+        return;
     }
     
-    return "";
+    if (auto* num = dynamic_cast<NumberExpr*>(expr)) {
+        generateNumber(num);
+    } else if (auto* id = dynamic_cast<IdentifierExpr*>(expr)) {
+        generateIdentifier(id);
+    } else if (auto* unary = dynamic_cast<UnaryExpr*>(expr)) {
+        generateUnary(unary);
+    } else if (auto* binary = dynamic_cast<BinaryExpr*>(expr)) {
+        generateBinary(binary);
+    } else if (auto* call = dynamic_cast<CallExpr*>(expr)) {
+        generateCall(call);
+    }
 }
 
 // ===== Генерация операторов =====
 
 void CodeGenerator::generateVarDecl(VarDecl* decl) {
-    std::string varName = pythonifyVarName(decl->name);
+    beginLine();
+    write(pythonifyVarName(decl->name));
+    write(" = ");
     
     if (decl->init) {
-        std::string initValue = generateExpression(decl->init.get());
-        emitLine(varName + " = " + initValue);
+        generateExpression(decl->init.get());
     } else {
         // Инициализация по умолчанию в зависимости от типа
-        std::string defaultValue = "0";  // Для числовых типов
+        const char* defaultValue = "0";  // Для числовых типов
         if (decl->type == "float" || decl->type == "double") {
             defaultValue = "0.0";
         } else if (decl->type == "char") {
@@ -180,14 +343,24 @@ void CodeGenerator::generateVarDecl(VarDecl* decl) {
         } else if (decl->type == "bool") {
             defaultValue = "False";
         }
-        emitLine(varName + " = " + defaultValue);
+        write(defaultValue);
     }
+    endLine();
 }
 
 void CodeGenerator::generateExpressionStmt(ExpressionStmt* stmt) {
-    std::string expr = generateExpression(stmt->expr.get());
-    if (!expr.empty()) {
-        emitLine(expr);
+    if (!stmt->expr) return;
+    beginLine();
+    generateExpression(stmt->expr.get());
+    endLine();
+}
+
+void CodeGenerator::generateBody(Statement* stmt) {
+    // Python не допускает пустых блоков (например, после удаления мёртвого кода)
+    size_t before = out->size();
+    generateStatement(stmt);
+    if (out->size() == before) {
+        emitLine("pass");
     }
 }
 
@@ -200,32 +373,59 @@ void CodeGenerator::generateBlock(BlockStmt* block) {
 }
 
 void CodeGenerator::generateIf(IfStmt* stmt) {
-    std::string condition = generateExpression(stmt->condition.get());
-    emitLine("if " + condition + ":");
+    beginLine();
+    write("if ");
+    generateExpression(stmt->condition.get());
+    write(':');
+    endLine();
     
     increaseIndent();
-    generateStatement(stmt->thenBranch.get());
+    generateBody(stmt->thenBranch.get());
     decreaseIndent();
     
     if (stmt->elseBranch) {
         emitLine("else:");
         increaseIndent();
-        generateStatement(stmt->elseBranch.get());
+        generateBody(stmt->elseBranch.get());
         decreaseIndent();
     }
 }
 
+void CodeGenerator::hoistInvariants(Statement* loop) {
+    if (!options.hoistLoopInvariants || !semanticAnalyzer) return;
+    
+    const std::vector<Expression*>* invariants = semanticAnalyzer->getLoopInvariants(loop);
+    if (!invariants) return;
+    
+    for (Expression* expr : *invariants) {
+        // Вложенные инварианты внешних циклов уже заменены своими временными
+        std::string name = "_c2py_inv" + std::to_string(hoistedCount++);
+        beginLine();
+        write(name);
+        write(" = ");
+        generateExpression(expr);
+        endLine();
+        hoisted[expr] = name;
+    }
+}
+
 void CodeGenerator::generateWhile(WhileStmt* stmt) {
-    std::string condition = generateExpression(stmt->condition.get());
-    emitLine("while " + condition + ":");
+    hoistInvariants(stmt);
+    beginLine();
+    write("while ");
+    generateExpression(stmt->condition.get());
+    write(':');
+    endLine();
     
     bool wasInLoop = inLoop;
     inLoop = true;
+    loopStack.push_back({ nullptr, nullptr });
     
     increaseIndent();
-    generateStatement(stmt->body.get());
+    generateBody(stmt->body.get());
     decreaseIndent();
     
+    loopStack.pop_back();
     inLoop = wasInLoop;
 }
 
@@ -235,112 +435,302 @@ void CodeGenerator::generateDoWhile(DoWhileStmt* stmt) {
     //     ...body...
     //     if not condition: break
     
+    hoistInvariants(stmt);
     emitLine("while True:");
     
     bool wasInLoop = inLoop;
     inLoop = true;
     
+    // continue в do-while переходит к проверке условия
+    loopStack.push_back({ nullptr, stmt->condition.get() });
+    
     increaseIndent();
     generateStatement(stmt->body.get());
-    
-    std::string condition = generateExpression(stmt->condition.get());
-    emitLine("if not (" + condition + "): break");
+    setPosition(stmt->condition.get());
+    generateDoWhileExit(stmt->condition.get());
     
     decreaseIndent();
+    loopStack.pop_back();
     inLoop = wasInLoop;
 }
 
 void CodeGenerator::generateFor(ForStmt* stmt) {
+    // Цикл с доказанной индуктивной переменной -> range()
+    const InductionVariable* iv = semanticAnalyzer
+        ? semanticAnalyzer->getInductionVariable(stmt) : nullptr;
+    if (iv) {
+        generateRangeFor(stmt, *iv);
+        return;
+    }
+    
     // Инициализация
     if (stmt->init) {
         generateStatement(stmt->init.get());
     }
+    hoistInvariants(stmt);
     
-    // Условие по умолчанию True (бесконечный цикл)
-    std::string condition = "True";
+    // Общий случай: while цикл с условием, по умолчанию True (бесконечный цикл)
+    beginLine();
+    write("while ");
     if (stmt->condition) {
-        condition = generateExpression(stmt->condition.get());
-    }
-    
-    // Проверка: if это простой инкремент (i++), то используем range()
-    if (auto* exprStmt = dynamic_cast<ExpressionStmt*>(stmt->init.get())) {
-        if (auto* binExpr = dynamic_cast<BinaryExpr*>(exprStmt->expr.get())) {
-            if (binExpr->op == "=" && dynamic_cast<IdentifierExpr*>(binExpr->lhs.get())) {
-                // Это присваивание, может быть начало цикла
-                // Попытаемся создать Python range() цикл для простых случаев
-                
-                // Проверяем условие и update
-                if (auto* condBin = dynamic_cast<BinaryExpr*>(stmt->condition.get())) {
-                    if ((condBin->op == "<" || condBin->op == "<=") && 
-                        dynamic_cast<IdentifierExpr*>(condBin->lhs.get())) {
-                        
-                        if (auto* updateBin = dynamic_cast<BinaryExpr*>(stmt->update.get())) {
-                            if ((updateBin->op == "++" || updateBin->op == "+=")) {
-                                // Это для цикла for (i = X; i < Y; i++)
-                                std::string varName = generateExpression(dynamic_cast<IdentifierExpr*>(condBin->lhs.get()));
-                                std::string endVal = generateExpression(condBin->rhs.get());
-                                std::string startVal = generateExpression(binExpr->rhs.get());
-                                
-                                emitLine("for " + varName + " in range(" + startVal + ", " + endVal + "):");
-                                
-                                bool wasInLoop = inLoop;
-                                inLoop = true;
-                                
-                                increaseIndent();
-                                generateStatement(stmt->body.get());
-                                decreaseIndent();
-                                
-                                inLoop = wasInLoop;
-                                return;
-                            }
-                        }
-                    }
-                }
-            }
-        }
+        generateExpression(stmt->condition.get());
+    } else {
+        write("True");
     }
-    
-    // Общий случай: while цикл с условием
-    emitLine("while " + condition + ":");
+    write(':');
+    endLine();
     
     bool wasInLoop = inLoop;
     inLoop = true;
+    // continue в for должен сначала выполнить update
+    loopStack.push_back({ stmt->update.get(), nullptr });
     
     increaseIndent();
+    size_t bodyStart = out->size();
     generateStatement(stmt->body.get());
     
     // Обновление
     if (stmt->update) {
-        std::string updateExpr = generateExpression(stmt->update.get());
-        if (!updateExpr.empty()) {
-            emitLine(updateExpr);
-        }
+        setPosition(stmt->update.get());
+        beginLine();
+        generateExpression(stmt->update.get());
+        endLine();
+    }
+    if (out->size() == bodyStart) {
+        emitLine("pass");
     }
     
     decreaseIndent();
+    loopStack.pop_back();
     inLoop = wasInLoop;
 }
 
+void CodeGenerator::generateRangeFor(ForStmt* stmt, const InductionVariable& iv) {
+    std::string varName = pythonifyVarName(static_cast<const VarDecl*>(iv.var)->name);
+    
+    // Если i читается после цикла, присваиваем начальное значение как в C
+    // и восстанавливаем итоговое значение в ветке else
+    if (iv.liveAfterLoop && stmt->init) {
+        generateStatement(stmt->init.get());
+    }
+    hoistInvariants(stmt);
+    
+    auto range = localAliases.find("range");
+    beginLine();
+    write("for ");
+    write(varName);
+    write(" in ");
+    write(range != localAliases.end() ? range->second : "range");
+    write('(');
+    if (!iv.liveAfterLoop && iv.start) {
+        generateExpression(iv.start);
+    } else {
+        write(varName);
+    }
+    write(", ");
+    generateRangeStop(iv);
+    if (iv.step != 1) {
+        write(", ");
+        write(std::to_string(iv.step));
+    }
+    write("):");
+    endLine();
+    
+    bool wasInLoop = inLoop;
+    inLoop = true;
+    loopStack.push_back({ nullptr, nullptr });
+    
+    increaseIndent();
+    generateBody(stmt->body.get());
+    decreaseIndent();
+    
+    loopStack.pop_back();
+    inLoop = wasInLoop;
+    
+    if (iv.liveAfterLoop) {
+        // После полного прохода в C значение i равно границе (или старту, если цикл пуст)
+        emitLine("else:");
+        increaseIndent();
+        beginLine();
+        write("if ");
+        write(varName);
+        write(iv.step > 0 ? " < " : " > ");
+        generateRangeStop(iv);
+        write(": ");
+        write(varName);
+        write(" = ");
+        generateRangeStop(iv);
+        endLine();
+        decreaseIndent();
+    }
+}
+
+void CodeGenerator::generateRangeStop(const InductionVariable& iv) {
+    generateExpression(iv.bound);
+    if (iv.inclusive) {
+        write(iv.step > 0 ? " + 1" : " - 1");
+    }
+}
+
 void CodeGenerator::generateReturn(ReturnStmt* stmt) {
-    // Если мы в main, то return должен быть заменен на exit() или sys.exit()
-    if (inFunction && currentFunctionName == "main") {
-        if (stmt->value) {
-            std::string value = generateExpression(stmt->value.get());
-            requiredImports.insert("import sys");
-            emitLine("sys.exit(" + value + ")");
+    // Код возврата main передаётся в sys.exit() при вызове (см. generateMainFunction)
+    if (tailCalls.count(stmt)) {
+        generateTailCall(static_cast<CallExpr*>(stmt->value.get()));
+    } else if (stmt->value) {
+        beginLine();
+        write("return ");
+        generateExpression(stmt->value.get());
+        endLine();
+    } else {
+        emitLine("return");
+    }
+    hasReturn = true;
+}
+
+void CodeGenerator::generateTailCall(CallExpr* call) {
+    // Параметр, которому передаётся он сам, не перепривязывается
+    std::vector<size_t> rebound;
+    for (size_t i = 0; i < call->args.size(); ++i) {
+        auto id = dynamic_cast<IdentifierExpr*>(call->args[i].get());
+        if (!id || id->name != currentFunction->params[i].second) {
+            rebound.push_back(i);
+        }
+    }
+    
+    // Новые значения вычисляются до присваивания - кортежем, как аргументы вызова
+    if (!rebound.empty()) {
+        beginLine();
+        for (size_t k = 0; k < rebound.size(); ++k) {
+            if (k > 0) write(", ");
+            write(pythonifyVarName(currentFunction->params[rebound[k]].second));
+        }
+        write(" = ");
+        for (size_t k = 0; k < rebound.size(); ++k) {
+            if (k > 0) write(", ");
+            generateExpression(call->args[rebound[k]].get());
+        }
+        endLine();
+    }
+    emitLine("continue");
+}
+
+bool CodeGenerator::isSelfCall(const Expression* expr, const FunctionDecl* func) const {
+    auto call = dynamic_cast<const CallExpr*>(expr);
+    if (!call || call->name != func->name || call->args.size() != func->params.size()) {
+        return false;
+    }
+    return !semanticAnalyzer || semanticAnalyzer->getCallGraph().calleeOf(call) == func;
+}
+
+bool CodeGenerator::shouldMemoize(const FunctionDecl* func) const {
+    if (!options.memoizePureRecursive || !semanticAnalyzer || options.noMemoize.count(func->name)) {
+        return false;
+    }
+    // Хвостовая рекурсия уже стала циклом - кешировать остаётся только внешний вызов
+    if (!tailCalls.empty()) return false;
+    
+    const CallGraph& callGraph = semanticAnalyzer->getCallGraph();
+    if (!callGraph.isRecursive(func) || !callGraph.isPure(func)) return false;
+    
+    // Ключ кеша - аргументы: только числа, хешируемые и сравниваемые по значению
+    auto ann = semanticAnalyzer->getAnnotationForNode(const_cast<FunctionDecl*>(func));
+    if (!ann || ann->returnType.kind == TypeInfo::Void) return false;
+    for (const TypeInfo& type : ann->paramTypes) {
+        if (type.isArray || !(type.isIntegral() || type.isNumeric())) return false;
+    }
+    return true;
+}
+
+void CodeGenerator::bindLoopGlobals(Statement* body, bool bodyIsLoop) {
+    // Один поиск в globals/builtins при входе вместо поиска на каждой итерации
+    std::set<std::string> names;
+    collectLoopGlobals(body, bodyIsLoop, names);
+    for (const std::string& name : names) {
+        std::string alias = "_c2py_" + name;
+        beginLine();
+        write(alias);
+        write(" = ");
+        write(name);
+        endLine();
+        localAliases[name] = alias;
+    }
+}
+
+void CodeGenerator::collectLoopGlobals(Statement* stmt, bool inLoop, std::set<std::string>& names) {
+    if (!stmt) return;
+    
+    if (auto* exprStmt = dynamic_cast<ExpressionStmt*>(stmt)) {
+        if (inLoop) collectLoopGlobals(exprStmt->expr.get(), names);
+    } else if (auto* decl = dynamic_cast<VarDecl*>(stmt)) {
+        if (inLoop) collectLoopGlobals(decl->init.get(), names);
+    } else if (auto* ret = dynamic_cast<ReturnStmt*>(stmt)) {
+        if (!inLoop) return;
+        if (tailCalls.count(ret)) {
+            // Хвостовой вызов становится перепривязкой параметров: вызываются только аргументы
+            for (auto& arg : static_cast<CallExpr*>(ret->value.get())->args) {
+                collectLoopGlobals(arg.get(), names);
+            }
         } else {
-            requiredImports.insert("import sys");
-            emitLine("sys.exit(0)");
+            collectLoopGlobals(ret->value.get(), names);
         }
-    } else {
-        if (stmt->value) {
-            std::string value = generateExpression(stmt->value.get());
-            emitLine("return " + value);
+    } else if (auto* block = dynamic_cast<BlockStmt*>(stmt)) {
+        for (auto& s : block->statements) {
+            collectLoopGlobals(s.get(), inLoop, names);
+        }
+    } else if (auto* ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+        if (inLoop) collectLoopGlobals(ifStmt->condition.get(), names);
+        collectLoopGlobals(ifStmt->thenBranch.get(), inLoop, names);
+        collectLoopGlobals(ifStmt->elseBranch.get(), inLoop, names);
+    } else if (auto* whileStmt = dynamic_cast<WhileStmt*>(stmt)) {
+        collectLoopGlobals(whileStmt->condition.get(), names);
+        collectLoopGlobals(whileStmt->body.get(), true, names);
+    } else if (auto* doWhile = dynamic_cast<DoWhileStmt*>(stmt)) {
+        collectLoopGlobals(doWhile->condition.get(), names);
+        collectLoopGlobals(doWhile->body.get(), true, names);
+    } else if (auto* forStmt = dynamic_cast<ForStmt*>(stmt)) {
+        collectLoopGlobals(forStmt->init.get(), inLoop, names);
+        if (semanticAnalyzer && semanticAnalyzer->getInductionVariable(forStmt)) {
+            // Границы range() вычисляются один раз, сам range - при каждом входе в цикл
+            if (inLoop) {
+                names.insert("range");
+                collectLoopGlobals(forStmt->condition.get(), names);
+            }
         } else {
-            emitLine("return");
+            collectLoopGlobals(forStmt->condition.get(), names);
+            collectLoopGlobals(forStmt->update.get(), names);
+        }
+        collectLoopGlobals(forStmt->body.get(), true, names);
+    }
+}
+
+void CodeGenerator::collectLoopGlobals(Expression* expr, std::set<std::string>& names) {
+    if (auto* call = dynamic_cast<CallExpr*>(expr)) {
+        names.insert(pythonifyVarName(call->name));
+        for (auto& arg : call->args) {
+            collectLoopGlobals(arg.get(), names);
+        }
+    } else if (auto* unary = dynamic_cast<UnaryExpr*>(expr)) {
+        collectLoopGlobals(unary->expr.get(), names);
+    } else if (auto* binary = dynamic_cast<BinaryExpr*>(expr)) {
+        collectLoopGlobals(binary->lhs.get(), names);
+        collectLoopGlobals(binary->rhs.get(), names);
+    }
+}
+
+void CodeGenerator::collectTailCalls(Statement* stmt, const FunctionDecl* func) {
+    // Внутри циклов continue относился бы к самому циклу - такие вызовы не трогаем
+    if (auto* block = dynamic_cast<BlockStmt*>(stmt)) {
+        for (auto& s : block->statements) {
+            collectTailCalls(s.get(), func);
+        }
+    } else if (auto* ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+        collectTailCalls(ifStmt->thenBranch.get(), func);
+        collectTailCalls(ifStmt->elseBranch.get(), func);
+    } else if (auto* returnStmt = dynamic_cast<ReturnStmt*>(stmt)) {
+        if (isSelfCall(returnStmt->value.get(), func)) {
+            tailCalls.insert(returnStmt);
         }
     }
-    hasReturn = true;
 }
 
 void CodeGenerator::generateBreak(BreakStmt*) {
@@ -358,12 +748,35 @@ void CodeGenerator::generateContinue(ContinueStmt*) {
         emitLine("# continue outside loop");
         return;
     }
+    
+    // Действия, которые в C выполняются при переходе к следующей итерации
+    const LoopContext& loop = loopStack.back();
+    if (loop.update) {
+        beginLine();
+        generateExpression(loop.update);
+        endLine();
+    }
+    if (loop.doWhileCondition) {
+        generateDoWhileExit(loop.doWhileCondition);
+    }
     emitLine("continue");
 }
 
+void CodeGenerator::generateDoWhileExit(Expression* condition) {
+    beginLine();
+    write("if not (");
+    generateExpression(condition);
+    write("): break");
+    endLine();
+}
+
 void CodeGenerator::generateStatement(Statement* stmt) {
     if (!stmt) return;
     
+    // Строки после вложенного оператора (update цикла, else) - снова от этого
+    SourcePosition outer = position;
+    setPosition(stmt);
+    
     if (auto* varDecl = dynamic_cast<VarDecl*>(stmt)) {
         generateVarDecl(varDecl);
     } else if (auto* exprStmt = dynamic_cast<ExpressionStmt*>(stmt)) {
@@ -385,6 +798,7 @@ void CodeGenerator::generateStatement(Statement* stmt) {
     } else if (auto* continueStmt = dynamic_cast<ContinueStmt*>(stmt)) {
         generateContinue(continueStmt);
     }
+    position = outer;
 }
 
 // ===== Генерация функций =====
@@ -394,57 +808,87 @@ bool CodeGenerator::isMainFunction(const std::string& name) {
 }
 
 void CodeGenerator::generateFunctionDecl(FunctionDecl* func) {
-    if (isMainFunction(func->name)) {
-        generateMainFunction();
-    } else {
-        // Обычная функция
-        std::string funcName = pythonifyVarName(func->name);
-        
-        std::string params;
+    // Текст функции зависит только от неё самой: временные нумеруются заново
+    hoisted.clear();
+    hoistedCount = 0;
+    
+    // main - тоже обычная функция: её переменные локальные (LOAD_FAST),
+    // а не глобальные переменные модуля
+    std::string funcName = pythonifyVarName(func->name);
+    
+    // У main параметров нет (MainWithParameters): точка входа вызывает main()
+    std::string params;
+    if (!isMainFunction(func->name)) {
         for (size_t i = 0; i < func->params.size(); ++i) {
             if (i > 0) params += ", ";
             params += pythonifyVarName(func->params[i].second);
         }
-        
-        emitLine("def " + funcName + "(" + params + "):");
-        
-        bool wasInFunc = inFunction;
-        std::string prevFuncName = currentFunctionName;
-        inFunction = true;
-        currentFunctionName = func->name;
-        hasReturn = false;
-        
+    }
+    
+    tailCalls.clear();
+    if (options.convertTailCalls && func->body) {
+        collectTailCalls(func->body.get(), func);
+    }
+    
+    setPosition(func);
+    if (shouldMemoize(func)) {
+        requiredImports.insert("import functools");
+        emitLine("@functools.lru_cache(maxsize=None)");
+    }
+    emitLine("def " + funcName + "(" + params + "):");
+    
+    bool wasInFunc = inFunction;
+    std::string prevFuncName = currentFunctionName;
+    inFunction = true;
+    currentFunctionName = func->name;
+    currentFunction = func;
+    hasReturn = false;
+    
+    increaseIndent();
+    if (options.bindLoopGlobals && func->body) {
+        bindLoopGlobals(func->body.get(), !tailCalls.empty());
+    }
+    if (!tailCalls.empty()) {
+        // Хвостовая рекурсия: каждая итерация - новый вызов
+        emitLine("while True:");
         increaseIndent();
-        if (func->body) {
-            generateBlock(func->body.get());
-        }
-        
-        // Если функция не имеет явного return, добавляем return None
-        if (!hasReturn) {
+    }
+    if (func->body) {
+        generateBlock(func->body.get());
+    }
+    
+    if (!tailCalls.empty()) {
+        // Выход из тела без return завершает вызов, а не повторяет цикл
+        const auto& stmts = func->body->statements;
+        if (stmts.empty() || !dynamic_cast<ReturnStmt*>(stmts.back().get())) {
             emitLine("return None");
         }
-        
         decreaseIndent();
-        inFunction = wasInFunc;
-        currentFunctionName = prevFuncName;
-        
-        // Пустая строка между функциями
-        emitLine("");
+        tailCalls.clear();
+    } else if (!hasReturn) {
+        // Если функция не имеет явного return, добавляем return None
+        emitLine("return None");
     }
+    
+    decreaseIndent();
+    inFunction = wasInFunc;
+    currentFunctionName = prevFuncName;
+    currentFunction = nullptr;
+    localAliases.clear();
+    
+    // Пустая строка между функциями
+    position = SourcePosition();
+    emitLine("");
 }
 
 void CodeGenerator::generateMainFunction() {
-    // main() -> if __name__ == "__main__":
+    // Точка входа: код возврата main -> код завершения процесса
+    // (return без значения и выход из main без return дают None, то есть 0)
+    requiredImports.insert("import sys");
     emitLine("if __name__ == \"__main__\":");
-    
-    // Если есть тело функции, выполняем его
-    bool wasInFunc = inFunction;
-    inFunction = true;
-    
     increaseIndent();
-    // Тело main будет генерировано в методе generate()
+    emitLine("sys.exit(main())");
     decreaseIndent();
-    inFunction = wasInFunc;
 }
 
 std::string CodeGenerator::pythonifyVarName(const std::string& name) {
@@ -466,72 +910,87 @@ std::string CodeGenerator::getPythonType(const std::string& cType) {
 
 // ===== Главный метод генерации =====
 
-std::string CodeGenerator::generate(const Program* program) {
+std::string CodeGenerator::generate(const Program* program, SourceMap* sourceMap) {
+    StringSink sink;
+    generate(program, sink, sourceMap);
+    return sink.take();
+}
+
+void CodeGenerator::generate(const Program* program, CodeSink& sink, SourceMap* map) {
+    C2PY_PHASE("codegen");
     reset();
+    if (map) map->clear();
+    if (!program) return;
     
-    if (!program) return "";
-    
-    // Сначала проходим по всем функциям, чтобы собрать все необходимые импорты
-    // Это требует полного анализа, поэтому делаем в два прохода
-    
-    // Создаем временный output для первого прохода
-    std::ostringstream tempOutput = std::move(output);
-    output.str("");
-    output.clear();
-    indentLevel = 0;
-    requiredImports.clear();
+    // Импорты известны только после генерации всех функций - оставляем место
+    out = &sink;
+    sourceMap = map;
+    out->reserveHeader();
     
-    // Проходим по всем функциям и собираем импорты
+    // Функции в порядке объявления, main - в конце вместе с точкой входа
+    std::vector<FunctionDecl*> functions;
+    FunctionDecl* mainFunc = nullptr;
     for (auto& func : program->functions) {
-        if (isMainFunction(func->name)) {
-            // Обработаем main в конце
-            continue;
+        if (!isMainFunction(func->name)) {
+            functions.push_back(func.get());
+        } else if (!mainFunc) {
+            mainFunc = func.get();
         }
-        generateFunctionDecl(func.get());
     }
+    if (mainFunc) functions.push_back(mainFunc);
     
-    // Теперь генерируем main, если он есть
-    for (auto& func : program->functions) {
-        if (isMainFunction(func->name)) {
-            emitLine("if __name__ == \"__main__\":");
-            increaseIndent();
-            
-            // Установим флаги для main функции
-            bool wasInFunc = inFunction;
-            std::string prevFuncName = currentFunctionName;
-            inFunction = true;
-            currentFunctionName = "main";
-            
-            if (func->body) {
-                for (auto& stmt : func->body->statements) {
-                    generateStatement(stmt.get());
-                }
-            }
-            
-            decreaseIndent();
-            
-            // Восстановим состояние
-            inFunction = wasInFunc;
-            currentFunctionName = prevFuncName;
-            break;
+    size_t threads = options.threads ? options.threads : ThreadPool::defaultThreads();
+    if (threads > 1 && functions.size() > 1) {
+        generateParallel(functions, threads);
+    } else {
+        for (FunctionDecl* func : functions) {
+            generateFunctionDecl(func);
         }
     }
+    if (mainFunc) generateMainFunction();
     
-    // Теперь создаем финальный output с импортами в начале
-    std::ostringstream result;
-    
-    // Выводим импорты в начало
+    // Импорты (упорядочены, не зависят от порядка генерации) и пустая строка после них
+    std::string header;
     for (const auto& imp : requiredImports) {
-        result << imp << "\n";
+        header += imp;
+        header += '\n';
     }
-    
-    // Если были импорты, добавляем пустую строку
     if (!requiredImports.empty()) {
-        result << "\n";
+        header += '\n';
     }
+    out->fillHeader(header);
+    if (sourceMap) {
+        sourceMap->prependLines(std::count(header.begin(), header.end(), '\n'));
+    }
+    out->flush();
+    out = nullptr;
+    sourceMap = nullptr;
+}
+
+void CodeGenerator::generateParallel(const std::vector<FunctionDecl*>& functions, size_t threads) {
+    // Функция генерируется независимо от остальных: у каждой свой генератор
+    // (отступы, циклы, временные, импорты) и свой буфер
+    std::vector<StringSink> buffers(functions.size());
+    std::vector<std::set<std::string>> imports(functions.size());
+    std::vector<SourceMap> maps(sourceMap ? functions.size() : 0);
+    
+    ThreadPool pool(std::min(threads, functions.size()));
+    for (size_t i = 0; i < functions.size(); ++i) {
+        pool.submit([this, &functions, &buffers, &imports, &maps, i] {
+            C2PY_PHASE("codegen function");
+            CodeGenerator worker(semanticAnalyzer, options);
+            worker.out = &buffers[i];
+            worker.sourceMap = maps.empty() ? nullptr : &maps[i];
+            worker.generateFunctionDecl(functions[i]);
+            imports[i] = std::move(worker.requiredImports);
+        });
+    }
+    pool.wait();
     
-    // Выводим остальной код
-    result << output.str();
-    
-    return result.str();
+    // Склейка в исходном порядке
+    for (size_t i = 0; i < functions.size(); ++i) {
+        out->append(buffers[i].str());
+        requiredImports.insert(imports[i].begin(), imports[i].end());
+        if (sourceMap) sourceMap->append(maps[i]);
+    }
 }
@@ -0,0 +1,20 @@
+#include "code_sink.h"
+
+
+void
+StringSink::fillHeader (const std::string& header)
+{
+    // Сдвиг внутри буфера: при достаточной ёмкости новой памяти не нужно
+    buffer.insert(headerPos, header);
+    headerSize += header.size();
+}
+
+std::string
+StringSink::take ()
+{
+    std::string result = std::move(buffer);
+    buffer.clear();
+    headerPos = 0;
+    headerSize = 0;
+    return result;
+}
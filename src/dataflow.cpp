@@ -0,0 +1,381 @@
+#include "dataflow.h"
+#include "semantic.h"
+
+#include <algorithm>
+#include <deque>
+
+
+/* ===== BitVector ===== */
+
+BitVector::BitVector (size_t size, bool value)
+    : bits(size), words((size + 63) / 64)
+{
+    if (words > localWords) heap.resize(words);
+    uint64_t* w = data();
+    for (size_t i = 0; i < words; ++i) w[i] = value ? ~uint64_t(0) : 0;
+    // Лишние биты последнего слова держим нулевыми, чтобы сравнение было корректным
+    if (value && size % 64) {
+        w[words - 1] = (uint64_t(1) << (size % 64)) - 1;
+    }
+}
+
+bool
+BitVector::any () const
+{
+    const uint64_t* w = data();
+    for (size_t i = 0; i < words; ++i) {
+        if (w[i]) return true;
+    }
+    return false;
+}
+
+BitVector&
+BitVector::operator|= (const BitVector& other)
+{
+    uint64_t* w = data();
+    const uint64_t* o = other.data();
+    for (size_t i = 0; i < words; ++i) w[i] |= o[i];
+    return *this;
+}
+
+BitVector&
+BitVector::operator&= (const BitVector& other)
+{
+    uint64_t* w = data();
+    const uint64_t* o = other.data();
+    for (size_t i = 0; i < words; ++i) w[i] &= o[i];
+    return *this;
+}
+
+BitVector&
+BitVector::subtract (const BitVector& other)
+{
+    uint64_t* w = data();
+    const uint64_t* o = other.data();
+    for (size_t i = 0; i < words; ++i) w[i] &= ~o[i];
+    return *this;
+}
+
+bool
+BitVector::operator== (const BitVector& other) const
+{
+    return words == other.words && std::equal(data(), data() + words, other.data());
+}
+
+/* ===== DataflowSolver ===== */
+
+DataflowResult
+DataflowSolver::solve (const ControlFlowGraph& cfg, const DataflowProblem& problem)
+{
+    const size_t n = cfg.blocks.size();
+    const bool forward = problem.direction == DataflowProblem::Forward;
+    const bool intersect = problem.meet == DataflowProblem::Intersection;
+    const int boundaryBlock = forward ? cfg.entry : cfg.exit;
+
+    DataflowResult result;
+    result.in.assign(n, BitVector(problem.width));
+    result.out.assign(n, BitVector(problem.width, intersect));
+
+    // "Вход" и "выход" блока относительно направления задачи
+    std::vector<BitVector>& before = forward ? result.in : result.out;
+    std::vector<BitVector>& after = forward ? result.out : result.in;
+
+    std::deque<int> worklist;
+    std::vector<bool> queued(n, true);
+    for (size_t b = 0; b < n; ++b) {
+        worklist.push_back(forward ? (int)b : (int)(n - 1 - b));
+    }
+
+    while (!worklist.empty()) {
+        int b = worklist.front();
+        worklist.pop_front();
+        queued[b] = false;
+
+        const CFGBlock& block = cfg.blocks[b];
+        const std::vector<int>& sources = forward ? block.preds : block.succs;
+        const std::vector<int>& targets = forward ? block.succs : block.preds;
+
+        // Слияние значений соседей
+        BitVector meet = (b == boundaryBlock)
+            ? problem.boundary : BitVector(problem.width);
+        if (b != boundaryBlock && !sources.empty()) {
+            meet = after[sources[0]];
+            for (size_t i = 1; i < sources.size(); ++i) {
+                if (intersect) meet &= after[sources[i]];
+                else meet |= after[sources[i]];
+            }
+        }
+        before[b] = meet;
+
+        // Передаточная функция: gen ∪ (x − kill)
+        BitVector value = meet;
+        value.subtract(problem.kill[b]);
+        value |= problem.gen[b];
+        ++result.iterations;
+
+        if (value != after[b]) {
+            after[b] = std::move(value);
+            for (int t : targets) {
+                if (!queued[t]) {
+                    queued[t] = true;
+                    worklist.push_back(t);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/* ===== FunctionDataflow ===== */
+
+namespace {
+
+// Событие внутри блока в порядке вычисления
+struct Event {
+    bool isDef;
+    bool conditional;               // Внутри правой части && / ||
+    const IdentifierExpr* use;      // Для использования
+    int def;                        // Индекс определения
+    int var;                        // Индекс переменной
+};
+
+class EventCollector {
+public:
+    explicit EventCollector(FunctionDataflow& df) : df(df) {}
+
+    std::vector<std::vector<Event>> events;
+
+    std::unordered_map<const ASTNode*, int> index;
+
+    int
+    variable (const ASTNode* decl)
+    {
+        auto it = index.find(decl);
+        if (it != index.end()) return it->second;
+        int idx = (int)df.variables.size();
+        df.variables.push_back(decl);
+        index[decl] = idx;
+        return idx;
+    }
+
+    void
+    addDef (const ASTNode* site, const ASTNode* var, int block)
+    {
+        int v = variable(var);
+        Definition d;
+        d.site = site;
+        d.var = var;
+        d.block = block;
+        df.definitions.push_back(d);
+        events[block].push_back({ true, conditional > 0, nullptr,
+                                  (int)df.definitions.size() - 1, v });
+    }
+
+    void
+    addUse (const IdentifierExpr* id, int block)
+    {
+        int v = variable(id->declaration);
+        events[block].push_back({ false, conditional > 0, id, -1, v });
+    }
+
+    void
+    item (ASTNode* node, int block)
+    {
+        if (auto varDecl = dynamic_cast<VarDecl*>(node)) {
+            expr(varDecl->init.get(), block);
+            addDef(varDecl, varDecl, block);
+        }
+        else if (auto exprStmt = dynamic_cast<ExpressionStmt*>(node)) {
+            expr(exprStmt->expr.get(), block);
+        }
+        else if (auto returnStmt = dynamic_cast<ReturnStmt*>(node)) {
+            expr(returnStmt->value.get(), block);
+        }
+        else if (auto e = dynamic_cast<Expression*>(node)) {
+            expr(e, block);
+        }
+    }
+
+private:
+    FunctionDataflow& df;
+    int conditional = 0;
+
+    static const IdentifierExpr*
+    variableRef (const Expression* e)
+    {
+        auto id = dynamic_cast<const IdentifierExpr*>(e);
+        return (id && dynamic_cast<const VarDecl*>(id->declaration)) ? id : nullptr;
+    }
+
+    void
+    expr (Expression* e, int block)
+    {
+        if (!e) return;
+
+        if (auto id = variableRef(e)) {
+            addUse(id, block);
+        }
+        else if (auto binary = dynamic_cast<BinaryExpr*>(e)) {
+            auto target = variableRef(binary->lhs.get());
+            if (SemanticAnalyzer::isAssignmentOp(binary->op) && target) {
+                expr(binary->rhs.get(), block);
+                if (binary->op != "=") addUse(target, block);
+                addDef(binary, target->declaration, block);
+            }
+            else if (binary->op == "&&" || binary->op == "||") {
+                expr(binary->lhs.get(), block);
+                ++conditional;
+                expr(binary->rhs.get(), block);
+                --conditional;
+            }
+            else {
+                expr(binary->lhs.get(), block);
+                expr(binary->rhs.get(), block);
+            }
+        }
+        else if (auto unary = dynamic_cast<UnaryExpr*>(e)) {
+            auto target = variableRef(unary->expr.get());
+            if ((unary->op == "++" || unary->op == "--") && target) {
+                addUse(target, block);
+                addDef(unary, target->declaration, block);
+            } else {
+                expr(unary->expr.get(), block);
+            }
+        }
+        else if (auto call = dynamic_cast<CallExpr*>(e)) {
+            for (auto& arg : call->args) expr(arg.get(), block);
+        }
+    }
+};
+
+} // namespace
+
+int
+FunctionDataflow::variableIndex (const ASTNode* var) const
+{
+    auto it = varIndex.find(var);
+    return (it != varIndex.end()) ? it->second : -1;
+}
+
+FunctionDataflow
+FunctionDataflow::analyze (FunctionDecl* func, const std::vector<const ASTNode*>& params)
+{
+    FunctionDataflow df;
+    df.cfg = ControlFlowGraph::build(func);
+    const size_t nblocks = df.cfg.blocks.size();
+
+    // Собираем определения и использования по блокам
+    EventCollector collector(df);
+    collector.events.resize(nblocks);
+    for (const ASTNode* param : params) {
+        collector.addDef(param, param, df.cfg.entry);
+    }
+    for (auto& block : df.cfg.blocks) {
+        for (ASTNode* item : block.items) collector.item(item, block.id);
+    }
+
+    df.varIndex = std::move(collector.index);
+    const size_t ndefs = df.definitions.size();
+    const size_t nvars = df.variables.size();
+
+    // Все определения каждой переменной
+    std::vector<BitVector> defsOfVar(nvars, BitVector(ndefs));
+    std::vector<std::vector<int>> defListOfVar(nvars);
+    for (size_t d = 0; d < ndefs; ++d) {
+        int v = df.variableIndex(df.definitions[d].var);
+        defsOfVar[v].set(d);
+        defListOfVar[v].push_back((int)d);
+    }
+
+    DataflowProblem reaching;
+    reaching.direction = DataflowProblem::Forward;
+    reaching.width = ndefs;
+    reaching.boundary = BitVector(ndefs);
+
+    DataflowProblem live;
+    live.direction = DataflowProblem::Backward;
+    live.width = nvars;
+    live.boundary = BitVector(nvars);
+
+    for (size_t b = 0; b < nblocks; ++b) {
+        BitVector gen(ndefs), kill(ndefs);
+        BitVector use(nvars), def(nvars);
+
+        for (const Event& ev : collector.events[b]) {
+            if (ev.isDef) {
+                // Условное определение (в правой части && / ||) ничего не убивает
+                if (!ev.conditional) {
+                    gen.subtract(defsOfVar[ev.var]);
+                    kill |= defsOfVar[ev.var];
+                    def.set(ev.var);
+                }
+                gen.set(ev.def);
+            } else if (!def.test(ev.var)) {
+                use.set(ev.var);
+            }
+        }
+
+        reaching.gen.push_back(std::move(gen));
+        reaching.kill.push_back(std::move(kill));
+        live.gen.push_back(std::move(use));
+        live.kill.push_back(std::move(def));
+    }
+
+    df.reaching = DataflowSolver::solve(df.cfg, reaching);
+    df.liveness = DataflowSolver::solve(df.cfg, live);
+
+    // Цепочки: проходим блок, обновляя множество достигающих определений
+    df.defUses.assign(ndefs, {});
+    for (size_t b = 0; b < nblocks; ++b) {
+        BitVector current = df.reaching.in[b];
+        for (const Event& ev : collector.events[b]) {
+            if (ev.isDef) {
+                if (!ev.conditional) current.subtract(defsOfVar[ev.var]);
+                current.set(ev.def);
+                continue;
+            }
+            std::vector<int>& defs = df.useDefs[ev.use];
+            for (int d : defListOfVar[ev.var]) {
+                if (current.test(d)) {
+                    defs.push_back(d);
+                    df.defUses[d].push_back(ev.use);
+                }
+            }
+        }
+    }
+
+    return df;
+}
+
+const std::vector<int>*
+FunctionDataflow::reachingDefs (const IdentifierExpr* use) const
+{
+    auto it = useDefs.find(use);
+    return (it != useDefs.end()) ? &it->second : nullptr;
+}
+
+bool
+FunctionDataflow::isModifiedInLoop (const ASTNode* var, const Statement* loop) const
+{
+    const CFGLoop* info = cfg.loopOf(loop);
+    if (!info) return true;
+
+    for (const Definition& d : definitions) {
+        if (d.var != var) continue;
+        for (int b : info->blocks) {
+            if (d.block == b) return true;
+        }
+    }
+    return false;
+}
+
+bool
+FunctionDataflow::isLiveAfterLoop (const ASTNode* var, const Statement* loop) const
+{
+    const CFGLoop* info = cfg.loopOf(loop);
+    if (!info) return true;  // Неизвестный цикл - считаем переменную живой
+
+    int idx = variableIndex(var);
+    return idx >= 0 && liveness.in[info->exit].test(idx);
+}
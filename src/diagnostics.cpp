@@ -0,0 +1,144 @@
+#include "diagnostics.h"
+
+
+namespace {
+
+struct DiagInfo {
+    Severity severity;
+    const char* name;
+    const char* format;         // '$' - очередной аргумент
+};
+
+// Порядок совпадает с DiagCode
+const DiagInfo infos[] = {
+    { Severity::Error,   "fatal",                       "Fatal: $" },
+    { Severity::Error,   "unknown-statement",           "Unknown statement type" },
+    { Severity::Error,   "undeclared-identifier",       "Undeclared identifier: '$'" },
+    { Severity::Error,   "undefined-function",          "Undefined function: '$'" },
+    { Severity::Error,   "not-a-function",              "'$' is not a function" },
+    { Severity::Error,   "if-condition-not-bool",       "Condition must be boolean" },
+    { Severity::Error,   "while-condition-not-bool",    "While condition must be boolean" },
+    { Severity::Error,   "for-condition-not-bool",      "For condition must be boolean" },
+    { Severity::Error,   "do-while-condition-not-bool", "Do-while condition must be boolean" },
+    { Severity::Error,   "not-operand-not-bool",        "Operand of '!' must be boolean" },
+    { Severity::Error,   "negate-operand-not-numeric",  "Operand of unary '-' must be numeric" },
+    { Severity::Error,   "inc-dec-not-lvalue",          "Operand of '++'/'--' must be an lvalue" },
+    { Severity::Error,   "inc-dec-not-numeric",         "Operand of '++'/'--' must be numeric" },
+    { Severity::Error,   "break-outside-loop",          "Break statement outside loop" },
+    { Severity::Error,   "continue-outside-loop",       "Continue statement outside loop" },
+    { Severity::Error,   "assign-to-non-lvalue",        "Left side of assignment must be an lvalue" },
+    { Severity::Error,   "logical-lhs-not-bool",        "Left operand of '$' must be boolean" },
+    { Severity::Error,   "logical-rhs-not-bool",        "Right operand of '$' must be boolean" },
+    { Severity::Error,   "arithmetic-lhs-not-numeric",  "Left operand of '$' must be numeric" },
+    { Severity::Error,   "arithmetic-rhs-not-numeric",  "Right operand of '$' must be numeric" },
+    { Severity::Error,   "return-without-value",        "Function must return a value" },
+    { Severity::Error,   "type-mismatch",               "$: type mismatch. Expected: $, got: $" },
+    { Severity::Error,   "main-with-parameters",        "Function 'main' must not take parameters" },
+    { Severity::Warning, "missing-return",              "Function '$' may not return a value" },
+};
+
+static_assert(sizeof(infos) / sizeof(infos[0]) == (size_t)DiagCode::Count,
+              "infos must describe every DiagCode");
+
+} // namespace
+
+void
+DiagnosticEngine::clear ()
+{
+    diagnostics.clear();
+    pool.clear();
+    errors = 0;
+}
+
+void
+DiagnosticEngine::report (DiagCode code, const ASTNode* node,
+                          std::initializer_list<std::string_view> args)
+{
+    if (isSuppressed(code)) return;
+
+    Diagnostic diag;
+    diag.code = code;
+    diag.severity = severityOf(code);
+    diag.argCount = (uint8_t)args.size();
+    diag.argOffset = (uint32_t)pool.size();
+    if (node) {
+        diag.line = node->line;
+        diag.column = node->column;
+    }
+    for (std::string_view arg : args) {
+        pool.append(arg.data(), arg.size());
+        pool.push_back('\0');
+    }
+
+    if (diag.severity == Severity::Error) ++errors;
+    diagnostics.push_back(diag);
+}
+
+void
+DiagnosticEngine::append (const DiagnosticEngine& from, const Diagnostic& diag, int lineDelta)
+{
+    if (isSuppressed(diag.code)) return;
+
+    Diagnostic copy = diag;
+    copy.line += lineDelta;
+    copy.argOffset = (uint32_t)pool.size();
+    for (size_t i = 0; i < diag.argCount; ++i) {
+        std::string_view arg = from.argument(diag, i);
+        pool.append(arg.data(), arg.size());
+        pool.push_back('\0');
+    }
+
+    if (copy.severity == Severity::Error) ++errors;
+    diagnostics.push_back(copy);
+}
+
+std::string_view
+DiagnosticEngine::argument (const Diagnostic& diag, size_t i) const
+{
+    if (i >= diag.argCount) return {};
+
+    const char* p = pool.data() + diag.argOffset;
+    for (; i > 0; --i) p += std::char_traits<char>::length(p) + 1;
+    return std::string_view(p);
+}
+
+std::string
+DiagnosticEngine::format (const Diagnostic& diag) const
+{
+    std::string text = (diag.severity == Severity::Error) ? "Semantic error at line " : "Warning at line ";
+    text += std::to_string(diag.line);
+    text += ':';
+    text += std::to_string(diag.column);
+    text += " - ";
+
+    size_t next = 0;
+    for (const char* p = infos[(size_t)diag.code].format; *p; ++p) {
+        if (*p == '$') text += argument(diag, next++);
+        else text += *p;
+    }
+    return text;
+}
+
+Severity
+DiagnosticEngine::severityOf (DiagCode code)
+{
+    return infos[(size_t)code].severity;
+}
+
+const char*
+DiagnosticEngine::nameOf (DiagCode code)
+{
+    return infos[(size_t)code].name;
+}
+
+bool
+DiagnosticEngine::codeFromName (std::string_view name, DiagCode& code)
+{
+    for (size_t i = 0; i < (size_t)DiagCode::Count; ++i) {
+        if (name == infos[i].name) {
+            code = (DiagCode)i;
+            return true;
+        }
+    }
+    return false;
+}
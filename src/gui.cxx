@@ -22,6 +22,9 @@ Fl_Double_Window* UserInterface::make_window() {
       o->labelfont(4);
       o->callback((Fl_Callback*)ui_export);
     } // Fl_Button* o
+    status_box = new Fl_Box(849, 730, 167, 25);
+    status_box->labelfont(4);
+    status_box->align(Fl_Align(FL_ALIGN_LEFT|FL_ALIGN_INSIDE));
     o->end();
   } // Fl_Double_Window* o
   return w;
@@ -0,0 +1,210 @@
+#include "induction.h"
+#include "semantic.h"
+#include "optimizer.h"
+
+#include <algorithm>
+
+
+namespace {
+
+bool
+isIntegerType (const SemanticAnalyzer& sema, const ASTNode* node)
+{
+    const SemanticAnnotation* ann = sema.getAnnotationForNode(const_cast<ASTNode*>(node));
+    return ann && (ann->type.kind == TypeInfo::Int || ann->type.kind == TypeInfo::Char);
+}
+
+const IdentifierExpr*
+asVariable (const Expression* expr)
+{
+    auto id = dynamic_cast<const IdentifierExpr*>(expr);
+    return (id && dynamic_cast<const VarDecl*>(id->declaration)) ? id : nullptr;
+}
+
+// Разбор update: i++, ++i, i--, --i, i += k, i -= k, i = i + k, i = k + i, i = i - k
+const ASTNode*
+parseUpdate (const Expression* update, long long& step)
+{
+    if (auto unary = dynamic_cast<const UnaryExpr*>(update)) {
+        auto id = asVariable(unary->expr.get());
+        if (!id) return nullptr;
+        if (unary->op == "++") { step = 1; return id->declaration; }
+        if (unary->op == "--") { step = -1; return id->declaration; }
+        return nullptr;
+    }
+
+    auto binary = dynamic_cast<const BinaryExpr*>(update);
+    if (!binary) return nullptr;
+    auto id = asVariable(binary->lhs.get());
+    if (!id) return nullptr;
+
+    if (binary->op == "+=" || binary->op == "-=") {
+        auto k = Optimizer::evaluateConstant(binary->rhs.get());
+        if (!k) return nullptr;
+        step = (binary->op == "+=") ? *k : -*k;
+        return id->declaration;
+    }
+
+    if (binary->op == "=") {
+        auto sum = dynamic_cast<const BinaryExpr*>(binary->rhs.get());
+        if (!sum || (sum->op != "+" && sum->op != "-")) return nullptr;
+
+        auto lhsVar = asVariable(sum->lhs.get());
+        auto rhsVar = asVariable(sum->rhs.get());
+        if (lhsVar && lhsVar->declaration == id->declaration) {
+            auto k = Optimizer::evaluateConstant(sum->rhs.get());
+            if (!k) return nullptr;
+            step = (sum->op == "+") ? *k : -*k;
+            return id->declaration;
+        }
+        if (sum->op == "+" && rhsVar && rhsVar->declaration == id->declaration) {
+            auto k = Optimizer::evaluateConstant(sum->lhs.get());
+            if (!k) return nullptr;
+            step = *k;
+            return id->declaration;
+        }
+    }
+    return nullptr;
+}
+
+// Выражение не имеет побочных эффектов и не зависит от переменных, меняющихся в цикле
+bool
+isLoopInvariant (const Expression* expr, const Statement* loop,
+                 const FunctionDataflow& df, const SemanticAnalyzer& sema)
+{
+    const SemanticAnnotation* ann = sema.getAnnotationForNode(const_cast<Expression*>(expr));
+    if (!ann || ann->hasSideEffects) return false;
+
+    if (dynamic_cast<const NumberExpr*>(expr)) return true;
+    if (auto id = dynamic_cast<const IdentifierExpr*>(expr)) {
+        return id->declaration && !df.isModifiedInLoop(id->declaration, loop);
+    }
+    if (auto unary = dynamic_cast<const UnaryExpr*>(expr)) {
+        return isLoopInvariant(unary->expr.get(), loop, df, sema);
+    }
+    if (auto binary = dynamic_cast<const BinaryExpr*>(expr)) {
+        return isLoopInvariant(binary->lhs.get(), loop, df, sema)
+            && isLoopInvariant(binary->rhs.get(), loop, df, sema);
+    }
+    // Вызовы: результат может меняться от итерации к итерации
+    return false;
+}
+
+void
+collectForLoops (Statement* stmt, std::vector<ForStmt*>& loops)
+{
+    if (!stmt) return;
+    if (auto block = dynamic_cast<BlockStmt*>(stmt)) {
+        for (auto& s : block->statements) collectForLoops(s.get(), loops);
+    }
+    else if (auto ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+        collectForLoops(ifStmt->thenBranch.get(), loops);
+        collectForLoops(ifStmt->elseBranch.get(), loops);
+    }
+    else if (auto whileStmt = dynamic_cast<WhileStmt*>(stmt)) {
+        collectForLoops(whileStmt->body.get(), loops);
+    }
+    else if (auto doWhileStmt = dynamic_cast<DoWhileStmt*>(stmt)) {
+        collectForLoops(doWhileStmt->body.get(), loops);
+    }
+    else if (auto forStmt = dynamic_cast<ForStmt*>(stmt)) {
+        loops.push_back(forStmt);
+        collectForLoops(forStmt->body.get(), loops);
+    }
+}
+
+} // namespace
+
+bool
+InductionAnalysis::analyzeLoop (ForStmt* loop, const FunctionDataflow& df,
+                                const SemanticAnalyzer& sema, InductionVariable& iv)
+{
+    if (!loop->condition || !loop->update) return false;
+
+    // Шаг и переменная цикла
+    long long step = 0;
+    const ASTNode* var = parseUpdate(loop->update.get(), step);
+    if (!var || step == 0 || !isIntegerType(sema, var)) return false;
+
+    // Начальное значение
+    Expression* start = nullptr;
+    if (auto decl = dynamic_cast<VarDecl*>(loop->init.get())) {
+        if (decl != var || !decl->init) return false;
+        start = decl->init.get();
+    }
+    else if (auto exprStmt = dynamic_cast<ExpressionStmt*>(loop->init.get())) {
+        auto assign = dynamic_cast<BinaryExpr*>(exprStmt->expr.get());
+        auto id = assign ? asVariable(assign->lhs.get()) : nullptr;
+        if (!assign || assign->op != "=" || !id || id->declaration != var) return false;
+        start = assign->rhs.get();
+    }
+    else if (loop->init) {
+        return false;
+    }
+    if (start && !isIntegerType(sema, start)) return false;
+
+    // Условие i < Y (или Y > i и т.п.)
+    auto cond = dynamic_cast<BinaryExpr*>(loop->condition.get());
+    if (!cond) return false;
+    std::string op = cond->op;
+    Expression* bound = nullptr;
+    auto lhsVar = asVariable(cond->lhs.get());
+    auto rhsVar = asVariable(cond->rhs.get());
+    if (lhsVar && lhsVar->declaration == var) {
+        bound = cond->rhs.get();
+    } else if (rhsVar && rhsVar->declaration == var) {
+        bound = cond->lhs.get();
+        if (op == "<") op = ">";
+        else if (op == ">") op = "<";
+        else if (op == "<=") op = ">=";
+        else if (op == ">=") op = "<=";
+    } else {
+        return false;
+    }
+
+    bool ascending = (op == "<" || op == "<=");
+    if (!ascending && op != ">" && op != ">=") return false;
+    if (ascending != (step > 0)) return false;
+    if (!isIntegerType(sema, bound)) return false;
+
+    // i меняется только в update
+    const CFGLoop* info = df.cfg.loopOf(loop);
+    if (!info) return false;
+    for (const Definition& d : df.definitions) {
+        if (d.var != var || d.site == loop->update.get()) continue;
+        if (std::find(info->blocks.begin(), info->blocks.end(), d.block) != info->blocks.end()) {
+            return false;
+        }
+    }
+
+    // Граница вычисляется в range() один раз
+    if (!isLoopInvariant(bound, loop, df, sema)) return false;
+
+    // Итоговое значение после цикла восстанавливаем только для шага ±1
+    bool live = df.isLiveAfterLoop(var, loop);
+    if (live && step != 1 && step != -1) return false;
+
+    iv.var = var;
+    iv.start = start;
+    iv.bound = bound;
+    iv.step = step;
+    iv.inclusive = (op == "<=" || op == ">=");
+    iv.liveAfterLoop = live;
+    return true;
+}
+
+void
+InductionAnalysis::analyzeFunction (FunctionDecl* func, const FunctionDataflow& df,
+                                    const SemanticAnalyzer& sema,
+                                    std::unordered_map<const ForStmt*, InductionVariable>& result)
+{
+    std::vector<ForStmt*> loops;
+    collectForLoops(func->body.get(), loops);
+
+    for (ForStmt* loop : loops) {
+        InductionVariable iv;
+        if (analyzeLoop(loop, df, sema, iv)) {
+            result[loop] = iv;
+        }
+    }
+}
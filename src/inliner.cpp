@@ -0,0 +1,345 @@
+#include "inliner.h"
+#include "instrument.h"
+
+#include <iterator>
+
+
+namespace {
+
+// Имя -> выражение, которым заменяется его чтение
+using Substitution = std::unordered_map<std::string, const Expression*>;
+
+/**
+ * Копия выражения с заменой идентификаторов.
+ * site - узел, позицию которого получают копии (место вызова); nullptr - сохранить свои.
+ * Связи с объявлениями не копируются: их восстановит повторный семантический анализ.
+ */
+ExprPtr
+cloneExpression (const Expression* expr, const Substitution& subst, const ASTNode* site)
+{
+    if (!expr) return nullptr;
+
+    ExprPtr copy;
+    if (auto num = dynamic_cast<const NumberExpr*>(expr)) {
+        copy = std::make_unique<NumberExpr>(num->value);
+    }
+    else if (auto id = dynamic_cast<const IdentifierExpr*>(expr)) {
+        auto it = subst.find(id->name);
+        if (it != subst.end()) {
+            // Подставляемое выражение взято из вызывающей функции
+            return cloneExpression(it->second, Substitution(), nullptr);
+        }
+        copy = std::make_unique<IdentifierExpr>(id->name);
+    }
+    else if (auto unary = dynamic_cast<const UnaryExpr*>(expr)) {
+        copy = std::make_unique<UnaryExpr>(unary->op, cloneExpression(unary->expr.get(), subst, site));
+    }
+    else if (auto binary = dynamic_cast<const BinaryExpr*>(expr)) {
+        copy = std::make_unique<BinaryExpr>(binary->op,
+                                            cloneExpression(binary->lhs.get(), subst, site),
+                                            cloneExpression(binary->rhs.get(), subst, site));
+    }
+    else if (auto call = dynamic_cast<const CallExpr*>(expr)) {
+        auto callCopy = std::make_unique<CallExpr>(call->name);
+        for (auto& arg : call->args) {
+            callCopy->args.push_back(cloneExpression(arg.get(), subst, site));
+        }
+        copy = std::move(callCopy);
+    }
+    else {
+        return nullptr;
+    }
+
+    const ASTNode* position = site ? site : expr;
+    copy->line = position->line;
+    copy->column = position->column;
+    return copy;
+}
+
+bool
+isTrivial (const Expression* expr)
+{
+    return dynamic_cast<const NumberExpr*>(expr) || dynamic_cast<const IdentifierExpr*>(expr);
+}
+
+} // namespace
+
+Inliner::Inliner (const SemanticAnalyzer& analyzer, const InlinerOptions& options)
+    : semanticAnalyzer(analyzer), options(options)
+{}
+
+InlinerStats
+Inliner::inlineCalls (Program* program)
+{
+    C2PY_PHASE("inline");
+    stats = InlinerStats();
+    candidates.clear();
+    if (!program || !options.enabled) return stats;
+
+    collectCandidates(program);
+    if (candidates.empty()) return stats;
+
+    for (auto& func : program->functions) {
+        if (!func->body) continue;
+        int before = stats.inlinedCalls;
+        inlineInBlock(func->body.get());
+
+        // Тело изменено - результаты анализа по хешу токенов переиспользовать нельзя
+        if (stats.inlinedCalls != before) {
+            func->tokenHash = 0;
+        }
+    }
+    return stats;
+}
+
+// ===== Кандидаты =====
+
+void
+Inliner::collectCandidates (Program* program)
+{
+    for (auto& func : program->functions) {
+        Candidate candidate;
+        if (isCandidate(func.get(), candidate)) {
+            candidates.emplace(func.get(), std::move(candidate));
+            ++stats.candidates;
+        }
+    }
+}
+
+bool
+Inliner::isCandidate (const FunctionDecl* func, Candidate& candidate) const
+{
+    if (!func->body || func->name == "main") return false;
+
+    const CallGraph& graph = semanticAnalyzer.getCallGraph();
+    const FunctionSummary* summary = graph.summary(func);
+    if (!summary || summary->callsUnknown || graph.isRecursive(func) || !graph.callees(func).empty()) {
+        return false;
+    }
+
+    const SemanticAnnotation* funcAnn = semanticAnalyzer.getAnnotationForNode(const_cast<FunctionDecl*>(func));
+    if (!funcAnn || funcAnn->returnType.kind == TypeInfo::Void ||
+        funcAnn->paramTypes.size() != func->params.size()) {
+        return false;
+    }
+
+    // { T1 l1 = e1; ... return e; }
+    const auto& stmts = func->body->statements;
+    if (stmts.empty()) return false;
+    auto ret = dynamic_cast<const ReturnStmt*>(stmts.back().get());
+    if (!ret || !ret->value) return false;
+
+    std::vector<const Expression*> exprs;
+    for (size_t i = 0; i + 1 < stmts.size(); ++i) {
+        auto local = dynamic_cast<const VarDecl*>(stmts[i].get());
+        if (!local || !local->init) return false;
+        candidate.locals.push_back(local);
+        exprs.push_back(local->init.get());
+    }
+    exprs.push_back(ret->value.get());
+
+    const SemanticAnnotation* resultAnn = semanticAnalyzer.getAnnotationForNode(ret->value.get());
+    if (!resultAnn || resultAnn->type != funcAnn->returnType) return false;
+
+    // Размер тела, отсутствие эффектов и чтения параметров/локальных
+    int size = 0;
+    std::vector<const Expression*> pending(exprs.begin(), exprs.end());
+    while (!pending.empty()) {
+        const Expression* expr = pending.back();
+        pending.pop_back();
+        if (!expr) continue;
+        if (++size > options.maxSize) return false;
+
+        const SemanticAnnotation* ann = semanticAnalyzer.getAnnotationForNode(const_cast<Expression*>(expr));
+        if (!ann || ann->hasSideEffects) return false;
+
+        if (auto id = dynamic_cast<const IdentifierExpr*>(expr)) {
+            ++candidate.uses[id->name];
+        }
+        else if (auto unary = dynamic_cast<const UnaryExpr*>(expr)) {
+            pending.push_back(unary->expr.get());
+        }
+        else if (auto binary = dynamic_cast<const BinaryExpr*>(expr)) {
+            pending.push_back(binary->lhs.get());
+            pending.push_back(binary->rhs.get());
+        }
+        else if (!dynamic_cast<const NumberExpr*>(expr)) {
+            return false;
+        }
+    }
+
+    candidate.func = func;
+    candidate.result = ret->value.get();
+    candidate.paramTypes = funcAnn->paramTypes;
+    return true;
+}
+
+// ===== Обход =====
+
+void
+Inliner::inlineInBlock (BlockStmt* block)
+{
+    auto& stmts = block->statements;
+    for (size_t i = 0; i < stmts.size(); ++i) {
+        std::vector<StmtPtr> prelude;
+        inlineInStatement(stmts[i].get(), prelude);
+        if (prelude.empty()) continue;
+
+        // Временные объявляются непосредственно перед оператором
+        size_t count = prelude.size();
+        stmts.insert(stmts.begin() + i, std::make_move_iterator(prelude.begin()),
+                     std::make_move_iterator(prelude.end()));
+        i += count;
+    }
+}
+
+void
+Inliner::inlineInStatement (StmtPtr& slot)
+{
+    if (!slot) return;
+
+    // Одиночный оператор (ветка if, тело цикла) - временным нужен свой блок
+    std::vector<StmtPtr> prelude;
+    inlineInStatement(slot.get(), prelude);
+    if (prelude.empty()) return;
+
+    auto block = std::make_unique<BlockStmt>();
+    block->line = slot->line;
+    block->column = slot->column;
+    block->statements = std::move(prelude);
+    block->statements.push_back(std::move(slot));
+    slot = std::move(block);
+}
+
+void
+Inliner::inlineInStatement (Statement* stmt, std::vector<StmtPtr>& prelude)
+{
+    if (auto block = dynamic_cast<BlockStmt*>(stmt)) {
+        inlineInBlock(block);
+    }
+    else if (auto varDecl = dynamic_cast<VarDecl*>(stmt)) {
+        inlineInExpression(varDecl->init, prelude, true);
+    }
+    else if (auto exprStmt = dynamic_cast<ExpressionStmt*>(stmt)) {
+        inlineInExpression(exprStmt->expr, prelude, true);
+    }
+    else if (auto returnStmt = dynamic_cast<ReturnStmt*>(stmt)) {
+        inlineInExpression(returnStmt->value, prelude, true);
+    }
+    else if (auto ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+        inlineInExpression(ifStmt->condition, prelude, true);
+        inlineInStatement(ifStmt->thenBranch);
+        inlineInStatement(ifStmt->elseBranch);
+    }
+    else if (auto whileStmt = dynamic_cast<WhileStmt*>(stmt)) {
+        // Условие вычисляется на каждой итерации - временные перед циклом не годятся
+        inlineInExpression(whileStmt->condition, prelude, false);
+        inlineInStatement(whileStmt->body);
+    }
+    else if (auto doWhileStmt = dynamic_cast<DoWhileStmt*>(stmt)) {
+        inlineInStatement(doWhileStmt->body);
+        inlineInExpression(doWhileStmt->condition, prelude, false);
+    }
+    else if (auto forStmt = dynamic_cast<ForStmt*>(stmt)) {
+        // init выполняется один раз - его временные объявляются перед циклом
+        if (auto decl = dynamic_cast<VarDecl*>(forStmt->init.get())) {
+            inlineInExpression(decl->init, prelude, true);
+        } else if (auto init = dynamic_cast<ExpressionStmt*>(forStmt->init.get())) {
+            inlineInExpression(init->expr, prelude, true);
+        }
+        inlineInExpression(forStmt->condition, prelude, false);
+        inlineInExpression(forStmt->update, prelude, false);
+        inlineInStatement(forStmt->body);
+    }
+}
+
+void
+Inliner::inlineInExpression (ExprPtr& slot, std::vector<StmtPtr>& prelude, bool statementPosition)
+{
+    Expression* expr = slot.get();
+    if (!expr) return;
+
+    if (auto unary = dynamic_cast<UnaryExpr*>(expr)) {
+        inlineInExpression(unary->expr, prelude, statementPosition);
+    }
+    else if (auto binary = dynamic_cast<BinaryExpr*>(expr)) {
+        inlineInExpression(binary->lhs, prelude, statementPosition);
+        // Правая часть && и || вычисляется не всегда
+        bool shortCircuit = binary->op == "&&" || binary->op == "||";
+        inlineInExpression(binary->rhs, prelude, statementPosition && !shortCircuit);
+    }
+    else if (auto call = dynamic_cast<CallExpr*>(expr)) {
+        // Типы и эффекты аргументов берём до подстановки во вложенные вызовы:
+        // у новых узлов нет аннотаций
+        std::vector<TypeInfo> argTypes;
+        std::vector<bool> argEffects;
+        for (auto& arg : call->args) {
+            const SemanticAnnotation* ann = semanticAnalyzer.getAnnotationForNode(arg.get());
+            argTypes.push_back(ann ? ann->type : TypeInfo());
+            argEffects.push_back(!ann || ann->hasSideEffects);
+        }
+        for (auto& arg : call->args) {
+            inlineInExpression(arg, prelude, statementPosition);
+        }
+        if (inlineCall(slot, argTypes, argEffects, prelude, statementPosition)) {
+            ++stats.inlinedCalls;
+        }
+    }
+}
+
+bool
+Inliner::inlineCall (ExprPtr& slot, const std::vector<TypeInfo>& argTypes,
+                     const std::vector<bool>& argEffects,
+                     std::vector<StmtPtr>& prelude, bool statementPosition)
+{
+    auto call = static_cast<CallExpr*>(slot.get());
+    auto it = candidates.find(semanticAnalyzer.getCallGraph().calleeOf(call));
+    if (it == candidates.end()) return false;
+
+    const Candidate& candidate = it->second;
+    const auto& params = candidate.func->params;
+    if (call->args.size() != params.size()) return false;
+
+    // Аргумент во временную: у него есть эффекты или тело читает его несколько раз
+    std::vector<bool> needsTemp(params.size(), false);
+    bool anyTemp = !candidate.locals.empty();
+    for (size_t i = 0; i < params.size(); ++i) {
+        if (argTypes[i] != candidate.paramTypes[i]) return false;
+
+        auto uses = candidate.uses.find(params[i].second);
+        int reads = (uses != candidate.uses.end()) ? uses->second : 0;
+        needsTemp[i] = !isTrivial(call->args[i].get()) && (argEffects[i] || reads > 1);
+        anyTemp = anyTemp || needsTemp[i];
+    }
+    if (anyTemp && !statementPosition) return false;
+
+    std::string prefix = "_c2py_inl" + std::to_string(nextId++) + "_";
+    Substitution subst;
+    std::vector<ExprPtr> names;     // Чтения временных, которыми заменяются имена
+
+    auto declareTemp = [&](const std::string& type, const std::string& name, ExprPtr init) {
+        auto decl = std::make_unique<VarDecl>(type, prefix + name, std::move(init));
+        decl->line = call->line;
+        decl->column = call->column;
+        prelude.push_back(std::move(decl));
+        names.push_back(std::make_unique<IdentifierExpr>(prefix + name));
+        subst[name] = names.back().get();
+    };
+
+    // Аргументы вычисляются в исходном порядке, затем локальные переменные
+    for (size_t i = 0; i < params.size(); ++i) {
+        if (needsTemp[i]) {
+            declareTemp(params[i].first, params[i].second, std::move(call->args[i]));
+        } else {
+            subst[params[i].second] = call->args[i].get();
+        }
+    }
+    for (const VarDecl* local : candidate.locals) {
+        declareTemp(local->type, local->name, cloneExpression(local->init.get(), subst, call));
+    }
+
+    // Аргументы, подставленные напрямую, живут в call до замены
+    ExprPtr result = cloneExpression(candidate.result, subst, call);
+    slot = std::move(result);
+    return true;
+}
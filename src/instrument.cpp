@@ -0,0 +1,281 @@
+#include "instrument.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+
+namespace {
+
+// Начало отсчёта времени событий - загрузка программы, раньше любой фазы
+const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+// Выделения потока: без динамической инициализации, годятся для operator new
+thread_local uint64_t threadAllocationCount = 0;
+thread_local uint64_t threadAllocationBytes = 0;
+
+struct Event {
+    const char* name;
+    int64_t startNs;                    // От начала процесса
+    int64_t durationNs;
+    uint64_t allocations;
+    uint64_t bytes;
+};
+
+// Буфер событий потока; живёт до reset(), переживая сам поток
+struct ThreadEvents {
+    int tid;
+    std::vector<Event> events;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::deque<ThreadEvents> threads;
+    std::atomic<uint64_t> counters[(int) instrument::Counter::Count] {};
+    std::atomic<unsigned> generation { 0 };     // Меняется при reset()
+};
+
+Registry&
+registry ()
+{
+    // Не разрушается при выходе: потоки пула могут завершать фазы позже
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+ThreadEvents&
+threadEvents ()
+{
+    thread_local ThreadEvents* events = nullptr;
+    thread_local unsigned generation = 0;
+    Registry& reg = registry();
+    if (!events || generation != reg.generation) {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.threads.push_back({ (int) reg.threads.size() + 1, {} });
+        events = &reg.threads.back();
+        generation = reg.generation;
+    }
+    return *events;
+}
+
+std::string
+jsonString (const char* text)
+{
+    std::string out = "\"";
+    for (const char* p = text; *p; ++p) {
+        if (*p == '"' || *p == '\\') out += '\\';
+        out += *p;
+    }
+    return out + "\"";
+}
+
+} // namespace
+
+namespace instrument {
+
+const char*
+counterName (Counter counter)
+{
+    switch (counter) {
+        case Counter::Tokens:       return "tokens";
+        case Counter::Nodes:        return "nodes";
+        case Counter::ScopesPushed: return "scopes pushed";
+        case Counter::LinesEmitted: return "lines emitted";
+        case Counter::BytesEmitted: return "bytes emitted";
+        case Counter::CallSites:    return "call sites";
+        case Counter::CallGraphMicros: return "call graph us";
+        case Counter::Count:        break;
+    }
+    return "?";
+}
+
+bool
+enabled ()
+{
+#ifdef C2PY_INSTRUMENT
+    return true;
+#else
+    return false;
+#endif
+}
+
+Phase::Phase (const char* name)
+    : name(name), start(std::chrono::steady_clock::now()),
+      allocations(threadAllocationCount), allocatedBytes(threadAllocationBytes)
+{
+}
+
+Phase::~Phase ()
+{
+    auto end = std::chrono::steady_clock::now();
+    uint64_t phaseAllocations = threadAllocationCount - allocations;
+    uint64_t phaseBytes = threadAllocationBytes - allocatedBytes;
+
+    int64_t startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch).count();
+    int64_t durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    threadEvents().events.push_back({ name, startNs, durationNs, phaseAllocations, phaseBytes });
+}
+
+void
+count (Counter counter, uint64_t value)
+{
+    registry().counters[(int) counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t
+counter (Counter counter)
+{
+    return registry().counters[(int) counter].load();
+}
+
+uint64_t
+threadAllocations ()
+{
+    return threadAllocationCount;
+}
+
+uint64_t
+threadAllocatedBytes ()
+{
+    return threadAllocationBytes;
+}
+
+std::string
+summary ()
+{
+    struct Total {
+        uint64_t calls = 0;
+        int64_t ns = 0;
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+        int64_t firstNs = 0;
+    };
+    std::map<std::string, Total> totals;
+    Registry& reg = registry();
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (const ThreadEvents& thread : reg.threads) {
+            for (const Event& event : thread.events) {
+                Total& total = totals[event.name];
+                if (!total.calls || event.startNs < total.firstNs) total.firstNs = event.startNs;
+                ++total.calls;
+                total.ns += event.durationNs;
+                total.allocations += event.allocations;
+                total.bytes += event.bytes;
+            }
+        }
+    }
+
+    // Фазы - в порядке первого начала, как они идут в конвейере
+    std::vector<std::pair<std::string, Total>> phases(totals.begin(), totals.end());
+    std::stable_sort(phases.begin(), phases.end(), [](const auto& a, const auto& b) {
+        return a.second.firstNs < b.second.firstNs;
+    });
+
+    std::string out;
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-16s %8s %12s %10s %12s %12s\n",
+                  "phase", "calls", "total ms", "avg us", "allocs", "alloc KB");
+    out += line;
+    for (const auto& phase : phases) {
+        const Total& total = phase.second;
+        std::snprintf(line, sizeof(line), "%-16s %8llu %12.3f %10.1f %12llu %12.1f\n",
+                      phase.first.c_str(), (unsigned long long) total.calls, total.ns / 1e6,
+                      total.ns / 1e3 / (double) total.calls, (unsigned long long) total.allocations,
+                      total.bytes / 1024.0);
+        out += line;
+    }
+    for (int i = 0; i < (int) Counter::Count; ++i) {
+        std::snprintf(line, sizeof(line), "%-16s %llu\n", counterName((Counter) i),
+                      (unsigned long long) reg.counters[i].load());
+        out += line;
+    }
+    return out;
+}
+
+std::string
+chromeTrace ()
+{
+    Registry& reg = registry();
+    std::string out = "{\"traceEvents\":[\n";
+    char buffer[128];
+    int64_t lastNs = 0;
+    bool first = true;
+
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const ThreadEvents& thread : reg.threads) {
+        for (const Event& event : thread.events) {
+            if (!first) out += ",\n";
+            first = false;
+            // Время в трассе - микросекунды
+            std::snprintf(buffer, sizeof(buffer), ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                          thread.tid, event.startNs / 1e3, event.durationNs / 1e3);
+            out += "{\"name\":" + jsonString(event.name) + ",\"cat\":\"c2py\"" + buffer;
+            std::snprintf(buffer, sizeof(buffer), ",\"args\":{\"allocs\":%llu,\"bytes\":%llu}}",
+                          (unsigned long long) event.allocations, (unsigned long long) event.bytes);
+            out += buffer;
+            lastNs = std::max(lastNs, event.startNs + event.durationNs);
+        }
+    }
+    // Счётчики - итоговые значения в конце трассы
+    for (int i = 0; i < (int) Counter::Count; ++i) {
+        if (!first) out += ",\n";
+        first = false;
+        std::snprintf(buffer, sizeof(buffer), ",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"value\":%llu}}",
+                      lastNs / 1e3, (unsigned long long) reg.counters[i].load());
+        out += "{\"name\":" + jsonString(counterName((Counter) i)) + buffer;
+    }
+    out += "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return out;
+}
+
+void
+reset ()
+{
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.threads.clear();
+    for (auto& counter : reg.counters) counter = 0;
+    ++reg.generation;
+}
+
+} // namespace instrument
+
+#ifdef C2PY_INSTRUMENT
+
+// Счёт выделений: замена глобального operator new на всю программу.
+// new[] и nothrow-варианты по умолчанию вызывают эту функцию.
+// GCC принимает free() в заменённом operator delete за несоответствие new/free
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void*
+operator new (std::size_t size)
+{
+    ++threadAllocationCount;
+    threadAllocationBytes += size;
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void
+operator delete (void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void
+operator delete (void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+#endif
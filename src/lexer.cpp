@@ -1,4 +1,5 @@
 #include "lexer.h"
+#include "instrument.h"
 #include <cctype>
 #include <stdexcept>
 
@@ -32,6 +33,13 @@ void Lexer::skipWhitespace() {
 // Функция, считывающая токены из входного кода
 std::vector<Token> Lexer::tokenize() {
     std::vector<Token> tokens;
+    tokenize(tokens);
+    return tokens;
+}
+// Функция, заполняющая готовый вектор токенов
+void Lexer::tokenize(std::vector<Token>& tokens) {
+    C2PY_PHASE("lex");
+    tokens.clear();
     while (!eof()) {
         skipWhitespace();
         if (eof()) break;
@@ -47,7 +55,7 @@ std::vector<Token> Lexer::tokenize() {
     }
     // Обозначим конец файла после считывания кода
     tokens.emplace_back(TokenType::EndOfFile, "", line, column);
-    return tokens;
+    C2PY_COUNT(Tokens, tokens.size());
 }
 // Функция чтения идентификатора/ключевого слова
 Token Lexer::readIdentifierOrKeyword() {
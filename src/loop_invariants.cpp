@@ -0,0 +1,201 @@
+#include "loop_invariants.h"
+#include "semantic.h"
+
+#include <cstdlib>
+
+
+namespace {
+
+// Выражение читает переменную или вызывает функцию (иначе выносить нечего)
+bool
+readsState (const Expression* expr)
+{
+    if (dynamic_cast<const IdentifierExpr*>(expr) || dynamic_cast<const CallExpr*>(expr)) return true;
+    if (auto unary = dynamic_cast<const UnaryExpr*>(expr)) return readsState(unary->expr.get());
+    if (auto binary = dynamic_cast<const BinaryExpr*>(expr)) {
+        return readsState(binary->lhs.get()) || readsState(binary->rhs.get());
+    }
+    return false;
+}
+
+// Вынос выигрывает только для операций; переменную или -x читать не дороже временной
+bool
+isTrivial (const Expression* expr)
+{
+    if (auto unary = dynamic_cast<const UnaryExpr*>(expr)) {
+        expr = unary->expr.get();
+    }
+    return dynamic_cast<const NumberExpr*>(expr) || dynamic_cast<const IdentifierExpr*>(expr);
+}
+
+// Вычисление может завершиться исключением в Python: вызов или деление на неконстанту
+bool
+mayRaise (const Expression* expr)
+{
+    if (dynamic_cast<const CallExpr*>(expr)) return true;
+    if (auto unary = dynamic_cast<const UnaryExpr*>(expr)) return mayRaise(unary->expr.get());
+    if (auto binary = dynamic_cast<const BinaryExpr*>(expr)) {
+        if (binary->op == "/" || binary->op == "%") {
+            auto divisor = dynamic_cast<const NumberExpr*>(binary->rhs.get());
+            if (!divisor || std::strtod(divisor->value.c_str(), nullptr) == 0) return true;
+        }
+        return mayRaise(binary->lhs.get()) || mayRaise(binary->rhs.get());
+    }
+    return false;
+}
+
+// Все прочитанные переменные не записываются внутри цикла
+bool
+isInvariantIn (const Expression* expr, const Statement* loop, const FunctionDataflow& df)
+{
+    if (dynamic_cast<const NumberExpr*>(expr)) return true;
+    if (auto id = dynamic_cast<const IdentifierExpr*>(expr)) {
+        return dynamic_cast<const VarDecl*>(id->declaration) && !df.isModifiedInLoop(id->declaration, loop);
+    }
+    if (auto unary = dynamic_cast<const UnaryExpr*>(expr)) {
+        return isInvariantIn(unary->expr.get(), loop, df);
+    }
+    if (auto binary = dynamic_cast<const BinaryExpr*>(expr)) {
+        return isInvariantIn(binary->lhs.get(), loop, df) && isInvariantIn(binary->rhs.get(), loop, df);
+    }
+    if (auto call = dynamic_cast<const CallExpr*>(expr)) {
+        for (auto& arg : call->args) {
+            if (!isInvariantIn(arg.get(), loop, df)) return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+class Hoister {
+public:
+    Hoister(const FunctionDataflow& df, const SemanticAnalyzer& sema,
+            std::unordered_map<const Statement*, std::vector<Expression*>>& result)
+        : df(df), sema(sema), result(result) {}
+
+    void
+    statement (Statement* stmt)
+    {
+        if (!stmt) return;
+
+        if (auto block = dynamic_cast<BlockStmt*>(stmt)) {
+            for (auto& s : block->statements) statement(s.get());
+        }
+        else if (auto varDecl = dynamic_cast<VarDecl*>(stmt)) {
+            expression(varDecl->init.get(), false, loops.size());
+        }
+        else if (auto exprStmt = dynamic_cast<ExpressionStmt*>(stmt)) {
+            expression(exprStmt->expr.get(), false, loops.size());
+        }
+        else if (auto ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+            expression(ifStmt->condition.get(), false, loops.size());
+            statement(ifStmt->thenBranch.get());
+            statement(ifStmt->elseBranch.get());
+        }
+        else if (auto returnStmt = dynamic_cast<ReturnStmt*>(stmt)) {
+            expression(returnStmt->value.get(), false, loops.size());
+        }
+        else if (auto whileStmt = dynamic_cast<WhileStmt*>(stmt)) {
+            enter(whileStmt);
+            expression(whileStmt->condition.get(), true, loops.size());
+            statement(whileStmt->body.get());
+            loops.pop_back();
+        }
+        else if (auto doWhileStmt = dynamic_cast<DoWhileStmt*>(stmt)) {
+            // Условие do-while вычисляется после тела и может быть не достигнуто
+            enter(doWhileStmt);
+            statement(doWhileStmt->body.get());
+            expression(doWhileStmt->condition.get(), false, loops.size());
+            loops.pop_back();
+        }
+        else if (auto forStmt = dynamic_cast<ForStmt*>(stmt)) {
+            // init выполняется до цикла; временные вычисляются уже после него
+            statement(forStmt->init.get());
+            enter(forStmt);
+            if (!sema.getInductionVariable(forStmt)) {
+                expression(forStmt->condition.get(), true, loops.size());
+                expression(forStmt->update.get(), false, loops.size());
+            }
+            // Для range() условие и update не вычисляются на каждой итерации
+            statement(forStmt->body.get());
+            loops.pop_back();
+        }
+    }
+
+private:
+    const FunctionDataflow& df;
+    const SemanticAnalyzer& sema;
+    std::unordered_map<const Statement*, std::vector<Expression*>>& result;
+    std::vector<const Statement*> loops;    // Объемлющие циклы, внешний первым
+
+    void
+    enter (const Statement* loop)
+    {
+        result.erase(loop);     // Результат прошлого анализа функции
+        loops.push_back(loop);
+    }
+
+    // Самый внешний из первых limit циклов, перед которым можно вычислить выражение; -1 - нельзя.
+    // conditionPosition - выражение безусловно вычисляется в условии самого внутреннего цикла
+    int
+    targetLoop (Expression* expr, bool conditionPosition, size_t limit) const
+    {
+        if (isTrivial(expr) || !readsState(expr)) return -1;
+
+        const SemanticAnnotation* ann = sema.getAnnotationForNode(expr);
+        if (!ann || ann->hasSideEffects) return -1;
+
+        // Исключение до входа в цикл допустимо, только если условие и так вычислилось бы первым
+        if (mayRaise(expr)) {
+            size_t innermost = loops.size() - 1;
+            bool exact = conditionPosition && limit == loops.size();
+            return (exact && isInvariantIn(expr, loops[innermost], df)) ? (int)innermost : -1;
+        }
+
+        for (size_t i = 0; i < limit; ++i) {
+            if (isInvariantIn(expr, loops[i], df)) return (int)i;
+        }
+        return -1;
+    }
+
+    void
+    expression (Expression* expr, bool conditionPosition, size_t limit)
+    {
+        if (!expr || limit == 0) return;
+
+        int target = targetLoop(expr, conditionPosition, limit);
+        if (target >= 0) {
+            result[loops[target]].push_back(expr);
+            // Внутри вынесенного выражения ищем части, инвариантные и для более внешних циклов
+            limit = target;
+            conditionPosition = false;
+        }
+
+        if (auto unary = dynamic_cast<UnaryExpr*>(expr)) {
+            if (unary->op == "++" || unary->op == "--") return;
+            expression(unary->expr.get(), conditionPosition, limit);
+        }
+        else if (auto binary = dynamic_cast<BinaryExpr*>(expr)) {
+            if (!SemanticAnalyzer::isAssignmentOp(binary->op)) {
+                expression(binary->lhs.get(), conditionPosition, limit);
+            }
+            // Правая часть && и || вычисляется не всегда
+            bool shortCircuit = binary->op == "&&" || binary->op == "||";
+            expression(binary->rhs.get(), conditionPosition && !shortCircuit, limit);
+        }
+        else if (auto call = dynamic_cast<CallExpr*>(expr)) {
+            for (auto& arg : call->args) expression(arg.get(), conditionPosition, limit);
+        }
+    }
+};
+
+} // namespace
+
+void
+LoopInvariantAnalysis::analyzeFunction (FunctionDecl* func, const FunctionDataflow& df,
+                                        const SemanticAnalyzer& sema,
+                                        std::unordered_map<const Statement*, std::vector<Expression*>>& result)
+{
+    Hoister hoister(df, sema, result);
+    hoister.statement(func->body.get());
+}
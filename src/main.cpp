@@ -14,13 +14,16 @@
 #include <sstream>
 #include <string>
 #include <exception>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
 
-#include "lexer.h"
-#include "parser.h"
-#include "ast.h"
-#include "semantic.h"
-#include "symbol_table.h"
-#include "code_generator.h"
+#include "pipeline.h"
 #include "gui.h"
 
 #include <FL/Fl_Native_File_Chooser.H>
@@ -51,54 +54,198 @@ void ui_export(Fl_Button*, void*) {
     }
 }
 
-void ui_translate(Fl_Button*, void*) {
-    std::string code = inputBuf->text();
-    if (code.empty()) return;
-    try {
-        //std::string code = loadSource(argc, argv);
-        
-        // Определяем источник кода
-        //std::string sourceInfo = (argc > 1) ? std::string("File: ") + argv[1] : "Built-in example";
-
-        // 1) Лексический анализ
-        Lexer lexer(code);
-        auto tokens = lexer.tokenize();
-
-        // 2) Синтаксический анализ → AST
-        Parser parser(tokens);
-        auto program = parser.parseProgram();
-
-        // 3) Семантический анализ
-        SymbolTable symbolTable;
-        SemanticAnalyzer semanticAnalyzer(symbolTable);
-        if (!semanticAnalyzer.analyze(program)) {
-            std::string error = "=== Semantic Analysis Errors ===\n";
-            for (const auto& err : semanticAnalyzer.getErrors()) {
-                error += err + "\n";
-            }
-            outputBuf->text(error.c_str());
-            return;
+namespace {
+
+void onTranslationUpdate(void* data);
+
+/**
+ * Трансляция вне потока событий FLTK: на больших входах окно не замирает.
+ * Новый запрос отменяет текущий (между фазами и функциями анализа).
+ * Текущая фаза и готовый результат лежат в рабочем объекте под мьютексом,
+ * Fl::awake лишь будит окно, и оно забирает последнее состояние (take()):
+ * сообщения не выделяются, поэтому не теряются и не утекают при выходе.
+ */
+class TranslationWorker {
+public:
+    // Новое для окна с прошлого take()
+    struct Update {
+        bool running = false;           // Фаза текущего запроса
+        TranslatePhase phase = TranslatePhase::Lex;
+        bool finished = false;          // Результат текущего запроса
+        TranslateResult result;
+        double seconds = 0;
+    };
+
+    TranslationWorker() : translator(windowOptions()), thread(&TranslationWorker::run, this) {}
+
+    ~TranslationWorker() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            ++latest;                   // Прерывает текущую трансляцию
+        }
+        wake.notify_one();
+        thread.join();
+    }
+
+    // Поток окна: запрос заменяет ожидающий и отменяет выполняемый
+    void submit(std::string code) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending = std::move(code);
+            hasPending = true;
+            ++latest;
+            state = Update();           // Фазы и результат прошлого запроса не показываются
+        }
+        wake.notify_one();
+    }
+
+    // Поток окна
+    Update take() {
+        std::lock_guard<std::mutex> lock(mutex);
+        notified = false;
+        Update update = std::move(state);
+        state = Update();
+        return update;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::string pending;
+    bool hasPending = false;
+    bool stopping = false;
+    uint64_t latest = 0;                // Номер последнего запроса; все поля - под mutex
+    Update state;
+    std::atomic<bool> notified{false};  // Fl::awake отправлен, окно ещё не забрало
+
+    // Один конвейер на всё время работы окна: таблицы анализатора и буферы
+    // не создаются заново на каждое нажатие. Только в рабочем потоке
+    Translator translator;
+    std::thread thread;
+
+    void run();
+
+    // Окно транслирует один вход за раз: функции генерируются на всех ядрах
+    static TranslateOptions windowOptions() {
+        TranslateOptions options;
+        options.codegen.threads = 0;
+        return options;
+    }
+
+    bool current(uint64_t generation) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return generation == latest;
+    }
+
+    // Одно сообщение на все изменения, пока окно их не забрало;
+    // false - очередь Fl::awake переполнена
+    bool notify() {
+        if (notified.exchange(true)) return true;
+        if (Fl::awake(onTranslationUpdate, this) == 0) return true;
+        notified = false;
+        return false;
+    }
+};
+
+void TranslationWorker::run() {
+    for (;;) {
+        std::string code;
+        uint64_t generation;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return hasPending || stopping; });
+            if (stopping) return;
+            code = std::move(pending);
+            hasPending = false;
+            generation = latest;
         }
-        
-        // Вывод предупреждений если есть
-        if (!semanticAnalyzer.getWarnings().empty()) {
-            std::string warning = "# === Warnings ===\n";
-            for (const auto& warn : semanticAnalyzer.getWarnings()) {
-                warning += "# " + warn + "\n";
+
+        auto start = std::chrono::steady_clock::now();
+        TranslatePhase shown = TranslatePhase::Count;
+        translator.translate(code, [&](TranslatePhase phase) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (generation != latest) return false;
+                // Внутри фазы опрос повторяется - окну только смена фазы
+                if (phase == shown) return true;
+                state.running = true;
+                state.phase = shown = phase;
             }
-            outputBuf->text(warning.c_str());
+            notify();                   // Потерянная фаза не страшна: следующая её заменит
+            return true;
+        });
+
+        {
+            // Отменённый результат не нужен: следующий запрос уже ждёт
+            std::lock_guard<std::mutex> lock(mutex);
+            if (generation != latest) continue;
+            state.finished = true;
+            state.result = translator.release();
+            state.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        // Результат терять нельзя: ждём места в очереди, пока он актуален
+        while (!notify() && current(generation)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+}
+
+TranslationWorker* worker = nullptr;
+Fl_Box* statusBox = nullptr;
+
+void showResult(const TranslateResult& result) {
+    if (!result.ok) {
+        std::string error = "=== Translation Errors ===\n";
+        for (const auto& err : result.errors) {
+            error += err + "\n";
+        }
+        outputBuf->text(error.c_str());
+        return;
+    }
+
+    // Предупреждения - комментарием перед кодом
+    std::string text;
+    if (!result.warnings.empty()) {
+        text = "# === Warnings ===\n";
+        for (const auto& warn : result.warnings) {
+            text += "# " + warn + "\n";
         }
+    }
+    text += result.output;
+    outputBuf->text(text.c_str());
+}
 
-        // 4) Генерация Python кода
-        CodeGenerator codeGen(&semanticAnalyzer);
-        std::string pythonCode = codeGen.generate(program.get());
-        
-        // 5) Вывод
-        outputBuf->text(pythonCode.c_str());
+// Поток окна (Fl::awake)
+void onTranslationUpdate(void* data) {
+    TranslationWorker::Update update = static_cast<TranslationWorker*>(data)->take();
 
-    } catch (const std::exception& ex) {
-        outputBuf->text(ex.what());
+    char status[64];
+    if (update.finished) {
+        showResult(update.result);
+        snprintf(status, sizeof status, "%s in %.2f s", update.result.ok ? "Done" : "Failed", update.seconds);
     }
+    else if (update.running) {
+        snprintf(status, sizeof status, "Translating: %s (%d/%d)", phaseName(update.phase),
+                 (int) update.phase + 1, (int) TranslatePhase::Count);
+    }
+    else {
+        return;
+    }
+    statusBox->copy_label(status);
+}
+
+} // namespace
+
+void ui_translate(Fl_Button*, void*) {
+    // text() возвращает копию буфера, освобождает её вызывающий
+    char* text = inputBuf->text();
+    std::string code(text);
+    free(text);
+    if (code.empty()) return;
+
+    statusBox->copy_label("Translating...");
+    worker->submit(std::move(code));
 }
 
 int main(int argc, char** argv) {
@@ -108,6 +255,7 @@ int main(int argc, char** argv) {
     ui->input_window->linenumber_width(30); 
     ui->input_window->linenumber_size(12);
     ui->output_window->buffer(outputBuf);
+    statusBox = ui->status_box;
     inputBuf->text(R"(int main() {
     int i = 0;
     int j = 0;
@@ -142,6 +290,13 @@ int main(int argc, char** argv) {
     return 42;
     })");
 
+    // Fl::lock() до первого окна включает Fl::awake из других потоков
+    Fl::lock();
+    TranslationWorker translationWorker;
+    worker = &translationWorker;
+
     window->show(argc, argv);
-    return Fl::run();
+    int status = Fl::run();
+    worker = nullptr;
+    return status;
 }
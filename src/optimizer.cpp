@@ -0,0 +1,486 @@
+#include "optimizer.h"
+#include "instrument.h"
+
+#include <algorithm>
+#include <vector>
+
+
+Optimizer::Optimizer (const SemanticAnalyzer& analyzer)
+    : semanticAnalyzer(analyzer)
+{}
+
+OptimizerStats
+Optimizer::optimize (Program* program)
+{
+    C2PY_PHASE("optimize");
+    stats = OptimizerStats();
+    if (!program) return stats;
+
+    for (auto& func : program->functions) {
+        if (!func->body) continue;
+        OptimizerStats before = stats;
+        simplifyBlock(func->body.get());
+        removeUnusedVariables(func.get());
+
+        // Тело больше не совпадает с исходными токенами - повторно использовать
+        // результаты анализа этой функции нельзя (см. SemanticAnalyzer::reanalyze)
+        if (stats.removedVariables != before.removedVariables ||
+            stats.removedStatements != before.removedStatements ||
+            stats.foldedBranches != before.foldedBranches) {
+            func->tokenHash = 0;
+        }
+    }
+
+    removeUnreachableFunctions(program);
+    return stats;
+}
+
+bool
+Optimizer::hasSideEffects (Expression* expr) const
+{
+    if (!expr) return false;
+    // Узлы без аннотации считаем опасными
+    const SemanticAnnotation* ann = semanticAnalyzer.getAnnotationForNode(expr);
+    return !ann || ann->hasSideEffects;
+}
+
+// ===== Константные выражения =====
+
+namespace {
+
+// Значение int по модулю 2^32, как в коде с эмуляцией переполнения:
+// ((value + 0x80000000 & 0xFFFFFFFF) - 0x80000000)
+long long
+wrapInt (long long value)
+{
+    return ((value + 0x80000000LL) & 0xFFFFFFFFLL) - 0x80000000LL;
+}
+
+} // namespace
+
+std::optional<long long>
+Optimizer::evaluateConstant (const Expression* expr)
+{
+    if (auto num = dynamic_cast<const NumberExpr*>(expr)) {
+        const std::string& v = num->value;
+        if (v.empty() || v.size() > 10 || v.find_first_not_of("0123456789") != std::string::npos) {
+            return std::nullopt; // Вещественные и не помещающиеся в int не сворачиваем
+        }
+        if (v.size() > 1 && v[0] == '0') return std::nullopt; // Восьмеричные
+
+        long long value = std::stoll(v);
+        if (value > 0x7FFFFFFFLL) return std::nullopt;
+        return value;
+    }
+
+    if (auto unary = dynamic_cast<const UnaryExpr*>(expr)) {
+        auto val = evaluateConstant(unary->expr.get());
+        if (!val) return std::nullopt;
+        if (unary->op == "-") return wrapInt(-*val);
+        if (unary->op == "!") return (long long)(*val == 0);
+        return std::nullopt;
+    }
+
+    if (auto binary = dynamic_cast<const BinaryExpr*>(expr)) {
+        auto lhs = evaluateConstant(binary->lhs.get());
+        if (!lhs) return std::nullopt;
+
+        // Логические операции вычисляются по короткой схеме, как в C
+        if (binary->op == "&&" && *lhs == 0) return 0LL;
+        if (binary->op == "||" && *lhs != 0) return 1LL;
+
+        auto rhs = evaluateConstant(binary->rhs.get());
+        if (!rhs) return std::nullopt;
+
+        // Операнды - int, поэтому в long long без переполнения; результат
+        // сворачивается в int, как у программы с эмуляцией переполнения
+        const std::string& op = binary->op;
+        long long a = *lhs, b = *rhs;
+        if (op == "&&" || op == "||") return (long long)(b != 0);
+        if (op == "==") return (long long)(a == b);
+        if (op == "!=") return (long long)(a != b);
+        if (op == "<")  return (long long)(a < b);
+        if (op == ">")  return (long long)(a > b);
+        if (op == "<=") return (long long)(a <= b);
+        if (op == ">=") return (long long)(a >= b);
+        if (op == "+")  return wrapInt(a + b);
+        if (op == "-")  return wrapInt(a - b);
+        if (op == "*")  return wrapInt(a * b);
+        // Генератор выдаёт // и % Python (округление вниз), в C - к нулю: результаты
+        // совпадают только при неотрицательных операндах, остальное не сворачиваем
+        // (в том числе деление на 0 и неопределённое INT_MIN / -1)
+        if ((op == "/" || op == "%") && (a < 0 || b <= 0)) return std::nullopt;
+        if (op == "/")  return a / b;
+        if (op == "%")  return a % b;
+        return std::nullopt;
+    }
+
+    return std::nullopt;
+}
+
+// ===== Недостижимый код и константные условия =====
+
+bool
+Optimizer::terminates (const Statement* stmt) const
+{
+    if (!stmt) return false;
+    if (dynamic_cast<const ReturnStmt*>(stmt) ||
+        dynamic_cast<const BreakStmt*>(stmt) ||
+        dynamic_cast<const ContinueStmt*>(stmt)) {
+        return true;
+    }
+    if (auto block = dynamic_cast<const BlockStmt*>(stmt)) {
+        return !block->statements.empty() && terminates(block->statements.back().get());
+    }
+    if (auto ifStmt = dynamic_cast<const IfStmt*>(stmt)) {
+        return ifStmt->elseBranch
+            && terminates(ifStmt->thenBranch.get())
+            && terminates(ifStmt->elseBranch.get());
+    }
+    return false;
+}
+
+void
+Optimizer::simplifyBlock (BlockStmt* block)
+{
+    auto& stmts = block->statements;
+    for (size_t i = 0; i < stmts.size(); ++i) {
+        simplifyStatement(stmts[i]);
+
+        // Всё, что после return/break/continue, никогда не выполнится
+        if (terminates(stmts[i].get()) && i + 1 < stmts.size()) {
+            stats.removedStatements += (int)(stmts.size() - i - 1);
+            stmts.erase(stmts.begin() + i + 1, stmts.end());
+        }
+    }
+}
+
+void
+Optimizer::simplifyStatement (StmtPtr& slot)
+{
+    Statement* stmt = slot.get();
+    if (!stmt) return;
+
+    if (auto block = dynamic_cast<BlockStmt*>(stmt)) {
+        simplifyBlock(block);
+    }
+    else if (auto ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+        simplifyStatement(ifStmt->thenBranch);
+        if (ifStmt->elseBranch) {
+            simplifyStatement(ifStmt->elseBranch);
+        }
+
+        auto cond = evaluateConstant(ifStmt->condition.get());
+        if (!cond) return;
+
+        // Оставляем только ветку, которая реально выполнится
+        ++stats.foldedBranches;
+        if (*cond != 0) {
+            slot = std::move(ifStmt->thenBranch);
+        } else if (ifStmt->elseBranch) {
+            slot = std::move(ifStmt->elseBranch);
+        } else {
+            slot = std::make_unique<BlockStmt>();
+        }
+    }
+    else if (auto whileStmt = dynamic_cast<WhileStmt*>(stmt)) {
+        simplifyStatement(whileStmt->body);
+    }
+    else if (auto doWhileStmt = dynamic_cast<DoWhileStmt*>(stmt)) {
+        simplifyStatement(doWhileStmt->body);
+    }
+    else if (auto forStmt = dynamic_cast<ForStmt*>(stmt)) {
+        simplifyStatement(forStmt->body);
+    }
+}
+
+// ===== Неиспользуемые переменные =====
+
+const ASTNode*
+Optimizer::storeTarget (const Expression* expr)
+{
+    const Expression* target = nullptr;
+    if (auto binary = dynamic_cast<const BinaryExpr*>(expr)) {
+        if (SemanticAnalyzer::isAssignmentOp(binary->op)) target = binary->lhs.get();
+    } else if (auto unary = dynamic_cast<const UnaryExpr*>(expr)) {
+        if (unary->op == "++" || unary->op == "--") target = unary->expr.get();
+    }
+
+    // Объявление может быть уже удалено из дерева - сравниваем только адреса
+    auto id = dynamic_cast<const IdentifierExpr*>(target);
+    return id ? id->declaration : nullptr;
+}
+
+void
+Optimizer::collectUsage (Expression* expr, bool isStoreTarget)
+{
+    if (!expr) return;
+
+    if (auto id = dynamic_cast<IdentifierExpr*>(expr)) {
+        if (id->declaration && !isStoreTarget && id->declaration != currentStore) {
+            ++usage[id->declaration].reads;
+        }
+    }
+    else if (auto binary = dynamic_cast<BinaryExpr*>(expr)) {
+        if (auto target = SemanticAnalyzer::isAssignmentOp(binary->op)
+                ? storeTarget(binary) : nullptr) {
+            // Запись внутри выражения: значение присваивания кто-то читает
+            ++usage[target].otherWrites;
+            collectUsage(binary->lhs.get(), true);
+        } else {
+            collectUsage(binary->lhs.get());
+        }
+        collectUsage(binary->rhs.get());
+    }
+    else if (auto unary = dynamic_cast<UnaryExpr*>(expr)) {
+        if (auto target = storeTarget(unary)) {
+            ++usage[target].otherWrites;
+            collectUsage(unary->expr.get(), true);
+        } else {
+            collectUsage(unary->expr.get());
+        }
+    }
+    else if (auto call = dynamic_cast<CallExpr*>(expr)) {
+        for (auto& arg : call->args) collectUsage(arg.get());
+    }
+}
+
+void
+Optimizer::collectUsage (Statement* stmt)
+{
+    if (!stmt) return;
+
+    if (auto exprStmt = dynamic_cast<ExpressionStmt*>(stmt)) {
+        Expression* expr = exprStmt->expr.get();
+        const ASTNode* target = storeTarget(expr);
+        if (!target) {
+            collectUsage(expr);
+            return;
+        }
+
+        // Запись отдельным оператором: "x = e;", "x += e;", "x++;"
+        // Чтение x только ради собственного обновления ("x = x + 1") использованием не считаем
+        if (auto binary = dynamic_cast<BinaryExpr*>(expr)) {
+            if (hasSideEffects(binary->rhs.get())) {
+                ++usage[target].otherWrites;
+                collectUsage(binary->rhs.get());
+            } else {
+                ++usage[target].pureStores;
+                currentStore = target;
+                collectUsage(binary->rhs.get());
+                currentStore = nullptr;
+            }
+        } else {
+            ++usage[target].pureStores;
+        }
+    }
+    else if (auto varDecl = dynamic_cast<VarDecl*>(stmt)) {
+        locals.insert(varDecl);
+        collectUsage(varDecl->init.get());
+    }
+    else if (auto block = dynamic_cast<BlockStmt*>(stmt)) {
+        for (auto& s : block->statements) collectUsage(s.get());
+    }
+    else if (auto ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+        collectUsage(ifStmt->condition.get());
+        collectUsage(ifStmt->thenBranch.get());
+        collectUsage(ifStmt->elseBranch.get());
+    }
+    else if (auto whileStmt = dynamic_cast<WhileStmt*>(stmt)) {
+        collectUsage(whileStmt->condition.get());
+        collectUsage(whileStmt->body.get());
+    }
+    else if (auto doWhileStmt = dynamic_cast<DoWhileStmt*>(stmt)) {
+        collectUsage(doWhileStmt->body.get());
+        collectUsage(doWhileStmt->condition.get());
+    }
+    else if (auto forStmt = dynamic_cast<ForStmt*>(stmt)) {
+        collectUsage(forStmt->init.get());
+        collectUsage(forStmt->condition.get());
+        collectUsage(forStmt->update.get());
+        collectUsage(forStmt->body.get());
+    }
+    else if (auto returnStmt = dynamic_cast<ReturnStmt*>(stmt)) {
+        collectUsage(returnStmt->value.get());
+    }
+}
+
+bool
+Optimizer::isDeadStore (Statement* stmt,
+                        const std::unordered_set<const ASTNode*>& dead) const
+{
+    if (auto varDecl = dynamic_cast<VarDecl*>(stmt)) {
+        return dead.count(varDecl) > 0;
+    }
+    if (auto exprStmt = dynamic_cast<ExpressionStmt*>(stmt)) {
+        return dead.count(storeTarget(exprStmt->expr.get())) > 0;
+    }
+    return false;
+}
+
+bool
+Optimizer::removeDeadStores (Statement* stmt,
+                             const std::unordered_set<const ASTNode*>& dead)
+{
+    if (!stmt) return false;
+    bool removed = false;
+
+    // Одиночный оператор в теле if/цикла заменяем пустым блоком
+    auto clearSlot = [&](StmtPtr& slot) {
+        if (isDeadStore(slot.get(), dead)) {
+            slot = std::make_unique<BlockStmt>();
+            ++stats.removedStatements;
+            removed = true;
+        } else {
+            removed |= removeDeadStores(slot.get(), dead);
+        }
+    };
+
+    if (auto block = dynamic_cast<BlockStmt*>(stmt)) {
+        auto& stmts = block->statements;
+        auto newEnd = std::remove_if(stmts.begin(), stmts.end(),
+            [&](const StmtPtr& s) { return isDeadStore(s.get(), dead); });
+        if (newEnd != stmts.end()) {
+            stats.removedStatements += (int)(stmts.end() - newEnd);
+            stmts.erase(newEnd, stmts.end());
+            removed = true;
+        }
+        for (auto& s : stmts) removed |= removeDeadStores(s.get(), dead);
+    }
+    else if (auto ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+        clearSlot(ifStmt->thenBranch);
+        if (ifStmt->elseBranch) clearSlot(ifStmt->elseBranch);
+    }
+    else if (auto whileStmt = dynamic_cast<WhileStmt*>(stmt)) {
+        clearSlot(whileStmt->body);
+    }
+    else if (auto doWhileStmt = dynamic_cast<DoWhileStmt*>(stmt)) {
+        clearSlot(doWhileStmt->body);
+    }
+    else if (auto forStmt = dynamic_cast<ForStmt*>(stmt)) {
+        if (isDeadStore(forStmt->init.get(), dead)) {
+            forStmt->init.reset();
+            ++stats.removedStatements;
+            removed = true;
+        }
+        clearSlot(forStmt->body);
+    }
+    return removed;
+}
+
+void
+Optimizer::removeUnusedVariables (FunctionDecl* func)
+{
+    // Удаление одной переменной может сделать ненужной другую,
+    // поэтому повторяем до неподвижной точки
+    while (true) {
+        usage.clear();
+        locals.clear();
+        collectUsage(func->body.get());
+
+        // Параметры и прочие объявления вне тела функции не трогаем
+        std::unordered_set<const ASTNode*> dead;
+        for (const VarDecl* decl : locals) {
+            const VarUsage& use = usage[decl];
+            if (use.reads || use.otherWrites) continue;
+            if (decl->init && hasSideEffects(decl->init.get())) continue;
+            dead.insert(decl);
+        }
+        if (dead.empty()) return;
+
+        removeDeadStores(func->body.get(), dead);
+        stats.removedVariables += (int)dead.size();
+    }
+}
+
+// ===== Недостижимые функции =====
+
+void
+Optimizer::collectCalls (const Expression* expr,
+                         std::unordered_set<std::string>& callees) const
+{
+    if (!expr) return;
+    if (auto call = dynamic_cast<const CallExpr*>(expr)) {
+        callees.insert(call->name);
+        for (const auto& arg : call->args) collectCalls(arg.get(), callees);
+    }
+    else if (auto binary = dynamic_cast<const BinaryExpr*>(expr)) {
+        collectCalls(binary->lhs.get(), callees);
+        collectCalls(binary->rhs.get(), callees);
+    }
+    else if (auto unary = dynamic_cast<const UnaryExpr*>(expr)) {
+        collectCalls(unary->expr.get(), callees);
+    }
+}
+
+void
+Optimizer::collectCalls (const Statement* stmt,
+                         std::unordered_set<std::string>& callees) const
+{
+    if (!stmt) return;
+    if (auto exprStmt = dynamic_cast<const ExpressionStmt*>(stmt)) {
+        collectCalls(exprStmt->expr.get(), callees);
+    }
+    else if (auto varDecl = dynamic_cast<const VarDecl*>(stmt)) {
+        collectCalls(varDecl->init.get(), callees);
+    }
+    else if (auto block = dynamic_cast<const BlockStmt*>(stmt)) {
+        for (const auto& s : block->statements) collectCalls(s.get(), callees);
+    }
+    else if (auto ifStmt = dynamic_cast<const IfStmt*>(stmt)) {
+        collectCalls(ifStmt->condition.get(), callees);
+        collectCalls(ifStmt->thenBranch.get(), callees);
+        collectCalls(ifStmt->elseBranch.get(), callees);
+    }
+    else if (auto whileStmt = dynamic_cast<const WhileStmt*>(stmt)) {
+        collectCalls(whileStmt->condition.get(), callees);
+        collectCalls(whileStmt->body.get(), callees);
+    }
+    else if (auto doWhileStmt = dynamic_cast<const DoWhileStmt*>(stmt)) {
+        collectCalls(doWhileStmt->body.get(), callees);
+        collectCalls(doWhileStmt->condition.get(), callees);
+    }
+    else if (auto forStmt = dynamic_cast<const ForStmt*>(stmt)) {
+        collectCalls(forStmt->init.get(), callees);
+        collectCalls(forStmt->condition.get(), callees);
+        collectCalls(forStmt->update.get(), callees);
+        collectCalls(forStmt->body.get(), callees);
+    }
+    else if (auto returnStmt = dynamic_cast<const ReturnStmt*>(stmt)) {
+        collectCalls(returnStmt->value.get(), callees);
+    }
+}
+
+void
+Optimizer::removeUnreachableFunctions (Program* program)
+{
+    std::unordered_map<std::string, const FunctionDecl*> byName;
+    for (const auto& func : program->functions) {
+        byName[func->name] = func.get();
+    }
+
+    // Без main точки входа нет - считаем, что нужны все функции
+    if (!byName.count("main")) return;
+
+    std::unordered_set<std::string> reached = { "main" };
+    std::vector<const FunctionDecl*> worklist = { byName["main"] };
+    while (!worklist.empty()) {
+        const FunctionDecl* func = worklist.back();
+        worklist.pop_back();
+
+        std::unordered_set<std::string> callees;
+        collectCalls(func->body.get(), callees);
+        for (const auto& name : callees) {
+            auto it = byName.find(name);
+            if (it != byName.end() && reached.insert(name).second) {
+                worklist.push_back(it->second);
+            }
+        }
+    }
+
+    auto& funcs = program->functions;
+    auto newEnd = std::remove_if(funcs.begin(), funcs.end(),
+        [&](const FuncPtr& f) { return !reached.count(f->name); });
+    stats.removedFunctions += (int)(funcs.end() - newEnd);
+    funcs.erase(newEnd, funcs.end());
+}
@@ -1,15 +1,44 @@
 #include "parser.h"
+#include "instrument.h"
 #include <stdexcept>
 #include <sstream>
 #include <iostream>
 #include <memory>
 
+namespace {
+
+// Позиция узла - позиция его первого токена
+template <typename Node>
+std::unique_ptr<Node> at(std::unique_ptr<Node> node, int line, int column) {
+    node->line = line;
+    node->column = column;
+    return node;
+}
+
+template <typename Node>
+std::unique_ptr<Node> at(std::unique_ptr<Node> node, const Token& token) {
+    return at(std::move(node), token.line, token.column);
+}
+
+// Бинарное выражение начинается с левого операнда
+ExprPtr binary(const std::string& op, ExprPtr lhs, ExprPtr rhs) {
+    int line = lhs->line, column = lhs->column;
+    return at<Expression>(std::make_unique<BinaryExpr>(op, std::move(lhs), std::move(rhs)), line, column);
+}
+
+}
+
 // --- constructor
 Parser::Parser(std::vector<Token> tokens)
     : tokens(std::move(tokens)), pos(0) {
     // initial scope already pushed by SymbolTable ctor
 }
 
+std::vector<Token> Parser::releaseTokens() {
+    pos = 0;
+    return std::move(tokens);
+}
+
 // --- token navigation
 const Token& Parser::peek() const {
     if (pos < tokens.size()) return tokens[pos];
@@ -64,6 +93,7 @@ std::string Parser::tokenLocation() const {
 
 // --- parseProgram
 ProgramPtr Parser::parseProgram() {
+    C2PY_PHASE("parse");
     auto program = std::make_unique<Program>();
     while (!atEnd()) {
         if (match(TokenType::Separator, ";")) continue;
@@ -80,6 +110,10 @@ ProgramPtr Parser::parseProgram() {
 
 // --- parseFunction
 FuncPtr Parser::parseFunction() {
+    size_t start = pos;
+    const Token& first = peek();
+    int startLine = first.line, startColumn = first.column;
+
     std::string retType;
     if (check(TokenType::Keyword)) { retType = peek().lexeme; advance(); }
 
@@ -120,9 +154,35 @@ FuncPtr Parser::parseFunction() {
     func->body = parseBlock();
 
     symbols.popScope();
+
+    func->line = startLine;
+    func->column = startColumn;
+    func->tokenHash = hashTokens(start, pos);
     return func;
 }
 
+// --- hashTokens: FNV-1a по типам, лексемам и позициям относительно первого токена,
+// чтобы сдвиг функции по строкам не менял хеш
+uint64_t Parser::hashTokens(size_t begin, size_t end) const {
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+
+    int baseLine = (begin < tokens.size()) ? tokens[begin].line : 0;
+    for (size_t i = begin; i < end && i < tokens.size(); ++i) {
+        const Token& t = tokens[i];
+        int fields[] = { (int)t.type, t.line - baseLine, t.column, (int)t.lexeme.size() };
+        mix(fields, sizeof(fields));
+        mix(t.lexeme.data(), t.lexeme.size());
+    }
+    return hash ? hash : 1;
+}
+
 // --- parseBlock
 std::unique_ptr<BlockStmt> Parser::parseBlock() {
     expect(TokenType::Separator, "{");
@@ -138,19 +198,20 @@ std::unique_ptr<BlockStmt> Parser::parseBlock() {
 
 // --- parseStatement
 StmtPtr Parser::parseStatement() {
-    if (match(TokenType::Keyword, "if")) return parseIf();
-    if (match(TokenType::Keyword, "while")) return parseWhile();
-    if (match(TokenType::Keyword, "do")) return parseDoWhile();
-    if (match(TokenType::Keyword, "for")) return parseFor();
-    if (match(TokenType::Keyword, "return")) return parseReturn();
-    if (match(TokenType::Keyword, "break")) return parseBreak();
-    if (match(TokenType::Keyword, "continue")) return parseContinue();
+    const Token& first = peek();
+    if (match(TokenType::Keyword, "if")) return at(parseIf(), first);
+    if (match(TokenType::Keyword, "while")) return at(parseWhile(), first);
+    if (match(TokenType::Keyword, "do")) return at(parseDoWhile(), first);
+    if (match(TokenType::Keyword, "for")) return at(parseFor(), first);
+    if (match(TokenType::Keyword, "return")) return at(parseReturn(), first);
+    if (match(TokenType::Keyword, "break")) return at(parseBreak(), first);
+    if (match(TokenType::Keyword, "continue")) return at(parseContinue(), first);
     if (check(TokenType::Keyword)) return parseVarDeclStatement();
-    if (match(TokenType::Separator, "{")) { --pos; return parseBlock(); }
+    if (match(TokenType::Separator, "{")) { --pos; return at<Statement>(parseBlock(), first); }
 
     auto expr = parseExpression();
     expect(TokenType::Separator, ";");
-    return std::make_unique<ExpressionStmt>(std::move(expr));
+    return at<Statement>(std::make_unique<ExpressionStmt>(std::move(expr)), first);
 }
 
 // --- if-else if-else (recursive else-if handling)
@@ -165,7 +226,8 @@ StmtPtr Parser::parseIf() {
     if (match(TokenType::Keyword, "else")) {
         if (match(TokenType::Keyword, "if")) {
             // 'else if' -> recursively parse another if and attach as else branch
-            elseStmt = parseIf();
+            const Token& elseIf = previous();
+            elseStmt = at(parseIf(), elseIf);
         } else {
             elseStmt = parseStatement();
         }
@@ -215,7 +277,8 @@ StmtPtr Parser::parseFor() {
         else {
             auto e = parseExpression();
             expect(TokenType::Separator, ";");
-            initStmt = std::make_unique<ExpressionStmt>(std::move(e));
+            int line = e->line, column = e->column;
+            initStmt = at<Statement>(std::make_unique<ExpressionStmt>(std::move(e)), line, column);
         }
     } else { expect(TokenType::Separator, ";"); }
 
@@ -251,6 +314,7 @@ StmtPtr Parser::parseBreak() { expect(TokenType::Separator, ";"); return std::ma
 StmtPtr Parser::parseContinue() { expect(TokenType::Separator, ";"); return std::make_unique<ContinueStmt>(); }
 
 StmtPtr Parser::parseVarDeclStatement() {
+    const Token& first = peek();
     std::string type = peek().lexeme; advance();
     if (!check(TokenType::Identifier)) throw std::runtime_error("Expected identifier after type at " + tokenLocation());
     std::string name = peek().lexeme; advance();
@@ -259,7 +323,7 @@ StmtPtr Parser::parseVarDeclStatement() {
     if (match(TokenType::Operator, "=")) init = parseExpression();
     expect(TokenType::Separator, ";");
 
-    auto node = std::make_unique<VarDecl>(type, name, std::move(init));
+    auto node = at(std::make_unique<VarDecl>(type, name, std::move(init)), first);
     symbols.declare(name, node.get());
     return node;
 }
@@ -276,7 +340,7 @@ ExprPtr Parser::parseAssignment() {
         if (op == "=" || op == "+=" || op == "-=" || op == "*=" || op == "/=" || op == "%=") {
             advance(); // consume operator
             auto right = parseAssignment();
-            return std::make_unique<BinaryExpr>(op, std::move(left), std::move(right));
+            return binary(op, std::move(left), std::move(right));
         }
     }
     return left;
@@ -287,7 +351,7 @@ ExprPtr Parser::parseLogicalOr() {
     while (match(TokenType::Operator, "||")) {
         std::string op = previous().lexeme;
         auto right = parseLogicalAnd();
-        expr = std::make_unique<BinaryExpr>(op, std::move(expr), std::move(right));
+        expr = binary(op, std::move(expr), std::move(right));
     }
     return expr;
 }
@@ -297,7 +361,7 @@ ExprPtr Parser::parseLogicalAnd() {
     while (match(TokenType::Operator, "&&")) {
         std::string op = previous().lexeme;
         auto right = parseEquality();
-        expr = std::make_unique<BinaryExpr>(op, std::move(expr), std::move(right));
+        expr = binary(op, std::move(expr), std::move(right));
     }
     return expr;
 }
@@ -307,7 +371,7 @@ ExprPtr Parser::parseEquality() {
     while (match(TokenType::Operator, "==") || match(TokenType::Operator, "!=")) {
         std::string op = previous().lexeme;
         auto right = parseRelational();
-        expr = std::make_unique<BinaryExpr>(op, std::move(expr), std::move(right));
+        expr = binary(op, std::move(expr), std::move(right));
     }
     return expr;
 }
@@ -318,7 +382,7 @@ ExprPtr Parser::parseRelational() {
            match(TokenType::Operator, "<=") || match(TokenType::Operator, ">=")) {
         std::string op = previous().lexeme;
         auto right = parseAdditive();
-        expr = std::make_unique<BinaryExpr>(op, std::move(expr), std::move(right));
+        expr = binary(op, std::move(expr), std::move(right));
     }
     return expr;
 }
@@ -328,7 +392,7 @@ ExprPtr Parser::parseAdditive() {
     while (match(TokenType::Operator, "+") || match(TokenType::Operator, "-")) {
         std::string op = previous().lexeme;
         auto right = parseMultiplicative();
-        expr = std::make_unique<BinaryExpr>(op, std::move(expr), std::move(right));
+        expr = binary(op, std::move(expr), std::move(right));
     }
     return expr;
 }
@@ -338,7 +402,7 @@ ExprPtr Parser::parseMultiplicative() {
     while (match(TokenType::Operator, "*") || match(TokenType::Operator, "/") || match(TokenType::Operator, "%")) {
         std::string op = previous().lexeme;
         auto right = parseUnary();
-        expr = std::make_unique<BinaryExpr>(op, std::move(expr), std::move(right));
+        expr = binary(op, std::move(expr), std::move(right));
     }
     return expr;
 }
@@ -347,9 +411,9 @@ ExprPtr Parser::parseMultiplicative() {
 ExprPtr Parser::parseUnary() {
     if (match(TokenType::Operator, "!") || match(TokenType::Operator, "-") ||
         match(TokenType::Operator, "++") || match(TokenType::Operator, "--")) {
-        std::string op = previous().lexeme;
+        const Token& opToken = previous();
         auto right = parseUnary();
-        return std::make_unique<UnaryExpr>(op, std::move(right));
+        return at<Expression>(std::make_unique<UnaryExpr>(opToken.lexeme, std::move(right)), opToken);
     }
     return parsePostfix();
 }
@@ -361,23 +425,25 @@ ExprPtr Parser::parsePostfix() {
     // post-increment / post-decrement
     while (match(TokenType::Operator, "++") || match(TokenType::Operator, "--")) {
         std::string op = previous().lexeme;
-        expr = std::make_unique<UnaryExpr>(op, std::move(expr));
+        int line = expr->line, column = expr->column;
+        expr = at<Expression>(std::make_unique<UnaryExpr>(op, std::move(expr)), line, column);
     }
     return expr;
 }
 
 ExprPtr Parser::parsePrimary() {
     if (match(TokenType::Number)) {
-        return std::make_unique<NumberExpr>(previous().lexeme);
+        return at<Expression>(std::make_unique<NumberExpr>(previous().lexeme), previous());
     }
 
     if (match(TokenType::Identifier)) {
-        std::string name = previous().lexeme;
+        const Token& nameToken = previous();
+        std::string name = nameToken.lexeme;
         
         // Check if it's a function call
         if (check(TokenType::Separator, "(")) {
             advance(); // consume '('
-            auto call = std::make_unique<CallExpr>(name);
+            auto call = at(std::make_unique<CallExpr>(name), nameToken);
             
             // Parse arguments
             if (!check(TokenType::Separator, ")")) {
@@ -391,7 +457,7 @@ ExprPtr Parser::parsePrimary() {
         }
         
         // Otherwise it's just an identifier
-        auto id = std::make_unique<IdentifierExpr>(name);
+        auto id = at(std::make_unique<IdentifierExpr>(name), nameToken);
         ASTNode* decl = symbols.lookup(id->name);
         if (decl) id->declaration = decl;
         return id;
@@ -0,0 +1,165 @@
+#include "pipeline.h"
+
+#include "lexer.h"
+#include "parser.h"
+#include "optimizer.h"
+#include "pyc_generator.h"
+#include "instrument.h"
+
+#include <exception>
+
+
+namespace {
+
+// Прерывание между фазами - исключением: выход через общий обработчик ошибок
+struct Cancelled {};
+
+} // namespace
+
+const char*
+phaseName (TranslatePhase phase)
+{
+    switch (phase) {
+        case TranslatePhase::Lex:       return "lex";
+        case TranslatePhase::Parse:     return "parse";
+        case TranslatePhase::Semantic:  return "semantic";
+        case TranslatePhase::Inline:    return "inline";
+        case TranslatePhase::Optimize:  return "optimize";
+        case TranslatePhase::Generate:  return "generate";
+        case TranslatePhase::Count:     break;
+    }
+    return "?";
+}
+
+Translator::Translator (const TranslateOptions& options)
+    : translateOptions(options), analyzer(symbolTable), generator(&analyzer, options.codegen)
+{
+}
+
+const TranslateResult&
+Translator::translate (std::string_view code, const TranslateProgress& progress)
+{
+    C2PY_PHASE("translate");
+    const TranslateOptions& options = translateOptions;
+    TranslatePhase current = TranslatePhase::Lex;
+    auto enter = [&](TranslatePhase phase) {
+        current = phase;
+        if (progress && !progress(phase)) throw Cancelled();
+    };
+    // Анализ - самая долгая фаза: отмена проверяется и между функциями.
+    // Опрос ссылается на progress этого вызова, следующий translate() его заменит
+    analyzer.setInterrupt(progress ? std::function<bool()>([&] { return !progress(current); }) : nullptr);
+    // Поля прошлого результата очищаются, их память остаётся
+    result.ok = false;
+    result.errors.clear();
+    result.warnings.clear();
+    result.sourceMap.clear();
+    reused = 0;
+    try {
+        enter(TranslatePhase::Lex);
+        source.assign(code);
+        Lexer(source).tokenize(tokens);
+
+        // Вектор токенов возвращается и после синтаксической ошибки
+        enter(TranslatePhase::Parse);
+        ProgramPtr program;
+        std::exception_ptr syntaxError;
+        Parser parser(std::move(tokens));
+        try {
+            program = parser.parseProgram();
+        } catch (...) {
+            syntaxError = std::current_exception();
+        }
+        tokens = parser.releaseTokens();
+        if (syntaxError) std::rethrow_exception(syntaxError);
+
+        // Прошлая программа отдаёт неизменённые функции. Дальше состояние
+        // анализатора - у program: если трансляция прервётся, previous
+        // останется пустым, и следующий вход анализируется полностью
+        enter(TranslatePhase::Semantic);
+        ProgramPtr last = std::move(previous);
+        bool valid = analyzer.reanalyze(last, program);
+        reused = analyzer.getReusedFunctionCount();
+        last.reset();
+        if (!valid) {
+            result.errors = analyzer.getErrors();
+            result.warnings = analyzer.getWarnings();
+            result.output.clear();
+            previous = std::move(program);
+            return result;
+        }
+        // Предупреждения - по исходной программе, до подстановки и оптимизации
+        result.warnings = analyzer.getWarnings();
+
+        // После изменений AST аннотации и потоки данных строятся заново
+        enter(TranslatePhase::Inline);
+        Inliner inliner(analyzer, options.inliner);
+        if (inliner.inlineCalls(program.get()).changed()) {
+            analyzer.analyze(program);
+        }
+        if (options.optimize) {
+            enter(TranslatePhase::Optimize);
+            Optimizer optimizer(analyzer);
+            if (optimizer.optimize(program.get()).changed()) {
+                analyzer.analyze(program);
+            }
+        }
+
+        enter(TranslatePhase::Generate);
+        if (options.bytecode) {
+            PycGenerator pycGenerator(&analyzer, options.codegen);
+            result.output = pycGenerator.generate(program.get(), options.fileName);
+        }
+        else {
+            StringSink sink(std::move(result.output));
+            generator.generate(program.get(), sink, options.sourceMap ? &result.sourceMap : nullptr);
+            result.output = sink.take();
+        }
+        result.ok = true;
+        previous = std::move(program);
+    } catch (const Cancelled&) {
+        cancelled();
+    } catch (const AnalysisInterrupted&) {
+        cancelled();
+    } catch (const std::exception& e) {
+        result.errors.push_back(e.what());
+        result.output.clear();
+    }
+    return result;
+}
+
+void
+Translator::cancelled ()
+{
+    result.errors.assign(1, "translation cancelled");
+    result.warnings.clear();
+    result.output.clear();
+}
+
+std::vector<TranslateResult>
+Translator::translate (const std::vector<std::string_view>& codes)
+{
+    std::vector<TranslateResult> results;
+    results.reserve(codes.size());
+    for (std::string_view code : codes) {
+        translate(code);
+        results.push_back(release());
+    }
+    return results;
+}
+
+TranslateResult
+Translator::release ()
+{
+    TranslateResult released = std::move(result);
+    result = TranslateResult();
+    return released;
+}
+
+TranslateResult
+translateSource (const std::string& code, const TranslateOptions& options)
+{
+    Translator translator(options);
+    translator.translate(code);
+    return translator.release();
+}
@@ -0,0 +1,324 @@
+#include "protocol.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+
+void
+writeU32 (std::string& out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i) out.push_back((char) ((value >> (8 * i)) & 0xff));
+}
+
+void
+writeBlob (std::string& out, const std::string& text)
+{
+    writeU32(out, (uint32_t) text.size());
+    out += text;
+}
+
+void
+writeList (std::string& out, const std::vector<std::string>& items)
+{
+    writeU32(out, (uint32_t) items.size());
+    for (const std::string& item : items) writeBlob(out, item);
+}
+
+uint32_t
+readU32 (const char* data)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) value |= (uint32_t) (unsigned char) data[i] << (8 * i);
+    return value;
+}
+
+// Чтение с проверкой границ: любой выход за конец - испорченные данные
+struct Reader {
+    const std::string& data;
+    size_t& pos;
+    bool failed = false;
+
+    uint32_t
+    u32 ()
+    {
+        if (data.size() - pos < 4) {
+            failed = true;
+            return 0;
+        }
+        uint32_t value = readU32(data.data() + pos);
+        pos += 4;
+        return value;
+    }
+
+    std::string
+    blob ()
+    {
+        uint32_t size = u32();
+        if (failed || data.size() - pos < size) {
+            failed = true;
+            return std::string();
+        }
+        std::string text = data.substr(pos, size);
+        pos += size;
+        return text;
+    }
+
+    std::vector<std::string>
+    list ()
+    {
+        uint32_t count = u32();
+        std::vector<std::string> items;
+        for (uint32_t i = 0; i < count && !failed; ++i) items.push_back(blob());
+        return items;
+    }
+};
+
+} // namespace
+
+void
+encodeResult (std::string& out, const TranslateResult& result)
+{
+    writeU32(out, result.ok ? 1 : 0);
+    writeList(out, result.errors);
+    writeList(out, result.warnings);
+    writeBlob(out, result.output);
+    writeU32(out, (uint32_t) result.sourceMap.lineCount());
+    writeBlob(out, result.sourceMap.lineCount() ? result.sourceMap.encodeMappings() : std::string());
+}
+
+bool
+decodeResult (const std::string& data, size_t& pos, TranslateResult& result)
+{
+    if (pos > data.size()) return false;
+    Reader reader { data, pos };
+    TranslateResult decoded;
+    decoded.ok = reader.u32() != 0;
+    decoded.errors = reader.list();
+    decoded.warnings = reader.list();
+    decoded.output = reader.blob();
+    uint32_t mapLines = reader.u32();
+    std::string mappings = reader.blob();
+    if (reader.failed) return false;
+
+    if (mapLines) {
+        try {
+            decoded.sourceMap = SourceMap::decodeMappings(mappings);
+        } catch (const std::exception&) {
+            return false;
+        }
+        // Хвост карты без позиций в mappings не виден
+        while (decoded.sourceMap.lineCount() < mapLines) decoded.sourceMap.addLine(SourcePosition());
+    }
+    result = std::move(decoded);
+    return true;
+}
+
+std::string
+encodeRequest (const TranslateRequest& request)
+{
+    uint32_t flags = 0;
+    if (request.options.bytecode) flags |= RequestBytecode;
+    if (request.options.sourceMap) flags |= RequestSourceMap;
+    if (!request.options.inliner.enabled) flags |= RequestNoInline;
+    if (!request.options.optimize) flags |= RequestNoOptimize;
+    const CodeGenOptions& codegen = request.options.codegen;
+    if (codegen.memoizePureRecursive) flags |= RequestMemoize;
+    if (codegen.bindLoopGlobals) flags |= RequestBindLoopGlobals;
+
+    std::string out;
+    writeU32(out, (uint32_t) request.kind);
+    writeU32(out, flags);
+    writeBlob(out, request.options.fileName);
+    writeBlob(out, request.code);
+    if (flags & RequestMemoize) {
+        std::vector<std::string> noMemoize(codegen.noMemoize.begin(), codegen.noMemoize.end());
+        std::sort(noMemoize.begin(), noMemoize.end());
+        writeList(out, noMemoize);
+    }
+    return out;
+}
+
+bool
+decodeRequest (const std::string& data, TranslateRequest& request)
+{
+    size_t pos = 0;
+    Reader reader { data, pos };
+    uint32_t kind = reader.u32();
+    uint32_t flags = reader.u32();
+    std::string fileName = reader.blob();
+    std::string code = reader.blob();
+    std::vector<std::string> noMemoize;
+    if (flags & RequestMemoize) noMemoize = reader.list();
+    if (reader.failed || pos != data.size()) return false;
+    if (kind != (uint32_t) RequestKind::Translate && kind != (uint32_t) RequestKind::Shutdown) return false;
+
+    request.kind = (RequestKind) kind;
+    request.options.bytecode = (flags & RequestBytecode) != 0;
+    request.options.sourceMap = (flags & RequestSourceMap) != 0;
+    request.options.inliner.enabled = (flags & RequestNoInline) == 0;
+    request.options.optimize = (flags & RequestNoOptimize) == 0;
+    request.options.codegen.memoizePureRecursive = (flags & RequestMemoize) != 0;
+    request.options.codegen.bindLoopGlobals = (flags & RequestBindLoopGlobals) != 0;
+    request.options.codegen.noMemoize.clear();
+    request.options.codegen.noMemoize.insert(noMemoize.begin(), noMemoize.end());
+    request.options.fileName = fileName;
+    request.code = std::move(code);
+    return true;
+}
+
+#ifndef _WIN32
+
+namespace {
+
+bool
+readAll (int fd, char* data, size_t size)
+{
+    while (size) {
+        ssize_t got = read(fd, data, size);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        data += got;
+        size -= (size_t) got;
+    }
+    return true;
+}
+
+// Закрытый собеседник - ошибка записи, а не SIGPIPE, убивающий процесс
+bool
+writeAll (int fd, const char* data, size_t size)
+{
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    while (size) {
+        ssize_t sent = send(fd, data, size, flags);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        data += sent;
+        size -= (size_t) sent;
+    }
+    return true;
+}
+
+} // namespace
+
+bool
+readFrame (int fd, std::string& payload)
+{
+    char header[4];
+    if (!readAll(fd, header, sizeof(header))) return false;
+    uint32_t size = readU32(header);
+    if (size > maxFrameSize) {
+        errno = EMSGSIZE;
+        return false;
+    }
+    payload.resize(size);
+    return readAll(fd, &payload[0], size);
+}
+
+bool
+writeFrame (int fd, const std::string& payload)
+{
+    if (payload.size() > maxFrameSize) {
+        errno = EMSGSIZE;
+        return false;
+    }
+    // Заголовок и тело - одной записью: маленький кадр уходит одним пакетом
+    std::string frame;
+    frame.reserve(4 + payload.size());
+    writeU32(frame, (uint32_t) payload.size());
+    frame += payload;
+    return writeAll(fd, frame.data(), frame.size());
+}
+
+std::string
+defaultSocketPath ()
+{
+    if (const char* path = std::getenv("C2PY_SOCKET")) {
+        if (*path) return path;
+    }
+    // Общий /tmp - в собственном каталоге: имя в нём не занять чужим сокетом
+    if (const char* runtime = std::getenv("XDG_RUNTIME_DIR")) {
+        if (*runtime) return std::string(runtime) + "/c2py.sock";
+    }
+    return "/tmp/c2py-" + std::to_string(getuid()) + "/c2py.sock";
+}
+
+bool
+checkSocketDirectory (const std::string& socketPath, bool create)
+{
+    size_t slash = socketPath.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : socketPath.substr(0, slash ? slash : 1);
+    if (create && mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) return false;
+
+    // lstat: ссылка на чужой каталог не подходит
+    struct stat info;
+    if (lstat(dir.c_str(), &info) != 0) return false;
+    if (!S_ISDIR(info.st_mode) || info.st_uid != getuid() || (info.st_mode & 077) != 0) {
+        errno = EACCES;
+        return false;
+    }
+    return true;
+}
+
+bool
+peerIsSameUser (int fd)
+{
+#ifdef SO_PEERCRED
+    ucred credentials;
+    socklen_t size = sizeof(credentials);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &size) != 0) return false;
+    uid_t uid = credentials.uid;
+#else
+    uid_t uid;
+    gid_t gid;
+    if (getpeereid(fd, &uid, &gid) != 0) return false;
+#endif
+    return uid == getuid();
+}
+
+int
+connectSocket (const std::string& path)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    if (path.size() >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (sockaddr*) &address, sizeof(address)) != 0) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    // Сервер другого пользователя получил бы исходники и подсунул бы свой вывод
+    if (!peerIsSameUser(fd)) {
+        close(fd);
+        errno = EACCES;
+        return -1;
+    }
+    return fd;
+}
+
+#endif
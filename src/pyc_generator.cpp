@@ -0,0 +1,865 @@
+#include "pyc_generator.h"
+#include "instrument.h"
+
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+
+
+namespace {
+
+using Label = BytecodeAssembler::Label;
+
+// Литерал числа: цифры, с точкой - float (как в тексте Python)
+PyConst
+parseNumber (const std::string& text)
+{
+    if (text.find('.') != std::string::npos) {
+        char* end = nullptr;
+        double value = std::strtod(text.c_str(), &end);
+        if (text.empty() || *end != '\0') {
+            throw std::runtime_error("pyc: bad number literal " + text);
+        }
+        return PyConst::makeFloat(value);
+    }
+
+    long long value = 0;
+    for (char c : text) {
+        if (!std::isdigit(static_cast<unsigned char>(c)) || value > (LLONG_MAX - (c - '0')) / 10) {
+            throw std::runtime_error("pyc: unsupported number literal " + text);
+        }
+        value = value * 10 + (c - '0');
+    }
+    return PyConst::makeInt(value);
+}
+
+// while (1): условие не проверяется, как у компилятора CPython
+bool
+isConstantTrue (const Expression* expr)
+{
+    auto num = dynamic_cast<const NumberExpr*>(expr);
+    return num && num->value.find_first_not_of("0.") != std::string::npos;
+}
+
+int
+binaryOpCode (const std::string& op)
+{
+    if (op == "+") return NB_ADD;
+    if (op == "-") return NB_SUBTRACT;
+    if (op == "*") return NB_MULTIPLY;
+    if (op == "/") return NB_FLOOR_DIVIDE;     // Как // в тексте
+    if (op == "%") return NB_REMAINDER;
+    if (op == "&") return NB_AND;
+    if (op == "|") return NB_OR;
+    if (op == "^") return NB_XOR;
+    if (op == "<<") return NB_LSHIFT;
+    if (op == ">>") return NB_RSHIFT;
+    return -1;
+}
+
+int
+compareOpCode (const std::string& op)
+{
+    if (op == "<") return CMP_LT;
+    if (op == "<=") return CMP_LE;
+    if (op == "==") return CMP_EQ;
+    if (op == "!=") return CMP_NE;
+    if (op == ">") return CMP_GT;
+    if (op == ">=") return CMP_GE;
+    return -1;
+}
+
+bool
+isIncrement (const Expression* expr)
+{
+    auto unary = dynamic_cast<const UnaryExpr*>(expr);
+    return unary && (unary->op == "++" || unary->op == "--");
+}
+
+}
+
+
+PycGenerator::PycGenerator (const SemanticAnalyzer* analyzer, const CodeGenOptions& options)
+    : semanticAnalyzer(analyzer), options(options)
+{
+}
+
+// ===== Имена и константы =====
+
+void
+PycGenerator::loadName (const std::string& name)
+{
+    int local = as->findLocal(name);
+    if (local >= 0) {
+        as->emit(PyOp::LOAD_FAST, local);
+    } else {
+        as->emit(PyOp::LOAD_GLOBAL, as->addName(name) << 1);
+    }
+}
+
+void
+PycGenerator::storeName (const std::string& name)
+{
+    as->emit(PyOp::STORE_FAST, as->addLocal(name));
+}
+
+void
+PycGenerator::loadConst (const PyConst& value)
+{
+    as->emit(PyOp::LOAD_CONST, as->addConst(value));
+}
+
+void
+PycGenerator::collectLocals (Statement* stmt)
+{
+    // Как в Python: имя, которому что-то присваивается в функции, - локальное
+    if (!stmt) return;
+
+    if (auto decl = dynamic_cast<VarDecl*>(stmt)) {
+        as->addLocal(decl->name);
+        collectLocals(decl->init.get());
+    }
+    else if (auto exprStmt = dynamic_cast<ExpressionStmt*>(stmt)) {
+        collectLocals(exprStmt->expr.get());
+    }
+    else if (auto block = dynamic_cast<BlockStmt*>(stmt)) {
+        for (auto& s : block->statements) {
+            collectLocals(s.get());
+        }
+    }
+    else if (auto ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+        collectLocals(ifStmt->condition.get());
+        collectLocals(ifStmt->thenBranch.get());
+        collectLocals(ifStmt->elseBranch.get());
+    }
+    else if (auto whileStmt = dynamic_cast<WhileStmt*>(stmt)) {
+        collectLocals(whileStmt->condition.get());
+        collectLocals(whileStmt->body.get());
+    }
+    else if (auto doWhile = dynamic_cast<DoWhileStmt*>(stmt)) {
+        collectLocals(doWhile->body.get());
+        collectLocals(doWhile->condition.get());
+    }
+    else if (auto forStmt = dynamic_cast<ForStmt*>(stmt)) {
+        collectLocals(forStmt->init.get());
+        collectLocals(forStmt->condition.get());
+        collectLocals(forStmt->update.get());
+        collectLocals(forStmt->body.get());
+    }
+    else if (auto ret = dynamic_cast<ReturnStmt*>(stmt)) {
+        collectLocals(ret->value.get());
+    }
+}
+
+void
+PycGenerator::collectLocals (Expression* expr)
+{
+    if (auto unary = dynamic_cast<UnaryExpr*>(expr)) {
+        auto id = dynamic_cast<IdentifierExpr*>(unary->expr.get());
+        if (id && isIncrement(unary)) as->addLocal(id->name);
+        collectLocals(unary->expr.get());
+    }
+    else if (auto binary = dynamic_cast<BinaryExpr*>(expr)) {
+        auto id = dynamic_cast<IdentifierExpr*>(binary->lhs.get());
+        if (id && SemanticAnalyzer::isAssignmentOp(binary->op)) as->addLocal(id->name);
+        collectLocals(binary->lhs.get());
+        collectLocals(binary->rhs.get());
+    }
+    else if (auto call = dynamic_cast<CallExpr*>(expr)) {
+        for (auto& arg : call->args) {
+            collectLocals(arg.get());
+        }
+    }
+}
+
+// ===== Выражения =====
+
+bool
+PycGenerator::needsWrap (const Expression* expr) const
+{
+    return options.wrapIntegerOverflow && semanticAnalyzer && semanticAnalyzer->mayOverflow(expr);
+}
+
+void
+PycGenerator::generateWrap ()
+{
+    // (value + 0x80000000 & 0xFFFFFFFF) - 0x80000000
+    loadConst(PyConst::makeInt(0x80000000LL));
+    as->emit(PyOp::BINARY_OP, NB_ADD);
+    loadConst(PyConst::makeInt(0xFFFFFFFFLL));
+    as->emit(PyOp::BINARY_OP, NB_AND);
+    loadConst(PyConst::makeInt(0x80000000LL));
+    as->emit(PyOp::BINARY_OP, NB_SUBTRACT);
+}
+
+void
+PycGenerator::generateNumber (NumberExpr* expr)
+{
+    loadConst(parseNumber(expr->value));
+}
+
+void
+PycGenerator::generateIncrement (UnaryExpr* expr, bool keepValue)
+{
+    auto id = dynamic_cast<IdentifierExpr*>(expr->expr.get());
+    if (!id) {
+        throw std::runtime_error("pyc: " + expr->op + " of a non-variable");
+    }
+
+    loadName(id->name);
+    loadConst(PyConst::makeInt(1));
+    int op = (expr->op == "++") ? NB_ADD : NB_SUBTRACT;
+    if (needsWrap(expr)) {
+        as->emit(PyOp::BINARY_OP, op);
+        generateWrap();
+    } else {
+        as->emit(PyOp::BINARY_OP, op + NB_INPLACE);
+    }
+    if (keepValue) as->emit(PyOp::COPY, 1);
+    storeName(id->name);
+}
+
+void
+PycGenerator::generateUnary (UnaryExpr* expr)
+{
+    if (isIncrement(expr)) {
+        generateIncrement(expr, true);
+        return;
+    }
+
+    generateExpression(expr->expr.get());
+    if (expr->op == "!") {
+        as->emit(PyOp::UNARY_NOT);
+        return;
+    }
+
+    if (expr->op == "-") {
+        as->emit(PyOp::UNARY_NEGATIVE);
+    } else if (expr->op == "+") {
+        as->emit(PyOp::UNARY_POSITIVE);
+    } else if (expr->op == "~") {
+        as->emit(PyOp::UNARY_INVERT);
+    } else {
+        throw std::runtime_error("pyc: unsupported unary operator " + expr->op);
+    }
+    if (needsWrap(expr)) generateWrap();
+}
+
+void
+PycGenerator::generateAssignment (BinaryExpr* expr, bool keepValue)
+{
+    auto id = dynamic_cast<IdentifierExpr*>(expr->lhs.get());
+    if (!id) {
+        throw std::runtime_error("pyc: assignment to a non-variable");
+    }
+
+    if (expr->op == "=") {
+        generateExpression(expr->rhs.get());
+    } else {
+        int op = binaryOpCode(expr->op.substr(0, expr->op.size() - 1));
+        if (op < 0) {
+            throw std::runtime_error("pyc: unsupported assignment operator " + expr->op);
+        }
+        loadName(id->name);
+        generateExpression(expr->rhs.get());
+        if (needsWrap(expr)) {
+            // x += e  ->  x = wrap(x + e)
+            as->emit(PyOp::BINARY_OP, op);
+            generateWrap();
+        } else {
+            as->emit(PyOp::BINARY_OP, op + NB_INPLACE);
+        }
+    }
+    if (keepValue) as->emit(PyOp::COPY, 1);
+    storeName(id->name);
+}
+
+void
+PycGenerator::generateBinary (BinaryExpr* expr)
+{
+    if (SemanticAnalyzer::isAssignmentOp(expr->op)) {
+        generateAssignment(expr, true);
+        return;
+    }
+
+    // and/or возвращают значение операнда, как в тексте
+    if (expr->op == "&&" || expr->op == "||") {
+        Label end = as->newLabel();
+        generateExpression(expr->lhs.get());
+        as->emitJump(expr->op == "&&" ? BytecodeAssembler::IfFalseOrPop
+                                      : BytecodeAssembler::IfTrueOrPop, end);
+        generateExpression(expr->rhs.get());
+        as->bind(end);
+        return;
+    }
+
+    generateExpression(expr->lhs.get());
+    generateExpression(expr->rhs.get());
+
+    int cmp = compareOpCode(expr->op);
+    if (cmp >= 0) {
+        as->emit(PyOp::COMPARE_OP, cmp);
+        return;
+    }
+
+    int op = binaryOpCode(expr->op);
+    if (op < 0) {
+        throw std::runtime_error("pyc: unsupported binary operator " + expr->op);
+    }
+    as->emit(PyOp::BINARY_OP, op);
+    if (needsWrap(expr)) generateWrap();
+}
+
+void
+PycGenerator::generateCall (CallExpr* expr)
+{
+    int local = as->findLocal(expr->name);
+    if (local >= 0) {
+        as->emit(PyOp::PUSH_NULL);
+        as->emit(PyOp::LOAD_FAST, local);
+    } else {
+        as->emit(PyOp::LOAD_GLOBAL, (as->addName(expr->name) << 1) | 1);
+    }
+
+    for (auto& arg : expr->args) {
+        generateExpression(arg.get());
+    }
+    int argc = (int) expr->args.size();
+    as->emit(PyOp::PRECALL, argc);
+    as->emit(PyOp::CALL, argc);
+}
+
+void
+PycGenerator::generateExpression (Expression* expr)
+{
+    auto inv = hoisted.find(expr);
+    if (inv != hoisted.end()) {
+        as->emit(PyOp::LOAD_FAST, inv->second);
+        return;
+    }
+
+    if (auto num = dynamic_cast<NumberExpr*>(expr)) {
+        generateNumber(num);
+    } else if (auto id = dynamic_cast<IdentifierExpr*>(expr)) {
+        loadName(id->name);
+    } else if (auto unary = dynamic_cast<UnaryExpr*>(expr)) {
+        generateUnary(unary);
+    } else if (auto binary = dynamic_cast<BinaryExpr*>(expr)) {
+        generateBinary(binary);
+    } else if (auto call = dynamic_cast<CallExpr*>(expr)) {
+        generateCall(call);
+    } else {
+        throw std::runtime_error("pyc: unsupported expression");
+    }
+}
+
+void
+PycGenerator::generateBranch (Expression* cond, Label target, bool onTrue)
+{
+    // && || ! в условии - цепочка переходов без промежуточных значений
+    if (!hoisted.count(cond)) {
+        auto unary = dynamic_cast<UnaryExpr*>(cond);
+        if (unary && unary->op == "!") {
+            generateBranch(unary->expr.get(), target, !onTrue);
+            return;
+        }
+
+        auto binary = dynamic_cast<BinaryExpr*>(cond);
+        if (binary && (binary->op == "&&" || binary->op == "||")) {
+            bool isAnd = binary->op == "&&";
+            if (isAnd != onTrue) {
+                // a && b ложно, если ложно a; a || b истинно, если истинно a
+                generateBranch(binary->lhs.get(), target, onTrue);
+                generateBranch(binary->rhs.get(), target, onTrue);
+            } else {
+                Label skip = as->newLabel();
+                generateBranch(binary->lhs.get(), skip, !onTrue);
+                generateBranch(binary->rhs.get(), target, onTrue);
+                as->bind(skip);
+            }
+            return;
+        }
+    }
+
+    generateExpression(cond);
+    as->emitJump(onTrue ? BytecodeAssembler::IfTrue : BytecodeAssembler::IfFalse, target);
+}
+
+// ===== Операторы =====
+
+void
+PycGenerator::generateVarDecl (VarDecl* decl)
+{
+    if (decl->init) {
+        generateExpression(decl->init.get());
+    } else if (decl->type == "float" || decl->type == "double") {
+        loadConst(PyConst::makeFloat(0.0));
+    } else if (decl->type == "char") {
+        loadConst(PyConst::makeString(std::string(1, '\0')));
+    } else if (decl->type == "bool") {
+        loadConst(PyConst::makeBool(false));
+    } else {
+        loadConst(PyConst::makeInt(0));
+    }
+    storeName(decl->name);
+}
+
+void
+PycGenerator::generateEffect (Expression* expr)
+{
+    // Присваивание - оператор: значение на стеке не нужно
+    auto binary = dynamic_cast<BinaryExpr*>(expr);
+    if (binary && SemanticAnalyzer::isAssignmentOp(binary->op) && !hoisted.count(expr)) {
+        generateAssignment(binary, false);
+    } else if (isIncrement(expr) && !hoisted.count(expr)) {
+        generateIncrement(static_cast<UnaryExpr*>(expr), false);
+    } else {
+        generateExpression(expr);
+        as->emit(PyOp::POP_TOP);
+    }
+}
+
+void
+PycGenerator::generateIf (IfStmt* stmt)
+{
+    Label elseLabel = as->newLabel();
+    generateBranch(stmt->condition.get(), elseLabel, false);
+    generateStatement(stmt->thenBranch.get());
+
+    if (stmt->elseBranch) {
+        Label end = as->newLabel();
+        if (!as->endsBlock()) as->emitJump(BytecodeAssembler::Always, end);
+        as->bind(elseLabel);
+        generateStatement(stmt->elseBranch.get());
+        as->bind(end);
+    } else {
+        as->bind(elseLabel);
+    }
+}
+
+void
+PycGenerator::hoistInvariants (Statement* loop)
+{
+    if (!options.hoistLoopInvariants || !semanticAnalyzer) return;
+
+    const std::vector<Expression*>* invariants = semanticAnalyzer->getLoopInvariants(loop);
+    if (!invariants) return;
+
+    for (Expression* expr : *invariants) {
+        generateExpression(expr);
+        int local = as->addLocal("_c2py_inv" + std::to_string(hoistedCount++));
+        as->emit(PyOp::STORE_FAST, local);
+        hoisted[expr] = local;
+    }
+}
+
+void
+PycGenerator::generateWhile (WhileStmt* stmt)
+{
+    // Условие проверяется перед циклом и в конце каждой итерации:
+    // один переход назад вместо перехода к проверке и перехода из неё
+    hoistInvariants(stmt);
+    Label top = as->newLabel(), next = as->newLabel(), end = as->newLabel();
+    bool always = isConstantTrue(stmt->condition.get());
+
+    if (!always) generateBranch(stmt->condition.get(), end, false);
+    as->bind(top);
+    loopStack.push_back({ next, end, false });
+    generateStatement(stmt->body.get());
+    loopStack.pop_back();
+
+    as->bind(next);
+    setLine(stmt->condition.get());
+    if (always) {
+        as->emitJump(BytecodeAssembler::Always, top);
+    } else {
+        generateBranch(stmt->condition.get(), top, true);
+    }
+    as->bind(end);
+}
+
+void
+PycGenerator::generateDoWhile (DoWhileStmt* stmt)
+{
+    hoistInvariants(stmt);
+    Label top = as->newLabel(), next = as->newLabel(), end = as->newLabel();
+
+    as->bind(top);
+    loopStack.push_back({ next, end, false });
+    generateStatement(stmt->body.get());
+    loopStack.pop_back();
+
+    // continue в do-while переходит к проверке условия
+    as->bind(next);
+    setLine(stmt->condition.get());
+    generateBranch(stmt->condition.get(), top, true);
+    as->bind(end);
+}
+
+void
+PycGenerator::generateFor (ForStmt* stmt)
+{
+    const InductionVariable* iv = semanticAnalyzer
+        ? semanticAnalyzer->getInductionVariable(stmt) : nullptr;
+    if (iv) {
+        generateRangeFor(stmt, *iv);
+        return;
+    }
+
+    generateStatement(stmt->init.get());
+    hoistInvariants(stmt);
+
+    Expression* cond = stmt->condition.get();
+    bool always = !cond || isConstantTrue(cond);
+    Label top = as->newLabel(), next = as->newLabel(), end = as->newLabel();
+
+    if (!always) generateBranch(cond, end, false);
+    as->bind(top);
+    loopStack.push_back({ next, end, false });
+    generateStatement(stmt->body.get());
+    loopStack.pop_back();
+
+    // continue в for выполняет update
+    as->bind(next);
+    if (stmt->update) {
+        setLine(stmt->update.get());
+        generateEffect(stmt->update.get());
+    }
+    setLine(cond);
+    if (always) {
+        as->emitJump(BytecodeAssembler::Always, top);
+    } else {
+        generateBranch(cond, top, true);
+    }
+    as->bind(end);
+}
+
+void
+PycGenerator::generateRangeFor (ForStmt* stmt, const InductionVariable& iv)
+{
+    const std::string& varName = static_cast<const VarDecl*>(iv.var)->name;
+
+    // Как в тексте: если i читается после цикла, старт - текущее значение i,
+    // итоговое значение восстанавливается после полного прохода
+    if (iv.liveAfterLoop && stmt->init) {
+        generateStatement(stmt->init.get());
+    }
+    hoistInvariants(stmt);
+
+    as->emit(PyOp::LOAD_GLOBAL, (as->addName("range") << 1) | 1);
+    if (!iv.liveAfterLoop && iv.start) {
+        generateExpression(iv.start);
+    } else {
+        loadName(varName);
+    }
+    generateRangeStop(iv);
+    int argc = 2;
+    if (iv.step != 1) {
+        loadConst(PyConst::makeInt(iv.step));
+        ++argc;
+    }
+    as->emit(PyOp::PRECALL, argc);
+    as->emit(PyOp::CALL, argc);
+    as->emit(PyOp::GET_ITER);
+
+    Label top = as->newLabel(), exhausted = as->newLabel(), end = as->newLabel();
+    as->bind(top);
+    as->emitJump(BytecodeAssembler::ForIter, exhausted);
+    storeName(varName);
+
+    loopStack.push_back({ top, end, true });
+    generateStatement(stmt->body.get());
+    loopStack.pop_back();
+    as->emitJump(BytecodeAssembler::Always, top);
+
+    as->bind(exhausted);
+    if (iv.liveAfterLoop) {
+        // else: if i < stop: i = stop
+        Label skip = as->newLabel();
+        loadName(varName);
+        generateRangeStop(iv);
+        as->emit(PyOp::COMPARE_OP, iv.step > 0 ? CMP_LT : CMP_GT);
+        as->emitJump(BytecodeAssembler::IfFalse, skip);
+        generateRangeStop(iv);
+        storeName(varName);
+        as->bind(skip);
+    }
+    as->bind(end);
+}
+
+void
+PycGenerator::generateRangeStop (const InductionVariable& iv)
+{
+    generateExpression(iv.bound);
+    if (iv.inclusive) {
+        loadConst(PyConst::makeInt(1));
+        as->emit(PyOp::BINARY_OP, iv.step > 0 ? NB_ADD : NB_SUBTRACT);
+    }
+}
+
+void
+PycGenerator::generateReturn (ReturnStmt* stmt)
+{
+    if (tailCalls.count(stmt)) {
+        generateTailCall(static_cast<CallExpr*>(stmt->value.get()));
+        return;
+    }
+
+    if (stmt->value) {
+        generateExpression(stmt->value.get());
+    } else {
+        loadConst(PyConst());
+    }
+    // Итераторы range() объемлющих циклов лежат под значением
+    for (auto loop = loopStack.rbegin(); loop != loopStack.rend(); ++loop) {
+        if (!loop->hasIterator) continue;
+        as->emit(PyOp::SWAP, 2);
+        as->emit(PyOp::POP_TOP);
+    }
+    as->emit(PyOp::RETURN_VALUE);
+}
+
+void
+PycGenerator::generateTailCall (CallExpr* call)
+{
+    // Параметр, которому передаётся он сам, не перепривязывается
+    std::vector<size_t> rebound;
+    for (size_t i = 0; i < call->args.size(); ++i) {
+        auto id = dynamic_cast<IdentifierExpr*>(call->args[i].get());
+        if (!id || id->name != currentFunction->params[i].second) {
+            rebound.push_back(i);
+        }
+    }
+
+    // Все новые значения вычисляются до присваивания
+    for (size_t index : rebound) {
+        generateExpression(call->args[index].get());
+    }
+    for (auto index = rebound.rbegin(); index != rebound.rend(); ++index) {
+        storeName(currentFunction->params[*index].second);
+    }
+    as->emitJump(BytecodeAssembler::Always, functionStart);
+}
+
+bool
+PycGenerator::isSelfCall (const Expression* expr, const FunctionDecl* func) const
+{
+    auto call = dynamic_cast<const CallExpr*>(expr);
+    if (!call || call->name != func->name || call->args.size() != func->params.size()) {
+        return false;
+    }
+    return !semanticAnalyzer || semanticAnalyzer->getCallGraph().calleeOf(call) == func;
+}
+
+void
+PycGenerator::collectTailCalls (Statement* stmt, const FunctionDecl* func)
+{
+    // Вызовы внутри циклов не трогаем, как и в тексте
+    if (auto block = dynamic_cast<BlockStmt*>(stmt)) {
+        for (auto& s : block->statements) {
+            collectTailCalls(s.get(), func);
+        }
+    }
+    else if (auto ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+        collectTailCalls(ifStmt->thenBranch.get(), func);
+        collectTailCalls(ifStmt->elseBranch.get(), func);
+    }
+    else if (auto ret = dynamic_cast<ReturnStmt*>(stmt)) {
+        if (isSelfCall(ret->value.get(), func)) {
+            tailCalls.insert(ret);
+        }
+    }
+}
+
+void
+PycGenerator::generateBreak ()
+{
+    if (loopStack.empty()) {
+        throw std::runtime_error("pyc: break outside loop");
+    }
+    if (loopStack.back().hasIterator) as->emit(PyOp::POP_TOP);
+    as->emitJump(BytecodeAssembler::Always, loopStack.back().breakTarget);
+}
+
+void
+PycGenerator::generateContinue ()
+{
+    if (loopStack.empty()) {
+        throw std::runtime_error("pyc: continue outside loop");
+    }
+    as->emitJump(BytecodeAssembler::Always, loopStack.back().continueTarget);
+}
+
+void
+PycGenerator::generateStatement (Statement* stmt)
+{
+    if (!stmt) return;
+
+    // Переходы в конце вложенного оператора - снова строка этого
+    int outer = as->line();
+    setLine(stmt);
+
+    if (auto decl = dynamic_cast<VarDecl*>(stmt)) {
+        generateVarDecl(decl);
+    } else if (auto exprStmt = dynamic_cast<ExpressionStmt*>(stmt)) {
+        if (exprStmt->expr) generateEffect(exprStmt->expr.get());
+    } else if (auto block = dynamic_cast<BlockStmt*>(stmt)) {
+        for (auto& s : block->statements) {
+            generateStatement(s.get());
+        }
+    } else if (auto ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+        generateIf(ifStmt);
+    } else if (auto whileStmt = dynamic_cast<WhileStmt*>(stmt)) {
+        generateWhile(whileStmt);
+    } else if (auto doWhile = dynamic_cast<DoWhileStmt*>(stmt)) {
+        generateDoWhile(doWhile);
+    } else if (auto forStmt = dynamic_cast<ForStmt*>(stmt)) {
+        generateFor(forStmt);
+    } else if (auto ret = dynamic_cast<ReturnStmt*>(stmt)) {
+        generateReturn(ret);
+    } else if (dynamic_cast<BreakStmt*>(stmt)) {
+        generateBreak();
+    } else if (dynamic_cast<ContinueStmt*>(stmt)) {
+        generateContinue();
+    }
+    as->setLine(outer);
+}
+
+void
+PycGenerator::setLine (const ASTNode* node)
+{
+    // Узлы, созданные оптимизатором без позиции, относятся к внешнему оператору
+    if (node && node->line > 0) as->setLine(node->line);
+}
+
+// ===== Функции и модуль =====
+
+PyCode
+PycGenerator::generateFunction (FunctionDecl* func)
+{
+    BytecodeAssembler assembler(func->name, fileName, func->line > 0 ? func->line : 1);
+    as = &assembler;
+    currentFunction = func;
+    hoisted.clear();
+    hoistedCount = 0;
+    loopStack.clear();
+
+    as->setLine(func->line);
+    as->addConst(PyConst());            // co_consts[0]: docstring нет
+
+    // У main параметров нет (MainWithParameters): точка входа вызывает main()
+    int argCount = 0;
+    if (func->name != "main") {
+        for (auto& param : func->params) {
+            as->addLocal(param.second);
+        }
+        argCount = (int) func->params.size();
+    }
+    collectLocals(func->body.get());
+
+    tailCalls.clear();
+    if (options.convertTailCalls && func->body) {
+        collectTailCalls(func->body.get(), func);
+    }
+
+    as->emit(PyOp::RESUME, 0);
+    functionStart = as->newLabel();
+    as->bind(functionStart);
+    generateStatement(func->body.get());
+    if (!as->endsBlock()) {
+        loadConst(PyConst());
+        as->emit(PyOp::RETURN_VALUE);
+    }
+
+    PyCode code = as->assemble(argCount, CO_OPTIMIZED | CO_NEWLOCALS);
+    as = nullptr;
+    currentFunction = nullptr;
+    tailCalls.clear();
+    return code;
+}
+
+PyCode
+PycGenerator::generateModule (const Program* program)
+{
+    BytecodeAssembler module("<module>", fileName, 1);
+    module.emit(PyOp::RESUME, 0);
+
+    // Функции в порядке объявления, main - в конце, как в тексте
+    std::vector<FunctionDecl*> functions;
+    FunctionDecl* mainFunc = nullptr;
+    for (auto& func : program->functions) {
+        if (func->name != "main") {
+            functions.push_back(func.get());
+        } else if (!mainFunc) {
+            mainFunc = func.get();
+        }
+    }
+    if (mainFunc) {
+        functions.push_back(mainFunc);
+
+        // import sys
+        module.setLine(1);
+        module.emit(PyOp::LOAD_CONST, module.addConst(PyConst::makeInt(0)));
+        module.emit(PyOp::LOAD_CONST, module.addConst(PyConst()));
+        module.emit(PyOp::IMPORT_NAME, module.addName("sys"));
+        module.emit(PyOp::STORE_NAME, module.addName("sys"));
+    }
+
+    for (FunctionDecl* func : functions) {
+        auto code = std::make_shared<PyCode>(generateFunction(func));
+        module.setLine(func->line);
+        module.emit(PyOp::LOAD_CONST, module.addConst(PyConst::makeCode(code)));
+        module.emit(PyOp::MAKE_FUNCTION, 0);
+        module.emit(PyOp::STORE_NAME, module.addName(func->name));
+    }
+
+    if (mainFunc) {
+        // if __name__ == "__main__": sys.exit(main())
+        Label end = module.newLabel();
+        module.emit(PyOp::LOAD_NAME, module.addName("__name__"));
+        module.emit(PyOp::LOAD_CONST, module.addConst(PyConst::makeString("__main__")));
+        module.emit(PyOp::COMPARE_OP, CMP_EQ);
+        module.emitJump(BytecodeAssembler::IfFalse, end);
+        module.emit(PyOp::PUSH_NULL);
+        module.emit(PyOp::LOAD_NAME, module.addName("sys"));
+        module.emit(PyOp::LOAD_ATTR, module.addName("exit"));
+        module.emit(PyOp::PUSH_NULL);
+        module.emit(PyOp::LOAD_NAME, module.addName("main"));
+        module.emit(PyOp::PRECALL, 0);
+        module.emit(PyOp::CALL, 0);
+        module.emit(PyOp::PRECALL, 1);
+        module.emit(PyOp::CALL, 1);
+        module.emit(PyOp::POP_TOP);
+        module.bind(end);
+    }
+    module.emit(PyOp::LOAD_CONST, module.addConst(PyConst()));
+    module.emit(PyOp::RETURN_VALUE);
+    return module.assemble(0, 0);
+}
+
+std::string
+PycGenerator::generate (const Program* program, const std::string& fileName)
+{
+    C2PY_PHASE("pyc");
+    if (!program) return std::string();
+    this->fileName = fileName;
+
+    // Заголовок: магическое число, флаги 0 (проверка по времени изменения),
+    // время и размер исходника 0 - проверяется только при наличии .py
+    std::string result(pycMagic, sizeof(pycMagic));
+    result.append(12, '\0');
+
+    MarshalWriter writer;
+    writer.writeCode(generateModule(program));
+    result += writer.data();
+    return result;
+}
+
+void
+PycGenerator::generate (const Program* program, CodeSink& sink, const std::string& fileName)
+{
+    sink.append(generate(program, fileName));
+    sink.flush();
+}
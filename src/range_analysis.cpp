@@ -0,0 +1,368 @@
+#include "range_analysis.h"
+#include "semantic.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+
+ValueRange
+ValueRange::join (const ValueRange& other) const
+{
+    if (empty()) return other;
+    if (other.empty()) return *this;
+    return ValueRange(std::min(lo, other.lo), std::max(hi, other.hi));
+}
+
+namespace {
+
+// Сколько раз диапазон переменной может расшириться до перехода к полному int
+const int wideningLimit = 3;
+// Число шагов сужения после расширения
+const int narrowingRounds = 2;
+
+class RangeEvaluator {
+public:
+    RangeEvaluator(const SemanticAnalyzer& sema,
+                   std::unordered_map<const ASTNode*, ValueRange>& ranges)
+        : sema(sema), ranges(ranges) {}
+
+    // Сайты переполнения собираются только в последнем проходе
+    std::unordered_set<const Expression*>* overflowSites = nullptr;
+
+    // Выражения тел и update циклов с индуктивными переменными -> циклы,
+    // условия которых при вычислении выражения истинны (внешние - первыми)
+    std::unordered_map<const Expression*, std::vector<const ForStmt*>> guarded;
+
+    bool
+    isTracked (const ASTNode* node) const
+    {
+        const SemanticAnnotation* ann = sema.getAnnotationForNode(const_cast<ASTNode*>(node));
+        return ann && (ann->type.kind == TypeInfo::Int || ann->type.kind == TypeInfo::Char);
+    }
+
+    ValueRange
+    variable (const ASTNode* decl) const
+    {
+        auto it = ranges.find(decl);
+        return (it != ranges.end()) ? it->second : ValueRange::full();
+    }
+
+    ValueRange
+    expr (const Expression* e)
+    {
+        if (!e) return ValueRange::full();
+
+        // Тело и update выполняются только при истинном условии цикла
+        auto guard = guarded.find(e);
+        if (guard != guarded.end()) {
+            std::vector<const ForStmt*> loops = std::move(guard->second);
+            guarded.erase(guard);
+            std::vector<std::pair<const ASTNode*, ValueRange>> saved;
+            for (const ForStmt* loop : loops) {
+                const ASTNode* var = sema.getInductionVariable(loop)->var;
+                auto it = ranges.find(var);
+                if (it == ranges.end()) continue;
+                saved.emplace_back(var, it->second);
+                it->second = restrictByCondition(it->second, loop);
+            }
+            ValueRange result = expr(e);
+            for (auto it = saved.rbegin(); it != saved.rend(); ++it) {
+                ranges[it->first] = it->second;
+            }
+            guarded[e] = std::move(loops);
+            return result;
+        }
+
+        if (auto num = dynamic_cast<const NumberExpr*>(e)) {
+            const std::string& v = num->value;
+            if (v.empty() || v.find_first_not_of("0123456789") != std::string::npos) {
+                return ValueRange::full();
+            }
+            try {
+                long long value = std::stoll(v);
+                return ValueRange(value, value);
+            } catch (const std::exception&) {
+                return ValueRange::full();
+            }
+        }
+        if (auto id = dynamic_cast<const IdentifierExpr*>(e)) {
+            return variable(id->declaration);
+        }
+        if (auto unary = dynamic_cast<const UnaryExpr*>(e)) {
+            return unaryExpr(unary);
+        }
+        if (auto binary = dynamic_cast<const BinaryExpr*>(e)) {
+            return binaryExpr(binary);
+        }
+        if (auto call = dynamic_cast<const CallExpr*>(e)) {
+            for (auto& arg : call->args) expr(arg.get());
+        }
+        return ValueRange::full();
+    }
+
+    // Значение, записываемое определением переменной
+    ValueRange
+    definition (const ASTNode* site, bool isParam)
+    {
+        if (isParam) return ValueRange::full();
+        if (auto decl = dynamic_cast<const VarDecl*>(site)) {
+            return decl->init ? expr(decl->init.get()) : ValueRange(0, 0);
+        }
+        if (auto e = dynamic_cast<const Expression*>(site)) {
+            return expr(e);
+        }
+        return ValueRange::full();
+    }
+
+private:
+    const SemanticAnalyzer& sema;
+    std::unordered_map<const ASTNode*, ValueRange>& ranges;
+
+    // Результат целочисленной операции: вне int - переполнение, значение произвольное
+    ValueRange
+    checked (const Expression* site, const ValueRange& exact)
+    {
+        if (exact.fitsInt()) return exact;
+        if (overflowSites && isTracked(site)) overflowSites->insert(site);
+        return ValueRange::full();
+    }
+
+    static ValueRange
+    arith (const std::string& op, const ValueRange& a, const ValueRange& b)
+    {
+        if (a.empty() || b.empty()) return ValueRange();
+
+        if (op == "+") return ValueRange(a.lo + b.lo, a.hi + b.hi);
+        if (op == "-") return ValueRange(a.lo - b.hi, a.hi - b.lo);
+        if (op == "*") {
+            // Операнды в пределах int, произведение помещается в long long
+            long long c[] = { a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi };
+            return ValueRange(*std::min_element(c, c + 4), *std::max_element(c, c + 4));
+        }
+        if (op == "/") {
+            // |a / b| <= |a|; единственное переполнение - INT_MIN / -1
+            long long m = std::max(-a.lo, a.hi);
+            if (a.contains(INT_MIN) && b.contains(-1)) return ValueRange(-m, m);
+            return ValueRange(-std::min(m, (long long)INT_MAX), std::min(m, (long long)INT_MAX));
+        }
+        if (op == "%") {
+            long long m = std::max(-b.lo, b.hi);
+            if (m == 0) return ValueRange::full();
+            return ValueRange(std::max(-(m - 1), std::min(a.lo, 0LL)),
+                              std::min(m - 1, std::max(a.hi, 0LL)));
+        }
+        return ValueRange::full();
+    }
+
+    ValueRange
+    unaryExpr (const UnaryExpr* e)
+    {
+        if (e->op == "++" || e->op == "--") {
+            auto id = dynamic_cast<const IdentifierExpr*>(e->expr.get());
+            ValueRange current = id ? variable(id->declaration) : ValueRange::full();
+            return checked(e, arith(e->op == "++" ? "+" : "-", current, ValueRange(1, 1)));
+        }
+
+        ValueRange operand = expr(e->expr.get());
+        if (e->op == "!") return ValueRange(0, 1);
+        if (e->op == "-") return checked(e, arith("-", ValueRange(0, 0), operand));
+        return ValueRange::full();
+    }
+
+    ValueRange
+    binaryExpr (const BinaryExpr* e)
+    {
+        const std::string& op = e->op;
+        ValueRange rhs = expr(e->rhs.get());
+
+        if (SemanticAnalyzer::isAssignmentOp(op)) {
+            if (op == "=") return rhs;
+
+            auto id = dynamic_cast<const IdentifierExpr*>(e->lhs.get());
+            ValueRange current = id ? variable(id->declaration) : ValueRange::full();
+            return checked(e, arith(op.substr(0, 1), current, rhs));
+        }
+
+        ValueRange lhs = expr(e->lhs.get());
+        if (op == "+" || op == "-" || op == "*" || op == "/" || op == "%") {
+            return checked(e, arith(op, lhs, rhs));
+        }
+        // Сравнения и логические операции
+        return ValueRange(0, 1);
+    }
+
+    // Значения i, при которых выполняются тело и update: условие цикла истинно
+    ValueRange
+    restrictByCondition (ValueRange current, const ForStmt* loop)
+    {
+        const InductionVariable* iv = sema.getInductionVariable(loop);
+        if (!iv || current.empty()) return current;
+
+        ValueRange bound = expr(iv->bound);
+        if (bound.empty()) return ValueRange();
+        if (iv->step > 0) {
+            current.hi = std::min(current.hi, iv->inclusive ? bound.hi : bound.hi - 1);
+        } else {
+            current.lo = std::max(current.lo, iv->inclusive ? bound.lo : bound.lo + 1);
+        }
+        return current;
+    }
+};
+
+// Все выражения функции - для последнего прохода, собирающего сайты переполнения
+void
+visitStatement (const Statement* stmt, RangeEvaluator& eval)
+{
+    if (!stmt) return;
+
+    if (auto varDecl = dynamic_cast<const VarDecl*>(stmt)) {
+        eval.expr(varDecl->init.get());
+    }
+    else if (auto block = dynamic_cast<const BlockStmt*>(stmt)) {
+        for (auto& s : block->statements) visitStatement(s.get(), eval);
+    }
+    else if (auto ifStmt = dynamic_cast<const IfStmt*>(stmt)) {
+        eval.expr(ifStmt->condition.get());
+        visitStatement(ifStmt->thenBranch.get(), eval);
+        visitStatement(ifStmt->elseBranch.get(), eval);
+    }
+    else if (auto whileStmt = dynamic_cast<const WhileStmt*>(stmt)) {
+        eval.expr(whileStmt->condition.get());
+        visitStatement(whileStmt->body.get(), eval);
+    }
+    else if (auto doWhileStmt = dynamic_cast<const DoWhileStmt*>(stmt)) {
+        visitStatement(doWhileStmt->body.get(), eval);
+        eval.expr(doWhileStmt->condition.get());
+    }
+    else if (auto forStmt = dynamic_cast<const ForStmt*>(stmt)) {
+        visitStatement(forStmt->init.get(), eval);
+        if (forStmt->condition) eval.expr(forStmt->condition.get());
+        if (forStmt->update) eval.expr(forStmt->update.get());
+        visitStatement(forStmt->body.get(), eval);
+    }
+    else if (auto returnStmt = dynamic_cast<const ReturnStmt*>(stmt)) {
+        if (returnStmt->value) eval.expr(returnStmt->value.get());
+    }
+    else if (auto exprStmt = dynamic_cast<const ExpressionStmt*>(stmt)) {
+        eval.expr(exprStmt->expr.get());
+    }
+}
+
+// Корневые выражения под условиями циклов loops (определения переменных -
+// такие же корни: присваивание, инициализатор, ++ выражения-оператора)
+void
+collectGuarded (const Statement* stmt, const SemanticAnalyzer& sema, RangeEvaluator& eval,
+                std::vector<const ForStmt*>& loops)
+{
+    if (!stmt) return;
+
+    auto guard = [&](const Expression* e) {
+        if (e && !loops.empty()) eval.guarded[e] = loops;
+    };
+    if (auto varDecl = dynamic_cast<const VarDecl*>(stmt)) {
+        guard(varDecl->init.get());
+    }
+    else if (auto block = dynamic_cast<const BlockStmt*>(stmt)) {
+        for (auto& s : block->statements) collectGuarded(s.get(), sema, eval, loops);
+    }
+    else if (auto ifStmt = dynamic_cast<const IfStmt*>(stmt)) {
+        guard(ifStmt->condition.get());
+        collectGuarded(ifStmt->thenBranch.get(), sema, eval, loops);
+        collectGuarded(ifStmt->elseBranch.get(), sema, eval, loops);
+    }
+    else if (auto whileStmt = dynamic_cast<const WhileStmt*>(stmt)) {
+        guard(whileStmt->condition.get());
+        collectGuarded(whileStmt->body.get(), sema, eval, loops);
+    }
+    else if (auto doWhileStmt = dynamic_cast<const DoWhileStmt*>(stmt)) {
+        collectGuarded(doWhileStmt->body.get(), sema, eval, loops);
+        guard(doWhileStmt->condition.get());
+    }
+    else if (auto forStmt = dynamic_cast<const ForStmt*>(stmt)) {
+        collectGuarded(forStmt->init.get(), sema, eval, loops);
+        guard(forStmt->condition.get());
+        // i не записывается в теле, Y в цикле не меняется: условие, истинное
+        // в начале итерации, верно во всём теле
+        bool induction = sema.getInductionVariable(forStmt) != nullptr;
+        if (induction) loops.push_back(forStmt);
+        guard(forStmt->update.get());
+        collectGuarded(forStmt->body.get(), sema, eval, loops);
+        if (induction) loops.pop_back();
+    }
+    else if (auto returnStmt = dynamic_cast<const ReturnStmt*>(stmt)) {
+        guard(returnStmt->value.get());
+    }
+    else if (auto exprStmt = dynamic_cast<const ExpressionStmt*>(stmt)) {
+        guard(exprStmt->expr.get());
+    }
+}
+
+} // namespace
+
+void
+RangeAnalysis::analyzeFunction (FunctionDecl* func, const FunctionDataflow& df,
+                                const std::vector<const ASTNode*>& params,
+                                const SemanticAnalyzer& sema,
+                                std::unordered_map<const ASTNode*, ValueRange>& ranges,
+                                std::unordered_set<const Expression*>& overflowSites)
+{
+    RangeEvaluator eval(sema, ranges);
+    std::vector<const ForStmt*> loops;
+    collectGuarded(func->body.get(), sema, eval, loops);
+
+    // Отслеживаем только целочисленные переменные; изначально диапазоны пусты
+    for (const ASTNode* var : df.variables) {
+        if (eval.isTracked(var)) ranges[var] = ValueRange();
+    }
+    std::unordered_set<const ASTNode*> paramSet(params.begin(), params.end());
+    auto valueOf = [&](const Definition& d) {
+        bool isParam = d.site == d.var && paramSet.count(d.var);
+        return eval.definition(d.site, isParam);
+    };
+
+    // Восходящие итерации с расширением: растущая граница сразу уходит
+    // к границе int, вторая граница сохраняется
+    std::unordered_map<const ASTNode*, int> widenings;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const Definition& d : df.definitions) {
+            auto it = ranges.find(d.var);
+            if (it == ranges.end()) continue;
+
+            ValueRange old = it->second;
+            ValueRange joined = old.join(valueOf(d));
+            if (joined == old) continue;
+
+            if (!old.empty() && ++widenings[d.var] > wideningLimit) {
+                if (joined.lo < old.lo) joined.lo = INT_MIN;
+                if (joined.hi > old.hi) joined.hi = INT_MAX;
+            }
+            it->second = joined;
+            changed = true;
+        }
+    }
+
+    // Сужение: пересчитываем диапазоны по определениям, не объединяя с прежними.
+    // Каждый шаг от неподвижной точки остаётся корректным и возвращает
+    // границы, потерянные при расширении (например, i < n для счётчика цикла)
+    for (int round = 0; round < narrowingRounds; ++round) {
+        std::unordered_map<const ASTNode*, ValueRange> narrowed;
+        for (const Definition& d : df.definitions) {
+            if (!ranges.count(d.var)) continue;
+            narrowed[d.var] = narrowed[d.var].join(valueOf(d));
+        }
+        for (auto& [var, range] : narrowed) ranges[var] = range;
+    }
+
+    // Значения, которые не определены ни одним определением (невозможно в корректной
+    // программе), считаем произвольными
+    for (const ASTNode* var : df.variables) {
+        auto it = ranges.find(var);
+        if (it != ranges.end() && it->second.empty()) it->second = ValueRange::full();
+    }
+
+    eval.overflowSites = &overflowSites;
+    visitStatement(func->body.get(), eval);
+}
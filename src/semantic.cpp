@@ -1,6 +1,6 @@
 #include "semantic.h"
+#include "instrument.h"
 
-#include <sstream>
 #include <cctype>
 #include <algorithm>
 
@@ -10,21 +10,45 @@ SemanticAnalyzer::SemanticAnalyzer (SymbolTable& symTab)
 {}
 
 void
-SemanticAnalyzer::error (const std::string& msg, ASTNode* node)
+SemanticAnalyzer::report (DiagCode code, ASTNode* node, std::initializer_list<std::string_view> args)
 {
-    std::ostringstream oss;
-    oss << "Semantic error at line " << node->line << ":" << node->column 
-        << " - " << msg;
-    errors.push_back(oss.str());
+    diagnostics.report(code, node, args);
+    diagnosticsFormatted = false;
 }
 
 void
-SemanticAnalyzer::warning (const std::string& msg, ASTNode* node)
+SemanticAnalyzer::formatDiagnostics () const
 {
-    std::ostringstream oss;
-    oss << "Warning at line " << node->line << ":" << node->column 
-        << " - " << msg;
-    warnings.push_back(oss.str());
+    if (diagnosticsFormatted) return;
+
+    errors.clear();
+    warnings.clear();
+    for (const Diagnostic& diag : diagnostics.all()) {
+        std::vector<std::string>& target = (diag.severity == Severity::Error) ? errors : warnings;
+        target.push_back(diagnostics.format(diag));
+    }
+    diagnosticsFormatted = true;
+}
+
+const std::vector<std::string>&
+SemanticAnalyzer::getErrors () const
+{
+    formatDiagnostics();
+    return errors;
+}
+
+const std::vector<std::string>&
+SemanticAnalyzer::getWarnings () const
+{
+    formatDiagnostics();
+    return warnings;
+}
+
+bool
+SemanticAnalyzer::isAssignmentOp (const std::string& op)
+{
+    return op == "=" || op == "+=" || op == "-=" || op == "*="
+        || op == "/=" || op == "%=";
 }
 
 TypeInfo
@@ -42,7 +66,9 @@ SemanticAnalyzer::typeFromString (const std::string& typeStr)
 SemanticAnnotation&
 SemanticAnalyzer::annotate (ASTNode* node)
 {
-    return annotations[node];
+    auto [it, inserted] = annotations.try_emplace(node);
+    if (inserted && currentRecord) currentRecord->nodes.push_back(node);
+    return it->second;
 }
 
 SemanticAnnotation*
@@ -59,30 +85,307 @@ SemanticAnalyzer::getAnnotationForNode (ASTNode* node) const
     return (it != annotations.end()) ? &it->second : nullptr;
 }
 
+const FunctionDataflow*
+SemanticAnalyzer::getDataflow (const FunctionDecl* func) const
+{
+    auto it = dataflow.find(func);
+    return (it != dataflow.end()) ? &it->second : nullptr;
+}
+
+const InductionVariable*
+SemanticAnalyzer::getInductionVariable (const ForStmt* loop) const
+{
+    auto it = inductionVars.find(loop);
+    return (it != inductionVars.end()) ? &it->second : nullptr;
+}
+
+const std::vector<Expression*>*
+SemanticAnalyzer::getLoopInvariants (const Statement* loop) const
+{
+    auto it = loopInvariants.find(loop);
+    return (it != loopInvariants.end()) ? &it->second : nullptr;
+}
+
+const ValueRange*
+SemanticAnalyzer::getValueRange (const ASTNode* var) const
+{
+    auto it = valueRanges.find(var);
+    return (it != valueRanges.end()) ? &it->second : nullptr;
+}
+
 // Основной метод анализа
 bool
 SemanticAnalyzer::analyze(ProgramPtr& program)
 {
-    errors.clear();
-    warnings.clear();
+    C2PY_PHASE("semantic");
+    diagnostics.clear();
+    diagnosticsFormatted = false;
     annotations.clear();
-    
+    dataflow.clear();
+    inductionVars.clear();
+    loopInvariants.clear();
+    callGraph.clear();
+    valueRanges.clear();
+    overflowSites.clear();
+    records.clear();
+    reusedFunctions.clear();
+    currentRecord = nullptr;
+    
+    // Таблица символов переживает анализ (Translator): области, открытые
+    // до исключения, закрываются
+    size_t depth = symbolTable.depth();
     try {
         analyzeProgram(program.get());
+    } catch (const AnalysisInterrupted&) {
+        // Следующий reanalyze() - полный анализ
+        while (symbolTable.depth() > depth) symbolTable.popScope();
+        analyzedProgram = nullptr;
+        throw;
     } catch (const std::exception& e) {
-        error(std::string("Fatal: ") + e.what(), program.get());
+        report(DiagCode::Fatal, program.get(), { e.what() });
     }
+    while (symbolTable.depth() > depth) symbolTable.popScope();
     
-    return errors.empty();
+    analyzedProgram = program.get();
+    return diagnostics.errorCount() == 0;
+}
+
+std::string
+SemanticAnalyzer::signatureOf (const FunctionDecl* func)
+{
+    std::string signature = func->returnType + "(";
+    for (size_t i = 0; i < func->params.size(); ++i) {
+        if (i > 0) signature += ",";
+        signature += func->params[i].first;
+    }
+    return signature + ")";
+}
+
+namespace {
+
+// Сдвинуть номера строк поддерева (функция переехала в исходном тексте)
+void
+shiftLines (ASTNode* node, int delta)
+{
+    if (!node) return;
+    node->line += delta;
+
+    if (auto func = dynamic_cast<FunctionDecl*>(node)) {
+        shiftLines(func->body.get(), delta);
+    }
+    else if (auto block = dynamic_cast<BlockStmt*>(node)) {
+        for (auto& s : block->statements) shiftLines(s.get(), delta);
+    }
+    else if (auto varDecl = dynamic_cast<VarDecl*>(node)) {
+        shiftLines(varDecl->init.get(), delta);
+    }
+    else if (auto exprStmt = dynamic_cast<ExpressionStmt*>(node)) {
+        shiftLines(exprStmt->expr.get(), delta);
+    }
+    else if (auto ifStmt = dynamic_cast<IfStmt*>(node)) {
+        shiftLines(ifStmt->condition.get(), delta);
+        shiftLines(ifStmt->thenBranch.get(), delta);
+        shiftLines(ifStmt->elseBranch.get(), delta);
+    }
+    else if (auto whileStmt = dynamic_cast<WhileStmt*>(node)) {
+        shiftLines(whileStmt->condition.get(), delta);
+        shiftLines(whileStmt->body.get(), delta);
+    }
+    else if (auto doWhileStmt = dynamic_cast<DoWhileStmt*>(node)) {
+        shiftLines(doWhileStmt->body.get(), delta);
+        shiftLines(doWhileStmt->condition.get(), delta);
+    }
+    else if (auto forStmt = dynamic_cast<ForStmt*>(node)) {
+        shiftLines(forStmt->init.get(), delta);
+        shiftLines(forStmt->condition.get(), delta);
+        shiftLines(forStmt->update.get(), delta);
+        shiftLines(forStmt->body.get(), delta);
+    }
+    else if (auto returnStmt = dynamic_cast<ReturnStmt*>(node)) {
+        shiftLines(returnStmt->value.get(), delta);
+    }
+    else if (auto unary = dynamic_cast<UnaryExpr*>(node)) {
+        shiftLines(unary->expr.get(), delta);
+    }
+    else if (auto binary = dynamic_cast<BinaryExpr*>(node)) {
+        shiftLines(binary->lhs.get(), delta);
+        shiftLines(binary->rhs.get(), delta);
+    }
+    else if (auto call = dynamic_cast<CallExpr*>(node)) {
+        for (auto& arg : call->args) shiftLines(arg.get(), delta);
+    }
+}
+
+} // namespace
+
+bool
+SemanticAnalyzer::reanalyze (ProgramPtr& previous, ProgramPtr& program)
+{
+    if (!previous || !program || previous.get() != analyzedProgram) {
+        return analyze(program);
+    }
+
+    // Функции прошлой программы по имени; повторяющиеся имена не переиспользуем
+    std::unordered_map<std::string, std::unique_ptr<FunctionDecl>*> oldByName;
+    std::unordered_set<std::string> duplicates;
+    for (auto& func : previous->functions) {
+        if (!oldByName.emplace(func->name, &func).second) duplicates.insert(func->name);
+    }
+
+    // Сигнатуры новой программы: от них зависят тела вызывающих функций
+    std::unordered_map<std::string, std::string> signatures;
+    for (auto& func : program->functions) {
+        signatures[func->name] = signatureOf(func.get());
+    }
+
+    reusedFunctions.clear();
+    for (auto& slot : program->functions) {
+        auto old = oldByName.find(slot->name);
+        if (slot->tokenHash == 0 || old == oldByName.end() || duplicates.count(slot->name)) continue;
+
+        FunctionDecl* oldFunc = old->second->get();
+        auto record = records.find(oldFunc);
+        if (record == records.end() || oldFunc->tokenHash != slot->tokenHash) continue;
+
+        bool dependenciesMatch = true;
+        for (const auto& [name, signature] : record->second.dependencies) {
+            auto it = signatures.find(name);
+            if ((it != signatures.end() ? it->second : std::string()) != signature) {
+                dependenciesMatch = false;
+                break;
+            }
+        }
+        if (!dependenciesMatch) continue;
+
+        // Переносим проанализированное поддерево; новый разбор уходит в previous
+        int delta = slot->line - oldFunc->line;
+        if (delta != 0) {
+            shiftLines(oldFunc, delta);
+            for (auto& param : record->second.params) param->line += delta;
+        }
+        record->second.lineDelta = delta;
+        std::swap(slot, *old->second);
+        reusedFunctions.insert(oldFunc);
+    }
+
+    // Результаты остальных функций устарели
+    for (auto it = records.begin(); it != records.end(); ) {
+        if (reusedFunctions.count(it->first)) {
+            ++it;
+            continue;
+        }
+        discardFunction(it->first, it->second);
+        it = records.erase(it);
+    }
+    for (auto& func : previous->functions) {
+        annotations.erase(func.get());
+    }
+
+    previousDiagnostics = diagnostics;
+    diagnostics.clear();
+    diagnosticsFormatted = false;
+    callGraph.clear();
+    currentRecord = nullptr;
+
+    size_t depth = symbolTable.depth();
+    try {
+        analyzeProgram(program.get());
+    } catch (const AnalysisInterrupted&) {
+        // Следующий reanalyze() - полный анализ
+        while (symbolTable.depth() > depth) symbolTable.popScope();
+        analyzedProgram = nullptr;
+        throw;
+    } catch (const std::exception& e) {
+        report(DiagCode::Fatal, program.get(), { e.what() });
+    }
+    while (symbolTable.depth() > depth) symbolTable.popScope();
+
+    previousDiagnostics.clear();
+    analyzedProgram = program.get();
+    return diagnostics.errorCount() == 0;
+}
+
+void
+SemanticAnalyzer::discardFunction (const FunctionDecl* func, FunctionRecord& record)
+{
+    for (ASTNode* node : record.nodes) {
+        annotations.erase(node);
+        valueRanges.erase(node);
+        if (auto expr = dynamic_cast<Expression*>(node)) overflowSites.erase(expr);
+        if (auto loop = dynamic_cast<ForStmt*>(node)) inductionVars.erase(loop);
+        if (auto stmt = dynamic_cast<Statement*>(node)) loopInvariants.erase(stmt);
+    }
+    for (auto& param : record.params) {
+        annotations.erase(param.get());
+        valueRanges.erase(param.get());
+    }
+    annotations.erase(const_cast<FunctionDecl*>(func));
+    dataflow.erase(func);
+}
+
+void
+SemanticAnalyzer::restoreFunction (FunctionDecl* func)
+{
+    FunctionRecord& record = records[func];
+
+    // Вызываемые функции могли быть разобраны заново - связываем рёбра по имени
+    for (const CallExpr* call : record.calls) {
+        auto callee = dynamic_cast<FunctionDecl*>(symbolTable.lookup(call->name));
+        if (callee) callGraph.addCall(func, call, callee);
+        else callGraph.addUnknownCall(func, call);
+    }
+    callGraph.setLocalEffects(func, dataflow[func]);
+
+    const std::vector<Diagnostic>& old = previousDiagnostics.all();
+    size_t begin = diagnostics.all().size();
+    for (size_t i = record.diagBegin; i < record.diagEnd && i < old.size(); ++i) {
+        diagnostics.append(previousDiagnostics, old[i], record.lineDelta);
+    }
+    record.diagBegin = begin;
+    record.diagEnd = diagnostics.all().size();
+    record.lineDelta = 0;
+}
+
+std::vector<bool>
+SemanticAnalyzer::calleeEffects (const FunctionRecord& record) const
+{
+    std::vector<bool> effects;
+    effects.reserve(record.calls.size());
+    for (const CallExpr* call : record.calls) {
+        const FunctionSummary* callee = callGraph.summary(callGraph.calleeOf(call));
+        effects.push_back(!callee || !callee->pure || !callee->terminates);
+    }
+    return effects;
+}
+
+void
+SemanticAnalyzer::noteDependency (const std::string& name, ASTNode* decl)
+{
+    if (!currentRecord) return;
+
+    auto func = dynamic_cast<FunctionDecl*>(decl);
+    if (decl && !func) return;  // Локальное имя - часть самой функции
+    currentRecord->dependencies[name] = func ? signatureOf(func) : std::string();
 }
 
 void
 SemanticAnalyzer::analyzeProgram (Program* program)
 {
+    // Функции объявляются в собственной области, которая закрывается после
+    // анализа: таблица символов не хранит указатели на узлы прошлых программ
+    symbolTable.pushScope();
+    
     // Первый проход: объявляем все функции
 
     for (auto& func : program->functions) {
 
+        // Регистрируем функцию в таблице символов
+        symbolTable.declare(func->name, func.get());
+        callGraph.addFunction(func.get());
+        
+        // Аннотация переиспользуемой функции уже построена
+        if (reusedFunctions.count(func.get())) continue;
+        
         // Создаем аннотацию для функции
         SemanticAnnotation& ann = annotate(func.get());
         ann.returnType = typeFromString(func->returnType);
@@ -92,18 +395,42 @@ SemanticAnalyzer::analyzeProgram (Program* program)
         for (const auto& param : func->params) {
             ann.paramTypes.push_back(typeFromString(param.first));
         }
-        
-        // Регистрируем функцию в таблице символов
-        symbolTable.declare(func->name, func.get());
     }
     
     // Второй проход: анализируем тела функций
 
     for (auto& func : program->functions) {
+        checkInterrupt();
 
-        analyzeFunction(func.get());
+        if (reusedFunctions.count(func.get())) {
+            restoreFunction(func.get());
+        } else {
+            analyzeFunction(func.get());
+        }
+    }
+    
+    // Третий проход: сводки функций известны только после анализа всех тел
+    callGraph.finalize();
+    C2PY_COUNT(CallSites, callGraph.stats().callSites);
+    C2PY_COUNT(CallGraphMicros, callGraph.stats().buildMicros);
+    for (auto& func : program->functions) {
+        if (!func->body) continue;
+        checkInterrupt();
+        
+        // Аннотации переиспользуемой функции меняются, только если изменились
+        // сводки вызываемых ею функций
+        FunctionRecord& record = records[func.get()];
+        std::vector<bool> effects = calleeEffects(record);
+        if (reusedFunctions.count(func.get()) && effects == record.callEffects) continue;
+        
+        refineCallEffects(func->body.get());
+        record.callEffects = std::move(effects);
+        
+        // Выносить можно только выражения без эффектов - нужны уточнённые аннотации
+        LoopInvariantAnalysis::analyzeFunction(func.get(), dataflow[func.get()], *this, loopInvariants);
     }
 
+    symbolTable.popScope();
 }
 
 void
@@ -111,12 +438,21 @@ SemanticAnalyzer::analyzeFunction (FunctionDecl* func)
 {
 
     
-    // Очищаем старые параметры
-    parameterDecls.clear();
-    
     // Устанавливаем контекст
     inFunction = true;
     currentFunctionName = func->name;
+    currentFunction = func;
+    
+    FunctionRecord& record = records[func];
+    record = FunctionRecord();
+    record.tokenHash = func->tokenHash;
+    record.diagBegin = diagnostics.all().size();
+    currentRecord = &record;
+
+    // Точка входа вызывает main() без аргументов: argc и argv не передать
+    if (func->name == "main" && !func->params.empty()) {
+        report(DiagCode::MainWithParameters, func);
+    }
     
     SemanticAnnotation* funcAnn = getAnnotation(func);
     if (funcAnn) {
@@ -142,8 +478,8 @@ SemanticAnalyzer::analyzeFunction (FunctionDecl* func)
         ann.isLValue = true;
         
         // Объявляем в таблице символов, используя адрес из хранилища
-        parameterDecls.push_back(std::move(paramDecl));
-        symbolTable.declare(param.second, parameterDecls.back().get());
+        record.params.push_back(std::move(paramDecl));
+        symbolTable.declare(param.second, record.params.back().get());
     }
     
     // Анализируем тело функции
@@ -155,12 +491,25 @@ SemanticAnalyzer::analyzeFunction (FunctionDecl* func)
     
     // Проверяем, что не-void функция возвращает значение
     if (currentReturnType != TypeInfo::Void && !funcAnn->returnsValue) {
-        warning("Function '" + func->name + "' may not return a value", func);
+        report(DiagCode::MissingReturn, func, { func->name });
     }
     
+    // Строим потоки данных по уже разрешённым объявлениям
+    std::vector<const ASTNode*> params;
+    for (auto& param : record.params) {
+        params.push_back(param.get());
+    }
+    dataflow[func] = FunctionDataflow::analyze(func, params);
+    InductionAnalysis::analyzeFunction(func, dataflow[func], *this, inductionVars);
+    RangeAnalysis::analyzeFunction(func, dataflow[func], params, *this, valueRanges, overflowSites);
+    callGraph.setLocalEffects(func, dataflow[func]);
+    record.diagEnd = diagnostics.all().size();
+    
     symbolTable.popScope();
     inFunction = false;
     currentFunctionName.clear();
+    currentFunction = nullptr;
+    currentRecord = nullptr;
 }
 
 void
@@ -223,7 +572,7 @@ void SemanticAnalyzer::analyzeStatement(Statement* stmt) {
     else {
         // Это должно быть невозможно, если парсер корректен
 
-        error("Unknown statement type", stmt);
+        report(DiagCode::UnknownStatement, stmt);
     }
 
 }
@@ -308,9 +657,14 @@ SemanticAnalyzer::analyzeIdentifier (IdentifierExpr* expr)
 
     // Ищем в таблице символов
     ASTNode* decl = symbolTable.lookup(expr->name);
+    noteDependency(expr->name, decl);
+    if (currentRecord && dynamic_cast<FunctionDecl*>(decl)) {
+        // declaration указывал бы на узел старой программы - такую функцию не переиспользуем
+        currentRecord->dependencies[expr->name] = "?";
+    }
 
     if (!decl) {
-        error("Undeclared identifier: '" + expr->name + "'", expr);
+        report(DiagCode::UndeclaredIdentifier, expr, { expr->name });
         return TypeInfo(TypeInfo::Error);
     }
     
@@ -322,6 +676,11 @@ SemanticAnalyzer::analyzeIdentifier (IdentifierExpr* expr)
     ann.isLValue = true;
     ann.resolvedDecl = decl;
     
+    // Чтение переменной (не цель простого присваивания) - отмечаем использование
+    if (!inAssignmentTarget) {
+        annotate(decl).isUsed = true;
+    }
+    
     // Получаем тип из объявления
 
     if (auto varDecl = dynamic_cast<VarDecl*>(decl)) {
@@ -369,13 +728,18 @@ SemanticAnalyzer::analyzeCall (CallExpr* expr)
 {
     // Ищем функцию в таблице символов
     ASTNode* decl = symbolTable.lookup(expr->name);
+    noteDependency(expr->name, decl);
+    if (currentRecord) currentRecord->calls.push_back(expr);
     if (!decl) {
-        error("Undefined function: '" + expr->name + "'", expr);
+        report(DiagCode::UndefinedFunction, expr, { expr->name });
+        if (currentFunction) callGraph.addUnknownCall(currentFunction, expr);
         return TypeInfo(TypeInfo::Error);
     }
     
     // Проверяем, что это функция
     if (auto funcDecl = dynamic_cast<FunctionDecl*>(decl)) {
+        if (currentFunction) callGraph.addCall(currentFunction, expr, funcDecl);
+        
         // Анализируем аргументы
         for (auto& arg : expr->args) {
             analyzeExpression(arg.get());
@@ -397,13 +761,82 @@ SemanticAnalyzer::analyzeCall (CallExpr* expr)
         }
         
         ann.type = retType;
+        ann.hasSideEffects = true; // Уточняется по графу вызовов в refineCallEffects
         return retType;
     }
     
-    error("'" + expr->name + "' is not a function", expr);
+    if (currentFunction) callGraph.addUnknownCall(currentFunction, expr);
+    report(DiagCode::NotAFunction, expr, { expr->name });
     return TypeInfo(TypeInfo::Error);
 }
 
+void
+SemanticAnalyzer::refineCallEffects (Statement* stmt)
+{
+    if (!stmt) return;
+
+    if (auto varDecl = dynamic_cast<VarDecl*>(stmt)) {
+        if (varDecl->init) refineCallEffects(varDecl->init.get());
+    }
+    else if (auto block = dynamic_cast<BlockStmt*>(stmt)) {
+        for (auto& s : block->statements) refineCallEffects(s.get());
+    }
+    else if (auto ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+        refineCallEffects(ifStmt->condition.get());
+        refineCallEffects(ifStmt->thenBranch.get());
+        refineCallEffects(ifStmt->elseBranch.get());
+    }
+    else if (auto whileStmt = dynamic_cast<WhileStmt*>(stmt)) {
+        refineCallEffects(whileStmt->condition.get());
+        refineCallEffects(whileStmt->body.get());
+    }
+    else if (auto doWhileStmt = dynamic_cast<DoWhileStmt*>(stmt)) {
+        refineCallEffects(doWhileStmt->body.get());
+        refineCallEffects(doWhileStmt->condition.get());
+    }
+    else if (auto forStmt = dynamic_cast<ForStmt*>(stmt)) {
+        refineCallEffects(forStmt->init.get());
+        refineCallEffects(forStmt->condition.get());
+        refineCallEffects(forStmt->body.get());
+        // update всегда считается выражением с эффектами (см. analyzeFor)
+    }
+    else if (auto returnStmt = dynamic_cast<ReturnStmt*>(stmt)) {
+        refineCallEffects(returnStmt->value.get());
+    }
+    else if (auto exprStmt = dynamic_cast<ExpressionStmt*>(stmt)) {
+        refineCallEffects(exprStmt->expr.get());
+    }
+}
+
+bool
+SemanticAnalyzer::refineCallEffects (Expression* expr)
+{
+    if (!expr) return false;
+    SemanticAnnotation* ann = getAnnotation(expr);
+    if (!ann) return true;
+
+    // Правила те же, что при первом проходе, но для вызова
+    // теперь известно, что делает вызываемая функция
+    if (auto call = dynamic_cast<CallExpr*>(expr)) {
+        bool effects = false;
+        for (auto& arg : call->args) {
+            effects = refineCallEffects(arg.get()) || effects;
+        }
+        const FunctionSummary* callee = callGraph.summary(callGraph.calleeOf(call));
+        ann->hasSideEffects = effects || !callee || !callee->pure || !callee->terminates;
+    }
+    else if (auto binary = dynamic_cast<BinaryExpr*>(expr)) {
+        bool lhs = refineCallEffects(binary->lhs.get());
+        bool rhs = refineCallEffects(binary->rhs.get());
+        ann->hasSideEffects = isAssignmentOp(binary->op) || lhs || rhs;
+    }
+    else if (auto unary = dynamic_cast<UnaryExpr*>(expr)) {
+        bool operand = refineCallEffects(unary->expr.get());
+        ann->hasSideEffects = unary->op == "++" || unary->op == "--" || operand;
+    }
+    return ann->hasSideEffects;
+}
+
 void
 SemanticAnalyzer::analyzeIf (IfStmt* stmt)
 {
@@ -412,7 +845,7 @@ SemanticAnalyzer::analyzeIf (IfStmt* stmt)
     
     // Проверяем, что условие - boolean
     if (condType.kind != TypeInfo::Bool && condType.kind != TypeInfo::Unknown) {
-        error("Condition must be boolean", stmt->condition.get());
+        report(DiagCode::IfConditionNotBool, stmt->condition.get());
     }
     
     // Аннотируем условие
@@ -444,7 +877,7 @@ SemanticAnalyzer::analyzeWhile (WhileStmt* stmt)
     TypeInfo condType = analyzeExpression(stmt->condition.get());
     
     if (condType.kind != TypeInfo::Bool && condType.kind != TypeInfo::Unknown) {
-        error("While condition must be boolean", stmt->condition.get());
+        report(DiagCode::WhileConditionNotBool, stmt->condition.get());
     }
     
     // Аннотируем условие
@@ -480,7 +913,7 @@ SemanticAnalyzer::analyzeFor (ForStmt* stmt)
         TypeInfo condType = analyzeExpression(stmt->condition.get());
         
         if (condType.kind != TypeInfo::Bool && condType.kind != TypeInfo::Unknown) {
-            error("For condition must be boolean", stmt->condition.get());
+            report(DiagCode::ForConditionNotBool, stmt->condition.get());
         }
         
         SemanticAnnotation& condAnn = annotate(stmt->condition.get());
@@ -539,12 +972,13 @@ SemanticAnalyzer::analyzeUnaryExpr (UnaryExpr* expr)
     
     // Аннотируем всё выражение
     SemanticAnnotation& exprAnn = annotate(expr);
+    exprAnn.hasSideEffects = operandAnn.hasSideEffects;
     
     // Определяем тип в зависимости от операции
     if (expr->op == "!" || expr->op == "!=") {
         // Логическое отрицание
         if (operandType.kind != TypeInfo::Bool && operandType != TypeInfo::Unknown) {
-            error("Operand of '!' must be boolean", expr->expr.get());
+            report(DiagCode::NotOperandNotBool, expr->expr.get());
         }
         exprAnn.type = TypeInfo(TypeInfo::Bool);
         return TypeInfo(TypeInfo::Bool);
@@ -552,7 +986,7 @@ SemanticAnalyzer::analyzeUnaryExpr (UnaryExpr* expr)
     else if (expr->op == "-") {
         // Арифметическое отрицание
         if (!operandType.isNumeric() && operandType != TypeInfo::Unknown) {
-            error("Operand of unary '-' must be numeric", expr->expr.get());
+            report(DiagCode::NegateOperandNotNumeric, expr->expr.get());
         }
         exprAnn.type = operandType;
         return operandType;
@@ -561,10 +995,10 @@ SemanticAnalyzer::analyzeUnaryExpr (UnaryExpr* expr)
         // Инкремент/декремент
         SemanticAnnotation* operandAnnPtr = getAnnotation(expr->expr.get());
         if (operandAnnPtr && !operandAnnPtr->isLValue) {
-            error("Operand of '++'/'--' must be an lvalue", expr->expr.get());
+            report(DiagCode::IncDecOperandNotLValue, expr->expr.get());
         }
         if (!operandType.isNumeric() && operandType != TypeInfo::Unknown) {
-            error("Operand of '++'/'--' must be numeric", expr->expr.get());
+            report(DiagCode::IncDecOperandNotNumeric, expr->expr.get());
         }
         exprAnn.type = operandType;
         exprAnn.hasSideEffects = true;
@@ -593,7 +1027,7 @@ SemanticAnalyzer::analyzeDoWhile (DoWhileStmt* stmt)
     TypeInfo condType = analyzeExpression(stmt->condition.get());
     
     if (condType.kind != TypeInfo::Bool && condType.kind != TypeInfo::Unknown) {
-        error("Do-while condition must be boolean", stmt->condition.get());
+        report(DiagCode::DoWhileConditionNotBool, stmt->condition.get());
     }
     
     SemanticAnnotation& condAnn = annotate(stmt->condition.get());
@@ -609,7 +1043,7 @@ void
 SemanticAnalyzer::analyzeBreak (BreakStmt* stmt)
 {
     if (!inLoop) {
-        error("Break statement outside loop", stmt);
+        report(DiagCode::BreakOutsideLoop, stmt);
     }
     
     SemanticAnnotation& ann = annotate(stmt);
@@ -620,7 +1054,7 @@ void
 SemanticAnalyzer::analyzeContinue (ContinueStmt* stmt)
 {
     if (!inLoop) {
-        error("Continue statement outside loop", stmt);
+        report(DiagCode::ContinueOutsideLoop, stmt);
     }
     
     SemanticAnnotation& ann = annotate(stmt);
@@ -630,18 +1064,29 @@ SemanticAnalyzer::analyzeContinue (ContinueStmt* stmt)
 TypeInfo
 SemanticAnalyzer::analyzeBinaryExpr (BinaryExpr* expr)
 {
+    // Левая часть простого присваивания - запись, а не чтение
+    bool wasAssignmentTarget = inAssignmentTarget;
+    inAssignmentTarget = (expr->op == "=");
     TypeInfo leftType = analyzeExpression(expr->lhs.get());
+    inAssignmentTarget = wasAssignmentTarget;
     TypeInfo rightType = analyzeExpression(expr->rhs.get());
     
     SemanticAnnotation& ann = annotate(expr);
     
+    // Побочные эффекты: само присваивание или эффекты операндов
+    SemanticAnnotation* lhsAnn = getAnnotation(expr->lhs.get());
+    SemanticAnnotation* rhsAnn = getAnnotation(expr->rhs.get());
+    ann.hasSideEffects = isAssignmentOp(expr->op)
+        || (lhsAnn && lhsAnn->hasSideEffects)
+        || (rhsAnn && rhsAnn->hasSideEffects);
+    
     // Определяем тип операции
     if (expr->op == "=") {
         // Присваивание
         // Проверяем, что левая часть - lvalue
         SemanticAnnotation* leftAnn = getAnnotation(expr->lhs.get());
         if (!leftAnn || !leftAnn->isLValue) {
-            error("Left side of assignment must be an lvalue", expr);
+            report(DiagCode::AssignToNonLValue, expr);
         }
         
         checkTypeCompatibility(leftType, rightType, expr, "assignment");
@@ -659,10 +1104,10 @@ SemanticAnalyzer::analyzeBinaryExpr (BinaryExpr* expr)
     else if (expr->op == "&&" || expr->op == "||") {
         // Логические операции
         if (leftType != TypeInfo::Bool) {
-            error("Left operand of '" + expr->op + "' must be boolean", expr);
+            report(DiagCode::LogicalLhsNotBool, expr, { expr->op });
         }
         if (rightType != TypeInfo::Bool) {
-            error("Right operand of '" + expr->op + "' must be boolean", expr);
+            report(DiagCode::LogicalRhsNotBool, expr, { expr->op });
         }
         ann.type = TypeInfo(TypeInfo::Bool);
         return TypeInfo(TypeInfo::Bool);
@@ -670,10 +1115,10 @@ SemanticAnalyzer::analyzeBinaryExpr (BinaryExpr* expr)
     else {
         // Арифметические операции: +, -, *, /, %
         if (!leftType.isNumeric()) {
-            error("Left operand of '" + expr->op + "' must be numeric", expr);
+            report(DiagCode::ArithmeticLhsNotNumeric, expr, { expr->op });
         }
         if (!rightType.isNumeric()) {
-            error("Right operand of '" + expr->op + "' must be numeric", expr);
+            report(DiagCode::ArithmeticRhsNotNumeric, expr, { expr->op });
         }
         
         // Определяем общий тип
@@ -708,7 +1153,7 @@ SemanticAnalyzer::analyzeReturn (ReturnStmt* stmt)
     } else {
         // Пустой return
         if (currentReturnType != TypeInfo::Void) {
-            error("Function must return a value", stmt);
+            report(DiagCode::ReturnWithoutValue, stmt);
         }
     }
 }
@@ -719,7 +1164,7 @@ bool
 SemanticAnalyzer::checkTypeCompatibility (const TypeInfo& expected, 
                                         const TypeInfo& actual,
                                         ASTNode* node,
-                                        const std::string& context)
+                                        const char* context)
 {
     if (expected == actual) return true;
     
@@ -732,10 +1177,7 @@ SemanticAnalyzer::checkTypeCompatibility (const TypeInfo& expected,
         return true; // Целое -> bool разрешено
     }
     
-    std::ostringstream oss;
-    oss << context << ": type mismatch. Expected: " << expected.toString()
-        << ", got: " << actual.toString();
-    error(oss.str(), node);
+    report(DiagCode::TypeMismatch, node, { context, expected.name(), actual.name() });
     
     return false;
 }
@@ -0,0 +1,317 @@
+#include "source_map.h"
+
+#include <cstdlib>
+#include <stdexcept>
+
+
+namespace {
+
+const char base64Digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// VLQ: знак в младшем бите, группы по 5 бит от младших, бит 32 - продолжение
+void
+writeVlq (std::string& out, int value)
+{
+    unsigned int rest = value < 0 ? ((unsigned int) -(long long) value << 1) | 1 : (unsigned int) value << 1;
+    do {
+        unsigned int digit = rest & 31;
+        rest >>= 5;
+        if (rest) digit |= 32;
+        out.push_back(base64Digits[digit]);
+    } while (rest);
+}
+
+int
+base64Value (char c)
+{
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+int
+readVlq (const std::string& text, size_t& pos)
+{
+    long long result = 0;
+    int shift = 0;
+    while (true) {
+        int digit = pos < text.size() ? base64Value(text[pos]) : -1;
+        if (digit < 0 || shift > 30) {
+            throw std::runtime_error("source map: bad VLQ at offset " + std::to_string(pos));
+        }
+        ++pos;
+        result |= (long long) (digit & 31) << shift;
+        shift += 5;
+        if (!(digit & 32)) break;
+    }
+    return (result & 1) ? -(int) (result >> 1) : (int) (result >> 1);
+}
+
+void
+writeJsonString (std::string& out, const std::string& text)
+{
+    out.push_back('"');
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out.push_back('\\');
+            out.push_back(c);
+        }
+        else if ((unsigned char) c < 0x20) {
+            static const char hex[] = "0123456789abcdef";
+            out += "\\u00";
+            out.push_back(hex[(c >> 4) & 0xf]);
+            out.push_back(hex[c & 0xf]);
+        }
+        else {
+            out.push_back(c);
+        }
+    }
+    out.push_back('"');
+}
+
+// Строка JSON, начиная с открывающей кавычки в pos
+std::string
+readJsonString (const std::string& json, size_t pos)
+{
+    if (pos >= json.size() || json[pos] != '"') {
+        throw std::runtime_error("source map: expected string");
+    }
+    std::string text;
+    for (++pos; pos < json.size(); ++pos) {
+        char c = json[pos];
+        if (c == '"') return text;
+        if (c != '\\') {
+            text.push_back(c);
+            continue;
+        }
+        if (++pos >= json.size()) break;
+        switch (json[pos]) {
+        case 'n': text.push_back('\n'); break;
+        case 't': text.push_back('\t'); break;
+        case 'r': text.push_back('\r'); break;
+        case 'b': text.push_back('\b'); break;
+        case 'f': text.push_back('\f'); break;
+        case 'u':
+            // Имена файлов - ASCII; остальное в наших картах не встречается
+            if (pos + 4 >= json.size()) break;
+            text.push_back((char) std::strtol(json.substr(pos + 1, 4).c_str(), nullptr, 16));
+            pos += 4;
+            break;
+        default: text.push_back(json[pos]); break;
+        }
+    }
+    throw std::runtime_error("source map: unterminated string");
+}
+
+// Позиция значения поля верхнего уровня "key": после двоеточия и пробелов
+size_t
+findField (const std::string& json, const std::string& key)
+{
+    std::string quoted = "\"" + key + "\"";
+    size_t pos = json.find(quoted);
+    if (pos == std::string::npos) {
+        throw std::runtime_error("source map: no \"" + key + "\" field");
+    }
+    pos = json.find(':', pos + quoted.size());
+    if (pos == std::string::npos) {
+        throw std::runtime_error("source map: no value for \"" + key + "\"");
+    }
+    pos = json.find_first_not_of(" \t\r\n", pos + 1);
+    return pos == std::string::npos ? json.size() : pos;
+}
+
+} // namespace
+
+void
+SourceMap::append (const SourceMap& other)
+{
+    lines.insert(lines.end(), other.lines.begin(), other.lines.end());
+}
+
+void
+SourceMap::prependLines (size_t count)
+{
+    lines.insert(lines.begin(), count, SourcePosition());
+}
+
+SourcePosition
+SourceMap::lookup (size_t generatedLine) const
+{
+    if (generatedLine == 0 || generatedLine > lines.size()) return SourcePosition();
+    return lines[generatedLine - 1];
+}
+
+std::string
+SourceMap::encodeMappings () const
+{
+    // Строки и столбцы в v3 - с 0; разности - с предыдущим сегментом
+    std::string out;
+    out.reserve(lines.size() * 5);
+    int line = 0, column = 0;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (i > 0) out.push_back(';');
+        const SourcePosition& pos = lines[i];
+        if (pos.line <= 0) continue;
+        out += "AA";                    // Столбец в выводе 0, исходник 0
+        writeVlq(out, pos.line - 1 - line);
+        writeVlq(out, pos.column - 1 - column);
+        line = pos.line - 1;
+        column = pos.column - 1;
+    }
+    return out;
+}
+
+SourceMap
+SourceMap::decodeMappings (const std::string& mappings)
+{
+    SourceMap map;
+    int line = 0, column = 0;
+    size_t pos = 0;
+    SourcePosition current;
+    bool hasSegment = false;
+    while (true) {
+        if (pos >= mappings.size() || mappings[pos] == ';') {
+            map.lines.push_back(hasSegment ? current : SourcePosition());
+            hasSegment = false;
+            if (pos >= mappings.size()) break;
+            ++pos;
+            continue;
+        }
+        if (mappings[pos] == ',') {
+            ++pos;
+            continue;
+        }
+
+        // Сегмент: столбец вывода, затем необязательные исходник, строка, столбец, имя;
+        // строке вывода соответствует её первый сегмент с позицией
+        readVlq(mappings, pos);
+        int fields = 1;
+        int values[4] = {};
+        while (pos < mappings.size() && mappings[pos] != ',' && mappings[pos] != ';') {
+            int value = readVlq(mappings, pos);
+            if (fields < 5 && fields > 0) values[fields - 1] = value;
+            ++fields;
+        }
+        if (fields >= 4) {
+            line += values[1];
+            column += values[2];
+            if (!hasSegment) {
+                current = SourcePosition { line + 1, column + 1 };
+                hasSegment = true;
+            }
+        }
+    }
+    // Пустая строка mappings - карта без строк
+    if (mappings.empty()) map.lines.clear();
+    return map;
+}
+
+std::string
+SourceMap::toJson (const std::string& generatedFile, const std::string& sourceFile) const
+{
+    std::string json = "{\"version\":3,\"file\":";
+    writeJsonString(json, generatedFile);
+    json += ",\"sources\":[";
+    writeJsonString(json, sourceFile);
+    json += "],\"names\":[],\"mappings\":\"";
+    json += encodeMappings();
+    json += "\"}\n";
+    return json;
+}
+
+SourceMap
+SourceMap::fromJson (const std::string& json, std::string* sourceFile, std::string* generatedFile)
+{
+    size_t version = findField(json, "version");
+    if (json.compare(version, 1, "3") != 0) {
+        throw std::runtime_error("source map: only version 3 is supported");
+    }
+    if (sourceFile) {
+        size_t sources = findField(json, "sources");
+        if (sources >= json.size() || json[sources] != '[') {
+            throw std::runtime_error("source map: \"sources\" is not an array");
+        }
+        size_t first = json.find_first_not_of(" \t\r\n", sources + 1);
+        *sourceFile = (first != std::string::npos && json[first] == '"')
+            ? readJsonString(json, first) : std::string();
+    }
+    if (generatedFile) {
+        *generatedFile = readJsonString(json, findField(json, "file"));
+    }
+    return decodeMappings(readJsonString(json, findField(json, "mappings")));
+}
+
+namespace {
+
+// Граница пути в тексте трассировки или профиля
+bool
+endsPath (char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '"' || c == '\'' || c == '(' ||
+           c == '[' || c == ',' || c == ';' || c == '=';
+}
+
+// Число в pos; pos - после него. Нет цифр - 0
+size_t
+readNumber (const std::string& text, size_t& pos)
+{
+    size_t value = 0;
+    while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9' && value < 100000000) {
+        value = value * 10 + (text[pos++] - '0');
+    }
+    return value;
+}
+
+} // namespace
+
+std::string
+remapLocations (const std::string& text, const SourceMap& map,
+                const std::string& generatedFile, const std::string& sourceFile)
+{
+    size_t slash = generatedFile.find_last_of("/\\");
+    std::string base = (slash == std::string::npos) ? generatedFile : generatedFile.substr(slash + 1);
+    if (base.empty()) return text;
+
+    std::string out;
+    out.reserve(text.size());
+    size_t copied = 0;
+    size_t pos = 0;
+    while ((pos = text.find(base, pos)) != std::string::npos) {
+        size_t end = pos + base.size();
+
+        // Имя целиком (не хвост другого имени), путь - до разделителя
+        size_t start = pos;
+        while (start > copied && !endsPath(text[start - 1])) --start;
+        bool wholeName = (start == pos) || text[pos - 1] == '/' || text[pos - 1] == '\\';
+
+        // Номер строки: ", line N" в трассировке или ":N"
+        bool traceback = text.compare(end, 8, "\", line ") == 0;
+        size_t number = end + (traceback ? 8 : 1);
+        size_t numberEnd = number;
+        size_t generatedLine = 0;
+        if (wholeName && (traceback || (end < text.size() && text[end] == ':'))) {
+            generatedLine = readNumber(text, numberEnd);
+        }
+
+        SourcePosition position = map.lookup(generatedLine);
+        if (numberEnd == number || position.line <= 0) {
+            pos = end;
+            continue;
+        }
+
+        out.append(text, copied, start - copied);
+        out += sourceFile;
+        if (traceback) {
+            out += "\", line " + std::to_string(position.line) + ", column " + std::to_string(position.column);
+        }
+        else {
+            out += ":" + std::to_string(position.line) + ":" + std::to_string(position.column);
+        }
+        copied = pos = numberEnd;
+    }
+    out.append(text, copied, std::string::npos);
+    return out;
+}
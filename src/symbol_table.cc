@@ -1,4 +1,5 @@
 #include    "symbol_table.h"
+#include    "instrument.h"
 
 
 SymbolTable::SymbolTable()
@@ -9,13 +10,24 @@ SymbolTable::SymbolTable()
 void
 SymbolTable::pushScope()
 {
-    scopes.emplace_back();
+    C2PY_COUNT(ScopesPushed, 1);
+    if (spare.empty()) {
+        scopes.emplace_back();
+        return;
+    }
+    scopes.push_back(std::move(spare.back()));
+    spare.pop_back();
 }
 
 void
 SymbolTable::popScope()
 {
-    if (!scopes.empty()) scopes.pop_back();
+    if (scopes.empty()) return;
+    // Таблица закрытой области очищается, но её массив корзин остаётся
+    // для следующей: блоки открываются и закрываются тысячами
+    scopes.back().clear();
+    spare.push_back(std::move(scopes.back()));
+    scopes.pop_back();
 }
 
 // объявление символа в текущей области
@@ -0,0 +1,80 @@
+#include "thread_pool.h"
+
+
+ThreadPool::ThreadPool (size_t threads)
+{
+    if (threads == 0) threads = defaultThreads();
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::run, this);
+    }
+}
+
+ThreadPool::~ThreadPool ()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    hasTask.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t
+ThreadPool::defaultThreads ()
+{
+    size_t n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+void
+ThreadPool::submit (std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+        ++active;
+    }
+    hasTask.notify_one();
+}
+
+void
+ThreadPool::wait ()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    allDone.wait(lock, [this] { return active == 0; });
+
+    if (failure) {
+        std::exception_ptr error = failure;
+        failure = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void
+ThreadPool::run ()
+{
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            hasTask.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return;      // stopping и очередь пуста
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        std::exception_ptr error;
+        try {
+            task();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (error && !failure) failure = error;
+        if (--active == 0) allDone.notify_all();
+    }
+}
@@ -0,0 +1,337 @@
+#include "translation_cache.h"
+
+#include "protocol.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+
+namespace {
+
+// Сигнатура записи; меняется вместе с форматом
+const char entryMagic[8] = { 'c', '2', 'p', 'y', 'c', 'a', '1', '\n' };
+const char* const entrySuffix = ".entry";
+
+// FNV-1a 128
+struct Hash128 {
+    unsigned __int128 value;
+
+    Hash128 ()
+        : value(((unsigned __int128) 0x6c62272e07bb0142ULL << 64) | 0x62b821756295c58dULL) {}
+
+    void
+    add (const char* data, size_t size)
+    {
+        const unsigned __int128 prime = ((unsigned __int128) 0x0000000001000000ULL << 64) | 0x000000000000013BULL;
+        for (size_t i = 0; i < size; ++i) {
+            value ^= (unsigned char) data[i];
+            value *= prime;
+        }
+    }
+
+    void add (const std::string& text) { add(text.data(), text.size() + 1); }   // С нулём-разделителем
+
+    std::string
+    hex () const
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string out(32, '0');
+        unsigned __int128 rest = value;
+        for (int i = 31; i >= 0; --i) {
+            out[i] = digits[(unsigned) (rest & 15)];
+            rest >>= 4;
+        }
+        return out;
+    }
+};
+
+// FNV-1a 64 - контрольная сумма записи
+uint64_t
+checksum (const char* data, size_t size)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= (unsigned char) data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void
+writeU64 (std::string& out, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i) out.push_back((char) ((value >> (8 * i)) & 0xff));
+}
+
+// Запись: сигнатура, результат (encodeResult) и контрольная сумма всего предыдущего
+std::string
+serialize (const TranslateResult& result)
+{
+    std::string out(entryMagic, sizeof(entryMagic));
+    encodeResult(out, result);
+    writeU64(out, checksum(out.data(), out.size()));
+    return out;
+}
+
+bool
+deserialize (const std::string& data, TranslateResult& result)
+{
+    if (data.size() < sizeof(entryMagic) + 8 ||
+        data.compare(0, sizeof(entryMagic), entryMagic, sizeof(entryMagic)) != 0) {
+        return false;
+    }
+    size_t body = data.size() - 8;
+    uint64_t stored = 0;
+    for (int i = 0; i < 8; ++i) stored |= (uint64_t) (unsigned char) data[body + i] << (8 * i);
+    if (stored != checksum(data.data(), body)) return false;
+
+    // Без суммы в конце, чтобы проверить, что результат занимает запись целиком
+    std::string payload = data.substr(0, body);
+    size_t pos = sizeof(entryMagic);
+    TranslateResult loaded;
+    if (!decodeResult(payload, pos, loaded) || pos != body) return false;
+    result = std::move(loaded);
+    return true;
+}
+
+bool
+readFile (const std::string& path, std::string& data)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+bool
+endsWith (const std::string& text, const char* suffix)
+{
+    size_t size = std::char_traits<char>::length(suffix);
+    return text.size() >= size && text.compare(text.size() - size, size, suffix) == 0;
+}
+
+} // namespace
+
+TranslationCache::TranslationCache (const std::string& directory, uint64_t maxBytes)
+    : root(directory), maxBytes(maxBytes)
+{
+    std::error_code error;
+    fs::create_directories(root, error);
+}
+
+const char*
+TranslationCache::version ()
+{
+    // Номер вывода увеличивается с каждым изменением генерируемого кода или
+    // карты строк, иначе кеш отдаст прежний результат. Дата сборки не подходит:
+    // пересобирается только изменённый файл, а сборки перестают совпадать.
+    // test_output_version напоминает о забытом увеличении
+    return "c2py translation cache 1, output 3";
+}
+
+std::string
+TranslationCache::fingerprint (const TranslateOptions& options)
+{
+    const CodeGenOptions& codegen = options.codegen;
+    std::string text;
+    text += codegen.wrapIntegerOverflow ? 'w' : '-';
+    text += codegen.hoistLoopInvariants ? 'h' : '-';
+    text += codegen.convertTailCalls ? 't' : '-';
+    text += codegen.bindLoopGlobals ? 'b' : '-';
+    text += codegen.memoizePureRecursive ? 'm' : '-';
+    text += options.inliner.enabled ? 'i' : '-';
+    text += options.optimize ? 'o' : '-';
+    text += options.bytecode ? 'p' : '-';
+    text += options.sourceMap ? 's' : '-';
+    text += ' ' + std::to_string(options.inliner.maxSize);
+
+    std::vector<std::string> noMemoize(codegen.noMemoize.begin(), codegen.noMemoize.end());
+    std::sort(noMemoize.begin(), noMemoize.end());
+    for (const std::string& name : noMemoize) {
+        text += ' ' + name;
+    }
+    // Имя исходника попадает только в .pyc (co_filename)
+    if (options.bytecode) {
+        text += '\0' + options.fileName;
+    }
+    return text;
+}
+
+std::string
+TranslationCache::keyFor (const std::string& code, const TranslateOptions& options)
+{
+    Hash128 hash;
+    hash.add(version());
+    hash.add(fingerprint(options));
+    hash.add(code.data(), code.size());
+    return hash.hex();
+}
+
+std::string
+TranslationCache::pathFor (const std::string& key) const
+{
+    // Два уровня: сотни тысяч записей не в одном каталоге
+    return root + "/" + key.substr(0, 2) + "/" + key.substr(2) + entrySuffix;
+}
+
+bool
+TranslationCache::load (const std::string& key, TranslateResult& result)
+{
+    std::string path = pathFor(key);
+    std::string data;
+    if (!readFile(path, data)) {
+        ++misses;
+        return false;
+    }
+    if (!deserialize(data, result)) {
+        // Повреждённая запись (обрыв записи до rename не бывает, но диск - бывает)
+        std::error_code error;
+        fs::remove(path, error);
+        ++misses;
+        return false;
+    }
+
+    // Время изменения - время последнего использования для LRU
+    std::error_code error;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+    ++hits;
+    bytesRead += data.size();
+    return true;
+}
+
+bool
+TranslationCache::store (const std::string& key, const TranslateResult& result)
+{
+    std::string path = pathFor(key);
+    std::string data = serialize(result);
+
+    std::error_code error;
+    fs::create_directories(fs::path(path).parent_path(), error);
+    if (error) return false;
+
+    // Имя временного файла уникально для процесса и потока
+    std::string temp = path + ".tmp" + std::to_string(getpid()) + "." +
+                       std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()) & 0xffffff) +
+                       "." + std::to_string(tempCounter++);
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(data.data(), (std::streamsize) data.size());
+        out.flush();
+        if (!out) {
+            out.close();
+            fs::remove(temp, error);
+            return false;
+        }
+    }
+    fs::rename(temp, path, error);
+    if (error) {
+        fs::remove(temp, error);
+        return false;
+    }
+
+    ++stores;
+    bytesWritten += data.size();
+    if (maxBytes && (pendingBytes += data.size()) > maxBytes / 4) {
+        trim();
+    }
+    return true;
+}
+
+TranslateResult
+TranslationCache::translate (const std::string& code, const TranslateOptions& options)
+{
+    std::string key = keyFor(code, options);
+    TranslateResult result;
+    if (load(key, result)) return result;
+
+    result = translateSource(code, options);
+    store(key, result);
+    return result;
+}
+
+TranslateResult
+TranslationCache::translate (const std::string& code, Translator& translator)
+{
+    std::string key = keyFor(code, translator.options());
+    TranslateResult result;
+    if (load(key, result)) return result;
+
+    result = translator.translate(code);
+    store(key, result);
+    return result;
+}
+
+uint64_t
+TranslationCache::trim ()
+{
+    // Просмотр каталога - один на процесс; остальные потоки не ждут
+    std::unique_lock<std::mutex> lock(trimMutex, std::try_to_lock);
+    if (!lock.owns_lock()) return 0;
+    pendingBytes = 0;
+
+    struct Entry {
+        fs::file_time_type used;
+        uint64_t size;
+        fs::path path;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    auto now = fs::file_time_type::clock::now();
+
+    std::error_code error;
+    for (fs::recursive_directory_iterator it(root, error), end; !error && it != end; it.increment(error)) {
+        std::error_code entryError;
+        if (!it->is_regular_file(entryError)) continue;
+        std::string name = it->path().filename().string();
+        fs::file_time_type used = it->last_write_time(entryError);
+        uint64_t size = it->file_size(entryError);
+        if (entryError) continue;       // Файл уже удалил другой процесс
+
+        if (endsWith(name, entrySuffix)) {
+            entries.push_back({ used, size, it->path() });
+            total += size;
+        }
+        else if (name.find(".tmp") != std::string::npos && now - used > std::chrono::hours(1)) {
+            // Временный файл процесса, завершившегося до rename
+            fs::remove(it->path(), entryError);
+        }
+    }
+    if (!maxBytes || total <= maxBytes) return total;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return std::tie(a.used, a.path) < std::tie(b.used, b.path);
+    });
+    uint64_t target = maxBytes / 4 * 3;
+    for (const Entry& entry : entries) {
+        if (total <= target) break;
+        std::error_code removeError;
+        if (fs::remove(entry.path, removeError)) {
+            ++evictions;
+        }
+        total -= entry.size;
+    }
+    return total;
+}
+
+CacheStats
+TranslationCache::stats () const
+{
+    CacheStats result;
+    result.hits = hits;
+    result.misses = misses;
+    result.stores = stores;
+    result.evictions = evictions;
+    result.bytesRead = bytesRead;
+    result.bytesWritten = bytesWritten;
+    return result;
+}
@@ -0,0 +1,226 @@
+#include "translation_server.h"
+
+#include "protocol.h"
+#include "thread_pool.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+TranslationServer::TranslationServer (const std::string& socketPath, TranslationCache* cache,
+                                      size_t threads)
+    : path(socketPath), cache(cache), slots(threads ? threads : ThreadPool::defaultThreads())
+{
+}
+
+TranslationServer::~TranslationServer ()
+{
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(path.c_str());
+    }
+    if (wakeFds[0] >= 0) {
+        close(wakeFds[0]);
+        close(wakeFds[1]);
+    }
+}
+
+bool
+TranslationServer::fail (const std::string& what)
+{
+    lastError = what + ": " + std::strerror(errno);
+    return false;
+}
+
+bool
+TranslationServer::listen ()
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    if (path.size() >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return fail("socket path " + path);
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    // Через сокет читаются любые переданные исходники и возвращается код,
+    // который клиент запишет и запустит: каталог - только владельцу
+    if (!checkSocketDirectory(path, true)) return fail("socket directory of " + path);
+
+    // Файл сокета остаётся после аварийного завершения: живой ли за ним сервер
+    struct stat info;
+    if (lstat(path.c_str(), &info) == 0) {
+        if (!S_ISSOCK(info.st_mode)) {
+            errno = EEXIST;
+            return fail(path + " is not a socket");
+        }
+        int probe = connectSocket(path);
+        if (probe >= 0 || errno == EACCES) {
+            if (probe >= 0) close(probe);
+            errno = EADDRINUSE;
+            return fail("another server is listening on " + path);
+        }
+        unlink(path.c_str());
+    }
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) return fail("socket");
+    fcntl(listenFd, F_SETFD, FD_CLOEXEC);
+    // Права - при создании: chmod после bind оставил бы окно для чужих соединений
+    mode_t mask = umask(077);
+    int bound = bind(listenFd, (sockaddr*) &address, sizeof(address));
+    umask(mask);
+    if (bound != 0) {
+        int error = errno;
+        close(listenFd);
+        listenFd = -1;
+        errno = error;
+        return fail("bind " + path);
+    }
+    if (::listen(listenFd, 64) != 0) return fail("listen " + path);
+
+    if (pipe(wakeFds) != 0) return fail("pipe");
+    fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
+    return true;
+}
+
+void
+TranslationServer::stop ()
+{
+    if (wakeFds[1] >= 0) {
+        char byte = 0;
+        ssize_t ignored = write(wakeFds[1], &byte, 1);
+        (void) ignored;
+    }
+}
+
+void
+TranslationServer::run ()
+{
+    pollfd fds[2] = { { listenFd, POLLIN, 0 }, { wakeFds[0], POLLIN, 0 } };
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+        if (!peerIsSameUser(fd)) {
+            close(fd);
+            continue;
+        }
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        ++connections;
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            clients.insert(fd);
+        }
+        std::thread([this, fd] { serve(fd); }).detach();
+    }
+
+    // Ждущие следующего запроса соединения получают конец потока
+    std::unique_lock<std::mutex> lock(clientsMutex);
+    for (int fd : clients) shutdown(fd, SHUT_RDWR);
+    clientsClosed.wait(lock, [this] { return clients.empty(); });
+}
+
+TranslateResult
+TranslationServer::translate (const TranslateRequest& request)
+{
+    // Имя исходника конвейер меняет между входами - в отпечаток оно не входит
+    TranslateOptions shape = request.options;
+    shape.fileName.clear();
+    std::string key = TranslationCache::fingerprint(shape);
+
+    std::unique_ptr<Translator> translator;
+    {
+        std::unique_lock<std::mutex> lock(clientsMutex);
+        slotFree.wait(lock, [this] { return translating < slots; });
+        ++translating;
+        for (auto it = idle.rbegin(); it != idle.rend(); ++it) {
+            if (it->first == key) {
+                translator = std::move(it->second);
+                idle.erase(std::next(it).base());
+                break;
+            }
+        }
+    }
+    if (!translator) translator = std::make_unique<Translator>(request.options);
+    translator->setFileName(request.options.fileName);
+
+    TranslateResult result = cache ? cache->translate(request.code, *translator)
+                                   : translator->translate(request.code);
+
+    std::unique_ptr<Translator> evicted;     // Разрушается после снятия блокировки
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        --translating;
+        idle.emplace_back(std::move(key), std::move(translator));
+        if (idle.size() > slots) {
+            evicted = std::move(idle.front().second);
+            idle.erase(idle.begin());
+        }
+    }
+    slotFree.notify_one();
+    return result;
+}
+
+void
+TranslationServer::serve (int fd)
+{
+    std::string frame;
+    while (readFrame(fd, frame)) {
+        ++requests;
+        TranslateRequest request;
+        TranslateResult result;
+        if (!decodeRequest(frame, request)) {
+            result.errors.push_back("malformed request");
+        }
+        else if (request.kind == RequestKind::Shutdown) {
+            result.ok = true;
+        }
+        else {
+            result = translate(request);
+        }
+        if (!result.ok) ++failed;
+
+        frame.clear();
+        encodeResult(frame, result);
+        bool written = writeFrame(fd, frame);
+        // Остановка - после ответа: run() закрывает все соединения, и ответ,
+        // записанный позже, до клиента бы не дошёл
+        if (request.kind == RequestKind::Shutdown) {
+            stop();
+            break;
+        }
+        if (!written) break;
+    }
+
+    // Номер освобождается под блокировкой: accept может сразу выдать его снова
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    clients.erase(fd);
+    close(fd);
+    clientsClosed.notify_all();
+}
+
+ServerStats
+TranslationServer::stats () const
+{
+    ServerStats result;
+    result.connections = connections;
+    result.requests = requests;
+    result.failed = failed;
+    return result;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include    "lexer.h"
+#include    "parser.h"
+#include    "semantic.h"
+#include    "symbol_table.h"
+
+#include    <memory>
+#include    <string>
+
+/**
+ * Общая подготовка групп тестов анализа: исходник -> лексер -> парсер ->
+ * SemanticAnalyzer. Анализатор ссылается на таблицу символов, поэтому оба
+ * живут в куче и переживают перемещение AnalyzedSource.
+ */
+
+struct AnalyzedSource {
+    ProgramPtr program;
+    std::unique_ptr<SymbolTable> symbols;
+    std::unique_ptr<SemanticAnalyzer> analyzer;
+    bool ok = false;                // Результат analyze(); false и без анализа
+};
+
+inline ProgramPtr
+parseSource (const std::string& code)
+{
+    Lexer l (code);
+    Parser p (l.tokenize ());
+    return p.parseProgram ();
+}
+
+// analyze == false - только разбор и анализатор (например, чтобы подавить коды)
+inline AnalyzedSource
+analyzeSource (const std::string& code, bool analyze = true)
+{
+    AnalyzedSource source;
+    source.program = parseSource (code);
+    source.symbols = std::make_unique<SymbolTable> ();
+    source.analyzer = std::make_unique<SemanticAnalyzer> (*source.symbols);
+    if (analyze) source.ok = source.analyzer->analyze (source.program);
+    return source;
+}
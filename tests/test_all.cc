@@ -4,6 +4,23 @@ IMPORT_TEST_GROUP (expr_translator_test_group);
 IMPORT_TEST_GROUP (lexer_test_group);
 IMPORT_TEST_GROUP (parser_test_group);
 IMPORT_TEST_GROUP (symbol_table_test_group);
+IMPORT_TEST_GROUP (optimizer_test_group);
+IMPORT_TEST_GROUP (dataflow_test_group);
+IMPORT_TEST_GROUP (induction_test_group);
+IMPORT_TEST_GROUP (call_graph_test_group);
+IMPORT_TEST_GROUP (range_analysis_test_group);
+IMPORT_TEST_GROUP (diagnostics_test_group);
+IMPORT_TEST_GROUP (incremental_test_group);
+IMPORT_TEST_GROUP (loop_invariants_test_group);
+IMPORT_TEST_GROUP (inliner_test_group);
+IMPORT_TEST_GROUP (code_sink_test_group);
+IMPORT_TEST_GROUP (thread_pool_test_group);
+IMPORT_TEST_GROUP (pyc_generator_test_group);
+IMPORT_TEST_GROUP (source_map_test_group);
+IMPORT_TEST_GROUP (pipeline_test_group);
+IMPORT_TEST_GROUP (translation_cache_test_group);
+IMPORT_TEST_GROUP (protocol_test_group);
+IMPORT_TEST_GROUP (instrument_test_group);
 
 int main (int ac, char **av)
 {
@@ -0,0 +1,103 @@
+#include    "analyzed_source.h"
+#include    "call_graph.h"
+
+#include    <CppUTest/TestHarness.h>
+
+
+TEST_GROUP (call_graph_test_group)
+{
+    AnalyzedSource source;
+
+    const CallGraph&
+    analyze (const std::string& code)
+    {
+        source = analyzeSource (code);
+        return source.analyzer->getCallGraph ();
+    }
+
+    const FunctionDecl*
+    func (size_t i)
+    {
+        return source.program->functions[i].get ();
+    }
+};
+
+
+TEST (call_graph_test_group, test_edges)
+{
+    auto& cg = analyze (
+        "int sq(int x) { return x * x; } "
+        "int sum(int a, int b) { return sq(a) + sq(b); } "
+        "int main() { return sum(1, 2); }");
+
+    CHECK_EQUAL (1u, cg.callees (func (1)).size ());
+    CHECK_TRUE (cg.callees (func (1))[0] == func (0));
+    CHECK_EQUAL (1u, cg.callers (func (0)).size ());
+    CHECK_EQUAL (2u, cg.stats ().edges);
+    CHECK_EQUAL (3u, cg.stats ().callSites);
+}
+
+TEST (call_graph_test_group, test_callees_ordered_first)
+{
+    auto& cg = analyze (
+        "int main() { return sum(1, 2); } "
+        "int sum(int a, int b) { return sq(a) + sq(b); } "
+        "int sq(int x) { return x * x; }");
+
+    CHECK_EQUAL (3u, cg.sccs ().size ());
+    CHECK_TRUE (cg.summary (func (2))->scc < cg.summary (func (1))->scc);
+    CHECK_TRUE (cg.summary (func (1))->scc < cg.summary (func (0))->scc);
+}
+
+TEST (call_graph_test_group, test_recursion)
+{
+    auto& cg = analyze (
+        "int fact(int n) { if (n <= 1) { return 1; } return n * fact(n - 1); } "
+        "int even(int n) { if (n == 0) { return 1; } return odd(n - 1); } "
+        "int odd(int n) { if (n == 0) { return 0; } return even(n - 1); } "
+        "int main() { return fact(3) + even(4); }");
+
+    CHECK_TRUE (cg.isRecursive (func (0)));
+    CHECK_TRUE (cg.isRecursive (func (1)));
+    CHECK_TRUE (cg.summary (func (1))->scc == cg.summary (func (2))->scc);
+    CHECK_FALSE (cg.isRecursive (func (3)));
+    CHECK_EQUAL (3u, cg.stats ().sccs);
+}
+
+TEST (call_graph_test_group, test_purity)
+{
+    auto& cg = analyze (
+        "int fib(int n) { if (n <= 1) { return n; } return fib(n - 1) + fib(n - 2); } "
+        "int loop(int n) { int s = 0; while (n > 0) { s = s + n; n = n - 1; } return s; } "
+        "int add(int a, int b) { return a + b; } "
+        "int main() { return fib(5) + loop(3) + add(1, 2); }");
+
+    CHECK_TRUE (cg.isPure (func (0)));
+    CHECK_FALSE (cg.summary (func (0))->terminates);
+    CHECK_TRUE (cg.isPure (func (1)));
+    CHECK_FALSE (cg.summary (func (1))->terminates);
+    CHECK_TRUE (cg.summary (func (2))->terminates);
+}
+
+TEST (call_graph_test_group, test_unknown_callee_is_impure)
+{
+    auto& cg = analyze (
+        "int f(int a) { return g(a); } "
+        "int main() { return f(1); }");
+
+    CHECK_TRUE (cg.summary (func (0))->callsUnknown);
+    CHECK_FALSE (cg.isPure (func (0)));
+    CHECK_FALSE (cg.isPure (func (1)));
+}
+
+TEST (call_graph_test_group, test_refined_call_effects)
+{
+    analyze (
+        "int add(int a, int b) { return a + b; } "
+        "int main() { int x = add(1, 2); return 0; }");
+
+    auto decl = static_cast<VarDecl*> (func (1)->body->statements[0].get ());
+    const SemanticAnnotation* ann = source.analyzer->getAnnotationForNode (decl->init.get ());
+    CHECK_TRUE (ann != nullptr);
+    CHECK_FALSE (ann->hasSideEffects);
+}
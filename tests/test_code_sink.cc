@@ -0,0 +1,30 @@
+#include    "code_sink.h"
+
+#include    <string>
+
+#include    <CppUTest/TestHarness.h>
+
+
+TEST_GROUP (code_sink_test_group)
+{
+};
+
+
+TEST (code_sink_test_group, test_string_header)
+{
+    StringSink sink;
+    sink.append ("# c2py\n");
+    sink.reserveHeader ();
+    sink.append ("def f():\n");
+    sink.append ("    return 1\n");
+    CHECK_EQUAL (29u, sink.size ());
+
+    sink.fillHeader ("import sys\n\n");
+    STRCMP_EQUAL ("# c2py\nimport sys\n\ndef f():\n    return 1\n", sink.str ().c_str ());
+    // Заголовок не считается частью вывода генератора
+    CHECK_EQUAL (29u, sink.size ());
+
+    std::string text = sink.take ();
+    CHECK_EQUAL (41u, text.size ());
+    CHECK_EQUAL (0u, sink.size ());
+}
@@ -0,0 +1,129 @@
+#include    "analyzed_source.h"
+#include    "dataflow.h"
+
+#include    <CppUTest/TestHarness.h>
+
+
+TEST_GROUP (dataflow_test_group)
+{
+    AnalyzedSource source;
+
+    const FunctionDataflow*
+    analyze (const std::string& code)
+    {
+        source = analyzeSource (code);
+        CHECK_TRUE (source.ok);
+        return source.analyzer->getDataflow (source.program->functions.back ().get ());
+    }
+
+    Statement*
+    stmt (size_t i)
+    {
+        return source.program->functions.back ()->body->statements[i].get ();
+    }
+
+    const VarDecl*
+    var (size_t i)
+    {
+        return static_cast<const VarDecl*> (stmt (i));
+    }
+};
+
+
+TEST (dataflow_test_group, test_bit_vector)
+{
+    BitVector a (70), b (70, true);
+
+    CHECK_FALSE (a.any ());
+    a.set (3);
+    a.set (69);
+    CHECK_TRUE (a.test (69));
+    CHECK_FALSE (a.test (68));
+
+    b.subtract (a);
+    CHECK_FALSE (b.test (3));
+    CHECK_TRUE (b.test (4));
+    b |= a;
+    CHECK_TRUE (b == BitVector (70, true));
+}
+
+TEST (dataflow_test_group, test_cfg_while_edges)
+{
+    auto df = analyze ("int main() { int i = 0; while (i < 3) { i++; } return i; }");
+
+    const CFGLoop* loop = df->cfg.loopOf (stmt (1));
+    CHECK_TRUE (loop != nullptr);
+    const CFGBlock& header = df->cfg.blocks[loop->header];
+    CHECK_EQUAL (2u, header.succs.size ());
+    CHECK_EQUAL (2u, header.preds.size ());
+}
+
+TEST (dataflow_test_group, test_cfg_break_continue_edges)
+{
+    auto df = analyze (
+        "int main() { int i = 0; "
+        "for (i = 0; i < 10; i++) { if (i == 5) { break; } continue; } "
+        "return i; }");
+
+    const CFGLoop* loop = df->cfg.loopOf (stmt (1));
+    CHECK_TRUE (loop != nullptr);
+    // Выход из for: ложное условие и break
+    CHECK_EQUAL (2u, df->cfg.blocks[loop->exit].preds.size ());
+}
+
+TEST (dataflow_test_group, test_reaching_definitions_merge)
+{
+    auto df = analyze (
+        "int main() { int x = 1; int c = 0; if (c == 0) { x = 2; } return x; }");
+
+    auto ret = static_cast<ReturnStmt*> (stmt (3));
+    auto use = static_cast<IdentifierExpr*> (ret->value.get ());
+    const std::vector<int>* defs = df->reachingDefs (use);
+    CHECK_TRUE (defs != nullptr);
+    CHECK_EQUAL (2u, defs->size ());
+}
+
+TEST (dataflow_test_group, test_reaching_definitions_kill)
+{
+    auto df = analyze ("int main() { int x = 1; x = 2; return x; }");
+
+    auto ret = static_cast<ReturnStmt*> (stmt (2));
+    auto use = static_cast<IdentifierExpr*> (ret->value.get ());
+    const std::vector<int>* defs = df->reachingDefs (use);
+    CHECK_EQUAL (1u, defs->size ());
+    CHECK_TRUE (df->definitions[(*defs)[0]].site != var (0));
+}
+
+TEST (dataflow_test_group, test_loop_modification)
+{
+    auto df = analyze (
+        "int main() { int i = 0; int n = 10; int s = 0; "
+        "while (i < n) { s = s + i; i++; } return s; }");
+
+    CHECK_TRUE (df->isModifiedInLoop (var (0), stmt (3)));
+    CHECK_FALSE (df->isModifiedInLoop (var (1), stmt (3)));
+    CHECK_TRUE (df->isModifiedInLoop (var (2), stmt (3)));
+}
+
+TEST (dataflow_test_group, test_liveness_after_loop)
+{
+    auto df = analyze (
+        "int main() { int i = 0; int s = 0; "
+        "for (i = 0; i < 10; i++) { s = s + i; } return s; }");
+
+    CHECK_FALSE (df->isLiveAfterLoop (var (0), stmt (2)));
+    CHECK_TRUE (df->isLiveAfterLoop (var (1), stmt (2)));
+}
+
+TEST (dataflow_test_group, test_def_use_chains)
+{
+    auto df = analyze ("int f(int a) { int b = a + 1; return b * a; }");
+
+    int paramIdx = -1;
+    for (size_t d = 0; d < df->definitions.size (); ++d) {
+        if (df->definitions[d].site == df->definitions[d].var &&
+            df->definitions[d].var != var (0)) paramIdx = (int)d;
+    }
+    CHECK_TRUE (paramIdx >= 0);
+    CHECK_EQUAL (2u, df->defUses[paramIdx].size ());
+}
@@ -0,0 +1,83 @@
+#include    "analyzed_source.h"
+#include    "diagnostics.h"
+
+#include    <CppUTest/TestHarness.h>
+
+
+TEST_GROUP (diagnostics_test_group)
+{
+    AnalyzedSource source;
+};
+
+
+TEST (diagnostics_test_group, test_format_arguments)
+{
+    DiagnosticEngine engine;
+    NumberExpr node ("1");
+    node.line = 3;
+    node.column = 7;
+
+    engine.report (DiagCode::TypeMismatch, &node, { "assignment", "int", "bool" });
+    CHECK_EQUAL (1u, engine.errorCount ());
+    STRCMP_EQUAL ("bool", std::string (engine.argument (engine.all ()[0], 2)).c_str ());
+    STRCMP_EQUAL ("Semantic error at line 3:7 - assignment: type mismatch. Expected: int, got: bool",
+                  engine.format (engine.all ()[0]).c_str ());
+}
+
+TEST (diagnostics_test_group, test_structured_codes)
+{
+    source = analyzeSource ("int f(int a) { if (a > 0) { return b; } } int main() { return f(1); }");
+    CHECK_FALSE (source.ok);
+
+    const DiagnosticEngine& diags = source.analyzer->getDiagnostics ();
+    CHECK_TRUE (diags.errorCount () >= 1);
+    CHECK_TRUE (diags.all ()[0].code == DiagCode::UndeclaredIdentifier);
+    STRCMP_EQUAL ("b", std::string (diags.argument (diags.all ()[0], 0)).c_str ());
+    STRCMP_EQUAL ("Semantic error at line 1:36 - Undeclared identifier: 'b'",
+                  source.analyzer->getErrors ()[0].c_str ());
+}
+
+TEST (diagnostics_test_group, test_warning_severity)
+{
+    source = analyzeSource ("int f(int a) { a = a + 1; } int main() { return 0; }");
+    CHECK_TRUE (source.ok);
+
+    CHECK_EQUAL (1u, source.analyzer->getDiagnostics ().warningCount ());
+    CHECK_EQUAL (0u, source.analyzer->getErrors ().size ());
+    STRCMP_EQUAL ("Warning at line 1:1 - Function 'f' may not return a value",
+                  source.analyzer->getWarnings ()[0].c_str ());
+}
+
+TEST (diagnostics_test_group, test_main_with_parameters)
+{
+    // Точка входа вызывает main() - параметры остались бы неопределёнными именами
+    source = analyzeSource ("int main(int argc) { return argc; }");
+    CHECK_FALSE (source.ok);
+    CHECK_TRUE (source.analyzer->getDiagnostics ().all ()[0].code == DiagCode::MainWithParameters);
+    STRCMP_EQUAL ("Semantic error at line 1:1 - Function 'main' must not take parameters",
+                  source.analyzer->getErrors ()[0].c_str ());
+
+    source = analyzeSource ("int f(int argc) { return argc; } int main() { return f(1); }");
+    CHECK_TRUE (source.ok);
+}
+
+TEST (diagnostics_test_group, test_suppression)
+{
+    source = analyzeSource ("int f(int a) { a = a + 1; } int main() { return 0; }", false);
+    source.analyzer->suppress (DiagCode::MissingReturn);
+    CHECK_TRUE (source.analyzer->analyze (source.program));
+    CHECK_EQUAL (0u, source.analyzer->getDiagnostics ().all ().size ());
+
+    // Подавление переживает повторный анализ
+    CHECK_TRUE (source.analyzer->analyze (source.program));
+    CHECK_EQUAL (0u, source.analyzer->getWarnings ().size ());
+}
+
+TEST (diagnostics_test_group, test_code_names)
+{
+    DiagCode code;
+    CHECK_TRUE (DiagnosticEngine::codeFromName ("missing-return", code));
+    CHECK_TRUE (code == DiagCode::MissingReturn);
+    CHECK_FALSE (DiagnosticEngine::codeFromName ("no-such-code", code));
+    STRCMP_EQUAL ("undeclared-identifier", DiagnosticEngine::nameOf (DiagCode::UndeclaredIdentifier));
+}
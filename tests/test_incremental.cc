@@ -0,0 +1,107 @@
+#include    "analyzed_source.h"
+
+#include    <CppUTest/TestHarness.h>
+
+
+TEST_GROUP (incremental_test_group)
+{
+    SymbolTable symbols;
+    std::unique_ptr<SemanticAnalyzer> analyzer;
+
+    void
+    setup ()
+    {
+        analyzer = std::make_unique<SemanticAnalyzer> (symbols);
+    }
+
+    FunctionDecl*
+    function (ProgramPtr& program, const std::string& name)
+    {
+        for (auto& func : program->functions) {
+            if (func->name == name) return func.get ();
+        }
+        return nullptr;
+    }
+};
+
+
+TEST (incremental_test_group, test_unchanged_function_reused)
+{
+    ProgramPtr first = parseSource ("int f(int a) { return a * 2; }\n"
+                                    "int main() { return f(1); }");
+    CHECK_TRUE (analyzer->analyze (first));
+    FunctionDecl* oldF = function (first, "f");
+
+    ProgramPtr second = parseSource ("int f(int a) { return a * 2; }\n"
+                                     "int main() { int x = 3; return f(x); }");
+    CHECK_TRUE (analyzer->reanalyze (first, second));
+
+    CHECK_EQUAL (1u, analyzer->getReusedFunctionCount ());
+    CHECK_TRUE (oldF == function (second, "f"));
+    CHECK_TRUE (analyzer->getDataflow (oldF) != nullptr);
+    CHECK_TRUE (analyzer->getCallGraph ().callers (oldF).size () == 1);
+    CHECK_FALSE (analyzer->getCallGraph ().isRecursive (oldF));
+}
+
+TEST (incremental_test_group, test_changed_body_reanalyzed)
+{
+    ProgramPtr first = parseSource ("int f(int a) { return a * 2; }\n"
+                                    "int main() { return f(1); }");
+    CHECK_TRUE (analyzer->analyze (first));
+
+    ProgramPtr second = parseSource ("int f(int a) { return a * 3; }\n"
+                                     "int main() { return f(1); }");
+    FunctionDecl* newF = function (second, "f");
+    CHECK_TRUE (analyzer->reanalyze (first, second));
+
+    CHECK_EQUAL (1u, analyzer->getReusedFunctionCount ());
+    CHECK_TRUE (newF == function (second, "f"));
+    CHECK_TRUE (analyzer->getDataflow (newF) != nullptr);
+}
+
+TEST (incremental_test_group, test_callee_signature_invalidates_caller)
+{
+    ProgramPtr first = parseSource ("int f(int a) { return a; }\n"
+                                    "int main() { return f(1); }");
+    CHECK_TRUE (analyzer->analyze (first));
+
+    ProgramPtr second = parseSource ("bool f(int a) { return a > 0; }\n"
+                                     "int main() { return f(1); }");
+    CHECK_FALSE (analyzer->reanalyze (first, second));
+
+    CHECK_EQUAL (0u, analyzer->getReusedFunctionCount ());
+    CHECK_TRUE (analyzer->getDiagnostics ().all ()[0].code == DiagCode::TypeMismatch);
+}
+
+TEST (incremental_test_group, test_diagnostics_preserved)
+{
+    ProgramPtr first = parseSource ("int g() { return 0; }\n"
+                                    "int f(int a) { a = a + 1; }\n"
+                                    "int main() { return g(); }");
+    CHECK_TRUE (analyzer->analyze (first));
+    CHECK_EQUAL (1u, analyzer->getWarnings ().size ());
+    std::string before = analyzer->getWarnings ()[0];
+
+    ProgramPtr second = parseSource ("int g() { return 1; }\n\n"
+                                     "int f(int a) { a = a + 1; }\n"
+                                     "int main() { return g(); }");
+    CHECK_TRUE (analyzer->reanalyze (first, second));
+
+    CHECK_EQUAL (2u, analyzer->getReusedFunctionCount ());
+    CHECK_EQUAL (1u, analyzer->getWarnings ().size ());
+    CHECK_EQUAL (first->functions.size (), second->functions.size ());
+    CHECK_TRUE (analyzer->getDiagnostics ().all ()[0].line
+                == function (second, "f")->line);
+    CHECK_TRUE (before != analyzer->getWarnings ()[0]);
+}
+
+TEST (incremental_test_group, test_unknown_previous_falls_back)
+{
+    ProgramPtr first = parseSource ("int main() { return 0; }");
+    ProgramPtr second = parseSource ("int main() { return 0; }");
+    FunctionDecl* newMain = function (second, "main");
+
+    CHECK_TRUE (analyzer->reanalyze (first, second));
+    CHECK_EQUAL (0u, analyzer->getReusedFunctionCount ());
+    CHECK_TRUE (newMain == function (second, "main"));
+}
@@ -0,0 +1,72 @@
+#include    "analyzed_source.h"
+#include    "induction.h"
+
+#include    <CppUTest/TestHarness.h>
+
+
+TEST_GROUP (induction_test_group)
+{
+    AnalyzedSource source;
+
+    const InductionVariable*
+    analyze (const std::string& code, size_t loop)
+    {
+        source = analyzeSource (code);
+        CHECK_TRUE (source.ok);
+        auto& body = source.program->functions.back ()->body->statements;
+        auto forStmt = dynamic_cast<ForStmt*> (body[loop].get ());
+        CHECK_TRUE (forStmt != nullptr);
+        return source.analyzer->getInductionVariable (forStmt);
+    }
+};
+
+
+TEST (induction_test_group, test_simple_counter)
+{
+    auto iv = analyze (
+        "int main() { int s = 0; for (int i = 0; i < 10; i++) { s = s + i; } return s; }", 1);
+
+    CHECK_TRUE (iv != nullptr);
+    CHECK_EQUAL (1, iv->step);
+    CHECK_FALSE (iv->inclusive);
+    CHECK_FALSE (iv->liveAfterLoop);
+}
+
+TEST (induction_test_group, test_descending_inclusive_step)
+{
+    auto iv = analyze (
+        "int main() { int s = 0; int i; for (i = 20; i >= 0; i -= 4) { s = s + i; } return s; }", 2);
+
+    CHECK_TRUE (iv != nullptr);
+    CHECK_EQUAL (-4, iv->step);
+    CHECK_TRUE (iv->inclusive);
+}
+
+TEST (induction_test_group, test_variable_modified_in_body)
+{
+    auto iv = analyze (
+        "int main() { int s = 0; for (int i = 0; i < 10; i++) { i = i + 1; s = s + 1; } return s; }", 1);
+
+    CHECK_TRUE (iv == nullptr);
+}
+
+TEST (induction_test_group, test_bound_modified_in_body)
+{
+    auto iv = analyze (
+        "int main() { int n = 10; for (int i = 0; i < n; i++) { n = n - 1; } return n; }", 1);
+
+    CHECK_TRUE (iv == nullptr);
+}
+
+TEST (induction_test_group, test_live_after_loop)
+{
+    auto unit = analyze (
+        "int main() { int i = 0; for (i = 0; i < 5; i++) { } return i; }", 1);
+    CHECK_TRUE (unit != nullptr);
+    CHECK_TRUE (unit->liveAfterLoop);
+
+    // Для шага, отличного от ±1, итоговое значение не восстанавливаем
+    auto wide = analyze (
+        "int main() { int i = 0; for (i = 0; i < 5; i += 2) { } return i; }", 1);
+    CHECK_TRUE (wide == nullptr);
+}
@@ -0,0 +1,114 @@
+#include    "analyzed_source.h"
+#include    "inliner.h"
+
+#include    <CppUTest/TestHarness.h>
+
+
+TEST_GROUP (inliner_test_group)
+{
+    AnalyzedSource source;
+
+    InlinerStats
+    inlineCalls (const std::string& code, const InlinerOptions& options = InlinerOptions ())
+    {
+        source = analyzeSource (code);
+        CHECK_TRUE (source.ok);
+
+        Inliner inliner (*source.analyzer, options);
+        InlinerStats stats = inliner.inlineCalls (source.program.get ());
+        // Результат подстановки - корректная программа
+        CHECK_TRUE (source.analyzer->analyze (source.program));
+        return stats;
+    }
+
+    std::vector<StmtPtr>&
+    mainBody ()
+    {
+        return source.program->functions.back ()->body->statements;
+    }
+};
+
+
+TEST (inliner_test_group, test_direct_substitution)
+{
+    InlinerStats stats = inlineCalls (
+        "int twice(int v) { return v * 2; } int main() { int x = 3; return twice(x + 1); }");
+
+    CHECK_EQUAL (1, stats.candidates);
+    CHECK_EQUAL (1, stats.inlinedCalls);
+    CHECK_EQUAL (2u, mainBody ().size ());
+
+    auto ret = dynamic_cast<ReturnStmt*> (mainBody ()[1].get ());
+    auto product = dynamic_cast<BinaryExpr*> (ret->value.get ());
+    CHECK_TRUE (product != nullptr);
+    STRCMP_EQUAL ("*", product->op.c_str ());
+    CHECK_TRUE (dynamic_cast<BinaryExpr*> (product->lhs.get ()) != nullptr);
+}
+
+TEST (inliner_test_group, test_temporaries_for_repeated_reads)
+{
+    InlinerStats stats = inlineCalls (
+        "int dist(int a, int b) { int d = a - b; return d * d + a; }"
+        " int main() { int x = 3; return dist(x + 1, x); }");
+
+    CHECK_EQUAL (1, stats.inlinedCalls);
+    // x, временная для аргумента a, временная для локальной d, return
+    CHECK_EQUAL (4u, mainBody ().size ());
+
+    auto a = dynamic_cast<VarDecl*> (mainBody ()[1].get ());
+    auto d = dynamic_cast<VarDecl*> (mainBody ()[2].get ());
+    CHECK_TRUE (a != nullptr && d != nullptr);
+    STRCMP_EQUAL ("_c2py_inl0_a", a->name.c_str ());
+    STRCMP_EQUAL ("_c2py_inl0_d", d->name.c_str ());
+}
+
+TEST (inliner_test_group, test_recursive_and_loops_not_inlined)
+{
+    InlinerStats stats = inlineCalls (
+        "int fact(int n) { if (n < 2) { return 1; } return n * fact(n - 1); }"
+        " int sum(int n) { int s = 0; while (n > 0) { s = s + n; n = n - 1; } return s; }"
+        " int main() { return fact(4) + sum(3); }");
+
+    CHECK_EQUAL (0, stats.candidates);
+    CHECK_EQUAL (0, stats.inlinedCalls);
+}
+
+TEST (inliner_test_group, test_loop_condition_requires_direct_substitution)
+{
+    InlinerStats stats = inlineCalls (
+        "int sq(int v) { return v * v; }"
+        " int main() { int i = 0; int n = 5;"
+        " while (i < sq(n + 1)) { i = i + 1; }"
+        " while (i < sq(n)) { i = i + 2; } return i; }");
+
+    // sq(n + 1) в условии цикла потребовал бы временной - остаётся вызовом
+    CHECK_EQUAL (1, stats.inlinedCalls);
+    auto first = dynamic_cast<WhileStmt*> (mainBody ()[2].get ());
+    auto cond = dynamic_cast<BinaryExpr*> (first->condition.get ());
+    CHECK_TRUE (dynamic_cast<CallExpr*> (cond->rhs.get ()) != nullptr);
+}
+
+TEST (inliner_test_group, test_switch_and_size_threshold)
+{
+    const char* code = "int sq(int v) { return v * v; } int main() { int x = 2; return sq(x); }";
+
+    InlinerOptions disabled;
+    disabled.enabled = false;
+    CHECK_EQUAL (0, inlineCalls (code, disabled).inlinedCalls);
+
+    InlinerOptions tiny;
+    tiny.maxSize = 2;
+    CHECK_EQUAL (0, inlineCalls (code, tiny).candidates);
+
+    CHECK_EQUAL (1, inlineCalls (code).inlinedCalls);
+}
+
+TEST (inliner_test_group, test_argument_type_mismatch)
+{
+    // В C аргумент 3 преобразуется в 3.0; при подстановке деление стало бы целочисленным
+    InlinerStats stats = inlineCalls (
+        "float half(float a) { return a / a; } int main() { float h = half(3); return 0; }");
+
+    CHECK_EQUAL (1, stats.candidates);
+    CHECK_EQUAL (0, stats.inlinedCalls);
+}
@@ -0,0 +1,121 @@
+#include    "instrument.h"
+#include    "pipeline.h"
+
+#include    <string>
+#include    <thread>
+
+#include    <CppUTest/TestHarness.h>
+
+
+TEST_GROUP (instrument_test_group)
+{
+    void
+    setup ()
+    {
+        instrument::reset ();
+    }
+
+    void
+    teardown ()
+    {
+        instrument::reset ();
+    }
+
+    size_t
+    occurrences (const std::string& text, const std::string& what)
+    {
+        size_t count = 0;
+        for (size_t pos = text.find (what); pos != std::string::npos; pos = text.find (what, pos + 1)) {
+            ++count;
+        }
+        return count;
+    }
+};
+
+
+TEST (instrument_test_group, test_phases_and_counters)
+{
+    {
+        instrument::Phase outer ("outer");
+        instrument::Phase inner ("inner");
+    }
+    {
+        instrument::Phase outer ("outer");
+    }
+    instrument::count (instrument::Counter::Tokens, 40);
+    instrument::count (instrument::Counter::Tokens, 2);
+    CHECK_EQUAL (42u, instrument::counter (instrument::Counter::Tokens));
+
+    std::string summary = instrument::summary ();
+    CHECK_TRUE (summary.find ("outer") < summary.find ("inner"));
+    CHECK_TRUE (summary.find ("outer                   2") != std::string::npos);
+    CHECK_TRUE (summary.find ("tokens           42") != std::string::npos);
+
+    std::string trace = instrument::chromeTrace ();
+    CHECK_EQUAL (3u, occurrences (trace, "\"ph\":\"X\""));
+    CHECK_EQUAL ((size_t) instrument::Counter::Count, occurrences (trace, "\"ph\":\"C\""));
+    CHECK_TRUE (trace.find ("{\"name\":\"tokens\",\"ph\":\"C\"") != std::string::npos);
+
+    instrument::reset ();
+    CHECK_EQUAL (0u, instrument::counter (instrument::Counter::Tokens));
+    CHECK_EQUAL (0u, occurrences (instrument::chromeTrace (), "\"ph\":\"X\""));
+}
+
+TEST (instrument_test_group, test_threads)
+{
+    // У каждого потока свой буфер и свой tid в трассе
+    auto work = [] { instrument::Phase phase ("work"); };
+    std::thread first (work);
+    first.join ();
+    std::thread second (work);
+    second.join ();
+
+    std::string trace = instrument::chromeTrace ();
+    CHECK_EQUAL (2u, occurrences (trace, "\"name\":\"work\""));
+    CHECK_EQUAL (1u, occurrences (trace, "\"tid\":1,"));
+    CHECK_EQUAL (1u, occurrences (trace, "\"tid\":2,"));
+}
+
+TEST (instrument_test_group, test_macros)
+{
+    int evaluated = 0;
+    auto tokens = [&] { ++evaluated; return 5; };
+    {
+        C2PY_PHASE ("macro");
+        C2PY_COUNT (Tokens, tokens ());
+    }
+    (void) tokens;
+    uint64_t allocations = instrument::threadAllocations ();
+    int* volatile allocated = new int (1);      // volatile - пару new/delete не убрать
+    delete allocated;
+    uint64_t allocationsAfter = instrument::threadAllocations ();
+
+    // Без C2PY_INSTRUMENT макросы пусты: аргументы не вычисляются
+    if (instrument::enabled ()) {
+        CHECK_EQUAL (1, evaluated);
+        CHECK_EQUAL (5u, instrument::counter (instrument::Counter::Tokens));
+        CHECK_TRUE (instrument::summary ().find ("macro") != std::string::npos);
+        CHECK_EQUAL (allocations + 1, allocationsAfter);
+    }
+    else {
+        CHECK_EQUAL (0, evaluated);
+        CHECK_EQUAL (0u, instrument::counter (instrument::Counter::Tokens));
+        CHECK_EQUAL (0u, allocationsAfter);
+    }
+}
+
+TEST (instrument_test_group, test_pipeline_phases)
+{
+    translateSource ("int main() { int a = 1; return a; }");
+    std::string summary = instrument::summary ();
+    if (instrument::enabled ()) {
+        CHECK_TRUE (summary.find ("lex") < summary.find ("parse"));
+        CHECK_TRUE (summary.find ("parse") < summary.find ("semantic"));
+        CHECK_TRUE (summary.find ("semantic") < summary.find ("codegen"));
+        CHECK_TRUE (instrument::counter (instrument::Counter::Tokens) > 10);
+        CHECK_TRUE (instrument::counter (instrument::Counter::LinesEmitted) > 0);
+    }
+    else {
+        CHECK_TRUE (summary.find ("lex") == std::string::npos);
+    }
+}
@@ -0,0 +1,97 @@
+#include    "analyzed_source.h"
+#include    "loop_invariants.h"
+
+#include    <CppUTest/TestHarness.h>
+
+
+TEST_GROUP (loop_invariants_test_group)
+{
+    AnalyzedSource source;
+
+    Statement*
+    analyze (const std::string& code, size_t loop)
+    {
+        source = analyzeSource (code);
+        CHECK_TRUE (source.ok);
+        return source.program->functions.back ()->body->statements[loop].get ();
+    }
+
+    size_t
+    hoistedCount (Statement* loop)
+    {
+        auto invariants = source.analyzer->getLoopInvariants (loop);
+        return invariants ? invariants->size () : 0;
+    }
+};
+
+
+TEST (loop_invariants_test_group, test_condition_invariant)
+{
+    Statement* loop = analyze (
+        "int main() { int n = 3; int m = 4; int i = 0; while (i < n * m) { i = i + 1; } return i; }", 3);
+
+    CHECK_EQUAL (1u, hoistedCount (loop));
+    auto product = dynamic_cast<BinaryExpr*> ((*source.analyzer->getLoopInvariants (loop))[0]);
+    CHECK_TRUE (product != nullptr);
+    STRCMP_EQUAL ("*", product->op.c_str ());
+}
+
+TEST (loop_invariants_test_group, test_body_subexpression)
+{
+    Statement* loop = analyze (
+        "int main() { int x = 2; int y = 5; int a = 0; int i = 0;"
+        " while (i < 10) { a = x * y + i; i = i + 1; } return a; }", 4);
+
+    CHECK_EQUAL (1u, hoistedCount (loop));
+    auto product = dynamic_cast<BinaryExpr*> ((*source.analyzer->getLoopInvariants (loop))[0]);
+    CHECK_TRUE (product != nullptr);
+    STRCMP_EQUAL ("*", product->op.c_str ());
+}
+
+TEST (loop_invariants_test_group, test_modified_variable_not_hoisted)
+{
+    Statement* loop = analyze (
+        "int main() { int x = 2; int i = 0; while (i < 10) { i = i + x * 2; x = x + 1; } return i; }", 2);
+
+    CHECK_EQUAL (0u, hoistedCount (loop));
+}
+
+TEST (loop_invariants_test_group, test_division_only_from_condition)
+{
+    // n / d в теле может не вычисляться (d == 0 при пустом цикле), в условии - вычисляется всегда
+    Statement* body = analyze (
+        "int main() { int n = 8; int d = 2; int s = 0; int i = 0;"
+        " while (i < 4) { s = s + n / d; i = i + 1; } return s; }", 4);
+    CHECK_EQUAL (0u, hoistedCount (body));
+
+    Statement* condition = analyze (
+        "int main() { int n = 8; int d = 2; int i = 0; while (i < n / d) { i = i + 1; } return i; }", 3);
+    CHECK_EQUAL (1u, hoistedCount (condition));
+}
+
+TEST (loop_invariants_test_group, test_nested_hoisted_to_outer_loop)
+{
+    Statement* outer = analyze (
+        "int main() { int n = 3; int s = 0; int i = 0;"
+        " while (i < 5) { int j = 0; while (j < 5) { s = s + n * 7 + i * j; j = j + 1; } i = i + 1; }"
+        " return s; }", 3);
+
+    auto invariants = source.analyzer->getLoopInvariants (outer);
+    CHECK_TRUE (invariants != nullptr);
+    CHECK_EQUAL (1u, invariants->size ());
+
+    auto& body = dynamic_cast<BlockStmt*> (dynamic_cast<WhileStmt*> (outer)->body.get ())->statements;
+    CHECK_EQUAL (0u, hoistedCount (body[1].get ()));
+}
+
+TEST (loop_invariants_test_group, test_pure_call_in_condition)
+{
+    Statement* loop = analyze (
+        "int sq(int v) { return v * v; }"
+        " int main() { int n = 3; int s = 0; int i = 0;"
+        " while (i < sq(n)) { s = s + sq(n); i = i + 1; } return s; }", 3);
+
+    // Вызов в условии выполняется до первой итерации, в теле - нет
+    CHECK_EQUAL (1u, hoistedCount (loop));
+    CHECK_TRUE (dynamic_cast<CallExpr*> ((*source.analyzer->getLoopInvariants (loop))[0]) != nullptr);
+}
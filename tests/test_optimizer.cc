@@ -0,0 +1,146 @@
+#include    "analyzed_source.h"
+#include    "optimizer.h"
+
+#include    <CppUTest/TestHarness.h>
+
+
+TEST_GROUP (optimizer_test_group)
+{
+    AnalyzedSource source;
+
+    OptimizerStats
+    optimize (const std::string& code)
+    {
+        source = analyzeSource (code);
+        CHECK_TRUE (source.ok);
+
+        Optimizer opt (*source.analyzer);
+        return opt.optimize (source.program.get ());
+    }
+
+    BlockStmt*
+    body (size_t func = 0)
+    {
+        return source.program->functions[func]->body.get ();
+    }
+};
+
+
+TEST (optimizer_test_group, test_unused_variable_removed)
+{
+    auto stats = optimize ("int main() { int x = 1; int y = 2; x = 3; return y; }");
+
+    CHECK_EQUAL (1, stats.removedVariables);
+    CHECK_EQUAL (2u, body ()->statements.size ());
+    CHECK_TRUE (dynamic_cast<VarDecl*> (body ()->statements[0].get ()));
+    STRCMP_EQUAL ("y", static_cast<VarDecl*> (body ()->statements[0].get ())->name.c_str ());
+}
+
+TEST (optimizer_test_group, test_side_effect_initializer_kept)
+{
+    // Вызов функции с циклом не удаляется: завершение не доказано
+    auto stats = optimize (
+        "int f() { int i = 0; while (i < 3) { i++; } return i; } "
+        "int main() { int x = f(); return 0; }");
+
+    CHECK_EQUAL (0, stats.removedVariables);
+    CHECK_EQUAL (2u, body (1)->statements.size ());
+}
+
+TEST (optimizer_test_group, test_pure_call_initializer_removed)
+{
+    auto stats = optimize ("int f() { return 1; } int main() { int x = f(); return 0; }");
+
+    CHECK_EQUAL (1, stats.removedVariables);
+    CHECK_EQUAL (1, stats.removedFunctions);
+    CHECK_EQUAL (1u, body ()->statements.size ());
+}
+
+TEST (optimizer_test_group, test_unused_chain_removed)
+{
+    auto stats = optimize ("int main() { int a = 1; int b = a + 1; return 0; }");
+
+    CHECK_EQUAL (2, stats.removedVariables);
+    CHECK_EQUAL (1u, body ()->statements.size ());
+}
+
+TEST (optimizer_test_group, test_code_after_return_removed)
+{
+    auto stats = optimize ("int main() { int x = 1; return x; x = 2; return 0; }");
+
+    CHECK_EQUAL (2, stats.removedStatements);
+    CHECK_EQUAL (2u, body ()->statements.size ());
+    CHECK_TRUE (dynamic_cast<ReturnStmt*> (body ()->statements[1].get ()));
+}
+
+TEST (optimizer_test_group, test_code_after_break_removed)
+{
+    optimize ("int main() { int i = 0; while (i < 3) { i++; break; i = 5; } return i; }");
+
+    auto loop = dynamic_cast<WhileStmt*> (body ()->statements[1].get ());
+    CHECK_TRUE (loop);
+    CHECK_EQUAL (2u, static_cast<BlockStmt*> (loop->body.get ())->statements.size ());
+}
+
+TEST (optimizer_test_group, test_constant_condition_folded)
+{
+    auto stats = optimize (
+        "int main() { int x = 0; if (1 > 2) { x = 1; } else { x = 2; } return x; }");
+
+    CHECK_EQUAL (1, stats.foldedBranches);
+    CHECK_FALSE (dynamic_cast<IfStmt*> (body ()->statements[1].get ()));
+    CHECK_TRUE (dynamic_cast<BlockStmt*> (body ()->statements[1].get ()));
+}
+
+TEST (optimizer_test_group, test_unreachable_function_removed)
+{
+    auto stats = optimize (
+        "int used() { return 1; } int unused() { return 2; } "
+        "int main() { return used(); }");
+
+    CHECK_EQUAL (1, stats.removedFunctions);
+    CHECK_EQUAL (2u, source.program->functions.size ());
+    STRCMP_EQUAL ("used", source.program->functions[0]->name.c_str ());
+}
+
+TEST (optimizer_test_group, test_evaluate_constant)
+{
+    auto prog = parseSource ("int main() { return (3 + 4) * 2 == 14 && 10 / 3 == 3; }");
+    auto ret = static_cast<ReturnStmt*> (prog->functions[0]->body->statements[0].get ());
+
+    auto val = Optimizer::evaluateConstant (ret->value.get ());
+    CHECK_TRUE (val.has_value ());
+    CHECK_EQUAL (1LL, *val);
+}
+
+TEST (optimizer_test_group, test_evaluate_constant_wraps_int)
+{
+    auto evaluate = [] (const std::string& expr) {
+        auto prog = parseSource ("int main() { return " + expr + "; }");
+        auto ret = static_cast<ReturnStmt*> (prog->functions[0]->body->statements[0].get ());
+        return Optimizer::evaluateConstant (ret->value.get ());
+    };
+
+    // Как gcc -fwrapv: 2^32 -> 0, INT_MAX + 1 -> INT_MIN
+    CHECK_EQUAL (0LL, *evaluate ("65536 * 65536 != 0"));
+    CHECK_EQUAL (0LL, *evaluate ("2147483647 + 1 > 0"));
+    CHECK_EQUAL (-2147483647LL - 1, *evaluate ("2147483647 + 1"));
+    CHECK_EQUAL (-2147483647LL - 1, *evaluate ("-2147483647 - 1"));
+
+    // Не int и неопределённое поведение не сворачиваются
+    CHECK_FALSE (evaluate ("2147483648").has_value ());
+    CHECK_FALSE (evaluate ("9223372036854775807 + 1").has_value ());
+    CHECK_FALSE (evaluate ("(-2147483647 - 1) / -1").has_value ());
+    CHECK_FALSE (evaluate ("10 / 0").has_value ());
+
+    // / и % с отрицательными операндами в C и в Python (// и %) различаются
+    CHECK_EQUAL (3LL, *evaluate ("7 / 2"));
+    CHECK_EQUAL (1LL, *evaluate ("7 % 2"));
+    CHECK_FALSE (evaluate ("(0 - 7) % 2").has_value ());
+    CHECK_FALSE (evaluate ("(0 - 7) / 2").has_value ());
+    CHECK_FALSE (evaluate ("7 % -2").has_value ());
+
+    // Ведущий 0 - восьмеричная запись
+    CHECK_EQUAL (0LL, *evaluate ("0"));
+    CHECK_FALSE (evaluate ("010").has_value ());
+}
@@ -807,3 +807,32 @@ TEST (parser_test_group, test_prefix_postfix)
     CHECK_TRUE (unary != nullptr);
     CHECK_EQUAL ("++", unary->op);
 }
+
+TEST (parser_test_group, test_node_positions)
+{
+    createParser ("int f(int a) {\n"
+                  "    int s = 0;\n"
+                  "    if (a > 0) s = a; else if (a < 0) s = -a;\n"
+                  "    return s;\n"
+                  "}");
+
+    // Позиция узла - первый токен: строка и столбец с 1
+    auto func = pt->parseFunction ();
+    const auto& stmts = func->body->statements;
+    CHECK_EQUAL (2, stmts[0]->line);
+    CHECK_EQUAL (5, stmts[0]->column);
+
+    auto ifStmt = dynamic_cast<IfStmt*> (stmts[1].get ());
+    CHECK_EQUAL (3, ifStmt->line);
+    CHECK_EQUAL (9, ifStmt->condition->column);
+    CHECK_EQUAL (16, ifStmt->thenBranch->column);
+    CHECK_EQUAL (28, ifStmt->elseBranch->column);
+
+    auto elseIf = dynamic_cast<IfStmt*> (ifStmt->elseBranch.get ());
+    auto negate = dynamic_cast<ExpressionStmt*> (elseIf->thenBranch.get ());
+    auto assign = dynamic_cast<BinaryExpr*> (negate->expr.get ());
+    CHECK_EQUAL (39, assign->column);
+    CHECK_EQUAL (43, assign->rhs->column);
+
+    CHECK_EQUAL (4, stmts[2]->line);
+}
@@ -0,0 +1,267 @@
+#include    "pipeline.h"
+#include    "bytecode.h"
+
+#include    <algorithm>
+#include    <string>
+#include    <vector>
+
+#include    <CppUTest/TestHarness.h>
+
+
+TEST_GROUP (pipeline_test_group)
+{
+};
+
+
+TEST (pipeline_test_group, test_translate_text)
+{
+    TranslateOptions options;
+    options.sourceMap = true;
+    TranslateResult result = translateSource (
+        "int twice(int x) { return x + x; }\n"
+        "int main() {\n"
+        "    int a = twice(4);\n"
+        "    return a;\n"
+        "}\n", options);
+
+    CHECK_TRUE (result.ok);
+    CHECK_TRUE (result.errors.empty ());
+    CHECK_TRUE (result.output.find ("def main():") != std::string::npos);
+    CHECK_TRUE (result.output.find ("sys.exit(main())") != std::string::npos);
+
+    // Карта - по строке на строку вывода
+    size_t lines = std::count (result.output.begin (), result.output.end (), '\n');
+    CHECK_EQUAL (lines, result.sourceMap.lineCount ());
+}
+
+TEST (pipeline_test_group, test_errors_are_returned)
+{
+    // Синтаксическая ошибка не бросается, а попадает в errors
+    TranslateResult syntax = translateSource ("int main() { return 1 }");
+    CHECK_FALSE (syntax.ok);
+    CHECK_EQUAL (1u, syntax.errors.size ());
+    CHECK_TRUE (syntax.output.empty ());
+
+    TranslateResult semantic = translateSource ("int main() { return y; }");
+    CHECK_FALSE (semantic.ok);
+    CHECK_TRUE (semantic.errors[0].find ("'y'") != std::string::npos);
+
+    // Предупреждения не мешают трансляции
+    TranslateResult warning = translateSource ("int f(int a) { a = a + 1; } int main() { return 0; }");
+    CHECK_TRUE (warning.ok);
+    CHECK_EQUAL (1u, warning.warnings.size ());
+}
+
+TEST (pipeline_test_group, test_translate_bytecode)
+{
+    TranslateOptions options;
+    options.bytecode = true;
+    options.fileName = "prog.c";
+    TranslateResult result = translateSource ("int main() { return 7; }", options);
+
+    CHECK_TRUE (result.ok);
+    CHECK_TRUE (result.output.compare (0, 4, pycMagic, 4) == 0);
+    CHECK_TRUE (result.output.find ("prog.c") != std::string::npos);
+}
+
+TEST (pipeline_test_group, test_translator_reuse)
+{
+    const char* first = "int twice(int x) { return x + x; }\n"
+                        "int main() { return twice(3); }\n";
+    const char* second = "int main() { int k = 0; while (k < 4) { k++; } return k; }";
+    TranslateOptions options;
+    options.sourceMap = true;
+    Translator translator (options);
+
+    // Тот же результат, что и у однократной трансляции, при любом порядке входов
+    std::string expected = translateSource (first, options).output;
+    CHECK_EQUAL (expected, translator.translate (first).output);
+    CHECK_EQUAL (translateSource (second, options).output, translator.translate (second).output);
+
+    // Ошибка не оставляет следов: имена прошлой программы не видны
+    const TranslateResult& failed = translator.translate ("int main() { return twice(1); }");
+    CHECK_FALSE (failed.ok);
+    CHECK_TRUE (failed.output.empty ());
+    CHECK_TRUE (failed.errors[0].find ("twice") != std::string::npos);
+    CHECK_FALSE (translator.translate ("int main() { return 1 }").ok);
+
+    const TranslateResult& again = translator.translate (first);
+    CHECK_TRUE (again.ok);
+    CHECK_TRUE (again.errors.empty ());
+    CHECK_EQUAL (expected, again.output);
+    size_t lines = std::count (again.output.begin (), again.output.end (), '\n');
+    CHECK_EQUAL (lines, again.sourceMap.lineCount ());
+}
+
+TEST (pipeline_test_group, test_translator_batch)
+{
+    std::string first = "int main() { return 1; }";
+    std::string second = "int main() { return x; }";
+    Translator translator;
+    std::vector<TranslateResult> results = translator.translate ({ first, second, first });
+
+    CHECK_EQUAL (3u, results.size ());
+    CHECK_TRUE (results[0].ok);
+    CHECK_FALSE (results[1].ok);
+    CHECK_EQUAL (results[0].output, results[2].output);
+    CHECK_EQUAL (translateSource (first).output, results[2].output);
+}
+
+TEST (pipeline_test_group, test_progress_and_cancel)
+{
+    const char* code = "int twice(int x) { return x + x; }\n"
+                       "int main() { return twice(3); }\n";
+    Translator translator;
+
+    // Фазы по порядку; внутри анализа опрос повторяется
+    std::vector<TranslatePhase> phases;
+    CHECK_TRUE (translator.translate (code, [&](TranslatePhase phase) {
+        if (phases.empty () || phases.back () != phase) phases.push_back (phase);
+        return true;
+    }).ok);
+    std::vector<TranslatePhase> expected = { TranslatePhase::Lex, TranslatePhase::Parse,
+                                             TranslatePhase::Semantic, TranslatePhase::Inline,
+                                             TranslatePhase::Optimize, TranslatePhase::Generate };
+    CHECK_TRUE (phases == expected);
+    STRCMP_EQUAL ("semantic", phaseName (TranslatePhase::Semantic));
+
+    // Отмена посреди анализа: между функциями, без вывода
+    int polls = 0;
+    const TranslateResult& cancelled = translator.translate (code, [&](TranslatePhase phase) {
+        return phase != TranslatePhase::Semantic || ++polls < 3;
+    });
+    CHECK_FALSE (cancelled.ok);
+    CHECK_EQUAL (3, polls);
+    CHECK_TRUE (cancelled.output.empty ());
+    CHECK_EQUAL (std::string ("translation cancelled"), cancelled.errors.at (0));
+
+    // После отмены конвейер работает как новый
+    CHECK_EQUAL (translateSource (code).output, translator.translate (code).output);
+}
+
+TEST (pipeline_test_group, test_translator_reanalyzes_changed_functions)
+{
+    std::string helpers = "int mix(int a, int b) { int s = 0; for (int i = 0; i < a; i++) { s += b * i; } return s; }\n"
+                          "int scale(int x) { int r = x; while (r > 100) { r = r / 2; } return r; }\n";
+    std::string first = helpers + "int main() { return mix(3, 4) + scale(500); }\n";
+    std::string second = helpers + "int main() { int k = 2; return mix(k, 5) - scale(700); }\n";
+    Translator translator;
+
+    CHECK_TRUE (translator.translate (first).ok);
+    CHECK_EQUAL (0u, translator.reusedFunctions ());
+
+    // Изменилась только main: mix и scale переносятся, вывод - как у нового транслятора
+    const TranslateResult& changed = translator.translate (second);
+    CHECK_EQUAL (2u, translator.reusedFunctions ());
+    CHECK_EQUAL (translateSource (second).output, changed.output);
+
+    // Синтаксическая ошибка не сбрасывает прошлую программу
+    CHECK_FALSE (translator.translate ("int main() { return 1 }").ok);
+    CHECK_EQUAL (translateSource (first).output, translator.translate (first).output);
+    CHECK_EQUAL (2u, translator.reusedFunctions ());
+
+    // После отмены посреди анализа - полный анализ
+    int polls = 0;
+    translator.translate (second, [&] (TranslatePhase phase) {
+        return phase != TranslatePhase::Semantic || ++polls < 2;
+    });
+    CHECK_EQUAL (translateSource (second).output, translator.translate (second).output);
+    CHECK_EQUAL (0u, translator.reusedFunctions ());
+}
+
+TEST (pipeline_test_group, test_parallel_codegen_matches_sequential)
+{
+    // Функции с временными переменными, хвостовой рекурсией и выносом инвариантов
+    std::string code;
+    for (int k = 0; k < 24; ++k) {
+        std::string n = std::to_string (k);
+        code += "int f" + n + "(int a, int b) { int s = 0; for (int i = 0; i < a; i++) { s += b * " + n +
+                " + i; } if (s > 1000) return f" + n + "(a - 1, b); return s; }\n";
+    }
+    code += "int main() { int r = 0; for (int k = 0; k < 3; k++) { r += f0(k, 2) + f23(k, 3); } return r % 256; }\n";
+
+    TranslateOptions options;
+    options.sourceMap = true;
+    options.codegen.threads = 1;
+    TranslateResult sequential = translateSource (code, options);
+    options.codegen.threads = 4;
+    TranslateResult parallel = translateSource (code, options);
+
+    CHECK_TRUE (sequential.ok);
+    STRCMP_EQUAL (sequential.output.c_str (), parallel.output.c_str ());
+    STRCMP_EQUAL (sequential.sourceMap.encodeMappings ().c_str (), parallel.sourceMap.encodeMappings ().c_str ());
+}
+
+TEST (pipeline_test_group, test_memoize_pure_recursive)
+{
+    std::string code =
+        "int fib(int n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+        "int calls(int n) { if (n < 2) return 1; return calls(n - 1) + calls(n - 2) + 1; }\n"
+        "int sum(int n, int acc) { if (n == 0) return acc; return sum(n - 1, acc + n); }\n"
+        "int main() { return (fib(20) + calls(10) + sum(100, 0)) % 256; }\n";
+    const std::string decorator = "@functools.lru_cache(maxsize=None)\n";
+
+    TranslateResult plain = translateSource (code);
+    CHECK_TRUE (plain.ok);
+    CHECK_TRUE (plain.output.find (decorator) == std::string::npos);
+
+    TranslateOptions options;
+    options.codegen.memoizePureRecursive = true;
+    options.codegen.noMemoize.insert ("calls");
+    TranslateResult result = translateSource (code, options);
+    CHECK_TRUE (result.ok);
+    CHECK_TRUE (result.output.find ("import functools\n") != std::string::npos);
+    CHECK_TRUE (result.output.find (decorator + "def fib(") != std::string::npos);
+    // Исключённая функция и хвостовая рекурсия, ставшая циклом, - без кеша
+    CHECK_TRUE (result.output.find (decorator + "def calls(") == std::string::npos);
+    CHECK_TRUE (result.output.find ("def calls(") != std::string::npos);
+    CHECK_TRUE (result.output.find (decorator + "def sum(") == std::string::npos);
+    CHECK_TRUE (result.output.find ("while True:") != std::string::npos);
+}
+
+TEST (pipeline_test_group, test_bind_loop_globals)
+{
+    std::string code =
+        "int sq(int x) { return x * x; }\n"
+        "int total(int n) { int s = 0; for (int i = 0; i < n; i++) { for (int j = 0; j < i; j++) { s += sq(j); } } return s; }\n"
+        "int main() { return total(10) % 256; }\n";
+
+    TranslateOptions options;
+    options.inliner.enabled = false;
+    TranslateResult plain = translateSource (code, options);
+    CHECK_TRUE (plain.ok);
+    CHECK_TRUE (plain.output.find ("_c2py_") == std::string::npos);
+
+    options.codegen.bindLoopGlobals = true;
+    TranslateResult result = translateSource (code, options);
+    CHECK_TRUE (result.ok);
+    CHECK_TRUE (result.output.find ("def total(n):\n    _c2py_range = range\n    _c2py_sq = sq\n") != std::string::npos);
+    // Привязанное имя берут оба цикла, не только вложенный
+    CHECK_TRUE (result.output.find ("for i in _c2py_range(0, n):") != std::string::npos);
+    CHECK_TRUE (result.output.find ("for j in _c2py_range(0, i):") != std::string::npos);
+    CHECK_TRUE (result.output.find ("_c2py_sq(j)") != std::string::npos);
+    CHECK_TRUE (result.output.find (" sq(j)") == std::string::npos);
+    // Функции без циклов пролог не получают
+    CHECK_TRUE (result.output.find ("def main():\n    return ") != std::string::npos);
+}
+
+TEST (pipeline_test_group, test_bind_loop_globals_skips_tail_calls)
+{
+    // Хвостовой вызов стал циклом: сама функция не вызывается, её имя не привязывается
+    std::string code =
+        "int twice(int x) { return x * 2; }\n"
+        "int gcd(int a, int b) { if (b == 0) return a; return gcd(b, a % b); }\n"
+        "int walk(int n, int acc) { if (n == 0) return acc; return walk(n - 1, twice(acc)); }\n"
+        "int main() { return gcd(48, 18) + walk(3, 1); }\n";
+
+    TranslateOptions options;
+    options.inliner.enabled = false;
+    options.codegen.bindLoopGlobals = true;
+    TranslateResult result = translateSource (code, options);
+    CHECK_TRUE (result.ok);
+    CHECK_TRUE (result.output.find ("while True:") != std::string::npos);
+    CHECK_TRUE (result.output.find ("_c2py_gcd") == std::string::npos);
+    CHECK_TRUE (result.output.find ("_c2py_walk") == std::string::npos);
+    // Вызовы в аргументах хвостового вызова выполняются на каждой итерации
+    CHECK_TRUE (result.output.find ("def walk(n, acc):\n    _c2py_twice = twice\n") != std::string::npos);
+}
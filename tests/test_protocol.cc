@@ -0,0 +1,227 @@
+#include    "protocol.h"
+#include    "translation_server.h"
+
+#include    <cstdlib>
+#include    <filesystem>
+#include    <string>
+#include    <thread>
+#include    <sys/socket.h>
+#include    <sys/stat.h>
+#include    <unistd.h>
+
+#include    <CppUTest/TestHarness.h>
+
+
+TEST_GROUP (protocol_test_group)
+{
+    // Запрос и ответ по соединению
+    TranslateResult
+    exchange (int fd, const TranslateRequest& request)
+    {
+        std::string frame;
+        size_t pos = 0;
+        TranslateResult result;
+        CHECK_TRUE (writeFrame (fd, encodeRequest (request)));
+        CHECK_TRUE (readFrame (fd, frame));
+        CHECK_TRUE (decodeResult (frame, pos, result));
+        return result;
+    }
+};
+
+
+TEST (protocol_test_group, test_result_round_trip)
+{
+    TranslateResult result;
+    result.ok = true;
+    result.output = std::string ("def main():\n    return 0\n\0tail", 30);
+    result.warnings.push_back ("unused variable 'x'");
+    result.sourceMap.addLine (SourcePosition ());
+    result.sourceMap.addLine ({ 3, 5 });
+    result.sourceMap.addLine (SourcePosition ());
+
+    std::string data = "prefix";
+    encodeResult (data, result);
+    size_t pos = 6;
+    TranslateResult decoded;
+    CHECK_TRUE (decodeResult (data, pos, decoded));
+    CHECK_EQUAL (data.size (), pos);
+    CHECK_TRUE (decoded.ok);
+    CHECK_TRUE (decoded.output == result.output);
+    CHECK_TRUE (decoded.warnings == result.warnings);
+    CHECK_EQUAL (3u, decoded.sourceMap.lineCount ());
+    CHECK_EQUAL (3, decoded.sourceMap.lookup (2).line);
+
+    // Обрезанные данные - ошибка, а не чтение за концом
+    for (size_t size = 6; size < data.size (); ++size) {
+        size_t at = 6;
+        CHECK_FALSE (decodeResult (data.substr (0, size), at, decoded));
+    }
+}
+
+TEST (protocol_test_group, test_request_round_trip)
+{
+    TranslateRequest request;
+    request.options.bytecode = true;
+    request.options.inliner.enabled = false;
+    request.options.fileName = "prog.c";
+    request.code = "int main() { return 0; }";
+
+    TranslateRequest decoded;
+    CHECK_TRUE (decodeRequest (encodeRequest (request), decoded));
+    CHECK_TRUE (decoded.kind == RequestKind::Translate);
+    CHECK_TRUE (decoded.options.bytecode);
+    CHECK_FALSE (decoded.options.sourceMap);
+    CHECK_FALSE (decoded.options.inliner.enabled);
+    CHECK_TRUE (decoded.options.optimize);
+    CHECK_TRUE (decoded.options.fileName == "prog.c");
+    CHECK_TRUE (decoded.code == request.code);
+    CHECK_FALSE (decoded.options.codegen.memoizePureRecursive);
+
+    // Список исключений передаётся вместе с флагом кеширования
+    request.options.codegen.memoizePureRecursive = true;
+    request.options.codegen.noMemoize = { "fib", "ack" };
+    CHECK_TRUE (decodeRequest (encodeRequest (request), decoded));
+    CHECK_TRUE (decoded.options.codegen.memoizePureRecursive);
+    CHECK_EQUAL (2, decoded.options.codegen.noMemoize.size ());
+    CHECK_EQUAL (1, decoded.options.codegen.noMemoize.count ("ack"));
+    CHECK_FALSE (decoded.options.codegen.bindLoopGlobals);
+    request.options.codegen.bindLoopGlobals = true;
+    CHECK_TRUE (decodeRequest (encodeRequest (request), decoded));
+    CHECK_TRUE (decoded.options.codegen.bindLoopGlobals);
+    CHECK_TRUE (decoded.code == request.code);
+
+    // Неизвестный вид и лишние байты
+    std::string bad = encodeRequest (request);
+    bad[0] = 7;
+    CHECK_FALSE (decodeRequest (bad, decoded));
+    CHECK_FALSE (decodeRequest (encodeRequest (request) + "x", decoded));
+}
+
+TEST (protocol_test_group, test_frames)
+{
+    int fds[2];
+    CHECK_EQUAL (0, socketpair (AF_UNIX, SOCK_STREAM, 0, fds));
+
+    std::string big (100000, 'z');
+    CHECK_TRUE (writeFrame (fds[0], "first"));
+    CHECK_TRUE (writeFrame (fds[0], ""));
+    std::thread writer ([&] { writeFrame (fds[0], big); });
+
+    std::string frame;
+    CHECK_TRUE (readFrame (fds[1], frame));
+    CHECK_TRUE (frame == "first");
+    CHECK_TRUE (readFrame (fds[1], frame));
+    CHECK_TRUE (frame.empty ());
+    CHECK_TRUE (readFrame (fds[1], frame));
+    CHECK_TRUE (frame == big);
+    writer.join ();
+
+    // Заголовок больше предела не приводит к выделению памяти
+    const char huge[4] = { '\xff', '\xff', '\xff', '\xff' };
+    CHECK_EQUAL (4, write (fds[0], huge, 4));
+    CHECK_FALSE (readFrame (fds[1], frame));
+
+    // Конец потока
+    close (fds[0]);
+    CHECK_FALSE (readFrame (fds[1], frame));
+    close (fds[1]);
+}
+
+TEST (protocol_test_group, test_server)
+{
+    char dir[] = "/tmp/c2py_server_test_XXXXXX";
+    CHECK_TRUE (mkdtemp (dir) != nullptr);
+    std::string socketPath = std::string (dir) + "/c2py.sock";
+
+    TranslationServer server (socketPath, nullptr, 2);
+    CHECK_TRUE (server.listen ());
+    std::thread running ([&] { server.run (); });
+
+    // Второй сервер на том же сокете не запускается
+    TranslationServer second (socketPath);
+    CHECK_FALSE (second.listen ());
+
+    int fd = connectSocket (socketPath);
+    CHECK_TRUE (fd >= 0);
+
+    TranslateRequest request;
+    request.options.sourceMap = true;
+    request.code = "int main() { return 3; }";
+    TranslateResult result = exchange (fd, request);
+    CHECK_TRUE (result.ok);
+    CHECK_TRUE (result.output == translateSource (request.code, request.options).output);
+    CHECK_TRUE (result.sourceMap.lineCount () > 0);
+
+    // Соединение держит несколько запросов; ошибка трансляции - в ответе
+    request.code = "int main() { return y; }";
+    result = exchange (fd, request);
+    CHECK_FALSE (result.ok);
+    CHECK_FALSE (result.errors.empty ());
+
+    // Конвейеры переиспользуются между запросами: вывод - как у однократной
+    // трансляции, в том числе после ошибки, с другими параметрами и именем файла
+    request.code = "int f(int a) { return a * 2; } int main() { return f(3); }";
+    result = exchange (fd, request);
+    CHECK_TRUE (result.ok);
+    CHECK_TRUE (result.output == translateSource (request.code, request.options).output);
+    request.options.sourceMap = false;
+    request.options.bytecode = true;
+    for (const char* name : { "first.c", "second.c" }) {
+        request.options.fileName = name;
+        result = exchange (fd, request);
+        CHECK_TRUE (result.ok);
+        CHECK_TRUE (result.output == translateSource (request.code, request.options).output);
+    }
+
+    // Открытое соединение не мешает другим клиентам
+    int other = connectSocket (socketPath);
+    CHECK_TRUE (other >= 0);
+    TranslateRequest shutdown;
+    shutdown.kind = RequestKind::Shutdown;
+    CHECK_TRUE (exchange (other, shutdown).ok);
+    close (other);
+
+    // Остановка закрывает и ждущие соединения
+    running.join ();
+    std::string frame;
+    CHECK_FALSE (readFrame (fd, frame));
+    close (fd);
+
+    CHECK_EQUAL (6u, server.stats ().requests);
+    CHECK_EQUAL (1u, server.stats ().failed);
+    std::filesystem::remove_all (dir);
+}
+
+TEST (protocol_test_group, test_socket_directory)
+{
+    char dir[] = "/tmp/c2py_server_test_XXXXXX";
+    CHECK_TRUE (mkdtemp (dir) != nullptr);
+
+    // Недостающий каталог создаётся закрытым
+    std::string inner = std::string (dir) + "/run";
+    CHECK_FALSE (checkSocketDirectory (inner + "/c2py.sock", false));
+    CHECK_TRUE (checkSocketDirectory (inner + "/c2py.sock", true));
+    struct stat info;
+    CHECK_EQUAL (0, stat (inner.c_str (), &info));
+    CHECK_EQUAL (0700, (int) (info.st_mode & 0777));
+
+    // Каталог, открытый другим, сервер не принимает
+    chmod (inner.c_str (), 0755);
+    CHECK_FALSE (checkSocketDirectory (inner + "/c2py.sock", true));
+    TranslationServer server (inner + "/c2py.sock");
+    CHECK_FALSE (server.listen ());
+
+    // Сокет создаётся сразу без прав для группы и остальных
+    chmod (inner.c_str (), 0700);
+    TranslationServer open (inner + "/c2py.sock");
+    CHECK_TRUE (open.listen ());
+    CHECK_EQUAL (0, stat ((inner + "/c2py.sock").c_str (), &info));
+    CHECK_EQUAL (0, (int) (info.st_mode & 077));
+
+    int fds[2];
+    CHECK_EQUAL (0, socketpair (AF_UNIX, SOCK_STREAM, 0, fds));
+    CHECK_TRUE (peerIsSameUser (fds[0]));
+    close (fds[0]);
+    close (fds[1]);
+    std::filesystem::remove_all (dir);
+}
@@ -0,0 +1,159 @@
+#include    "analyzed_source.h"
+#include    "bytecode.h"
+#include    "pyc_generator.h"
+
+#include    <cstdio>
+#include    <cstdlib>
+#include    <fstream>
+#include    <string>
+#include    <sys/wait.h>
+#include    <unistd.h>
+
+#include    <CppUTest/TestHarness.h>
+
+
+TEST_GROUP (pyc_generator_test_group)
+{
+    AnalyzedSource source;
+
+    std::string
+    compile (const std::string& code)
+    {
+        source = analyzeSource (code);
+        CHECK_TRUE (source.ok);
+
+        PycGenerator generator (source.analyzer.get ());
+        return generator.generate (source.program.get (), "test.c");
+    }
+
+    // Интерпретатор для проверки .pyc: PYTHON или python3, только 3.11
+    std::string
+    python ()
+    {
+        const char* env = std::getenv ("PYTHON");
+        std::string interpreter = env ? env : "python3";
+        std::string probe = interpreter + " -c \"import sys; sys.exit(sys.version_info[:2] != (3, 11))\""
+                            " > /dev/null 2>&1";
+        return std::system (probe.c_str ()) == 0 ? interpreter : std::string ();
+    }
+
+    // Код завершения python file.pyc
+    int
+    run (const std::string& interpreter, const std::string& pyc)
+    {
+        char path[] = "/tmp/c2py_pyc_test_XXXXXX";
+        int fd = mkstemp (path);
+        CHECK_TRUE (fd >= 0);
+        close (fd);
+        std::string file = std::string (path) + ".pyc";
+        std::ofstream (file, std::ios::binary) << pyc;
+
+        int status = std::system ((interpreter + " " + file).c_str ());
+        std::remove (file.c_str ());
+        std::remove (path);
+        return WIFEXITED (status) ? WEXITSTATUS (status) : -1;
+    }
+};
+
+
+TEST (pyc_generator_test_group, test_marshal_constants)
+{
+    MarshalWriter small;
+    small.writeConst (PyConst::makeInt (-2));
+    CHECK_EQUAL (5u, small.data ().size ());
+    CHECK_TRUE (small.data () == std::string ("i\xfe\xff\xff\xff", 5));
+
+    // 2^31 не помещается в int32: 15-битные цифры 0, 0, 2
+    MarshalWriter large;
+    large.writeConst (PyConst::makeInt (0x80000000LL));
+    CHECK_TRUE (large.data () == std::string ("l\x03\x00\x00\x00\x00\x00\x00\x00\x02\x00", 11));
+
+    MarshalWriter text;
+    text.writeConst (PyConst::makeString ("__main__"));
+    CHECK_TRUE (text.data () == std::string ("z\x08__main__", 10));
+
+    // 1, 1.0 и True - разные элементы co_consts
+    CHECK_FALSE (PyConst::makeInt (1).sameAs (PyConst::makeFloat (1.0)));
+    CHECK_FALSE (PyConst::makeInt (1).sameAs (PyConst::makeBool (true)));
+    CHECK_TRUE (PyConst::makeFloat (2.5).sameAs (PyConst::makeFloat (2.5)));
+}
+
+TEST (pyc_generator_test_group, test_jump_direction_and_extended_arg)
+{
+    BytecodeAssembler as ("f", "test.c", 1);
+    BytecodeAssembler::Label top = as.newLabel (), end = as.newLabel ();
+    as.emit (PyOp::RESUME, 0);
+    as.bind (top);
+    as.emit (PyOp::LOAD_CONST, as.addConst (PyConst::makeBool (true)));
+    as.emitJump (BytecodeAssembler::IfFalse, end);
+    // Тело длиннее 255 единиц кода: обоим переходам нужен EXTENDED_ARG
+    for (int i = 0; i < 300; ++i) {
+        as.emit (PyOp::NOP);
+    }
+    as.emitJump (BytecodeAssembler::Always, top);
+    as.bind (end);
+    as.emit (PyOp::LOAD_CONST, as.addConst (PyConst ()));
+    as.emit (PyOp::RETURN_VALUE);
+
+    PyCode code = as.assemble (0, CO_OPTIMIZED | CO_NEWLOCALS);
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*> (code.code.data ());
+    CHECK_EQUAL (1, code.stackSize);
+
+    // RESUME, LOAD_CONST, EXTENDED_ARG 1, POP_JUMP_FORWARD_IF_FALSE: 302 единицы до end
+    CHECK_EQUAL ((int) PyOp::EXTENDED_ARG, bytes[4]);
+    CHECK_EQUAL ((int) PyOp::POP_JUMP_FORWARD_IF_FALSE, bytes[6]);
+    CHECK_EQUAL (302, bytes[5] * 256 + bytes[7]);
+
+    // Переход назад на LOAD_CONST: смещение считается от следующей инструкции
+    size_t back = 8 + 300 * 2;
+    CHECK_EQUAL ((int) PyOp::EXTENDED_ARG, bytes[back]);
+    CHECK_EQUAL ((int) PyOp::JUMP_BACKWARD, bytes[back + 2]);
+    CHECK_EQUAL (305, bytes[back + 1] * 256 + bytes[back + 3]);
+}
+
+TEST (pyc_generator_test_group, test_header_and_module)
+{
+    std::string pyc = compile ("int main() { return 3; }");
+
+    CHECK_TRUE (pyc.size () > 16);
+    CHECK_TRUE (pyc.compare (0, 4, pycMagic, 4) == 0);
+    CHECK_TRUE (pyc.compare (4, 12, std::string (12, '\0')) == 0);
+    CHECK_EQUAL ('c', pyc[16]);
+    // Имя исходника - в co_filename
+    CHECK_TRUE (pyc.find ("test.c") != std::string::npos);
+}
+
+TEST (pyc_generator_test_group, test_unsupported_construct)
+{
+    // Присваивание результату вызова не транслируется
+    ProgramPtr program = parseSource ("int f() { return 1; } int main() { f() = 2; return 0; }");
+
+    PycGenerator generator;
+    CHECK_THROWS (std::runtime_error, generator.generate (program.get ()));
+}
+
+TEST (pyc_generator_test_group, test_runs_under_python)
+{
+    std::string interpreter = python ();
+    if (interpreter.empty ()) return;   // Нет CPython 3.11 - проверять нечем
+
+    CHECK_EQUAL (55, run (interpreter, compile (
+        "int main() { int s = 0; for (int i = 1; i <= 10; i++) { s = s + i; } return s; }")));
+
+    CHECK_EQUAL (21, run (interpreter, compile (
+        "int gcd(int a, int b) { if (b == 0) return a; return gcd(b, a % b); }"
+        " int main() { return gcd(1071, 462); }")));
+
+    // break, continue, do-while и ранний return из вложенных range()
+    CHECK_EQUAL (57, run (interpreter, compile (
+        "int find(int n) { for (int i = 0; i < n; i++) { for (int j = 0; j < n; j++) {"
+        "   if (i * j == 12) return i * 10 + j; } } return 0; }"
+        " int main() { int s = 0; int k = 0;"
+        "   do { k = k + 1; if (k % 2 == 0) continue; s = s + k; } while (k < 10);"
+        "   for (;;) { s = s + 1; if (s > 30) break; }"
+        "   return find(10) + s; }")));
+
+    // Переполнение int, как в тексте: маска там, где анализ не исключил выход за 32 бита
+    CHECK_EQUAL (0, run (interpreter, compile (
+        "int main() { int x = 65536; int y = x * x; if (y == 0) return 0; return 1; }")));
+}
@@ -0,0 +1,128 @@
+#include    "analyzed_source.h"
+#include    "range_analysis.h"
+
+#include    <CppUTest/TestHarness.h>
+
+
+TEST_GROUP (range_analysis_test_group)
+{
+    AnalyzedSource source;
+
+    void
+    analyze (const std::string& code)
+    {
+        source = analyzeSource (code);
+        CHECK_TRUE (source.ok);
+    }
+
+    Statement*
+    stmt (size_t i)
+    {
+        return source.program->functions.back ()->body->statements[i].get ();
+    }
+
+    const ValueRange*
+    range (size_t i)
+    {
+        return source.analyzer->getValueRange (stmt (i));
+    }
+
+    Expression*
+    init (size_t i)
+    {
+        return static_cast<VarDecl*> (stmt (i))->init.get ();
+    }
+};
+
+
+TEST (range_analysis_test_group, test_constant_arithmetic)
+{
+    analyze ("int main() { int a = 7; int b = a * 3 - 1; return b; }");
+
+    CHECK_EQUAL (20, range (1)->lo);
+    CHECK_EQUAL (20, range (1)->hi);
+    CHECK_FALSE (source.analyzer->mayOverflow (init (1)));
+}
+
+TEST (range_analysis_test_group, test_overflowing_constant)
+{
+    analyze ("int main() { int a = 2147483647; int b = a + 1; return b; }");
+
+    CHECK_TRUE (source.analyzer->mayOverflow (init (1)));
+    CHECK_TRUE (*range (1) == ValueRange::full ());
+}
+
+TEST (range_analysis_test_group, test_parameters_unbounded)
+{
+    analyze ("int f(int x) { int y = x / 2; int z = x + 1; return y + z; }");
+
+    CHECK_FALSE (source.analyzer->mayOverflow (init (0)));
+    CHECK_TRUE (source.analyzer->mayOverflow (init (1)));
+}
+
+TEST (range_analysis_test_group, test_loop_counter_bounded)
+{
+    analyze (
+        "int main() { int s = 0; int i = 0; "
+        "for (i = 0; i < 100; i++) { s = i * 2; } return s; }");
+
+    CHECK_EQUAL (0, range (1)->lo);
+    CHECK_EQUAL (100, range (1)->hi);
+    CHECK_EQUAL (0, range (0)->lo);
+    CHECK_EQUAL (198, range (0)->hi);
+}
+
+TEST (range_analysis_test_group, test_counter_guarded_by_parameter)
+{
+    // i < n <= INT_MAX, поэтому i++ не переполняется
+    analyze (
+        "int f(int n) { int s = 0; int i; "
+        "for (i = 0; i < n; i++) { s = i; } return s; }");
+
+    auto loop = static_cast<ForStmt*> (stmt (2));
+    CHECK_FALSE (source.analyzer->mayOverflow (loop->update.get ()));
+    CHECK_EQUAL (0, range (1)->lo);
+}
+
+TEST (range_analysis_test_group, test_counter_guarded_in_body)
+{
+    // В теле i < n <= INT_MAX: i + 1 не переполняется, во вложенном цикле - j + 1
+    analyze (
+        "int f(int n) { int s = 0; int i; "
+        "for (i = 0; i < n; i++) { s = i + 1; for (int j = 0; j < i; j++) { s = j + 1; } } "
+        "for (i = n; i > 0; i--) { s = i - 1; } return s; }");
+
+    auto loop = static_cast<ForStmt*> (stmt (2));
+    auto body = static_cast<BlockStmt*> (loop->body.get ());
+    auto store = static_cast<ExpressionStmt*> (body->statements[0].get ());
+    CHECK_FALSE (source.analyzer->mayOverflow (static_cast<BinaryExpr*> (store->expr.get ())->rhs.get ()));
+    auto inner = static_cast<ForStmt*> (body->statements[1].get ());
+    auto innerStore = static_cast<ExpressionStmt*> (static_cast<BlockStmt*> (inner->body.get ())->statements[0].get ());
+    CHECK_FALSE (source.analyzer->mayOverflow (static_cast<BinaryExpr*> (innerStore->expr.get ())->rhs.get ()));
+
+    auto down = static_cast<ForStmt*> (stmt (3));
+    auto downStore = static_cast<ExpressionStmt*> (static_cast<BlockStmt*> (down->body.get ())->statements[0].get ());
+    CHECK_FALSE (source.analyzer->mayOverflow (static_cast<BinaryExpr*> (downStore->expr.get ())->rhs.get ()));
+}
+
+TEST (range_analysis_test_group, test_counter_written_in_body)
+{
+    // Счётчик, изменяемый в теле, - не индуктивная переменная: условие не сужает его
+    analyze (
+        "int f(int n) { int s = 0; int i; "
+        "for (i = 0; i < n; i++) { i = i + 1; s = i + 1; } return s; }");
+
+    auto loop = static_cast<ForStmt*> (stmt (2));
+    auto body = static_cast<BlockStmt*> (loop->body.get ());
+    auto store = static_cast<ExpressionStmt*> (body->statements[1].get ());
+    CHECK_TRUE (source.analyzer->mayOverflow (static_cast<BinaryExpr*> (store->expr.get ())->rhs.get ()));
+}
+
+TEST (range_analysis_test_group, test_accumulator_widened)
+{
+    analyze (
+        "int main() { int s = 1; int k = 0; "
+        "while (k < 10) { s = s * 2; k++; } return s; }");
+
+    CHECK_TRUE (*range (0) == ValueRange::full ());
+}
@@ -0,0 +1,91 @@
+#include    "source_map.h"
+
+#include    <stdexcept>
+#include    <string>
+
+#include    <CppUTest/TestHarness.h>
+
+
+TEST_GROUP (source_map_test_group)
+{
+    SourceMap
+    sample ()
+    {
+        SourceMap map;
+        map.addLine ({ 1, 1 });
+        map.addLine ({});
+        map.addLine ({ 2, 5 });
+        map.addLine ({ 2, 9 });
+        map.addLine ({ 1, 1 });
+        return map;
+    }
+};
+
+
+TEST (source_map_test_group, test_encode_mappings)
+{
+    // Сегмент на строку: столбец вывода, исходник, разности строки и столбца
+    STRCMP_EQUAL ("AAAA;;AACI;AAAI;AADR", sample ().encodeMappings ().c_str ());
+
+    // Разность больше 15 - две цифры VLQ
+    SourceMap wide;
+    wide.addLine ({ 1, 40 });
+    STRCMP_EQUAL ("AAAuC", wide.encodeMappings ().c_str ());
+}
+
+TEST (source_map_test_group, test_decode_round_trip)
+{
+    SourceMap map = SourceMap::decodeMappings (sample ().encodeMappings ());
+    CHECK_EQUAL (5u, map.lineCount ());
+    CHECK_EQUAL (0, map.lookup (2).line);
+    CHECK_EQUAL (2, map.lookup (4).line);
+    CHECK_EQUAL (9, map.lookup (4).column);
+    CHECK_EQUAL (1, map.lookup (5).column);
+    CHECK_EQUAL (0, map.lookup (6).line);
+
+    // Несколько сегментов в строке: позиция - первый, разности копятся по всем
+    SourceMap multi = SourceMap::decodeMappings ("AAAA,EAAE;AACA");
+    CHECK_EQUAL (1, multi.lookup (1).column);
+    CHECK_EQUAL (2, multi.lookup (2).line);
+    CHECK_EQUAL (3, multi.lookup (2).column);
+
+    CHECK_THROWS (std::runtime_error, SourceMap::decodeMappings ("AA!A"));
+}
+
+TEST (source_map_test_group, test_json_and_header)
+{
+    SourceMap map = sample ();
+    map.prependLines (2);
+    std::string json = map.toJson ("prog.py", "dir/\"q\".c");
+
+    std::string source, generated;
+    SourceMap parsed = SourceMap::fromJson (json, &source, &generated);
+    STRCMP_EQUAL ("dir/\"q\".c", source.c_str ());
+    STRCMP_EQUAL ("prog.py", generated.c_str ());
+    CHECK_EQUAL (7u, parsed.lineCount ());
+    CHECK_EQUAL (0, parsed.lookup (1).line);
+    CHECK_EQUAL (5, parsed.lookup (5).column);
+
+    CHECK_THROWS (std::runtime_error, SourceMap::fromJson ("{\"version\":2,\"mappings\":\"\"}"));
+}
+
+TEST (source_map_test_group, test_remap_locations)
+{
+    SourceMap map = sample ();
+
+    std::string traceback =
+        "Traceback (most recent call last):\n"
+        "  File \"/tmp/out/prog.py\", line 3, in f\n"
+        "  File \"/tmp/out/prog.py\", line 2, in <module>\n"
+        "  File \"/tmp/out/myprog.py\", line 3, in g\n";
+    STRCMP_EQUAL ("Traceback (most recent call last):\n"
+                  "  File \"prog.c\", line 2, column 5, in f\n"
+                  "  File \"/tmp/out/prog.py\", line 2, in <module>\n"
+                  "  File \"/tmp/out/myprog.py\", line 3, in g\n",
+                  remapLocations (traceback, map, "prog.py", "prog.c").c_str ());
+
+    // cProfile и py-spy
+    STRCMP_EQUAL ("      10    0.001    0.000    0.002    0.000 prog.c:2:9(f)\nf (prog.c:1:1)",
+                  remapLocations ("      10    0.001    0.000    0.002    0.000 prog.py:4(f)\n"
+                                  "f (./prog.py:5)", map, "out/prog.py", "prog.c").c_str ());
+}
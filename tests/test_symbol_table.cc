@@ -158,3 +158,18 @@ IGNORE_TEST (symbol_table_test_group, test_lookup_identifier_shadowing)
     st.popScope();
     CHECK (st.lookup("THE_SAME_IDENTIFIER") == &node_A);
 }
+
+TEST (symbol_table_test_group, test_reopened_scope_is_empty)
+{
+    SymbolTable st;
+    ASTNode astnode;
+
+    // Новая область может занять таблицу закрытой, но без её имён
+    st.pushScope();
+    st.declare("INNER", &astnode);
+    st.popScope();
+    st.pushScope();
+    CHECK (st.depth() == 2);
+    CHECK (st.lookup("INNER") == nullptr);
+    CHECK_FALSE (st.isDeclaredInCurrentScope("INNER"));
+}
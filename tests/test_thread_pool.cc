@@ -0,0 +1,66 @@
+#include    "thread_pool.h"
+
+#include    <atomic>
+#include    <stdexcept>
+#include    <vector>
+
+#include    <CppUTest/TestHarness.h>
+
+
+TEST_GROUP (thread_pool_test_group)
+{
+};
+
+
+TEST (thread_pool_test_group, test_results_in_own_slots)
+{
+    ThreadPool pool (4);
+    CHECK_EQUAL (4u, pool.size ());
+
+    std::vector<int> squares (100);
+    for (size_t i = 0; i < squares.size (); ++i) {
+        pool.submit ([&squares, i] { squares[i] = (int) (i * i); });
+    }
+    pool.wait ();
+
+    for (size_t i = 0; i < squares.size (); ++i) {
+        CHECK_EQUAL ((int) (i * i), squares[i]);
+    }
+}
+
+TEST (thread_pool_test_group, test_reuse_after_wait)
+{
+    ThreadPool pool (2);
+    std::atomic<int> counter (0);
+
+    for (int round = 1; round <= 3; ++round) {
+        for (int i = 0; i < 10; ++i) {
+            pool.submit ([&counter] { ++counter; });
+        }
+        pool.wait ();
+        CHECK_EQUAL (round * 10, counter.load ());
+    }
+}
+
+TEST (thread_pool_test_group, test_exception_rethrown_by_wait)
+{
+    ThreadPool pool (2);
+    std::atomic<int> finished (0);
+
+    pool.submit ([] { throw std::runtime_error ("task failed"); });
+    for (int i = 0; i < 5; ++i) {
+        pool.submit ([&finished] { ++finished; });
+    }
+    CHECK_THROWS (std::runtime_error, pool.wait ());
+    // Остальные задачи всё равно выполнены, ошибка сообщается один раз
+    CHECK_EQUAL (5, finished.load ());
+    pool.wait ();
+}
+
+TEST (thread_pool_test_group, test_default_threads)
+{
+    CHECK_TRUE (ThreadPool::defaultThreads () >= 1);
+
+    ThreadPool pool;
+    CHECK_EQUAL (ThreadPool::defaultThreads (), pool.size ());
+}
@@ -0,0 +1,196 @@
+#include    "translation_cache.h"
+
+#include    <chrono>
+#include    <cstdlib>
+#include    <filesystem>
+#include    <fstream>
+#include    <string>
+
+#include    <CppUTest/TestHarness.h>
+
+namespace fs = std::filesystem;
+
+
+TEST_GROUP (translation_cache_test_group)
+{
+    std::string dir;
+
+    void
+    setup ()
+    {
+        char path[] = "/tmp/c2py_cache_test_XXXXXX";
+        CHECK_TRUE (mkdtemp (path) != nullptr);
+        dir = path;
+    }
+
+    void
+    teardown ()
+    {
+        std::error_code error;
+        fs::remove_all (dir, error);
+    }
+
+    // Файл записи по ключу (раскладка каталога - деталь кеша, ищем по имени)
+    fs::path
+    entryFile (const std::string& key)
+    {
+        for (const auto& entry : fs::recursive_directory_iterator (dir)) {
+            if (entry.path ().filename ().string ().find (key.substr (2)) == 0) return entry.path ();
+        }
+        return fs::path ();
+    }
+
+    TranslateResult
+    fakeResult (char fill)
+    {
+        TranslateResult result;
+        result.ok = true;
+        result.output = std::string (1000, fill);
+        return result;
+    }
+};
+
+
+TEST (translation_cache_test_group, test_key_depends_on_input_and_options)
+{
+    TranslateOptions options;
+    std::string key = TranslationCache::keyFor ("int main() { return 0; }", options);
+    CHECK_EQUAL (32u, key.size ());
+    CHECK_TRUE (key == TranslationCache::keyFor ("int main() { return 0; }", options));
+    CHECK_TRUE (key != TranslationCache::keyFor ("int main() { return 1; }", options));
+
+    TranslateOptions noInline = options;
+    noInline.inliner.enabled = false;
+    CHECK_TRUE (key != TranslationCache::keyFor ("int main() { return 0; }", noInline));
+
+    TranslateOptions noMemoize = options;
+    noMemoize.codegen.noMemoize.insert ("f");
+    CHECK_TRUE (key != TranslationCache::keyFor ("int main() { return 0; }", noMemoize));
+
+    // Число потоков и имя файла текста не меняют
+    TranslateOptions same = options;
+    same.codegen.threads = 8;
+    same.fileName = "other.c";
+    CHECK_TRUE (key == TranslationCache::keyFor ("int main() { return 0; }", same));
+
+    // В .pyc имя файла записано
+    TranslateOptions pyc = options;
+    pyc.bytecode = true;
+    TranslateOptions pycOther = pyc;
+    pycOther.fileName = "other.c";
+    CHECK_TRUE (TranslationCache::keyFor ("int main() { return 0; }", pyc) !=
+                TranslationCache::keyFor ("int main() { return 0; }", pycOther));
+}
+
+TEST (translation_cache_test_group, test_round_trip)
+{
+    TranslationCache cache (dir);
+    TranslateOptions options;
+    options.sourceMap = true;
+    const char* code = "int twice(int x) { return x + x; }\n"
+                       "int main() {\n"
+                       "    return twice(3);\n"
+                       "}\n";
+
+    TranslateResult first = cache.translate (code, options);
+    TranslateResult second = cache.translate (code, options);
+    CHECK_TRUE (second.ok);
+    CHECK_TRUE (first.output == second.output);
+    CHECK_EQUAL (first.sourceMap.lineCount (), second.sourceMap.lineCount ());
+    CHECK_TRUE (first.sourceMap.encodeMappings () == second.sourceMap.encodeMappings ());
+
+    // Ошибки тоже кешируются
+    TranslateResult failed = cache.translate ("int main() { return y; }", options);
+    TranslateResult failedAgain = cache.translate ("int main() { return y; }", options);
+    CHECK_FALSE (failedAgain.ok);
+    CHECK_TRUE (failed.errors == failedAgain.errors);
+
+    CacheStats stats = cache.stats ();
+    CHECK_EQUAL (2u, stats.hits);
+    CHECK_EQUAL (2u, stats.misses);
+    CHECK_EQUAL (2u, stats.stores);
+}
+
+TEST (translation_cache_test_group, test_corrupt_entry_is_miss)
+{
+    TranslationCache cache (dir);
+    std::string key = TranslationCache::keyFor ("x", TranslateOptions ());
+    CHECK_TRUE (cache.store (key, fakeResult ('a')));
+
+    fs::path file = entryFile (key);
+    CHECK_FALSE (file.empty ());
+    {
+        std::fstream stream (file, std::ios::in | std::ios::out | std::ios::binary);
+        stream.seekp (100);
+        stream.put ('b');
+    }
+
+    TranslateResult result;
+    CHECK_FALSE (cache.load (key, result));
+    CHECK_FALSE (fs::exists (file));
+
+    // Обрезанная запись - тоже промах
+    CHECK_TRUE (cache.store (key, fakeResult ('a')));
+    fs::resize_file (entryFile (key), 20);
+    CHECK_FALSE (cache.load (key, result));
+    CHECK_EQUAL (2u, cache.stats ().misses);
+}
+
+TEST (translation_cache_test_group, test_lru_eviction)
+{
+    std::string keys[4];
+    {
+        TranslationCache fill (dir);
+        auto now = fs::file_time_type::clock::now ();
+        for (int i = 0; i < 4; ++i) {
+            keys[i] = TranslationCache::keyFor (std::string (1, (char) ('a' + i)), TranslateOptions ());
+            CHECK_TRUE (fill.store (keys[i], fakeResult ((char) ('a' + i))));
+            fs::last_write_time (entryFile (keys[i]), now - std::chrono::hours (4 - i));
+        }
+    }
+
+    // Четыре записи по ~1 КБ при пределе 3000: остаётся не больше 3/4 предела
+    TranslationCache cache (dir, 3000);
+    TranslateResult result;
+    CHECK_TRUE (cache.load (keys[0], result));      // Самая старая становится самой свежей
+    uint64_t size = cache.trim ();
+    CHECK_TRUE (size <= 2250);
+    CHECK_EQUAL (2u, cache.stats ().evictions);
+
+    CHECK_TRUE (cache.load (keys[0], result));
+    CHECK_TRUE (result.output == std::string (1000, 'a'));
+    CHECK_FALSE (cache.load (keys[1], result));
+    CHECK_FALSE (cache.load (keys[2], result));
+    CHECK_TRUE (cache.load (keys[3], result));
+}
+
+TEST (translation_cache_test_group, test_output_version)
+{
+    // Вывод транслятора изменился: увеличьте номер вывода в
+    // TranslationCache::version() и запишите здесь новые версию и хеш
+    const char* sample =
+        "int square(int x) { return x * x; }\n"
+        "int sum(int n) { int s = 0; for (int i = 0; i < n; i++) { s += square(i) % 7; } return s; }\n"
+        "int fact(int n, int acc) { if (n <= 1) return acc; return fact(n - 1, acc * n); }\n"
+        "int main() {\n"
+        "    int k = 10; int big = 2147483647;\n"
+        "    while (k > 0) { k--; if (k == 3) break; }\n"
+        "    do { k += 2; } while (k < 20);\n"
+        "    big = big + k;\n"
+        "    return (sum(k) + fact(5, 1) + big) % 256;\n"
+        "}\n";
+    TranslateOptions options;
+    options.sourceMap = true;
+    TranslateResult text = translateSource (sample, options);
+    options.bytecode = true;
+    TranslateResult pyc = translateSource (sample, options);
+    CHECK_TRUE (text.ok && pyc.ok);
+
+    // FNV-1a: не зависит от кеша, который проверяем
+    uint64_t hash = 14695981039346656037ULL;
+    for (const std::string& part : { text.output, text.sourceMap.encodeMappings (), pyc.output }) {
+        for (unsigned char c : part) hash = (hash ^ c) * 1099511628211ULL;
+    }
+    STRCMP_EQUAL ("c2py translation cache 1, output 3", TranslationCache::version ());
+    CHECK_EQUAL (9594288933933584178ULL, hash);
+}
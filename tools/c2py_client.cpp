@@ -0,0 +1,272 @@
+/**
+ * c2py-client - тонкий клиент сервера трансляции (c2py-cli --serve).
+ *
+ * Не содержит транслятора: читает исходники, отправляет их серверу одним
+ * соединением (protocol.h) и пишет результаты так же, как c2py-cli. Запуск
+ * клиента - это запуск маленькой программы без статических таблиц, а
+ * трансляция идёт в прогретом процессе.
+ *
+ *     c2py-cli --serve &
+ *     c2py-client [--socket PATH] [-o DIR | -o -] [--pyc] [--map] [--no-inline]
+ *                 [--memoize [--no-memoize NAME]...] [--bind-globals] [-q] file.c...
+ *     c2py-client [--socket PATH] --stop
+ *
+ * Код завершения: 0 - все файлы транслированы, 1 - есть ошибки, 2 - неверные
+ * аргументы, 3 - сервер не запущен (сборочный сценарий может вызвать
+ * c2py-cli напрямую).
+ *
+ *     make -f Makefile_cli
+ */
+
+#include "protocol.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct ClientOptions {
+    std::string socketPath;
+    std::string outDir;                 // Пусто - рядом с исходником
+    bool toStdout = false;
+    bool writeMap = false;
+    bool quiet = false;
+    bool stop = false;
+    TranslateOptions translate;
+    std::vector<std::string> inputs;
+};
+
+void
+usage (const char* program)
+{
+    std::fprintf(stderr,
+                 "usage: %s [--socket PATH] [-o DIR | -o -] [--pyc] [--map] [--no-inline]\n"
+                 "       [--memoize [--no-memoize NAME]...] [--bind-globals] [-q] file.c...\n"
+                 "       %s [--socket PATH] --stop\n",
+                 program, program);
+}
+
+bool
+parseArguments (int argc, char** argv, ClientOptions& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-o" || arg == "--socket" || arg == "--no-memoize") {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s: %s needs a value\n", argv[0], arg.c_str());
+                return false;
+            }
+            std::string value = argv[++i];
+            if (arg == "--socket") {
+                options.socketPath = value;
+            }
+            else if (arg == "--no-memoize") {
+                options.translate.codegen.noMemoize.insert(value);
+            }
+            else if (value == "-") {
+                options.toStdout = true;
+            }
+            else {
+                options.outDir = value;
+            }
+        }
+        else if (arg == "--pyc") {
+            options.translate.bytecode = true;
+        }
+        else if (arg == "--map") {
+            options.writeMap = true;
+        }
+        else if (arg == "--no-inline") {
+            options.translate.inliner.enabled = false;
+        }
+        else if (arg == "--memoize") {
+            options.translate.codegen.memoizePureRecursive = true;
+        }
+        else if (arg == "--bind-globals") {
+            options.translate.codegen.bindLoopGlobals = true;
+        }
+        else if (arg == "-q") {
+            options.quiet = true;
+        }
+        else if (arg == "--stop") {
+            options.stop = true;
+        }
+        else if (arg == "-h" || arg == "--help") {
+            usage(argv[0]);
+            std::exit(0);
+        }
+        else if (arg.size() > 1 && arg[0] == '-') {
+            std::fprintf(stderr, "%s: unknown option '%s'\n", argv[0], arg.c_str());
+            return false;
+        }
+        else {
+            options.inputs.push_back(arg);
+        }
+    }
+    if (options.inputs.empty() != options.stop) {
+        usage(argv[0]);
+        return false;
+    }
+    if (options.socketPath.empty()) options.socketPath = defaultSocketPath();
+    if (options.translate.bytecode) options.writeMap = false;
+    return true;
+}
+
+bool
+readFile (const std::string& path, std::string& text)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+// Как в c2py-cli: временный файл и rename
+bool
+writeFile (const std::string& path, const std::string& data)
+{
+    std::string temp = path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(data.data(), (std::streamsize) data.size());
+        if (!out.flush()) {
+            out.close();
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string
+outputPath (const ClientOptions& options, const std::string& input)
+{
+    fs::path source(input);
+    fs::path output = options.outDir.empty() ? source : fs::path(options.outDir) / source.filename();
+    output.replace_extension(options.translate.bytecode ? ".pyc" : ".py");
+    return output.string();
+}
+
+// Исходник в карте - относительно её каталога
+std::string
+mapJson (const std::string& input, const std::string& output, const SourceMap& map)
+{
+    fs::path mapDir = fs::path(output).parent_path();
+    std::string source = fs::path(input).lexically_proximate(mapDir.empty() ? fs::path(".") : mapDir).string();
+    return map.toJson(fs::path(output).filename().string(), source);
+}
+
+// Запрос и ответ; false - соединение потеряно
+bool
+exchange (int fd, const TranslateRequest& request, TranslateResult& result)
+{
+    std::string frame;
+    size_t pos = 0;
+    return writeFrame(fd, encodeRequest(request)) && readFrame(fd, frame) &&
+           decodeResult(frame, pos, result);
+}
+
+} // namespace
+
+int
+main (int argc, char** argv)
+{
+    ClientOptions options;
+    if (!parseArguments(argc, argv, options)) return 2;
+
+    if (!options.outDir.empty()) {
+        std::error_code error;
+        fs::create_directories(options.outDir, error);
+    }
+
+    // Чужой каталог или чужой сервер получили бы исходники и вернули бы свой код
+    if (!checkSocketDirectory(options.socketPath, false) && errno == EACCES) {
+        std::fprintf(stderr, "%s: %s is not in a private directory of this user\n", argv[0],
+                     options.socketPath.c_str());
+        return 3;
+    }
+    int fd = connectSocket(options.socketPath);
+    if (fd < 0) {
+        std::fprintf(stderr, "%s: no server on %s: %s (start c2py-cli --serve)\n", argv[0],
+                     options.socketPath.c_str(), std::strerror(errno));
+        return 3;
+    }
+
+    if (options.stop) {
+        TranslateRequest request;
+        request.kind = RequestKind::Shutdown;
+        TranslateResult result;
+        bool ok = exchange(fd, request, result);
+        close(fd);
+        return ok ? 0 : 1;
+    }
+
+    int failed = 0;
+    for (const std::string& input : options.inputs) {
+        TranslateRequest request;
+        request.options = options.translate;
+        request.options.fileName = input;
+        request.options.sourceMap = options.writeMap;
+        if (!readFile(input, request.code)) {
+            std::fprintf(stderr, "FAIL %s\n     cannot read %s: %s\n", input.c_str(), input.c_str(),
+                         std::strerror(errno));
+            ++failed;
+            continue;
+        }
+
+        TranslateResult result;
+        if (!exchange(fd, request, result)) {
+            std::fprintf(stderr, "%s: lost connection to %s\n", argv[0], options.socketPath.c_str());
+            close(fd);
+            return 1;
+        }
+
+        std::string ioError;
+        std::string output = options.toStdout ? std::string("<stdout>") : outputPath(options, input);
+        if (result.ok && options.toStdout) {
+            std::fwrite(result.output.data(), 1, result.output.size(), stdout);
+            std::fflush(stdout);
+        }
+        else if (result.ok) {
+            if (!writeFile(output, result.output)) {
+                ioError = "cannot write " + output + ": " + std::strerror(errno);
+            }
+            else if (options.writeMap &&
+                     !writeFile(output + ".map", mapJson(input, output, result.sourceMap))) {
+                ioError = "cannot write " + output + ".map: " + std::strerror(errno);
+            }
+        }
+
+        if (!result.ok || !ioError.empty()) {
+            ++failed;
+            std::fprintf(stderr, "FAIL %s\n", input.c_str());
+            if (!ioError.empty()) std::fprintf(stderr, "     %s\n", ioError.c_str());
+            for (const auto& error : result.errors) std::fprintf(stderr, "     %s\n", error.c_str());
+        }
+        else if (!options.quiet) {
+            std::fprintf(stderr, "ok   %s -> %s\n", input.c_str(), output.c_str());
+        }
+        if (!options.quiet) {
+            for (const auto& warning : result.warnings) {
+                std::fprintf(stderr, "     %s: %s\n", input.c_str(), warning.c_str());
+            }
+        }
+    }
+    close(fd);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,95 @@
+/**
+ * Перевод трассировки или профиля сгенерированной программы в позиции C.
+ *
+ * Читает карту исходника (Source Map v3, SourceMap::toJson) и текст - из
+ * файлов или стандартного ввода, - в котором ссылки на строки сгенерированного
+ * файла заменяются позициями в исходнике C:
+ *
+ *     python3 prog.py 2>&1 | tools/c2py_remap prog.py.map
+ *     python3 -m cProfile prog.py | tools/c2py_remap prog.py.map
+ *     py-spy dump --pid 1234 | tools/c2py_remap prog.py.map
+ *
+ * Путь исходника в карте - относительно каталога карты, как в Source Map v3.
+ *
+ *     make remap
+ *     tools/c2py_remap карта [файл...]
+ */
+
+#include "source_map.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+bool
+readFile (const std::string& path, std::string& text)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Путь исходника относительно каталога карты
+std::string
+resolveSource (const std::string& mapPath, const std::string& source)
+{
+    if (source.empty() || source[0] == '/') return source;
+    size_t slash = mapPath.find_last_of('/');
+    return (slash == std::string::npos) ? source : mapPath.substr(0, slash + 1) + source;
+}
+
+} // namespace
+
+int
+main (int argc, char** argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s map.json [file...]\n", argv[0]);
+        return 2;
+    }
+
+    std::string json;
+    if (!readFile(argv[1], json)) {
+        std::fprintf(stderr, "%s: cannot read %s\n", argv[0], argv[1]);
+        return 1;
+    }
+
+    SourceMap map;
+    std::string sourceFile, generatedFile;
+    try {
+        map = SourceMap::fromJson(json, &sourceFile, &generatedFile);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s: %s: %s\n", argv[0], argv[1], e.what());
+        return 1;
+    }
+    sourceFile = resolveSource(argv[1], sourceFile);
+
+    int status = 0;
+    auto remap = [&](const std::string& text) {
+        std::string result = remapLocations(text, map, generatedFile, sourceFile);
+        std::fwrite(result.data(), 1, result.size(), stdout);
+    };
+
+    if (argc == 2) {
+        std::ostringstream input;
+        input << std::cin.rdbuf();
+        remap(input.str());
+    }
+    for (int i = 2; i < argc; ++i) {
+        std::string text;
+        if (!readFile(argv[i], text)) {
+            std::fprintf(stderr, "%s: cannot read %s\n", argv[0], argv[i]);
+            status = 1;
+            continue;
+        }
+        remap(text);
+    }
+    return status;
+}